@@ -0,0 +1,315 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "synthetic.h"
+#include "../src/formats.h"
+#include "../src/linker/module.h"
+#include "../src/linker/module_collector.h"
+#include "../src/linker/reader.h"
+#include "../src/format/elf.h"
+#include "../src/format/hunk.h"
+#include "../src/format/leexe.h"
+#include "../src/format/mzexe.h"
+#include "../src/format/neexe.h"
+#include "../src/format/peexe.h"
+
+/*
+ * Measures the time spent in each stage of linking synthetic programs
+ *
+ * Usage: linkbench [options]
+ *	-m<count>	number of modules (default 64)
+ *	-c<count>	number of sections per module (default 2)
+ *	-z<size>	number of bytes per section (default 512)
+ *	-y<count>	number of global symbols per module (default 16)
+ *	-r<count>	number of relocations per module (default 64)
+ *	-f<count>	number of modules referenced by each module (default 4)
+ *	-n<count>	number of repetitions (default 5)
+ *	-F<format>	only measure the given output format (mz, ne, le, pe, elf, hunk), may be repeated
+ *	-I<input>	only measure the given input kind (elf_i386, elf_m68k, coff_i386, aout_i386, or one of these prefixed with ar_), may be repeated
+ *	-o<directory>	instead of measuring, write the generated input files into a directory, for each input kind
+ *
+ * Results are displayed as tab separated lines: benchmark, output format, input kind, stage, modules, relocations per module, repetitions, fastest seconds, median seconds.
+ * The stages are collect (reading the inputs through ModuleCollector), combine (CombineModulesInto), process (setting up the format and ProcessModule),
+ * calculate (CalculateValues), write (WriteFile) and total, these are disjoint intervals that add up to total.
+ * Since ProcessModule compiles the linker script itself, script (compiling the linker script) is measured separately on another instance of the format,
+ * it is not part of total, and the same amount of time is contained in process.
+ */
+
+using namespace Benchmark;
+
+class null_buffer : public std::streambuf
+{
+protected:
+	int overflow(int ch = EOF) override { return ch; }
+public:
+	static null_buffer the_null_buffer;
+};
+
+null_buffer null_buffer::the_null_buffer;
+
+/**
+ * @brief An output format to measure, along with the inputs it accepts
+ */
+struct OutputCase
+{
+	std::string name;
+	/** @brief Name of the format on the linker command line */
+	std::string format;
+	/** @brief Size of relocated fields, 2 for 16-bit formats */
+	unsigned width;
+	std::vector<object_format> inputs;
+	/** @brief Compiles the linker script of the format, without running it */
+	std::function<void(Linker::OutputFormat&, Linker::Module&)> compile_script;
+};
+
+template <typename FormatType>
+	static std::function<void(Linker::OutputFormat&, Linker::Module&)> CompileScript()
+{
+	return [](Linker::OutputFormat& format, Linker::Module& module)
+	{
+		dynamic_cast<FormatType&>(format).GetScript(module);
+	};
+}
+
+static const std::vector<OutputCase> output_cases =
+{
+	{ "mz",   "exe",    2, { ELF_I386 },                       CompileScript<Microsoft::MZFormat>() },
+	{ "ne",   "win",    2, { ELF_I386 },                       CompileScript<Microsoft::NEFormat>() },
+	{ "le",   "dos4g",  4, { ELF_I386, COFF_I386, AOUT_I386 }, CompileScript<Microsoft::LEFormat>() },
+	{ "pe",   "pe",     4, { ELF_I386, COFF_I386, AOUT_I386 }, CompileScript<Microsoft::PEFormat>() },
+	{ "elf",  "elf",    4, { ELF_I386, COFF_I386, AOUT_I386 }, CompileScript<ELF::ELFFormat>() },
+	{ "hunk", "amiga",  4, { ELF_M68K },                       CompileScript<Amiga::HunkFormat>() },
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+/**
+ * @brief Sets up a format the way the link program does before generating the file
+ */
+static void SetupFormat(Linker::OutputFormat& format, Linker::Module& module)
+{
+	std::map<std::string, std::string> options;
+	std::map<std::string, std::string> parameters;
+	format.AllocateSymbols(module);
+	format.SetOptions(options);
+	format.SetModel("");
+	format.SetLinkScript("", parameters);
+}
+
+/**
+ * @brief Links the generated files once, recording the time spent in each stage
+ */
+static void LinkOnce(const OutputCase& output_case, const std::vector<std::pair<std::string, std::string>>& files, std::string output_file, std::map<std::string, double>& stages)
+{
+	{
+		/* the script is compiled again during ProcessModule, so it is measured outside of the link */
+		std::shared_ptr<Linker::OutputFormat> format = std::dynamic_pointer_cast<Linker::OutputFormat>(FetchFormat(output_case.format));
+		Linker::Module module;
+		SetupFormat(*format, module);
+		auto script_start = clock_type::now();
+		output_case.compile_script(*format, module);
+		stages["script"] = std::chrono::duration<double>(clock_type::now() - script_start).count();
+	}
+
+	auto start = clock_type::now();
+	auto last = start;
+	auto lap = [&](std::string stage)
+	{
+		auto now = clock_type::now();
+		stages[stage] = std::chrono::duration<double>(now - last).count();
+		last = now;
+	};
+
+	std::shared_ptr<Linker::OutputFormat> format = std::dynamic_pointer_cast<Linker::OutputFormat>(FetchFormat(output_case.format));
+	Linker::ModuleCollector linker;
+	linker.SetupOptions('$', format);
+
+	for(auto& file : files)
+	{
+		std::istringstream in(file.second);
+		Linker::Reader rd(::LittleEndian, &in);
+		std::vector<format_description> file_formats;
+		DetermineFormat(file_formats, rd);
+		std::shared_ptr<Linker::InputFormat> input_format = nullptr;
+		for(auto& file_format : file_formats)
+		{
+			input_format = std::dynamic_pointer_cast<Linker::InputFormat>(CreateFormat(rd, file_format, ReadLibraryFile));
+			if(input_format != nullptr)
+			{
+				input_format->file_offset = file_format.offset;
+				rd.Seek(file_format.offset);
+				break;
+			}
+		}
+		if(input_format == nullptr)
+		{
+			Linker::FatalError("Fatal error: Unable to process generated file " + file.first);
+		}
+		input_format->SetupOptions(format);
+		input_format->ProduceModule(linker, rd, file.first);
+	}
+	lap("collect");
+
+	Linker::Module module;
+	linker.CombineModulesInto(module);
+	lap("combine");
+
+	SetupFormat(*format, module);
+	format->stage_finished = lap;
+	format->GenerateFile(output_file, module);
+
+	stages["total"] = std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+static const std::vector<std::string> stage_names = { "collect", "combine", "script", "process", "calculate", "write", "total" };
+
+static void Measure(const Parameters& parameters, const OutputCase& output_case, object_format input, bool as_archive, unsigned repetitions, std::string output_file)
+{
+	std::vector<std::pair<std::string, std::string>> files = GenerateProgram(parameters, input, as_archive, output_case.width);
+	std::string input_name = (as_archive ? "ar_" : "") + GetObjectFormatName(input);
+
+	std::map<std::string, std::vector<double>> timings;
+	for(unsigned i = 0; i < repetitions; i++)
+	{
+		std::map<std::string, double> stages;
+		LinkOnce(output_case, files, output_file, stages);
+		for(auto& stage : stages)
+			timings[stage.first].push_back(stage.second);
+	}
+
+	for(auto& stage : stage_names)
+	{
+		std::vector<double>& values = timings[stage];
+		if(values.size() == 0)
+			continue;
+		std::sort(values.begin(), values.end());
+		std::cout << "link\t" << output_case.name << "\t" << input_name << "\t" << stage
+			<< "\t" << parameters.module_count << "\t" << parameters.relocation_count << "\t" << values.size()
+			<< "\t" << values.front() << "\t" << values[values.size() / 2] << std::endl;
+	}
+}
+
+static void WriteInputs(const Parameters& parameters, std::string directory)
+{
+	for(object_format input : { ELF_I386, ELF_M68K, COFF_I386, AOUT_I386 })
+	{
+		for(bool as_archive : { false, true })
+		{
+			std::filesystem::path path = std::filesystem::path(directory) / ((as_archive ? "ar_" : "") + GetObjectFormatName(input));
+			std::filesystem::create_directories(path);
+			for(auto& file : GenerateProgram(parameters, input, as_archive))
+			{
+				std::ofstream out(path / file.first, std::ios_base::out | std::ios_base::binary);
+				out.write(file.second.data(), file.second.size());
+			}
+		}
+	}
+}
+
+int main(int argc, char * argv[])
+{
+	Parameters parameters;
+	unsigned repetitions = 5;
+	std::vector<std::string> selected_outputs;
+	std::vector<std::string> selected_inputs;
+	std::string directory;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(argv[i][0] != '-' || argv[i][1] == '\0')
+		{
+			std::cerr << "Unknown argument `" << argv[i] << "'" << std::endl;
+			return 1;
+		}
+		char option = argv[i][1];
+		std::string value = argv[i][2] ? &argv[i][2] : i + 1 < argc ? argv[++i] : "";
+		try
+		{
+			switch(option)
+			{
+			case 'm':
+				parameters.module_count = std::stoul(value);
+				break;
+			case 'c':
+				parameters.section_count = std::stoul(value);
+				break;
+			case 'z':
+				parameters.section_size = std::stoul(value);
+				break;
+			case 'y':
+				parameters.symbol_count = std::stoul(value);
+				break;
+			case 'r':
+				parameters.relocation_count = std::stoul(value);
+				break;
+			case 'f':
+				parameters.fan_out = std::stoul(value);
+				break;
+			case 'n':
+				repetitions = std::max(std::stoul(value), 1ul);
+				break;
+			case 'F':
+				selected_outputs.push_back(value);
+				break;
+			case 'I':
+				selected_inputs.push_back(value);
+				break;
+			case 'o':
+				directory = value;
+				break;
+			default:
+				std::cerr << "Unknown option `-" << option << "'" << std::endl;
+				return 1;
+			}
+		}
+		catch(std::logic_error&)
+		{
+			std::cerr << "Invalid value for option `-" << option << "'" << std::endl;
+			return 1;
+		}
+	}
+
+	if(directory != "")
+	{
+		WriteInputs(parameters, directory);
+		return 0;
+	}
+
+	Linker::Debug.rdbuf(&null_buffer::the_null_buffer);
+	Linker::Warning.rdbuf(&null_buffer::the_null_buffer);
+
+	std::string output_file = (std::filesystem::temp_directory_path() / "linkbench.out").string();
+	int status = 0;
+	for(auto& output_case : output_cases)
+	{
+		if(selected_outputs.size() != 0 && std::find(selected_outputs.begin(), selected_outputs.end(), output_case.name) == selected_outputs.end())
+			continue;
+		for(object_format input : output_case.inputs)
+		{
+			for(bool as_archive : { false, true })
+			{
+				std::string input_name = (as_archive ? "ar_" : "") + GetObjectFormatName(input);
+				if(selected_inputs.size() != 0 && std::find(selected_inputs.begin(), selected_inputs.end(), input_name) == selected_inputs.end())
+					continue;
+				try
+				{
+					Measure(parameters, output_case, input, as_archive, repetitions, output_file);
+				}
+				catch(Linker::Exception& exception)
+				{
+					std::cerr << output_case.name << " from " << input_name << ": " << exception.message << std::endl;
+					status = 1;
+				}
+			}
+		}
+	}
+	std::filesystem::remove(output_file);
+
+	return status;
+}
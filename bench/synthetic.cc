@@ -0,0 +1,536 @@
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include "synthetic.h"
+#include "../src/linker/writer.h"
+
+using namespace Benchmark;
+
+std::string Benchmark::GetObjectFormatName(object_format format)
+{
+	switch(format)
+	{
+	case ELF_I386:
+		return "elf_i386";
+	case ELF_M68K:
+		return "elf_m68k";
+	case COFF_I386:
+		return "coff_i386";
+	case AOUT_I386:
+		return "aout_i386";
+	}
+	return "";
+}
+
+static std::string ModuleName(unsigned index)
+{
+	return "m" + std::to_string(index) + ".o";
+}
+
+static std::string SymbolName(unsigned module_index, unsigned symbol_index)
+{
+	return "m" + std::to_string(module_index) + "_f" + std::to_string(symbol_index);
+}
+
+SyntheticModule Benchmark::GenerateModule(const Parameters& parameters, unsigned index, unsigned width)
+{
+	std::mt19937 random(parameters.seed * 65521 + index);
+	SyntheticModule module;
+	module.name = ModuleName(index);
+	module.width = width;
+
+	unsigned section_count = std::max(parameters.section_count, 1u);
+	unsigned section_size = std::max(parameters.section_size, 4u) & ~3u;
+	for(unsigned i = 0; i < section_count; i++)
+	{
+		SyntheticModule::Section section;
+		section.is_code = (i & 1) == 0;
+		section.name = section.is_code ? ".text" : ".data";
+		if(i >= 2)
+			section.name += "." + std::to_string(i / 2);
+		section.data.resize(section_size);
+		for(auto& byte : section.data)
+			byte = section.is_code ? "\x55\x89\xE5\x83\xEC\x08\x8B\x45"[random() & 7] : random();
+		module.sections.push_back(section);
+	}
+
+	/* symbol j lives in section j % section_count, so symbols of both kinds are always available */
+	unsigned symbol_count = std::max(parameters.symbol_count, 1u);
+	for(unsigned j = 0; j < symbol_count; j++)
+	{
+		module.symbols.push_back(SyntheticModule::Symbol{SymbolName(index, j), int(j % section_count), (j / section_count * 16) % section_size});
+	}
+	if(index == 0)
+	{
+		module.symbols.push_back(SyntheticModule::Symbol{"_start", 0, 0});
+	}
+
+	std::map<std::string, unsigned> undefined_symbols;
+	auto fetch_symbol = [&](unsigned module_index, unsigned symbol_index) -> unsigned
+	{
+		if(module_index == index)
+			return symbol_index;
+		std::string name = SymbolName(module_index, symbol_index);
+		auto it = undefined_symbols.find(name);
+		if(it != undefined_symbols.end())
+			return it->second;
+		unsigned symbol = module.symbols.size();
+		module.symbols.push_back(SyntheticModule::Symbol{name, -1, 0});
+		undefined_symbols[name] = symbol;
+		return symbol;
+	};
+
+	/* relocations are spread evenly over the slots of each section */
+	unsigned slot_count = section_size / width;
+	unsigned relocation_count = std::min(parameters.relocation_count, slot_count * section_count);
+	unsigned relocations_per_section = (relocation_count + section_count - 1) / section_count;
+	unsigned stride = relocations_per_section == 0 ? 1 : std::max(slot_count / relocations_per_section, 1u);
+	for(unsigned r = 0; r < relocation_count; r++)
+	{
+		SyntheticModule::Relocation relocation;
+		relocation.section = r % section_count;
+		relocation.offset = (r / section_count) * stride * width;
+		relocation.relative = module.sections[relocation.section].is_code && (r & 1) != 0;
+
+		unsigned symbol_index = random() % symbol_count;
+		if(relocation.relative && (symbol_index % section_count & 1) != 0)
+			symbol_index--; /* relative references only target code */
+		if(parameters.fan_out == 0 || parameters.module_count <= 1 || r % 4 == 0)
+		{
+			relocation.symbol = symbol_index;
+		}
+		else
+		{
+			/* references to the next module come first, this way every module gets included */
+			unsigned target = (index + 1 + (r / 4 * 3 + r % 4 - 1) % parameters.fan_out) % parameters.module_count;
+			relocation.symbol = fetch_symbol(target, symbol_index);
+		}
+
+		std::fill_n(module.sections[relocation.section].data.begin() + relocation.offset, width, 0);
+		module.relocations.push_back(relocation);
+	}
+
+	return module;
+}
+
+/** @brief Collects zero terminated names, offsets start after a prefix of the given size */
+class StringTable
+{
+public:
+	std::string contents;
+	size_t prefix;
+
+	StringTable(size_t prefix = 0, std::string initial = "")
+		: contents(initial), prefix(prefix)
+	{
+	}
+
+	uint32_t Add(std::string name)
+	{
+		uint32_t offset = prefix + contents.size();
+		contents += name;
+		contents += '\0';
+		return offset;
+	}
+};
+
+static std::string WriteELF(const SyntheticModule& module, bool m68k)
+{
+	EndianType endiantype = m68k ? ::BigEndian : ::LittleEndian;
+	std::ostringstream out;
+	Linker::Writer wr(endiantype, &out);
+
+	enum
+	{
+		SHT_PROGBITS = 1,
+		SHT_SYMTAB = 2,
+		SHT_STRTAB = 3,
+		SHT_RELA = 4,
+		SHT_REL = 9,
+	};
+
+	struct SectionHeader
+	{
+		uint32_t name, type, flags, offset, size, link, info, align, entsize;
+	};
+	std::vector<SectionHeader> headers;
+	headers.push_back(SectionHeader{});
+
+	StringTable section_names(0, std::string(1, '\0'));
+	StringTable symbol_names(0, std::string(1, '\0'));
+
+	size_t section_count = module.sections.size();
+	size_t symtab_index = section_count + 1;
+	size_t strtab_index = section_count + 2;
+
+	wr.Seek(52);
+	for(auto& section : module.sections)
+	{
+		wr.AlignTo(4);
+		SectionHeader header{};
+		header.name = section_names.Add(section.name);
+		header.type = SHT_PROGBITS;
+		header.flags = section.is_code ? 0x6 : 0x3; // SHF_ALLOC | SHF_EXECINSTR or SHF_ALLOC | SHF_WRITE
+		header.offset = wr.Tell();
+		header.size = section.data.size();
+		header.align = 4;
+		wr.WriteData(section.data.size(), section.data.data());
+		headers.push_back(header);
+	}
+
+	/* symbol table: null symbol, section symbols, then every named symbol as global */
+	wr.AlignTo(4);
+	SectionHeader symtab{};
+	symtab.name = section_names.Add(".symtab");
+	symtab.type = SHT_SYMTAB;
+	symtab.offset = wr.Tell();
+	symtab.link = strtab_index;
+	symtab.info = section_count + 1;
+	symtab.align = 4;
+	symtab.entsize = 16;
+	wr.Skip(16);
+	for(size_t i = 0; i < section_count; i++)
+	{
+		wr.WriteWord(4, 0);
+		wr.WriteWord(4, 0);
+		wr.WriteWord(4, 0);
+		wr.WriteWord(1, 0x03); // STB_LOCAL, STT_SECTION
+		wr.WriteWord(1, 0);
+		wr.WriteWord(2, i + 1);
+	}
+	for(auto& symbol : module.symbols)
+	{
+		wr.WriteWord(4, symbol_names.Add(symbol.name));
+		wr.WriteWord(4, symbol.offset);
+		wr.WriteWord(4, 0);
+		if(symbol.section < 0)
+			wr.WriteWord(1, 0x10); // STB_GLOBAL, STT_NOTYPE
+		else
+			wr.WriteWord(1, module.sections[symbol.section].is_code ? 0x12 : 0x11); // STB_GLOBAL, STT_FUNC or STT_OBJECT
+		wr.WriteWord(1, 0);
+		wr.WriteWord(2, symbol.section < 0 ? 0 : symbol.section + 1);
+	}
+	symtab.size = wr.Tell() - symtab.offset;
+	headers.push_back(symtab);
+
+	SectionHeader strtab{};
+	strtab.name = section_names.Add(".strtab");
+	strtab.type = SHT_STRTAB;
+	strtab.offset = wr.Tell();
+	strtab.size = symbol_names.contents.size();
+	strtab.align = 1;
+	wr.WriteData(symbol_names.contents);
+	headers.push_back(strtab);
+
+	SectionHeader shstrtab{};
+	shstrtab.name = section_names.Add(".shstrtab");
+	shstrtab.type = SHT_STRTAB;
+	shstrtab.align = 1;
+	/* relocation section names must be added before the section name table is written */
+	std::vector<uint32_t> relocation_names;
+	for(auto& section : module.sections)
+	{
+		relocation_names.push_back(section_names.Add((m68k ? ".rela" : ".rel") + section.name));
+	}
+	shstrtab.offset = wr.Tell();
+	shstrtab.size = section_names.contents.size();
+	wr.WriteData(section_names.contents);
+	headers.push_back(shstrtab);
+
+	unsigned symbol_base = section_count + 1;
+	for(size_t i = 0; i < section_count; i++)
+	{
+		wr.AlignTo(4);
+		SectionHeader header{};
+		header.name = relocation_names[i];
+		header.type = m68k ? SHT_RELA : SHT_REL;
+		header.offset = wr.Tell();
+		header.link = symtab_index;
+		header.info = i + 1;
+		header.align = 4;
+		header.entsize = m68k ? 12 : 8;
+		for(auto& relocation : module.relocations)
+		{
+			if(relocation.section != i)
+				continue;
+			uint8_t type;
+			if(m68k)
+				type = relocation.relative ? 4 : 1; // R_68K_PC32 or R_68K_32
+			else if(module.width == 2)
+				type = relocation.relative ? 21 : 20; // R_386_PC16 or R_386_16
+			else
+				type = relocation.relative ? 2 : 1; // R_386_PC32 or R_386_32
+			wr.WriteWord(4, relocation.offset);
+			wr.WriteWord(4, ((symbol_base + relocation.symbol) << 8) | type);
+			if(m68k)
+				wr.WriteWord(4, relocation.relative ? -4 : 0);
+		}
+		header.size = wr.Tell() - header.offset;
+		headers.push_back(header);
+	}
+
+	wr.AlignTo(4);
+	offset_t section_header_offset = wr.Tell();
+	for(auto& header : headers)
+	{
+		wr.WriteWord(4, header.name);
+		wr.WriteWord(4, header.type);
+		wr.WriteWord(4, header.flags);
+		wr.WriteWord(4, 0); // address
+		wr.WriteWord(4, header.offset);
+		wr.WriteWord(4, header.size);
+		wr.WriteWord(4, header.link);
+		wr.WriteWord(4, header.info);
+		wr.WriteWord(4, header.align);
+		wr.WriteWord(4, header.entsize);
+	}
+
+	wr.Seek(0);
+	wr.WriteData("\x7F" "ELF");
+	wr.WriteWord(1, 1); // ELFCLASS32
+	wr.WriteWord(1, m68k ? 2 : 1); // ELFDATA2MSB or ELFDATA2LSB
+	wr.WriteWord(1, 1); // EV_CURRENT
+	wr.Skip(9);
+	wr.WriteWord(2, 1); // ET_REL
+	wr.WriteWord(2, m68k ? 4 : 3); // EM_68K or EM_386
+	wr.WriteWord(4, 1); // EV_CURRENT
+	wr.WriteWord(4, 0); // entry
+	wr.WriteWord(4, 0); // program headers
+	wr.WriteWord(4, section_header_offset);
+	wr.WriteWord(4, 0); // flags
+	wr.WriteWord(2, 52);
+	wr.WriteWord(2, 0);
+	wr.WriteWord(2, 0);
+	wr.WriteWord(2, 40);
+	wr.WriteWord(2, headers.size());
+	wr.WriteWord(2, symtab_index + 2); // .shstrtab
+
+	return out.str();
+}
+
+static std::string WriteCOFF(const SyntheticModule& module)
+{
+	std::ostringstream out;
+	Linker::Writer wr(::LittleEndian, &out);
+
+	size_t section_count = module.sections.size();
+	offset_t offset = 20 + 40 * section_count;
+	std::vector<offset_t> data_offsets, relocation_offsets;
+	std::vector<size_t> relocation_counts(section_count, 0);
+	for(auto& relocation : module.relocations)
+		relocation_counts[relocation.section]++;
+	for(auto& section : module.sections)
+	{
+		data_offsets.push_back(offset);
+		offset += section.data.size();
+	}
+	for(size_t i = 0; i < section_count; i++)
+	{
+		relocation_offsets.push_back(offset);
+		offset += 10 * relocation_counts[i];
+	}
+	offset_t symbol_table_offset = offset;
+
+	wr.WriteWord(2, 0x014C);
+	wr.WriteWord(2, section_count);
+	wr.WriteWord(4, 0); // time stamp
+	wr.WriteWord(4, symbol_table_offset);
+	wr.WriteWord(4, module.symbols.size());
+	wr.WriteWord(2, 0); // optional header size
+	wr.WriteWord(2, 0); // flags
+
+	for(size_t i = 0; i < section_count; i++)
+	{
+		auto& section = module.sections[i];
+		wr.WriteData(8, section.name.substr(0, 8));
+		wr.WriteWord(4, 0); // physical address
+		wr.WriteWord(4, 0); // virtual address, all sections start at 0 so that offsets and addresses coincide
+		wr.WriteWord(4, section.data.size());
+		wr.WriteWord(4, data_offsets[i]);
+		wr.WriteWord(4, relocation_counts[i] != 0 ? relocation_offsets[i] : 0);
+		wr.WriteWord(4, 0); // line numbers
+		wr.WriteWord(2, relocation_counts[i]);
+		wr.WriteWord(2, 0);
+		wr.WriteWord(4, section.is_code ? 0x20 : 0x40); // STYP_TEXT or STYP_DATA
+	}
+
+	for(auto& section : module.sections)
+	{
+		wr.WriteData(section.data.size(), section.data.data());
+	}
+
+	for(size_t i = 0; i < section_count; i++)
+	{
+		for(auto& relocation : module.relocations)
+		{
+			if(relocation.section != i)
+				continue;
+			wr.WriteWord(4, relocation.offset);
+			wr.WriteWord(4, relocation.symbol);
+			wr.WriteWord(2, relocation.relative ? 20 : 6); // R_PCRLONG or R_DIR32
+		}
+	}
+
+	StringTable names(4);
+	for(auto& symbol : module.symbols)
+	{
+		if(symbol.name.size() <= 8)
+		{
+			wr.WriteData(8, symbol.name);
+		}
+		else
+		{
+			wr.WriteWord(4, 0);
+			wr.WriteWord(4, names.Add(symbol.name));
+		}
+		wr.WriteWord(4, symbol.offset);
+		wr.WriteWord(2, symbol.section + 1); // N_UNDEF for undefined symbols
+		wr.WriteWord(2, 0); // type
+		wr.WriteWord(1, 2); // C_EXT
+		wr.WriteWord(1, 0); // auxiliary entries
+	}
+	wr.WriteWord(4, 4 + names.contents.size());
+	wr.WriteData(names.contents);
+
+	return out.str();
+}
+
+static std::string WriteAOut(const SyntheticModule& module)
+{
+	std::ostringstream out;
+	Linker::Writer wr(::LittleEndian, &out);
+
+	/* code sections are concatenated into text, data sections into data */
+	std::vector<offset_t> section_offsets;
+	offset_t text_size = 0, data_size = 0;
+	for(auto& section : module.sections)
+	{
+		offset_t& size = section.is_code ? text_size : data_size;
+		section_offsets.push_back(size);
+		size += section.data.size();
+	}
+	std::vector<std::pair<offset_t, const SyntheticModule::Relocation *>> text_relocations, data_relocations;
+	for(auto& relocation : module.relocations)
+	{
+		bool is_code = module.sections[relocation.section].is_code;
+		(is_code ? text_relocations : data_relocations).push_back({ section_offsets[relocation.section] + relocation.offset, &relocation });
+	}
+
+	wr.WriteWord(4, 0x00640107); // OMAGIC, MID_PC386
+	wr.WriteWord(4, text_size);
+	wr.WriteWord(4, data_size);
+	wr.WriteWord(4, 0); // bss
+	wr.WriteWord(4, 12 * module.symbols.size());
+	wr.WriteWord(4, 0); // entry
+	wr.WriteWord(4, 8 * text_relocations.size());
+	wr.WriteWord(4, 8 * data_relocations.size());
+
+	for(int kind = 0; kind < 2; kind++)
+	{
+		for(auto& section : module.sections)
+		{
+			if(section.is_code == (kind == 0))
+				wr.WriteData(section.data.size(), section.data.data());
+		}
+	}
+
+	for(auto * relocations : { &text_relocations, &data_relocations })
+	{
+		for(auto& relocation : *relocations)
+		{
+			wr.WriteWord(4, relocation.first);
+			wr.WriteWord(4, relocation.second->symbol
+				| (relocation.second->relative ? 0x01000000 : 0)
+				| ((module.width == 2 ? 1 : 2) << 25)
+				| 0x08000000); // external
+		}
+	}
+
+	StringTable names(4);
+	for(auto& symbol : module.symbols)
+	{
+		wr.WriteWord(4, names.Add(symbol.name));
+		if(symbol.section < 0)
+		{
+			wr.WriteWord(1, 0x01); // N_UNDF | N_EXT
+			wr.WriteWord(1, 0);
+			wr.WriteWord(2, 0);
+			wr.WriteWord(4, 0);
+		}
+		else
+		{
+			bool is_code = module.sections[symbol.section].is_code;
+			wr.WriteWord(1, is_code ? 0x05 : 0x07); // N_TEXT | N_EXT or N_DATA | N_EXT
+			wr.WriteWord(1, 0);
+			wr.WriteWord(2, 0);
+			wr.WriteWord(4, section_offsets[symbol.section] + symbol.offset + (is_code ? 0 : text_size));
+		}
+	}
+	wr.WriteWord(4, 4 + names.contents.size());
+	wr.WriteData(names.contents);
+
+	return out.str();
+}
+
+std::string Benchmark::WriteObject(const SyntheticModule& module, object_format format)
+{
+	switch(format)
+	{
+	case ELF_I386:
+		return WriteELF(module, false);
+	case ELF_M68K:
+		return WriteELF(module, true);
+	case COFF_I386:
+		return WriteCOFF(module);
+	case AOUT_I386:
+		return WriteAOut(module);
+	}
+	return "";
+}
+
+std::string Benchmark::WriteArchive(const std::vector<std::pair<std::string, std::string>>& members)
+{
+	std::ostringstream out;
+	out << "!<arch>\n";
+	for(auto& member : members)
+	{
+		std::string header;
+		auto field = [&header](std::string value, size_t width)
+		{
+			value.resize(width, ' ');
+			header += value;
+		};
+		field(member.first + "/", 16);
+		field("0", 12); // modification time
+		field("0", 6); // owner
+		field("0", 6); // group
+		field("644", 8); // mode
+		field(std::to_string(member.second.size()), 10);
+		header += "`\n";
+		out << header << member.second;
+		if((member.second.size() & 1) != 0)
+			out << '\n';
+	}
+	return out.str();
+}
+
+std::vector<std::pair<std::string, std::string>> Benchmark::GenerateProgram(const Parameters& parameters, object_format format, bool as_archive, unsigned width)
+{
+	std::vector<std::pair<std::string, std::string>> files;
+	std::vector<std::pair<std::string, std::string>> members;
+	for(unsigned i = 0; i < std::max(parameters.module_count, 1u); i++)
+	{
+		SyntheticModule module = GenerateModule(parameters, i, width);
+		std::pair<std::string, std::string> file(module.name, WriteObject(module, format));
+		if(as_archive && i != 0)
+			members.push_back(file);
+		else
+			files.push_back(file);
+	}
+	if(as_archive)
+	{
+		files.push_back({ "libsynth.a", WriteArchive(members) });
+	}
+	return files;
+}
@@ -0,0 +1,123 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/common.h"
+
+/*
+ * Generates synthetic object files and archives to feed the linker benchmarks
+ */
+
+namespace Benchmark
+{
+	/**
+	 * @brief The shape of the generated program
+	 */
+	struct Parameters
+	{
+		/** @brief Number of object modules */
+		unsigned module_count = 64;
+		/** @brief Number of sections in each module, even sections contain code, odd sections contain data */
+		unsigned section_count = 2;
+		/** @brief Number of bytes in each section */
+		unsigned section_size = 512;
+		/** @brief Number of global symbols defined in each module */
+		unsigned symbol_count = 16;
+		/** @brief Number of relocations in each module */
+		unsigned relocation_count = 64;
+		/** @brief Number of other modules that each module references, the modules form a chain so that all of them get included from the first one */
+		unsigned fan_out = 4;
+		/** @brief Seed for the contents and the relocation targets */
+		unsigned seed = 0;
+	};
+
+	/**
+	 * @brief Format independent description of a generated module
+	 */
+	struct SyntheticModule
+	{
+		struct Section
+		{
+			std::string name;
+			bool is_code;
+			std::vector<uint8_t> data;
+		};
+
+		struct Symbol
+		{
+			std::string name;
+			/** @brief Index of the section in the module, or -1 for undefined symbols */
+			int section;
+			offset_t offset;
+		};
+
+		struct Relocation
+		{
+			unsigned section;
+			offset_t offset;
+			/** @brief Index into the symbol list */
+			unsigned symbol;
+			bool relative;
+		};
+
+		std::string name;
+		std::vector<Section> sections;
+		/** @brief Defined symbols come first, followed by the undefined ones */
+		std::vector<Symbol> symbols;
+		std::vector<Relocation> relocations;
+		/** @brief The size of each relocated field, 2 for 16-bit targets and 4 otherwise */
+		unsigned width;
+	};
+
+	/**
+	 * @brief Object file formats that the generator can produce
+	 */
+	enum object_format
+	{
+		/** @brief ELF relocatable file for the Intel 80386, also used for 16-bit targets */
+		ELF_I386,
+		/** @brief ELF relocatable file for the Motorola 68000 */
+		ELF_M68K,
+		/** @brief DJGPP COFF object file for the Intel 80386 */
+		COFF_I386,
+		/** @brief a.out object file for the Intel 80386 */
+		AOUT_I386,
+	};
+
+	/**
+	 * @brief Returns the name used for the format on the command line and in reports
+	 */
+	std::string GetObjectFormatName(object_format format);
+
+	/**
+	 * @brief Creates the description of a single module
+	 *
+	 * @param parameters The shape of the program
+	 * @param index Index of the module, module 0 defines the entry point _start
+	 * @param width Size of each relocated field
+	 */
+	SyntheticModule GenerateModule(const Parameters& parameters, unsigned index, unsigned width);
+
+	/**
+	 * @brief Encodes a module in the requested object file format
+	 */
+	std::string WriteObject(const SyntheticModule& module, object_format format);
+
+	/**
+	 * @brief Creates a UNIX ar archive from a list of named files
+	 */
+	std::string WriteArchive(const std::vector<std::pair<std::string, std::string>>& members);
+
+	/**
+	 * @brief Generates the input files of a program
+	 *
+	 * @param as_archive When set, all modules except the first one are collected into an archive called libsynth.a
+	 * @param width Size of each relocated field, only ELF_I386 supports 2
+	 * @return A list of file names and file contents
+	 */
+	std::vector<std::pair<std::string, std::string>> GenerateProgram(const Parameters& parameters, object_format format, bool as_archive, unsigned width = 4);
+}
+
+#endif /* SYNTHETIC_H */
@@ -0,0 +1,263 @@
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include "../src/format/w3w4.h"
+
+/*
+ * Measures the throughput of W4 (VMM32.VXD) decompression
+ *
+ * Usage: w4 [<VMM32.VXD>]
+ * Without an argument, a synthetic compressed image is generated.
+ * Results are displayed as tab separated lines: benchmark, variant, input bytes, output bytes, seconds, output megabytes per second.
+ */
+
+using namespace Microsoft;
+
+/**
+ * @brief Collects bits, least significant bits first, the way the W4 decompressor reads them
+ */
+class BitWriter
+{
+public:
+	std::vector<uint8_t> bytes;
+	unsigned bit_count = 0;
+
+	void WriteBits(unsigned count, uint32_t value)
+	{
+		for(unsigned i = 0; i < count; i++)
+		{
+			if(bit_count == 0)
+				bytes.push_back(0);
+			bytes.back() |= ((value >> i) & 1) << bit_count;
+			bit_count = (bit_count + 1) & 7;
+		}
+	}
+};
+
+/**
+ * @brief Generates a compressed chunk with a mixture of literals and back references, resembling machine code
+ *
+ * The bytes the chunk is meant to decompress to are appended to plain, zero filled to chunk_size.
+ */
+static std::vector<uint8_t> GenerateChunk(std::mt19937& random, size_t chunk_size, std::vector<uint8_t>& plain)
+{
+	BitWriter writer;
+	size_t position = 0;
+	size_t chunk_start = plain.size();
+	while(position < chunk_size)
+	{
+		if(position < 16 || random() % 3 == 0)
+		{
+			uint8_t byte = random() % 4 == 0 ? random() : random() % 0x40;
+			writer.WriteBits(2, byte & 0x80 ? 0b01 : 0b10);
+			writer.WriteBits(7, byte & 0x7F);
+			plain.push_back(byte);
+			position++;
+		}
+		else
+		{
+			size_t depth = 1 + random() % std::min(position, size_t(4414));
+			size_t count_bits = random() % 4;
+			size_t count_value = random() % (1 << count_bits);
+			size_t count = count_value + (1 << count_bits) + 1;
+			if(position + count > chunk_size)
+				break;
+			if(depth < 64)
+			{
+				writer.WriteBits(2, 0b00);
+				writer.WriteBits(6, depth);
+			}
+			else if(depth < 320)
+			{
+				writer.WriteBits(2, 0b11);
+				writer.WriteBits(1, 0);
+				writer.WriteBits(8, depth - 64);
+			}
+			else
+			{
+				writer.WriteBits(2, 0b11);
+				writer.WriteBits(1, 1);
+				writer.WriteBits(12, depth - 320);
+			}
+			writer.WriteBits(count_bits, 0);
+			writer.WriteBits(1, 1);
+			writer.WriteBits(count_bits, count_value);
+			for(size_t i = 0; i < count; i++)
+			{
+				plain.push_back(plain[plain.size() - depth]);
+			}
+			position += count;
+		}
+	}
+	writer.WriteBits(8, 0);
+	plain.resize(chunk_start + chunk_size);
+	return writer.bytes;
+}
+
+/**
+ * @brief The original decompressor, reading a bit at a time through Image::GetByte and growing a vector
+ */
+static std::shared_ptr<Linker::Buffer> ReferenceDecompressW4(const W4Format& w4)
+{
+	std::shared_ptr<Linker::Buffer> buffer = std::make_shared<Linker::Buffer>();
+	uint32_t chunk_index = 0;
+	for(auto& chunk : w4.chunks)
+	{
+		std::vector<uint8_t> bytes;
+		offset_t contents_offset = 0;
+		uint8_t byte = 0;
+		unsigned bit_count = 0;
+		auto read_bits = [&](unsigned count) -> uint32_t
+		{
+			uint32_t value = 0;
+			for(unsigned shift = 0; shift < count; shift++)
+			{
+				if(bit_count == 0)
+				{
+					if(contents_offset >= chunk.contents->ImageSize())
+						return value;
+					byte = chunk.contents->GetByte(contents_offset++);
+					bit_count = 8;
+				}
+				value |= uint32_t(byte & 1) << shift;
+				byte >>= 1;
+				bit_count--;
+			}
+			return value;
+		};
+
+		bool chunk_over = false;
+		while(!chunk_over && !(contents_offset >= chunk.contents->ImageSize() && bit_count == 0))
+		{
+			size_t depth = 0;
+			switch(read_bits(2))
+			{
+			case 0b00:
+				depth = read_bits(6);
+				if(depth == 0)
+					chunk_over = true;
+				break;
+			case 0b01:
+				bytes.push_back(read_bits(7) | 0x80);
+				break;
+			case 0b10:
+				bytes.push_back(read_bits(7));
+				break;
+			case 0b11:
+				if(read_bits(1) == 0)
+				{
+					depth = 64 + read_bits(8);
+				}
+				else
+				{
+					depth = 320 + read_bits(12);
+					if(depth == 4415)
+						continue;
+				}
+				break;
+			}
+			if(depth != 0)
+			{
+				size_t count_bits = 0;
+				while(read_bits(1) == 0)
+				{
+					count_bits ++;
+					if(count_bits == 9)
+						Linker::FatalError("Fatal error: illegal encoding in W4 compression");
+				}
+				size_t count = read_bits(count_bits) + (1 << count_bits) + 1;
+				for(size_t char_index = 0; char_index < count; char_index++)
+				{
+					bytes.push_back(bytes[bytes.size() - depth]);
+				}
+			}
+		}
+		buffer->Append(bytes);
+		buffer->Resize(w4.chunk_size * (chunk_index + 1));
+		chunk_index ++;
+	}
+	return buffer;
+}
+
+static bool SameContents(const Linker::Buffer& buffer1, const Linker::Buffer& buffer2)
+{
+	if(buffer1.ImageSize() != buffer2.ImageSize())
+		return false;
+	std::vector<uint8_t> data1(buffer1.ImageSize()), data2(buffer2.ImageSize());
+	buffer1.ReadData(data1.size(), 0, data1.data());
+	buffer2.ReadData(data2.size(), 0, data2.data());
+	return data1 == data2;
+}
+
+template <typename Function>
+	static void Measure(std::string variant, size_t input_size, size_t output_size, Function function)
+{
+	/* repeat until the measurement is long enough to be meaningful */
+	unsigned repetitions = 0;
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed;
+	do
+	{
+		function();
+		repetitions++;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while(elapsed.count() < 0.5);
+	double seconds = elapsed.count() / repetitions;
+	std::cout << "w4_decompress\t" << variant << "\t" << input_size << "\t" << output_size << "\t" << seconds << "\t" << output_size / seconds / 1e6 << std::endl;
+}
+
+int main(int argc, char * argv[])
+{
+	W4Format w4;
+	std::shared_ptr<Linker::Buffer> expected;
+	if(argc > 1)
+	{
+		std::ifstream in(argv[1], std::ios_base::in | std::ios_base::binary);
+		if(!in.is_open())
+		{
+			std::cerr << "Unable to open " << argv[1] << std::endl;
+			return 1;
+		}
+		Linker::Reader rd(::LittleEndian, &in);
+		w4.ReadFile(rd);
+		expected = ReferenceDecompressW4(w4);
+	}
+	else
+	{
+		std::mt19937 random(0);
+		w4.chunk_size = 0x1000;
+		std::vector<uint8_t> plain;
+		for(unsigned i = 0; i < 1024; i++)
+		{
+			W4Format::Chunk chunk;
+			chunk.contents = std::make_shared<Linker::Buffer>(GenerateChunk(random, w4.chunk_size, plain));
+			chunk.length = chunk.contents->ImageSize();
+			w4.chunks.push_back(chunk);
+		}
+		expected = std::make_shared<Linker::Buffer>(plain);
+		if(!SameContents(*expected, *ReferenceDecompressW4(w4)))
+		{
+			std::cerr << "Synthetic image does not decompress to the generated contents" << std::endl;
+			return 1;
+		}
+	}
+
+	size_t input_size = 0;
+	for(auto& chunk : w4.chunks)
+		input_size += chunk.contents->ImageSize();
+	size_t output_size = size_t(w4.chunk_size) * w4.chunks.size();
+
+	if(!SameContents(*expected, *w4.DecompressW4(1)) || !SameContents(*expected, *w4.DecompressW4()))
+	{
+		std::cerr << "Decompressed image differs from reference implementation" << std::endl;
+		return 1;
+	}
+
+	Measure("reference", input_size, output_size, [&]() { ReferenceDecompressW4(w4); });
+	Measure("single_thread", input_size, output_size, [&]() { w4.DecompressW4(1); });
+	Measure("parallel", input_size, output_size, [&]() { w4.DecompressW4(); });
+
+	return 0;
+}
@@ -1,5 +1,6 @@
 
 #include <bit>
+#include <filesystem>
 #include "common.h"
 
 size_t GetOffset(EndianType endiantype, size_t bytes, size_t index)
@@ -268,9 +269,9 @@ bool ends_with(std::string str, std::string end)
 	return str.size() >= end.size() && str.substr(str.size() - end.size()) == end;
 }
 
-std::ostream Linker::Debug(std::cerr.rdbuf());
-std::ostream Linker::Warning(std::cerr.rdbuf());
-std::ostream Linker::Error(std::cerr.rdbuf());
+thread_local std::ostream Linker::Debug(std::cerr.rdbuf());
+thread_local std::ostream Linker::Warning(std::cerr.rdbuf());
+thread_local std::ostream Linker::Error(std::cerr.rdbuf());
 
 [[noreturn]] void Linker::FatalError(std::string message)
 {
@@ -278,3 +279,22 @@ std::ostream Linker::Error(std::cerr.rdbuf());
 	throw Linker::Exception(message);
 }
 
+thread_local std::string Linker::base_directory;
+
+std::string Linker::ResolvePath(std::string file_name)
+{
+	if(base_directory == "" || file_name == "" || std::filesystem::path(file_name).is_absolute())
+		return file_name;
+	return (std::filesystem::path(base_directory) / file_name).string();
+}
+
+uint64_t Linker::Hash(const void * data, size_t size, uint64_t hash)
+{
+	const uint8_t * bytes = reinterpret_cast<const uint8_t *>(data);
+	for(size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x00000100000001B3;
+	}
+	return hash;
+}
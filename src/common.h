@@ -168,12 +168,25 @@ namespace Linker
 	};
 
 	/* TODO: implement these properly */
-	extern std::ostream Debug;
-	extern std::ostream Warning;
-	extern std::ostream Error;
+	/* each thread has its own streams, so that diagnostics can be redirected per thread */
+	extern thread_local std::ostream Debug;
+	extern thread_local std::ostream Warning;
+	extern thread_local std::ostream Error;
 
 	[[noreturn]] void FatalError(std::string message);
 
+	/** @brief Directory that relative file names are resolved against, the working directory of the process if empty
+	 *
+	 * A LinkServer sets it to the directory of the client for the duration of each job, instead of changing the working directory of the whole process.
+	 */
+	extern thread_local std::string base_directory;
+
+	/** @brief Returns the path under which a file name given on the command line is to be accessed, see base_directory */
+	std::string ResolvePath(std::string file_name);
+
+	/** @brief Calculates a 64-bit FNV-1a hash, which can be continued by passing the previous result as hash */
+	uint64_t Hash(const void * data, size_t size, uint64_t hash = 0xCBF29CE484222325);
+
 	class Section;
 	class Location;
 	typedef std::map<std::shared_ptr<Section>, Location> Displacement;
@@ -1,10 +1,18 @@
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "common.h"
 #include "formats.h"
@@ -16,9 +24,12 @@ using namespace Linker;
 
 void usage(char * argv0)
 {
-	std::cerr << "Usage: " << argv0 << "[options] <input file>" << std::endl;
+	std::cerr << "Usage: " << argv0 << "[options] <input file or directory>..." << std::endl;
 	std::cerr << "\t-h" << std::endl << "\t\tDisplay this help page" << std::endl;
 	std::cerr << "\t-F<format>" << std::endl << "\t\tSelect output format" << std::endl;
+	std::cerr << "\t--identify" << std::endl << "\t\tOnly display the possible formats of each file, without parsing them" << std::endl;
+	std::cerr << "\t-s" << std::endl << "\t\tSummary only, do not display the contents of blocks" << std::endl;
+	std::cerr << "\t-j<count>" << std::endl << "\t\tNumber of files processed in parallel when several files or directories are given" << std::endl;
 
 	std::cerr << "List of supported formats:" << std::endl;
 	format_specification * last = nullptr;
@@ -42,52 +53,16 @@ void usage(char * argv0)
 }
 
 /**
- * @brief The main entry to the dumper
+ * @brief Reads a single file and displays its contents
+ *
+ * @param input Name of the file
+ * @param format_name The format requested on the command line, or empty if it should be determined from the file contents
+ * @param summary_only Set to skip displaying the contents of blocks
+ * @param out The stream to display the contents to
+ * @return The exit status, nonzero if the file could not be processed
  */
-int main(int argc, char * argv[])
+static int DumpFile(std::string input, std::string format_name, bool summary_only, std::ostream& out)
 {
-	std::string input = "";
-	std::shared_ptr<Format> format = nullptr;
-
-	for(int i = 1; i < argc; i++)
-	{
-		if(argv[i][0] == '-')
-		{
-			if(argv[i][1] == 'h')
-			{
-				usage(argv[0]);
-				exit(0);
-			}
-			else if(argv[i][1] == 'F')
-			{
-				/* TODO: FetchFormat with another table for input formats, enable setting system type */
-				format = FetchFormat(argv[i][2] ? &argv[i][2] : argv[++i]);
-				/* TODO: enable selecting a format within the determined formats, or force parsing a format at a specified address */
-			}
-			/* TODO: select text encoding */
-			else
-			{
-				std::ostringstream message;
-				message << "Fatal error: Unknown option `" << argv[i] << "'";
-				Linker::FatalError(message.str());
-			}
-		}
-		else
-		{
-			if(input != "")
-			{
-				Linker::Error << "Error: Multiple input files provided, ignoring" << std::endl;
-			}
-			input = argv[i];
-		}
-	}
-
-	if(input == "")
-	{
-		usage(argv[0]);
-		exit(0);
-	}
-
 	std::ifstream in;
 	in.open(input, std::ios_base::in | std::ios_base::binary);
 	if(!in.is_open())
@@ -99,7 +74,7 @@ int main(int argc, char * argv[])
 	Reader rd (LittleEndian, &in);
 	int status = 0;
 
-	if(format == nullptr)
+	if(format_name == "")
 	{
 		std::vector<format_description> file_formats;
 		DetermineFormat(file_formats, rd);
@@ -123,7 +98,7 @@ int main(int argc, char * argv[])
 				continue;
 
 			Linker::Debug << "Debug: Reading as " << file_format.magic.description << std::endl;
-			format = CreateFormat(rd, file_format);
+			std::shared_ptr<Format> format = CreateFormat(rd, file_format);
 			if(!format)
 			{
 				Linker::Error << "Error: Unable to parse file, unimplemented format " << file_format.magic.description << std::endl;
@@ -135,7 +110,8 @@ int main(int argc, char * argv[])
 			try
 			{
 				format->ReadFile(rd);
-				Dumper::Dumper dump(std::cout);
+				Dumper::Dumper dump(out);
+				dump.display_contents = !summary_only;
 				format->Dump(dump);
 			}
 			catch(Linker::Exception&)
@@ -153,11 +129,265 @@ int main(int argc, char * argv[])
 	}
 	else
 	{
+		std::shared_ptr<Format> format = FetchFormat(format_name);
 		format->ReadFile(rd);
-		Dumper::Dumper dump(std::cout);
+		Dumper::Dumper dump(out);
+		dump.display_contents = !summary_only;
 		format->Dump(dump);
 	}
 
 	return status;
 }
 
+/**
+ * @brief Displays the formats a file may be in, without parsing it
+ *
+ * @param input Name of the file
+ * @param out The stream to display the formats to, a single line is displayed
+ * @return The exit status, nonzero if the file could not be opened or it is in an unknown format
+ */
+static int IdentifyFile(std::string input, std::ostream& out)
+{
+	std::ifstream in;
+	in.open(input, std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+	{
+		Linker::Error << "Error: Unable to open file " << input << std::endl;
+		return 1;
+	}
+	Reader rd (LittleEndian, &in);
+
+	std::vector<format_description> file_formats;
+	DetermineFormat(file_formats, rd);
+
+	out << input << ": ";
+	if(file_formats.size() == 0)
+	{
+		out << "unknown format" << std::endl;
+		return 1;
+	}
+
+	bool first = true;
+	for(auto& file_format : file_formats)
+	{
+		if(!first)
+			out << "; ";
+		first = false;
+		out << file_format.magic.description;
+		if(file_format.offset != 0)
+			out << " at offset 0x" << std::hex << file_format.offset << std::dec;
+		if(file_format.magic.priority == PRIORITY_LOW)
+			out << " (unlikely)";
+	}
+	out << std::endl;
+	return 0;
+}
+
+/**
+ * @brief A single file processed in batch mode
+ */
+struct DumpJob
+{
+	std::string input;
+	/** @brief The rendered dump, emitted once all preceding files have been emitted */
+	std::ostringstream output;
+	/** @brief Messages issued while processing the file */
+	std::ostringstream diagnostics;
+	int status = 0;
+	bool done = false;
+};
+
+/**
+ * @brief Processes several files on a pool of worker threads, the results are displayed in input order
+ */
+static int DumpFiles(const std::vector<std::string>& inputs, std::string format_name, bool summary_only, bool identify_only, unsigned thread_count)
+{
+	std::vector<std::unique_ptr<DumpJob>> jobs;
+	for(auto& input : inputs)
+	{
+		jobs.push_back(std::make_unique<DumpJob>());
+		jobs.back()->input = input;
+	}
+
+	std::mutex mutex;
+	std::condition_variable job_done;
+	std::atomic<size_t> next_job = 0;
+
+	auto worker = [&]()
+	{
+		size_t index;
+		while((index = next_job++) < jobs.size())
+		{
+			DumpJob& job = *jobs[index];
+			Linker::Debug.rdbuf(job.diagnostics.rdbuf());
+			Linker::Warning.rdbuf(job.diagnostics.rdbuf());
+			Linker::Error.rdbuf(job.diagnostics.rdbuf());
+			try
+			{
+				if(identify_only)
+					job.status = IdentifyFile(job.input, job.output);
+				else
+					job.status = DumpFile(job.input, format_name, summary_only, job.output);
+			}
+			catch(Linker::Exception&)
+			{
+				/* the message has already been issued */
+				job.status = 1;
+			}
+			catch(std::exception& e)
+			{
+				Linker::Error << "Error: " << job.input << ": " << e.what() << std::endl;
+				job.status = 1;
+			}
+			catch(...)
+			{
+				Linker::Error << "Error: " << job.input << ": unknown failure" << std::endl;
+				job.status = 1;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			job.done = true;
+			job_done.notify_all();
+		}
+	};
+
+	thread_count = std::max(1u, std::min(thread_count, unsigned(jobs.size())));
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < thread_count; i++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	int status = 0;
+	for(auto& job : jobs)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_done.wait(lock, [&job]() { return job->done; });
+		}
+		std::cerr << job->diagnostics.str();
+		if(!identify_only)
+			std::cout << "==> " << job->input << " <==" << std::endl;
+		std::cout << job->output.str();
+		if(job->status != 0)
+			status = job->status;
+		/* release the buffers as soon as possible */
+		job = nullptr;
+	}
+
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return status;
+}
+
+/**
+ * @brief Adds an input, directories are searched recursively in a deterministic order
+ */
+static void AddInput(std::vector<std::string>& inputs, std::string input)
+{
+	std::error_code error;
+	if(!std::filesystem::is_directory(input, error))
+	{
+		inputs.push_back(input);
+		return;
+	}
+
+	std::vector<std::string> files;
+	for(auto& entry : std::filesystem::recursive_directory_iterator(input, error))
+	{
+		if(entry.is_regular_file(error))
+			files.push_back(entry.path().string());
+	}
+	if(error)
+	{
+		Linker::Error << "Error: Unable to read directory " << input << ": " << error.message() << std::endl;
+	}
+	std::sort(files.begin(), files.end());
+	inputs.insert(inputs.end(), files.begin(), files.end());
+}
+
+/**
+ * @brief The main entry to the dumper
+ */
+int main(int argc, char * argv[])
+{
+	std::vector<std::string> inputs;
+	bool batch_mode = false;
+	std::string format_name = "";
+	bool summary_only = false;
+	bool identify_only = false;
+	unsigned thread_count = std::thread::hardware_concurrency();
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(argv[i][0] == '-')
+		{
+			if(strcmp(argv[i], "--identify") == 0)
+			{
+				identify_only = true;
+			}
+			else if(argv[i][1] == 'h')
+			{
+				usage(argv[0]);
+				exit(0);
+			}
+			else if(argv[i][1] == 'F')
+			{
+				/* TODO: FetchFormat with another table for input formats, enable setting system type */
+				format_name = argv[i][2] ? &argv[i][2] : argv[++i];
+				FetchFormat(format_name); // reports unknown formats, a new instance is created for each file
+				/* TODO: enable selecting a format within the determined formats, or force parsing a format at a specified address */
+			}
+			else if(argv[i][1] == 's')
+			{
+				summary_only = true;
+			}
+			else if(argv[i][1] == 'j')
+			{
+				try
+				{
+					thread_count = std::stoul(argv[i][2] ? &argv[i][2] : argv[++i]);
+				}
+				catch(std::logic_error&)
+				{
+					Linker::FatalError("Fatal error: Invalid job count");
+				}
+			}
+			/* TODO: select text encoding */
+			else
+			{
+				std::ostringstream message;
+				message << "Fatal error: Unknown option `" << argv[i] << "'";
+				Linker::FatalError(message.str());
+			}
+		}
+		else
+		{
+			if(inputs.size() != 0 || std::filesystem::is_directory(argv[i]))
+				batch_mode = true;
+			AddInput(inputs, argv[i]);
+		}
+	}
+
+	if(inputs.size() == 0)
+	{
+		if(!batch_mode)
+			usage(argv[0]);
+		exit(0);
+	}
+
+	if(batch_mode)
+	{
+		return DumpFiles(inputs, format_name, summary_only, identify_only, thread_count);
+	}
+	else if(identify_only)
+	{
+		return IdentifyFile(inputs[0], std::cout);
+	}
+	else
+	{
+		return DumpFile(inputs[0], format_name, summary_only, std::cout);
+	}
+}
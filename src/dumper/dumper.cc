@@ -290,10 +290,47 @@ void Entry::Display(Dumper& dump)
 	dump.out << std::endl;
 }
 
+static const char hex_digits[] = "0123456789abcdef";
+
+/** @brief Appends a hexadecimal value to a line, formatted the same way as Dumper::PrintHex without a prefix */
+static void AppendHex(std::string& line, offset_t value, unsigned width)
+{
+	char digits[2 * sizeof(offset_t)];
+	unsigned count = 0;
+	do
+	{
+		digits[count++] = hex_digits[value & 0xF];
+		value >>= 4;
+	} while(value != 0);
+	if(count < width)
+		line.append(width - count, '0');
+	while(count > 0)
+		line += digits[--count];
+}
+
+/** @brief Collects the signals between first and first + count - 1 (modulo the offset range) into a bit mask */
+static uint32_t SignalMask(const std::set<offset_t>& signals, offset_t first, unsigned count)
+{
+	uint32_t mask = 0;
+	for(auto it = signals.lower_bound(first); it != signals.end() && *it - first < count; ++it)
+	{
+		mask |= uint32_t(1) << (*it - first);
+	}
+	if(first + count < first)
+	{
+		/* the range wraps around */
+		for(auto it = signals.begin(); it != signals.end() && *it < first + count; ++it)
+		{
+			mask |= uint32_t(1) << (*it - first);
+		}
+	}
+	return mask;
+}
+
 void Block::Display(Dumper& dump)
 {
 	Region::Display(dump);
-	if(!image || image->ImageSize() == 0)
+	if(!dump.display_contents || !image || image->ImageSize() == 0)
 		return;
 	size_t block_offset = GetField<offset_t>("Offset", 0);
 	size_t block_address = GetField<offset_t>("Address", 0);
@@ -324,128 +361,143 @@ void Block::Display(Dumper& dump)
 	}
 	dump.out << "\tDATA" << std::endl;
 
+	/* rows are formatted into a line buffer, the characters of the current encoding are converted once */
+	std::string characters[256];
+	for(unsigned byte = 0; dump.encoding != nullptr && byte < 256; byte++)
+	{
+		characters[byte] = Dumper::EncodeChar((*dump.encoding)[byte]);
+	}
+	const char * underline_start = dump.use_ansi ? "\33[4m" : "";
+	const char * underline_end = dump.use_ansi ? "\33[m" : "";
+
+	std::string line;
 	for(size_t off = 0; off < (image_offset & 0xF) + image->ImageSize(); off += 16)
 	{
 		size_t address = block_address - image_offset + off;
+		/* offset of the first byte of the row within the image, wraps around on the first row if the block is not aligned */
+		offset_t row_offset = off - image_offset;
 		bool current_underlined = false;
+
+		line.clear();
 		if(block_offset != 0)
 		{
-			dump.out << "[";
+			line += '[';
 			/* display the start of the block on the first line, but the start of the line on following lines */
-			dump.PrintHex(off == 0 ? block_offset : block_offset - image_offset + off, offset_display_width, "");
-			dump.out << "]\t";
+			AppendHex(line, off == 0 ? block_offset : block_offset - image_offset + off, offset_display_width);
+			line += "]\t";
 		}
 		if(block_address != 0)
 		{
-			dump.out << "(";
-			dump.PrintHex(off == 0 ? 0 : off - image_offset, position_display_width, "");
-			dump.out << ")\t";
+			line += '(';
+			AppendHex(line, off == 0 ? 0 : off - image_offset, position_display_width);
+			line += ")\t";
 		}
-		dump.PrintHex(off == 0 ? block_address : address, address_display_width, "");
-		dump.out << "\t";
+		AppendHex(line, off == 0 ? block_address : address, address_display_width);
+		line += '\t';
 		if(last_underlined)
-			dump.BeginUnderline();
+			line += underline_start;
 
+		/* fetch the row with a single read, bytes outside the image are not displayed */
+		uint8_t bytes[16] = { };
+		uint16_t present = 0;
+		int first = -1, last = -1;
 		for(int i = 0; i < 16; i++)
 		{
+			if(block_address <= address + i && row_offset + i < image->ImageSize())
+			{
+				present |= 1 << i;
+				if(first == -1)
+					first = i;
+				last = i;
+			}
+		}
+		if(first != -1)
+		{
+			image->ReadData(last + 1 - first, row_offset + first, bytes + first);
+		}
+
+		/* bit i of starts marks a signal starting at row_offset + i, bit i of ends marks a signal ending at row_offset + i - 1 */
+		uint32_t starts = SignalMask(signal_starts, row_offset, 16);
+		uint32_t ends = SignalMask(signal_ends, row_offset - 1, 17);
+
+		for(int i = 0; i < 16; i++)
+		{
+			bool starts_here = (starts >> i) & 1;
+			bool ends_before = (ends >> i) & 1;
 			if(dump.use_ansi)
 			{
 				if(i == 8)
-					dump.out << "   ";
+					line += "   ";
 				else if(i != 0)
-					dump.out << " ";
+					line += ' ';
+			}
+			else if(i == 8)
+			{
+				line += ends_before ? ']' : ' ';
+				line += ' ';
+				line += starts_here ? '[' : ' ';
 			}
 			else
 			{
-				if(i == 8)
-				{
-					if(signal_ends.find(off - image_offset + i - 1) == signal_ends.end())
-						dump.out << " ";
-					else
-						dump.out << "]";
-					dump.out << " ";
-					if(signal_starts.find(off - image_offset + i) == signal_starts.end())
-						dump.out << " ";
-					else
-						dump.out << "[";
-				}
-				else
-				{
-					if(signal_ends.find(off - image_offset + i - 1) == signal_ends.end())
-					{
-						if(signal_starts.find(off - image_offset + i) == signal_starts.end())
-							dump.out << " ";
-						else
-							dump.out << "[";
-					}
-					else
-					{
-						if(signal_starts.find(off - image_offset + i) == signal_starts.end())
-							dump.out << "]";
-						else
-							dump.out << "I";
-					}
-				}
+				line += ends_before ? (starts_here ? 'I' : ']') : (starts_here ? '[' : ' ');
 			}
 
-			if(signal_starts.find(off - image_offset + i) != signal_starts.end())
+			if(starts_here)
 			{
-				dump.BeginUnderline();
+				line += underline_start;
 				current_underlined = true;
 			}
-			int byte;
-			if(block_address <= address + i
-			&& off - image_offset + i < image->ImageSize()
-			&& ((byte = image->GetByte(off - image_offset + i)) != -1))
+			if((present >> i) & 1)
 			{
-				dump.PrintHex(byte, 2, "");
+				line += hex_digits[bytes[i] >> 4];
+				line += hex_digits[bytes[i] & 0xF];
 			}
 			else
 			{
-				dump.out << "  ";
+				line += "  ";
 			}
-			if(signal_ends.find(off - image_offset + i) != signal_ends.end())
+			if((ends >> (i + 1)) & 1)
 			{
-				dump.EndUnderline();
+				line += underline_end;
 				current_underlined = false;
 			}
 		}
 		if(current_underlined)
-			dump.EndUnderline();
-		dump.out << "\t";
+			line += underline_end;
+		line += '\t';
 		if(last_underlined)
-			dump.BeginUnderline();
+			line += underline_start;
 		for(int i = 0; i < 16; i++)
 		{
-			int byte;
 			if(i == 8)
-				dump.out << " ";
-			if(signal_starts.find(off - image_offset + i) != signal_starts.end())
+				line += ' ';
+			if((starts >> i) & 1)
 			{
-				dump.BeginUnderline();
+				line += underline_start;
 				current_underlined = true;
 			}
-			if(block_address <= address + i
-			&& off - image_offset + i < image->ImageSize()
-			&& ((byte = image->GetByte(off - image_offset + i)) != -1))
+			if((present >> i) & 1)
 			{
-				dump.PutChar((*dump.encoding)[byte]);
+				line += characters[bytes[i]];
 			}
 			else
 			{
-				dump.PutChar(' ');
+				line += ' ';
 			}
-			if(signal_ends.find(off - image_offset + i) != signal_ends.end())
+			if((ends >> (i + 1)) & 1)
 			{
-				dump.EndUnderline();
+				line += underline_end;
 				current_underlined = false;
 			}
 		}
 		if(current_underlined)
-			dump.EndUnderline();
-		dump.out << std::endl;
+			line += underline_end;
+		line += '\n';
+		dump.out << line;
 		last_underlined = current_underlined;
 	}
+	/* leave the stream in the state PrintHex would */
+	dump.out << std::hex << std::setfill('0') << std::flush;
 }
 
 // based on Wikipedia
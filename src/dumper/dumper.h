@@ -774,6 +774,8 @@ class Dumper
 public:
 	std::ostream& out;
 	bool use_ansi;
+	/** @brief When cleared, blocks only display their fields and not their contents */
+	bool display_contents = true;
 
 	SingleByteEncoding * encoding;
 	Encoding * string_encoding;
@@ -852,9 +854,9 @@ public:
 #endif
 
 	/**
-	 * @brief Displays a Unicode character as a UTF-8 byte sequence
+	 * @brief Converts a Unicode character to the byte sequence displayed by PutChar
 	 */
-	void PutChar(char32_t c)
+	static std::string EncodeChar(char32_t c)
 	{
 		/* TODO: this should depend on the current locale */
 		const char32_t * input = &c;
@@ -864,7 +866,15 @@ public:
 		std::vector<char> buffer(size);
 		output = buffer.data();
 		UTF32ToUTF8(input, output, size, size);
-		out << std::string(buffer.data(), buffer.size());
+		return std::string(buffer.data(), buffer.size());
+	}
+
+	/**
+	 * @brief Displays a Unicode character as a UTF-8 byte sequence
+	 */
+	void PutChar(char32_t c)
+	{
+		out << EncodeChar(c);
 	}
 
 	void PutEncodedString(std::string encoded_string, bool terminate_at_null = false)
@@ -1,4 +1,5 @@
 
+#include <bit>
 #include <filesystem>
 #include <sstream>
 #include "8bitexe.h"
@@ -311,7 +312,7 @@ void CPM3Format::rsx_record::OpenAndPrepare()
 	if(rsx_file_name != "")
 	{
 		std::ifstream rsx_file;
-		rsx_file.open(rsx_file_name, std::ios_base::in | std::ios_base::binary);
+		rsx_file.open(Linker::ResolvePath(rsx_file_name), std::ios_base::in | std::ios_base::binary);
 		if(rsx_file.is_open())
 		{
 			Linker::Reader rd(::LittleEndian, &rsx_file);
@@ -612,6 +613,36 @@ void PRLFormat::OnNewSegment(std::shared_ptr<Linker::Segment> segment)
 	}
 }
 
+void PRLFormat::AddRelocation(uint16_t offset)
+{
+	if(size_t(offset >> 3) >= relocation_bitmap.size())
+	{
+		relocation_bitmap.resize((offset >> 3) + 1);
+	}
+	relocation_bitmap[offset >> 3] |= 0x80 >> (offset & 7);
+}
+
+bool PRLFormat::HasRelocation(uint16_t offset) const
+{
+	return size_t(offset >> 3) < relocation_bitmap.size() && (relocation_bitmap[offset >> 3] & (0x80 >> (offset & 7))) != 0;
+}
+
+std::vector<uint16_t> PRLFormat::GetRelocations() const
+{
+	std::vector<uint16_t> relocations;
+	for(size_t index = 0; index < relocation_bitmap.size(); index++)
+	{
+		/* most bytes of the bitmap are empty */
+		for(uint8_t reloc_byte = relocation_bitmap[index]; reloc_byte != 0; )
+		{
+			int bit = std::countl_zero(reloc_byte);
+			relocations.push_back((index << 3) | bit);
+			reloc_byte &= ~(0x80 >> bit);
+		}
+	}
+	return relocations;
+}
+
 bool PRLFormat::ProcessRelocation(Linker::Module& module, Linker::Relocation& rel, Linker::Resolution resolution)
 {
 	rel.WriteWord(resolution.value);
@@ -622,7 +653,7 @@ bool PRLFormat::ProcessRelocation(Linker::Module& module, Linker::Relocation& re
 			Linker::Debug << "Debug: PRL relocation: " << rel << " at " <<
 				rel.source.GetPosition().GetSegmentOffset() + 1
 				<< std::endl;
-			relocations.insert(rel.source.GetPosition().GetSegmentOffset() + 1);
+			AddRelocation(rel.source.GetPosition().GetSegmentOffset() + 1);
 		}
 	}
 	return true;
@@ -667,22 +698,16 @@ void PRLFormat::ReadWithoutHeader(Linker::Reader& rd, uint16_t image_size)
 
 	image = Linker::Buffer::ReadFromFile(rd, image_size);
 
-	relocations.clear();
+	relocation_bitmap.clear();
 	Linker::Debug << "Debug: File end: " << end << ", expected end with relocations: " << (offset + image_size + ((image_size + 7) >> 3)) << std::endl;
 	if(end >= offset + image_size + ((image_size + 7) >> 3))
 	{
 		suppress_relocations = false;
-		for(uint16_t byte_offset = 0; byte_offset < image_size; byte_offset += 8)
+		rd.ReadData((image_size + 7) >> 3, relocation_bitmap);
+		if((image_size & 7) != 0)
 		{
-			uint8_t reloc_byte = rd.ReadUnsigned(1);
-			for(int byte = 7; byte >= 0; byte --)
-			{
-				if((reloc_byte & 1) != 0 && byte_offset + byte < image_size)
-				{
-					relocations.insert(byte_offset + byte);
-				}
-				reloc_byte >>= 1;
-			}
+			/* bits past the end of the image are ignored */
+			relocation_bitmap.back() &= 0xFF << (8 - (image_size & 7));
 		}
 	}
 	else
@@ -715,17 +740,11 @@ void PRLFormat::WriteWithoutHeader(Linker::Writer& wr) const
 	if(!suppress_relocations) /* suppress relocations only for OVL files */
 	{
 		Linker::Debug << "Debug: Writing relocations" << std::endl;
-		for(uint16_t offset = 0; offset < ::AlignTo(image->ImageSize(), 8); offset += 8)
+		size_t bitmap_size = (image->ImageSize() + 7) >> 3;
+		size_t written = wr.WriteData(bitmap_size, relocation_bitmap);
+		if(written < bitmap_size)
 		{
-			uint8_t reloc_byte = 0;
-			for(int byte = 0; byte < 8; byte ++)
-			{
-				if(relocations.find(offset + byte) != relocations.end())
-				{
-					reloc_byte |= 1 << (7 - byte);
-				}
-			}
-			wr.WriteWord(1, reloc_byte);
+			wr.WriteData(std::vector<uint8_t>(bitmap_size - written, 0));
 		}
 	}
 }
@@ -746,6 +765,7 @@ void PRLFormat::Dump(Dumper::Dumper& dump) const
 	Dumper::Block image_block("Image", 0x0100, image->AsImage(),
 		load_address != 0 ? load_address : application == APPL_SPR ? 0x0000 : 0x0100,
 		4);
+	std::vector<uint16_t> relocations = GetRelocations();
 	for(auto relocation : relocations)
 	{
 		image_block.AddSignal(relocation, 1);
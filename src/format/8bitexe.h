@@ -125,9 +125,9 @@ namespace Binary
 			 */
 			std::shared_ptr<Linker::Contents> image;
 			/**
-			 * @brief Relocations, only used for SDX_SYMREQ and SDX_FIXUPS
+			 * @brief Relocations, only used for SDX_SYMREQ and SDX_FIXUPS, kept sorted so that they can be stored as increasing distances
 			 */
-			std::set<uint16_t> relocations; // TODO: multiple blocks?
+			std::vector<uint16_t> relocations; // TODO: multiple blocks?
 
 			Segment(bool header_type_optional = true)
 				: header_type(ATARI_SEGMENT), header_type_optional(header_type_optional)
@@ -362,8 +362,20 @@ namespace Binary
 		/** @brief On a banked BIOS, align the data segment of the .SPR on a page boundary and store the length of the code segment in the header */
 		bool option_banked_bios = false; // TODO: make flag, implement behavior
 
-		/** @brief Offsets to bytes referencing pages that must be relocated */
-		std::set<uint16_t> relocations;
+		/**
+		 * @brief Relocation bitmap, one bit for every byte of the image that references a page that must be relocated
+		 *
+		 * It is kept in the layout it has in the file, the most significant bit of each byte corresponding to the lowest offset.
+		 * It may be shorter than the image, missing bytes are taken as 0.
+		 */
+		std::vector<uint8_t> relocation_bitmap;
+
+		/** @brief Marks a byte of the image as referencing a page that must be relocated */
+		void AddRelocation(uint16_t offset);
+		/** @brief Returns true if a byte of the image must be relocated */
+		bool HasRelocation(uint16_t offset) const;
+		/** @brief Retrieves the offsets of all bytes that must be relocated, in ascending order */
+		std::vector<uint16_t> GetRelocations() const;
 
 		/**
 		 * @brief The format of the generated binary
@@ -259,7 +259,7 @@ bool AOutFormat::CheckFileSizes(Linker::Reader& rd, offset_t image_size)
 			rd.Skip(word_size);
 			continue;
 		}
-		next_size = rd.ReadUnsigned(word_size);
+		next_size = rd.ReadUnsigned(word_size, endiantype);
 		if(i == 1 && next_size == 0)
 			return false; // empty text segment
 		if(full_size + next_size < full_size || full_size + next_size > image_size)
@@ -276,7 +276,7 @@ bool AOutFormat::CheckFileSizes(Linker::Reader& rd, offset_t image_size)
 	if(word_size == WordSize16)
 	{
 		rd.Seek(file_offset + 7 * word_size);
-		if(rd.ReadUnsigned(word_size) == 0)
+		if(rd.ReadUnsigned(word_size, endiantype) == 0)
 		{
 			// add relocations (same size as text + data)
 			if(full_size + load_size < full_size || full_size + load_size > image_size)
@@ -862,10 +862,21 @@ void AOutFormat::ReadFile(Linker::Reader& rd)
 				 * otherwise first attempt 32-bit little endian
 				 * finally attempt 32-bit big endian which is distinct enough from the other types on a byte-per-byte level
 				 * (unsure if 16-bit big endian was ever a thing)
+				 * a known 32-bit machine type in the upper half of the first word also makes a 32-bit file more likely
 				 */
+				bool prefer_16bit = file_offset == 0;
+				switch(signature[2] | (signature[3] << 8))
+				{
+				case MID_PC386:
+				case MID_BFD_ARM:
+				case MID_MIPS1:
+				case MID_MIPS2:
+					prefer_16bit = false;
+					break;
+				}
 				if(!AttemptReadFile(rd, signature.data(), file_end - file_offset,
-					file_offset == 0 ? read_attempt_type{WordSize16, ::PDP11Endian} : read_attempt_type{WordSize32, ::LittleEndian},
-					file_offset == 0 ? read_attempt_type{WordSize32, ::LittleEndian} : read_attempt_type{WordSize16, ::PDP11Endian},
+					prefer_16bit ? read_attempt_type{WordSize16, ::PDP11Endian} : read_attempt_type{WordSize32, ::LittleEndian},
+					prefer_16bit ? read_attempt_type{WordSize32, ::LittleEndian} : read_attempt_type{WordSize16, ::PDP11Endian},
 					read_attempt_type{WordSize32, ::BigEndian}))
 				{
 					Linker::FatalError("Fatal error: Unable to determine file format");
@@ -1250,7 +1261,7 @@ void AOutFormat::ReadFile(Linker::Reader& rd)
 		switch(symbol_format)
 		{
 		case SYMBOL_FORMAT_ATT:
-			for(size_t i = 0; i < symbol_table_size; i += 8)
+			for(size_t i = 0; i < symbol_table_size; i += 8 + std::min(4, int(word_size)) + word_size)
 			{
 				Symbol symbol;
 				symbol.name = rd.ReadASCIIZ(8);
@@ -1260,7 +1271,7 @@ void AOutFormat::ReadFile(Linker::Reader& rd)
 			}
 			break;
 		case SYMBOL_FORMAT_BSD:
-			for(size_t i = 0; i < symbol_table_size; i += 8)
+			for(size_t i = 0; i < symbol_table_size; i += std::max(4, int(word_size)) + std::min(4, int(word_size)) + word_size)
 			{
 				Symbol symbol;
 				symbol.name_offset = rd.ReadUnsigned(std::max(4, int(word_size))); // 32-bit or 64-bit
@@ -217,6 +217,11 @@ void ArchiveFormat::Dump(Dumper::Dumper& dump) const
 	}
 }
 
+void ArchiveFormat::SetupOptions(std::shared_ptr<Linker::OutputFormat> format)
+{
+	output_format = format;
+}
+
 void ArchiveFormat::GenerateModule(Linker::ModuleCollector& linker, std::string file_name, bool is_library) const
 {
 	//is_library = true;
@@ -227,6 +232,8 @@ void ArchiveFormat::GenerateModule(Linker::ModuleCollector& linker, std::string
 
 		if(const std::shared_ptr<Linker::InputFormat> input_format = std::dynamic_pointer_cast<Linker::InputFormat>(entry.contents))
 		{
+			if(auto format = output_format.lock())
+				input_format->SetupOptions(format);
 			input_format->GenerateModule(linker, file_name + ":" + entry.name, true);
 		}
 		else
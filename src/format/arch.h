@@ -60,11 +60,15 @@ namespace Archive
 
 		std::vector<File> files;
 
+		/** @brief The output format passed to SetupOptions, forwarded to the members when generating their modules */
+		std::weak_ptr<Linker::OutputFormat> output_format;
+
 		void ReadFile(Linker::Reader& rd) override;
 		using Linker::Format::WriteFile;
 		offset_t WriteFile(Linker::Writer& wr) const override;
 		offset_t ImageSize() const override;
 		void Dump(Dumper::Dumper& dump) const override;
+		void SetupOptions(std::shared_ptr<Linker::OutputFormat> format) override;
 		using Linker::InputFormat::GenerateModule;
 		void GenerateModule(Linker::ModuleCollector& linker, std::string file_name, bool is_library = false) const override;
 		void CalculateValues() override;
@@ -1504,7 +1504,8 @@ offset_t COFFFormat::FlexOSAOutHeader::CalculateValues(COFFFormat& coff)
 	AOutHeader::CalculateValues(coff);
 	relocations_offset = coff.relocations_offset;
 	stack_size = coff.stack->zero_fill;
-	return DigitalResearch::CPM68KFormat::CDOS68K_MeasureRelocations(coff.relocations);
+	crunched_relocations = DigitalResearch::CPM68KFormat::CDOS68K_CrunchRelocations(coff.relocations, 0);
+	return crunched_relocations.size();
 }
 
 void COFFFormat::FlexOSAOutHeader::PostReadFile(COFFFormat& coff, Linker::Reader& rd)
@@ -1512,7 +1513,7 @@ void COFFFormat::FlexOSAOutHeader::PostReadFile(COFFFormat& coff, Linker::Reader
 	if(coff.cpu_type == CPU_M68K)
 	{
 		rd.Seek(coff.file_offset + coff.relocations_offset);
-		DigitalResearch::CPM68KFormat::CDOS68K_ReadRelocations(rd, coff.relocations, coff);
+		DigitalResearch::CPM68KFormat::CDOS68K_ReadRelocations(rd, coff.relocations, coff, 0);
 	}
 }
 
@@ -1521,7 +1522,7 @@ void COFFFormat::FlexOSAOutHeader::PostWriteFile(const COFFFormat& coff, Linker:
 	if(coff.cpu_type == CPU_M68K)
 	{
 		wr.Seek(coff.file_offset + coff.relocations_offset);
-		DigitalResearch::CPM68KFormat::CDOS68K_WriteRelocations(wr, coff.relocations);
+		wr.WriteData(crunched_relocations);
 	}
 }
 
@@ -1405,6 +1405,10 @@ namespace COFF
 			 * @brief Size of stack for execution
 			 */
 			uint32_t stack_size = 0;
+			/**
+			 * @brief The crunched relocation data, filled in by CalculateValues
+			 */
+			std::vector<uint8_t> crunched_relocations;
 
 			/* TODO: magic not needed for CDOS68K? */
 
@@ -18,9 +18,9 @@ CPM68KFormat::Relocation CPM68KFormat::Relocation::Create(size_t size, uint32_t
 	uint32_t value;
 
 	if(offset < format.data_address)
-		value = format.CodeSegment()->ReadUnsigned(size, offset, ::BigEndian);
+		value = format.code->AsImage()->ReadUnsigned(size, offset - format.code_address, ::BigEndian);
 	else
-		value = format.DataSegment()->ReadUnsigned(size, offset, ::BigEndian);
+		value = format.data->AsImage()->ReadUnsigned(size, offset - format.data_address, ::BigEndian);
 
 	if(value < format.data_address)
 		return Relocation{size, 2};
@@ -85,6 +85,7 @@ void CPM68KFormat::Clear()
 	code = nullptr;
 	data = nullptr;
 	relocations.clear();
+	crunched_relocations.clear();
 	/* writer fields */
 	bss_segment = nullptr;
 	stack_segment = nullptr;
@@ -101,7 +102,7 @@ void CPM68KFormat::ReadFile(Linker::Reader& rd)
 	bss_size = rd.ReadUnsigned(4);
 	symbol_table_size = rd.ReadUnsigned(4);
 	stack_size = rd.ReadUnsigned(4);
-	if(system == SYSTEM_UNKNOWN && stack_size != 0)
+	if(system == SYSTEM_UNKNOWN && (stack_size != 0 || GetSignature() == MAGIC_CRUNCHED))
 	{
 		system = SYSTEM_CDOS68K;
 	}
@@ -227,7 +228,7 @@ void CPM68KFormat::ReadFile(Linker::Reader& rd)
 		if(GetSignature() == MAGIC_CRUNCHED)
 		{
 			/* relocations must be present */
-			CDOS68K_ReadRelocations(rd, relocations, *this);
+			CDOS68K_ReadRelocations(rd, relocations, *this, code_address);
 			break;
 		}
 	case SYSTEM_CPM68K:
@@ -306,7 +307,10 @@ offset_t CPM68KFormat::MeasureRelocations() const
 	switch(system)
 	{
 	case SYSTEM_CDOS68K:
-		return CDOS68K_MeasureRelocations(relocations);
+		if(GetSignature() == MAGIC_CRUNCHED)
+		{
+			return crunched_relocations.size();
+		}
 	case SYSTEM_CPM68K:
 		return code->ImageSize() + data->ImageSize();
 	case SYSTEM_GEMDOS:
@@ -384,7 +388,7 @@ offset_t CPM68KFormat::WriteFile(Linker::Writer& wr) const
 		if(GetSignature() == MAGIC_CRUNCHED)
 		{
 			/* relocations must be present */
-			CDOS68K_WriteRelocations(wr, relocations);
+			wr.WriteData(crunched_relocations);
 			break;
 		}
 	case SYSTEM_CPM68K:
@@ -628,6 +632,12 @@ void CPM68KFormat::CalculateValues()
 		relocations_suppressed = 0;
 	}
 
+	if(system == SYSTEM_CDOS68K && GetSignature() == MAGIC_CRUNCHED)
+	{
+		crunched_relocations = CDOS68K_CrunchRelocations(relocations, code_address);
+		Linker::Debug << "Debug: " << relocations.size() << " relocations crunched into " << crunched_relocations.size() << " bytes" << std::endl;
+	}
+
 	offset_t actual_file_size = (GetSignature() == MAGIC_NONCONTIGUOUS ? 36 : 28) + code->ImageSize() + data->ImageSize() + MeasureRelocations();
 	if(file_size == offset_t(-1) || file_size < actual_file_size)
 	{
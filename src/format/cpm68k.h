@@ -4,6 +4,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 #include "../common.h"
 #include "../linker/module.h"
 #include "../linker/options.h"
@@ -127,6 +128,10 @@ namespace DigitalResearch
 		 * @brief Relocations, not used for Human68k
 		 */
 		std::map<uint32_t, Relocation> relocations;
+		/**
+		 * @brief Relocations encoded in the crunched format, filled in by CalculateValues for Concurrent DOS 68K files with crunched relocations
+		 */
+		std::vector<uint8_t> crunched_relocations;
 
 		struct Symbol
 		{
@@ -207,73 +212,63 @@ namespace DigitalResearch
 
 		void ReadFile(Linker::Reader& rd) override;
 
+		/**
+		 * @brief Encodes relocations in the crunched format of Concurrent DOS 68K
+		 *
+		 * Each relocation is stored as its distance from the previous one, in a single byte up to 0x7C, otherwise as a byte, word or longword following the escape values 0x7D, 0x7E or 0x7F.
+		 * The top bit of the first byte is set for word relocations, and the stream ends with a 0 byte.
+		 *
+		 * @param relocations Relocations, mapping each address to its size, iterated in ascending order
+		 * @param base_address The address the first distance is counted from, the start of the code segment
+		 */
 		template <typename SizeType>
-			static offset_t CDOS68K_MeasureRelocations(std::map<uint32_t, SizeType> relocations)
-		{
-			/* TODO: test */
-			offset_t count = 0;
-			offset_t last_relocation = 0;
-			for(auto it : relocations)
-			{
-				offset_t difference = it.first - last_relocation;
-				if(difference != 0 && difference <= 0x7C)
-				{
-					count += 1;
-				}
-				else if(difference < 0x100)
-				{
-					count += 2;
-				}
-				else if(difference < 0x10000)
-				{
-					count += 3;
-				}
-				else
-				{
-					count += 5;
-				}
-			}
-			return count;
-		}
-
-		template <typename SizeType>
-			static void CDOS68K_WriteRelocations(Linker::Writer& wr, std::map<uint32_t, SizeType> relocations)
+			static std::vector<uint8_t> CDOS68K_CrunchRelocations(const std::map<uint32_t, SizeType>& relocations, uint32_t base_address)
 		{
-			/* TODO: test */
-			offset_t last_relocation = 0;
-			for(auto it : relocations)
+			std::vector<uint8_t> stream;
+			stream.reserve(relocations.size() + 1);
+			uint32_t last_relocation = base_address;
+			for(auto& it : relocations)
 			{
-				offset_t difference = it.first - last_relocation;
-				uint8_t highbit = it.second/*.size*/ == 2 ? 0x80 : 0x00;
+				uint32_t difference = it.first - last_relocation;
+				uint8_t highbit = size_t(it.second) == 2 ? 0x80 : 0x00;
 				if(difference != 0 && difference <= 0x7C)
 				{
-					wr.WriteWord(1, highbit | difference);
+					stream.push_back(highbit | difference);
 				}
 				else if(difference < 0x100)
 				{
-					wr.WriteWord(1, highbit | 0x7D);
-					wr.WriteWord(1, difference);
+					stream.push_back(highbit | 0x7D);
+					stream.push_back(difference);
 				}
 				else if(difference < 0x10000)
 				{
-					wr.WriteWord(1, highbit | 0x7E);
-					wr.WriteWord(2, difference);
+					stream.push_back(highbit | 0x7E);
+					stream.push_back(difference >> 8);
+					stream.push_back(difference);
 				}
 				else
 				{
-					wr.WriteWord(1, highbit | 0x7F);
-					wr.WriteWord(4, difference);
+					stream.push_back(highbit | 0x7F);
+					stream.push_back(difference >> 24);
+					stream.push_back(difference >> 16);
+					stream.push_back(difference >> 8);
+					stream.push_back(difference);
 				}
 				last_relocation = it.first;
 			}
-			wr.WriteWord(1, 0);
+			stream.push_back(0);
+			return stream;
 		}
 
+		/**
+		 * @brief Decodes relocations stored in the crunched format of Concurrent DOS 68K
+		 *
+		 * @param base_address The address the first distance is counted from, the start of the code segment
+		 */
 		template <typename SizeType, typename Format>
-			static void CDOS68K_ReadRelocations(Linker::Reader& rd, std::map<uint32_t, SizeType> relocations, const Format& format)
+			static void CDOS68K_ReadRelocations(Linker::Reader& rd, std::map<uint32_t, SizeType>& relocations, const Format& format, uint32_t base_address)
 		{
-			/* TODO: test */
-			offset_t offset = 0;
+			uint32_t address = base_address;
 			while(true)
 			{
 				uint8_t byte = rd.ReadUnsigned(1);
@@ -285,21 +280,21 @@ namespace DigitalResearch
 				}
 				else if(byte <= 0x7C)
 				{
-					offset += byte;
+					address += byte;
 				}
 				else if(byte == 0x7D)
 				{
-					offset += rd.ReadUnsigned(1);
+					address += rd.ReadUnsigned(1);
 				}
 				else if(byte == 0x7E)
 				{
-					offset += rd.ReadUnsigned(2);
+					address += rd.ReadUnsigned(2);
 				}
 				else /*if(byte == 0x7F)*/
 				{
-					offset += rd.ReadUnsigned(4);
+					address += rd.ReadUnsigned(4);
 				}
-				relocations[offset] = SizeType::Create(size, offset, format);
+				relocations[address] = SizeType::Create(size, address, format);
 			}
 		}
 
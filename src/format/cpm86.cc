@@ -1782,21 +1782,36 @@ void CPM86Format::Link(Linker::Module& module)
 
 void CPM86Format::BuildLDTImage(Linker::Module& module)
 {
-	std::array<std::set<uint32_t>, 8> segment_boundaries;
+	// every relocation is resolved once, then processed from the bucket it belongs to
+	struct internal_reference
+	{
+		Linker::Relocation * relocation;
+		relocation_target target;
+	};
+	struct external_reference
+	{
+		Linker::Relocation * relocation;
+		uint32_t address;
+	};
+	std::vector<internal_reference> internal_references;
+	// indexed by the position of the library within library_descriptor.libraries
+	std::vector<std::vector<external_reference>> external_references;
 
 	// divide the groups into segments
 	// also collect libraries
+	std::array<std::vector<uint32_t>, 8> segment_starts;
 	for(Linker::Relocation& rel : module.GetRelocations())
 	{
 		Linker::Resolution resolution;
-		if(rel.kind == Linker::Relocation::SelectorIndex && rel.Resolve(module, resolution))
+		bool resolved = rel.Resolve(module, resolution);
+		if(rel.kind == Linker::Relocation::SelectorIndex && resolved)
 		{
 			if(resolution.reference == nullptr)
 			{
 				resolution.value = (resolution.value >> 4) + rel.addend;
-				uint32_t offset = uint32_t(resolution.value) << 4;
 				unsigned dst_segment = GetSegmentNumber(resolution.target);
-				segment_boundaries[dst_segment - 1].insert(offset);
+				segment_starts[dst_segment - 1].push_back(uint32_t(resolution.value) << 4);
+				internal_references.push_back(internal_reference { &rel, relocation_target { dst_segment, resolution.value } });
 			}
 		}
 		else if(Linker::SymbolName * symbol = std::get_if<Linker::SymbolName>(&rel.target.target))
@@ -1805,13 +1820,19 @@ void CPM86Format::BuildLDTImage(Linker::Module& module)
 			if(symbol->GetImportedLibrary(library))
 			{
 				Linker::Debug << "Debug: reference library " << library << std::endl;
-				library_descriptor.FetchImportedLibrary(library);
+				size_t library_index = &library_descriptor.FetchImportedLibrary(library) - library_descriptor.libraries.data();
+				if(!resolved)
+				{
+					if(external_references.size() <= library_index)
+						external_references.resize(library_index + 1);
+					external_references[library_index].push_back(external_reference { &rel, uint32_t(symbol->addend + rel.addend) << 4 });
+				}
 			}
 		}
 	}
 
-	// calculate segment limits for each segment in each group
-	std::array<std::map<uint32_t, uint32_t>, 8> segment_limits;
+	// calculate segment limits for each segment in each group, segment_limits[n][i] belongs to the segment starting at segment_starts[n][i]
+	std::array<std::vector<uint32_t>, 8> segment_limits;
 
 	for(size_t i = 0; i < Segments().size(); i++)
 	{
@@ -1819,20 +1840,32 @@ void CPM86Format::BuildLDTImage(Linker::Module& module)
 		if(segment_types.find(segment) == segment_types.end())
 			continue;
 		unsigned segment_number = GetSegmentNumber(segment);
-		uint32_t segment_start = 0;
-		for(auto offset : segment_boundaries[segment_number - 1])
+		std::vector<uint32_t>& starts = segment_starts[segment_number - 1];
+		starts.push_back(0);
+		std::sort(starts.begin(), starts.end());
+		starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+		std::vector<uint32_t>& limits = segment_limits[segment_number - 1];
+		limits.resize(starts.size());
+		for(size_t index = 0; index + 1 < starts.size(); index++)
 		{
-			if(offset == 0)
-				continue;
-			segment_limits[segment_number - 1][segment_start] = std::min(0xFFFFU, offset - segment_start - 1);
-			segment_start = offset;
+			limits[index] = std::min(0xFFFFU, starts[index + 1] - starts[index] - 1);
 		}
-		segment_limits[segment_number - 1][segment_start] =
-			segment->ImageSize() == segment_start
+		limits.back() =
+			segment->ImageSize() == starts.back()
 				? 0
-				: std::min(offset_t(0xFFFF), segment->ImageSize() - segment_start - 1);
+				: std::min(offset_t(0xFFFF), segment->ImageSize() - starts.back() - 1);
 	}
 
+	auto get_segment_limit = [&segment_starts, &segment_limits](unsigned segment_number, uint32_t offset) -> uint32_t
+	{
+		std::vector<uint32_t>& starts = segment_starts[segment_number - 1];
+		std::vector<uint32_t>& limits = segment_limits[segment_number - 1];
+		auto it = std::lower_bound(starts.begin(), starts.end(), offset);
+		if(it == starts.end() || *it != offset || limits.size() != starts.size())
+			return 0;
+		return limits[it - starts.begin()];
+	};
+
 	// create the LDT image
 	fastload_descriptor.Clear();
 
@@ -1845,62 +1878,42 @@ void CPM86Format::BuildLDTImage(Linker::Module& module)
 	// allocate internal selectors for each relocation
 	std::map<relocation_target, uint16_t> selectors;
 
-	for(Linker::Relocation& rel : module.GetRelocations())
+	for(auto& reference : internal_references)
 	{
-		Linker::Resolution resolution;
-		if(rel.kind == Linker::Relocation::SelectorIndex && rel.Resolve(module, resolution) && resolution.reference == nullptr)
+		const relocation_target& target = reference.target;
+		uint16_t selector;
+		auto it = selectors.find(target);
+		if(it == selectors.end())
 		{
-			resolution.value = (resolution.value >> 4) + rel.addend;
-			unsigned dst_segment = GetSegmentNumber(resolution.target);
-			relocation_target target { dst_segment, resolution.value };
-			uint16_t selector;
-			if(selectors.find(target) == selectors.end())
-			{
-				size_t index = fastload_descriptor.first_free_entry++;
-				selector = index * 8 + 7;
-				fastload_descriptor.ldt[index].limit = segment_limits[dst_segment - 1][resolution.value << 4];
-				fastload_descriptor.ldt[index].address = resolution.value << 4;
-				fastload_descriptor.ldt[index].group = dst_segment;
-				selectors[target] = selector;
-			}
-			else
-			{
-				selector = selectors[target];
-			}
-			rel.WriteWord(selector);
+			size_t index = fastload_descriptor.first_free_entry++;
+			selector = index * 8 + 7;
+			fastload_descriptor.ldt[index].limit = get_segment_limit(target.segment, target.offset << 4);
+			fastload_descriptor.ldt[index].address = target.offset << 4;
+			fastload_descriptor.ldt[index].group = target.segment;
+			selectors[target] = selector;
+		}
+		else
+		{
+			selector = it->second;
 		}
+		reference.relocation->WriteWord(selector);
 	}
 
 	// allocate external selectors
-	for(auto& library : library_descriptor.libraries)
+	for(size_t library_index = 0; library_index < external_references.size(); library_index++)
 	{
-		for(Linker::Relocation& rel : module.GetRelocations())
+		auto& library = library_descriptor.libraries[library_index];
+		for(auto& reference : external_references[library_index])
 		{
-			Linker::Resolution resolution;
-			if(rel.Resolve(module, resolution))
-				continue;
-
-			Linker::SymbolName * symbol = std::get_if<Linker::SymbolName>(&rel.target.target);
-			if(!symbol)
-				continue;
-
-			std::string library_name;
-			if(!symbol->GetImportedLibrary(library_name))
-				continue;
-
-			Linker::Debug << "Debug: reference library " << library_name << std::endl;
-
-			if(&library_descriptor.FetchImportedLibrary(library_name) != &library)
-				continue;
-
-			Linker::Debug << "Debug: reference library " << library.name << " offset " << std::hex << (uint32_t(symbol->addend + rel.addend) << 4) << " in group " << std::hex << GetSegmentNumber(rel.source.GetPosition().segment) << " offset " << std::hex << rel.source.GetPosition().address << std::endl;
+			Linker::Relocation& rel = *reference.relocation;
+			Linker::Debug << "Debug: reference library " << library.name << " offset " << std::hex << reference.address << " in group " << std::hex << GetSegmentNumber(rel.source.GetPosition().segment) << " offset " << std::hex << rel.source.GetPosition().address << std::endl;
 
 			size_t index = fastload_descriptor.first_free_entry++;
 			uint16_t selector = index * 8 + 7;
 			if(library.first_selector == 0)
 				library.first_selector = index;
 			fastload_descriptor.ldt[index].limit = 0;
-			fastload_descriptor.ldt[index].address = uint32_t(symbol->addend + rel.addend) << 4;
+			fastload_descriptor.ldt[index].address = reference.address;
 			fastload_descriptor.ldt[index].group = 1;
 			rel.WriteWord(selector);
 		}
@@ -1920,7 +1933,7 @@ void CPM86Format::BuildLDTImage(Linker::Module& module)
 
 		Linker::Debug << "Debug: segment " << segment->name << " has segment number " << segment_number << std::endl;
 		size_t index = fastload_descriptor.first_free_entry++;
-		fastload_descriptor.ldt[index].limit = std::min(0xFFFFU, segment_limits[segment_number - 1][0]);
+		fastload_descriptor.ldt[index].limit = std::min(0xFFFFU, get_segment_limit(segment_number, 0));
 		fastload_descriptor.ldt[index].address = 0;
 		fastload_descriptor.ldt[index].group = segment_number;
 	}
@@ -2091,7 +2104,7 @@ void CPM86Format::ProcessModule(Linker::Module& module)
 		if(rsx_table[i].rsx_file_name != "")
 		{
 			std::ifstream rsx_file;
-			rsx_file.open(rsx_table[i].rsx_file_name, std::ios_base::in | std::ios_base::binary);
+			rsx_file.open(Linker::ResolvePath(rsx_table[i].rsx_file_name), std::ios_base::in | std::ios_base::binary);
 			if(rsx_file.is_open())
 			{
 				Linker::Reader rd(::LittleEndian, &rsx_file);
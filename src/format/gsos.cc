@@ -711,6 +711,10 @@ void OMFFormat::CalculateValues()
 	offset_t current_offset = 0;
 	for(unsigned i = 0; i < segments.size(); i++)
 	{
+		if(compact_relocations)
+		{
+			segments[i]->CompactRelocations();
+		}
 		current_offset = segments[i]->CalculateValues(i, current_offset);
 	}
 }
@@ -1290,33 +1294,7 @@ void OMFFormat::Segment::EntryRecord::AddFields(Dumper::Dumper& dump, Dumper::Re
 
 offset_t OMFFormat::Segment::SuperCompactRecord::GetLength(const Segment& segment) const
 {
-	offset_t record_size = 1;
-	uint16_t current_page = 0;
-	for(uint16_t offset : offsets)
-	{
-		if((offset & 0xFF00) == current_page)
-		{
-			/* append byte for next patch */
-			record_size ++;
-		}
-		else if((offset & 0xFF00) == current_page + 0x100)
-		{
-			/* append byte for next page and next patch */
-			record_size += 2;
-		}
-		else if((offset & 0xFF00) < offset_t(current_page) + 0x8000)
-		{
-			/* append byte for skip patch, next page and next patch */
-			record_size += 3;
-		}
-		else
-		{
-			/* we need two skip patch bytes */
-			record_size += 4;
-		}
-		current_page = offset & 0xFF00;
-	}
-	return 6 + record_size;
+	return 6 + EncodePatches().size();
 }
 
 void OMFFormat::Segment::SuperCompactRecord::ReadFile(Segment& segment, Linker::Reader& rd)
@@ -1328,7 +1306,7 @@ void OMFFormat::Segment::SuperCompactRecord::ReadFile(Segment& segment, Linker::
 	while(rd.Tell() < start + record_size)
 	{
 		uint8_t count = rd.ReadUnsigned(1);
-		if(count <= 0x80)
+		if(count < 0x80)
 		{
 			for(int i = 0; i < count + 1; i++)
 			{
@@ -1338,7 +1316,7 @@ void OMFFormat::Segment::SuperCompactRecord::ReadFile(Segment& segment, Linker::
 		}
 		else
 		{
-			current_page += (count - 0x80) << 8;
+			current_page += (count & 0x7F) << 8;
 		}
 	}
 }
@@ -1346,52 +1324,55 @@ void OMFFormat::Segment::SuperCompactRecord::ReadFile(Segment& segment, Linker::
 void OMFFormat::Segment::SuperCompactRecord::WriteFile(const Segment& segment, Linker::Writer& wr) const
 {
 	Record::WriteFile(segment, wr);
-	wr.WriteWord(4, GetLength(segment) - 5);
+	std::vector<uint8_t> patches = EncodePatches();
+	wr.WriteWord(4, 1 + patches.size());
 	wr.WriteWord(1, super_type);
-	uint16_t current_page = 0;
+	wr.WriteData(patches);
+}
+
+std::vector<uint8_t> OMFFormat::Segment::SuperCompactRecord::EncodePatches() const
+{
+	std::vector<uint16_t> sorted_offsets = offsets;
+	std::sort(sorted_offsets.begin(), sorted_offsets.end());
+	sorted_offsets.erase(std::unique(sorted_offsets.begin(), sorted_offsets.end()), sorted_offsets.end());
+
 	std::vector<uint8_t> patches;
-	for(uint16_t offset : offsets)
+	unsigned current_page = 0;
+	for(size_t index = 0; index < sorted_offsets.size(); )
 	{
-		if((offset & 0xFF00) == current_page)
+		unsigned page = sorted_offsets[index] >> 8;
+		while(current_page < page)
 		{
-			/* append byte for next patch */
-			patches.push_back(offset & 0xFF);
+			/* skip pages without patches, at most 0x7F at a time */
+			unsigned skip = std::min(page - current_page, 0x7Fu);
+			patches.push_back(0x80 | skip);
+			current_page += skip;
 		}
-		else if((offset & 0xFF00) == current_page + 0x100)
+
+		size_t count = 0;
+		while(index + count < sorted_offsets.size() && unsigned(sorted_offsets[index + count] >> 8) == page && count < MAX_PAGE_PATCHES)
 		{
-			/* append byte for next page and next patch */
-			WritePatchList(wr, patches);
-			patches.clear();
-			patches.push_back(offset & 0xFF);
+			count++;
 		}
-		else if((offset & 0xFF00) < offset_t(current_page) + 0x8000)
+		if(index + count < sorted_offsets.size() && unsigned(sorted_offsets[index + count] >> 8) == page)
 		{
-			/* append byte for skip patch, next page and next patch */
-			WritePatchList(wr, patches);
-			patches.clear();
-			wr.WriteWord(1, 0x7F + ((offset - current_page) >> 8));
-			patches.push_back(offset & 0xFF);
+			Linker::Error << "Error: too many SUPER patches in page " << std::hex << page << std::dec << ", truncating" << std::endl;
 		}
-		else
+
+		/* patch count minus one, then the low bytes of the offsets, after which the page advances */
+		patches.push_back(count - 1);
+		for(size_t i = 0; i < count; i++)
 		{
-			/* we need two skip patch bytes */
-			WritePatchList(wr, patches);
-			patches.clear();
-			wr.WriteWord(1, 0xFF);
-			wr.WriteWord(1, (offset - current_page) >> 8);
-			patches.push_back(offset & 0xFF);
+			patches.push_back(sorted_offsets[index + i] & 0xFF);
 		}
-	}
-	WritePatchList(wr, patches);
-}
+		current_page = page + 1;
 
-void OMFFormat::Segment::SuperCompactRecord::WritePatchList(Linker::Writer& wr, const std::vector<uint8_t>& patches) const
-{
-	wr.WriteWord(1, patches.size() - 1);
-	for(uint8_t patch : patches)
-	{
-		wr.WriteWord(1, patch);
+		while(index < sorted_offsets.size() && unsigned(sorted_offsets[index] >> 8) == page)
+		{
+			index++;
+		}
 	}
+	return patches;
 }
 
 void OMFFormat::Segment::SuperCompactRecord::Dump(Dumper::Dumper& dump, const OMFFormat& omf, const Segment& segment, unsigned index, offset_t file_offset, offset_t address) const
@@ -1858,3 +1839,141 @@ std::unique_ptr<OMFFormat::Segment::Record> OMFFormat::Segment::makeSUPER(SuperC
 	return std::make_unique<SuperCompactRecord>(Record::OPC_SUPER, super_type);
 }
 
+
+void OMFFormat::Segment::CompactRelocations()
+{
+	/* the segment image is needed to check SUPER relocations, so the records are only rearranged once every relocation has been examined */
+	std::vector<std::unique_ptr<Record>> replacements(records.size());
+	std::vector<bool> in_super_record(records.size(), false);
+	std::map<SuperCompactRecord::super_record_type, std::unique_ptr<SuperCompactRecord>> super_records;
+	std::map<std::pair<SuperCompactRecord::super_record_type, uint16_t>, size_t> page_patch_counts;
+	offset_t old_size = 0;
+	offset_t new_size = 0;
+
+	for(size_t index = 0; index < records.size(); index++)
+	{
+		Record& record = *records[index];
+		if(record.type != Record::OPC_RELOC && record.type != Record::OPC_INTERSEG
+		&& record.type != Record::OPC_C_RELOC && record.type != Record::OPC_C_INTERSEG)
+		{
+			continue;
+		}
+
+		old_size += record.GetLength(*this);
+
+		RelocationRecord& relocation = static_cast<RelocationRecord&>(record);
+		bool intersegment = record.type == Record::OPC_INTERSEG || record.type == Record::OPC_C_INTERSEG;
+		uint16_t file_number = 1;
+		uint16_t target_segment = 0;
+		if(intersegment)
+		{
+			IntersegmentRelocationRecord& intersegment_relocation = static_cast<IntersegmentRelocationRecord&>(record);
+			file_number = intersegment_relocation.file_number;
+			target_segment = intersegment_relocation.segment_number;
+		}
+
+		if(relocation.source > 0xFFFF || relocation.target > 0xFFFF || (intersegment && target_segment > 0xFF))
+		{
+			/* only the verbose forms can represent this */
+			continue;
+		}
+
+		if(version >= OMF_VERSION_2)
+		{
+			std::optional<SuperCompactRecord::super_record_type> super_type;
+			if(!intersegment && relocation.shift == 0 && relocation.size == 2)
+			{
+				if(ReadUnsigned(2, relocation.source) == relocation.target)
+					super_type = SuperCompactRecord::SUPER_RELOC2;
+			}
+			else if(!intersegment && relocation.shift == 0 && relocation.size == 3)
+			{
+				if(ReadUnsigned(3, relocation.source) == relocation.target)
+					super_type = SuperCompactRecord::SUPER_RELOC3;
+			}
+			else if(intersegment && relocation.shift == 0 && relocation.size == 3 && 1 <= file_number && file_number <= 12)
+			{
+				if(ReadUnsigned(2, relocation.source) == relocation.target && ReadUnsigned(1, relocation.source + 2) == target_segment)
+					super_type = SuperCompactRecord::super_record_type(SuperCompactRecord::SUPER_INTERSEG1 + file_number - 1);
+			}
+			else if(intersegment && relocation.size == 2 && file_number == 1 && 1 <= target_segment && target_segment <= 12
+				&& (relocation.shift == 0 || relocation.shift == -16))
+			{
+				if(ReadUnsigned(2, relocation.source) == relocation.target)
+					super_type = SuperCompactRecord::super_record_type(
+						(relocation.shift == 0 ? SuperCompactRecord::SUPER_INTERSEG13 : SuperCompactRecord::SUPER_INTERSEG25) + target_segment - 1);
+			}
+
+			if(super_type && page_patch_counts[{ *super_type, uint16_t(relocation.source >> 8) }] < SuperCompactRecord::MAX_PAGE_PATCHES)
+			{
+				page_patch_counts[{ *super_type, uint16_t(relocation.source >> 8) }]++;
+				auto& super_record = super_records[*super_type];
+				if(super_record == nullptr)
+				{
+					super_record = std::make_unique<SuperCompactRecord>(Record::OPC_SUPER, *super_type);
+				}
+				super_record->offsets.push_back(relocation.source);
+				in_super_record[index] = true;
+				continue;
+			}
+		}
+
+		if(!intersegment)
+		{
+			replacements[index] = makecRELOC(relocation.size, relocation.shift, relocation.source, relocation.target);
+		}
+		else if(file_number == 1)
+		{
+			replacements[index] = makecINTERSEG(relocation.size, relocation.shift, relocation.source, target_segment, relocation.target);
+		}
+	}
+
+	if(old_size == 0)
+	{
+		/* no relocations, nothing to do */
+		return;
+	}
+
+	std::vector<std::unique_ptr<Record>> compacted_records;
+	std::vector<std::unique_ptr<Record>> relocation_records;
+	std::optional<size_t> relocation_index;
+	for(size_t index = 0; index < records.size(); index++)
+	{
+		Record::record_type type = records[index]->type;
+		if(type != Record::OPC_RELOC && type != Record::OPC_INTERSEG
+		&& type != Record::OPC_C_RELOC && type != Record::OPC_C_INTERSEG)
+		{
+			compacted_records.emplace_back(std::move(records[index]));
+			continue;
+		}
+
+		if(!relocation_index)
+		{
+			relocation_index = compacted_records.size();
+		}
+
+		if(in_super_record[index])
+		{
+			continue;
+		}
+
+		relocation_records.emplace_back(replacements[index] != nullptr ? std::move(replacements[index]) : std::move(records[index]));
+	}
+
+	for(auto& super_record : super_records)
+	{
+		std::sort(super_record.second->offsets.begin(), super_record.second->offsets.end());
+		relocation_records.emplace_back(std::move(super_record.second));
+	}
+
+	for(auto& record : relocation_records)
+	{
+		new_size += record->GetLength(*this);
+	}
+
+	compacted_records.insert(compacted_records.begin() + *relocation_index,
+		std::make_move_iterator(relocation_records.begin()), std::make_move_iterator(relocation_records.end()));
+	records = std::move(compacted_records);
+
+	Linker::Debug << "Debug: segment " << segment_number << " relocation dictionary: " << old_size << " bytes, compacted to " << new_size << " bytes" << std::endl;
+}
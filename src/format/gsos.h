@@ -626,8 +626,13 @@ namespace Apple
 				offset_t GetLength(const Segment& segment) const override;
 				void ReadFile(Segment& segment, Linker::Reader& rd) override;
 				void WriteFile(const Segment& segment, Linker::Writer& wr) const override;
+
+				/** @brief Maximal number of patches that a SUPER record can hold within a single page */
+				static constexpr size_t MAX_PAGE_PATCHES = 0x80;
+
 			private:
-				void WritePatchList(Linker::Writer& wr, const std::vector<uint8_t>& patches) const;
+				/** @brief Encodes the sorted offsets as a sequence of patch lists and page skips, as stored after the type byte */
+				std::vector<uint8_t> EncodePatches() const;
 
 			public:
 				void Dump(Dumper::Dumper& dump, const OMFFormat& omf, const Segment& segment, unsigned index, offset_t file_offset, offset_t address) const override;
@@ -687,10 +692,20 @@ namespace Apple
 			std::unique_ptr<Record> makecINTERSEG(uint8_t size, uint8_t shift, uint16_t source, uint16_t segment_number, uint16_t target);
 			std::unique_ptr<Record> makecINTERSEG();
 			std::unique_ptr<Record> makeSUPER(SuperCompactRecord::super_record_type super_type = SuperCompactRecord::super_record_type(0));
+
+			/** @brief Replaces RELOC and INTERSEG records with the shorter cRELOC, cINTERSEG and SUPER forms wherever they can represent them
+			 *
+			 * Since SUPER records take the relocation target from the segment image, a relocation is only grouped into a SUPER record if the patched location already contains the target value.
+			 * SUPER records are only generated for version 2 segments.
+			 */
+			void CompactRelocations();
 		};
 
 		std::vector<std::unique_ptr<Segment>> segments;
 
+		/** @brief Convert relocation records into their compact forms when generating the file */
+		bool compact_relocations = true;
+
 		void CalculateValues() override;
 		void ReadFile(Linker::Reader& rd) override;
 		using Linker::Format::WriteFile;
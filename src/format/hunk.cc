@@ -8,6 +8,11 @@ using namespace Amiga;
 
 // Relocation
 
+bool HunkFormat::Relocation::operator ==(const Relocation& other) const
+{
+	return offset == other.offset && size == other.size && type == other.type;
+}
+
 bool HunkFormat::Relocation::operator <(const Relocation& other) const
 {
 	return offset < other.offset || (offset == other.offset && (size < other.size || (size == other.size && type < other.type)));
@@ -344,16 +349,13 @@ void HunkFormat::LoadBlock::Dump(Dumper::Dumper& dump, const Module& module, con
 	{
 		hunk_block.AddOptionalField("Additional memory", Dumper::HexDisplay::Make(8), offset_t(header_hunk_size - image->ImageSize()));
 	}
-	for(auto pair : hunk->relocations)
+	for(auto& pair : hunk->relocations)
 	{
-		for(auto rel : pair.second)
-		{
-			hunk_block.AddSignal(rel.offset, rel.size);
-		}
+		hunk_block.AddSignal(pair.second.offset, pair.second.size);
 	}
-	for(auto pair : hunk->externals)
+	for(auto& pair : hunk->externals)
 	{
-		for(auto rel : pair.second)
+		for(auto& rel : pair.second)
 		{
 			hunk_block.AddSignal(rel.offset, rel.size);
 		}
@@ -1169,141 +1171,148 @@ void HunkFormat::Hunk::ProduceBlocks(HunkFormat& fmt, Module& module)
 	/* Relocation blocks */
 	std::map<Block::block_type, std::shared_ptr<RelocationBlock>> relocation_blocks;
 
-	for(auto it : relocations)
+	std::sort(relocations.begin(), relocations.end());
+	relocations.erase(std::unique(relocations.begin(), relocations.end()), relocations.end());
+
+	for(auto& [target, rel] : relocations)
 	{
-		for(Relocation rel : it.second)
+		Block::block_type btype = Block::block_type(0);
+		switch(rel.type)
 		{
-			Block::block_type btype = Block::block_type(0);
-			switch(rel.type)
+		case Relocation::Absolute:
+			switch(rel.size)
 			{
-			case Relocation::Absolute:
-				switch(rel.size)
+			case 2:
+				if(fmt.system == V39)
 				{
-				case 2:
-					if(fmt.system == V39)
-					{
-						btype = Block::HUNK_ABSRELOC16;
-					}
-					break;
-				case 4:
-					if(module.IsExecutable())
+					btype = Block::HUNK_ABSRELOC16;
+				}
+				break;
+			case 4:
+				if(module.IsExecutable())
+				{
+					switch(fmt.system)
 					{
-						switch(fmt.system)
-						{
-						case V1:
-							btype = Block::HUNK_ABSRELOC32;
-							break;
-						case V37:
-							// TODO: only if possible to fit
-							btype = Block::HUNK_V37_RELOC32SHORT;
-							break;
-						case V38:
-						case V39:
-							btype = Block::HUNK_RELOC32SHORT;
-							break;
-						}
+					case V1:
+						btype = Block::HUNK_ABSRELOC32;
+						break;
+					case V37:
+						btype = Block::HUNK_V37_RELOC32SHORT;
+						break;
+					case V38:
+					case V39:
+						btype = Block::HUNK_RELOC32SHORT;
+						break;
 					}
-					else
+					/* the short form stores the hunk number and offset as 16-bit words */
+					if(btype != Block::HUNK_ABSRELOC32 && (target > 0xFFFF || rel.offset > 0xFFFF))
 					{
 						btype = Block::HUNK_ABSRELOC32;
 					}
-					break;
 				}
-				break;
-			case Relocation::SelfRelative:
-				switch(rel.size)
+				else
 				{
-				case 1:
-					btype = Block::HUNK_RELRELOC8;
-					break;
-				case 2:
-					btype = Block::HUNK_RELRELOC16;
-					break;
-				case 4:
-					if(fmt.system == V39)
-					{
-						btype = Block::HUNK_RELRELOC32;
-					}
-					break;
+					btype = Block::HUNK_ABSRELOC32;
 				}
 				break;
-			case Relocation::DataRelative:
-				switch(rel.size)
+			}
+			break;
+		case Relocation::SelfRelative:
+			switch(rel.size)
+			{
+			case 1:
+				btype = Block::HUNK_RELRELOC8;
+				break;
+			case 2:
+				btype = Block::HUNK_RELRELOC16;
+				break;
+			case 4:
+				if(fmt.system == V39)
 				{
-				case 1:
-					btype = Block::HUNK_DRELOC8;
-					break;
-				case 2:
-					btype = Block::HUNK_DRELOC16;
-					break;
-				case 4:
-					btype = Block::HUNK_DRELOC32;
-					break;
+					btype = Block::HUNK_RELRELOC32;
 				}
 				break;
-			case Relocation::SelfRelative26:
-				btype = Block::HUNK_RELRELOC26;
+			}
+			break;
+		case Relocation::DataRelative:
+			switch(rel.size)
+			{
+			case 1:
+				btype = Block::HUNK_DRELOC8;
+				break;
+			case 2:
+				btype = Block::HUNK_DRELOC16;
+				break;
+			case 4:
+				btype = Block::HUNK_DRELOC32;
 				break;
 			}
+			break;
+		case Relocation::SelfRelative26:
+			btype = Block::HUNK_RELRELOC26;
+			break;
+		}
 
-			if(module.IsExecutable())
+		if(module.IsExecutable())
+		{
+			switch(btype)
 			{
-				switch(btype)
-				{
-				case Block::HUNK_ABSRELOC32:
-					break;
-				case Block::HUNK_V37_RELOC32SHORT:
-					if(fmt.system != V37)
-						btype = Block::block_type(0);
-					break;
-				case Block::HUNK_RELOC32SHORT:
-					if(fmt.system == V1)
-						btype = Block::block_type(0);
-					break;
-				case Block::HUNK_RELRELOC32:
-					if(fmt.system != V39)
-						btype = Block::block_type(0);
-					break;
-				default:
-					// invalid in executable
+			case Block::HUNK_ABSRELOC32:
+				break;
+			case Block::HUNK_V37_RELOC32SHORT:
+				if(fmt.system != V37)
 					btype = Block::block_type(0);
-					break;
-				}
+				break;
+			case Block::HUNK_RELOC32SHORT:
+				if(fmt.system == V1)
+					btype = Block::block_type(0);
+				break;
+			case Block::HUNK_RELRELOC32:
+				if(fmt.system != V39)
+					btype = Block::block_type(0);
+				break;
+			default:
+				// invalid in executable
+				btype = Block::block_type(0);
+				break;
 			}
+		}
 
-			if(btype != Block::block_type(0))
+		if(btype != Block::block_type(0))
+		{
+			std::shared_ptr<RelocationBlock>& relocation_block = relocation_blocks[btype];
+			if(relocation_block == nullptr)
 			{
-				if(relocation_blocks.find(btype) == relocation_blocks.end())
-				{
-					relocation_blocks[btype] = std::make_shared<RelocationBlock>(btype, module.IsExecutable());
-					relocation_blocks[btype]->relocations.emplace_back(RelocationBlock::RelocationData(it.first));
-				}
-				else if(relocation_blocks[btype]->relocations.back().hunk != it.first)
-				{
-					relocation_blocks[btype]->relocations.emplace_back(RelocationBlock::RelocationData(it.first));
-				}
-				relocation_blocks[btype]->relocations.back().offsets.push_back(rel.offset);
+				relocation_block = std::make_shared<RelocationBlock>(btype, module.IsExecutable());
+				relocation_block->relocations.emplace_back(RelocationBlock::RelocationData(target));
 			}
-			else
+			else if(relocation_block->relocations.back().hunk != target
+			|| (relocation_block->IsShortRelocationBlock() && relocation_block->relocations.back().offsets.size() >= 0xFFFF))
 			{
-				Linker::Warning << "Warning: generating relocation of size " << rel.size << " and type ";
-				switch(rel.type)
-				{
-				case Relocation::Absolute:
-					Linker::Warning << "absolute";
-					break;
-				case Relocation::SelfRelative:
-					Linker::Warning << "PC-relative";
-					break;
-				case Relocation::DataRelative:
-					Linker::Warning << "data section relative";
-					break;
-				case Relocation::SelfRelative26:
-					Linker::Warning << "26-bit PC-relative";
-					break;
-				}
-				Linker::Warning << " is not supported, ignoring" << std::endl;
+				/* the count of a short block is also a 16-bit word */
+				relocation_block->relocations.emplace_back(RelocationBlock::RelocationData(target));
+			}
+			relocation_block->relocations.back().offsets.push_back(rel.offset);
+		}
+		else
+		{
+			Linker::Warning << "Warning: generating relocation of size " << rel.size << " and type ";
+			switch(rel.type)
+			{
+			case Relocation::Absolute:
+				Linker::Warning << "absolute";
+				break;
+			case Relocation::SelfRelative:
+				Linker::Warning << "PC-relative";
+				break;
+			case Relocation::DataRelative:
+				Linker::Warning << "data section relative";
+				break;
+			case Relocation::SelfRelative26:
+				Linker::Warning << "26-bit PC-relative";
+				break;
 			}
+			Linker::Warning << " is not supported, ignoring" << std::endl;
 		}
 	}
 
@@ -1437,12 +1446,10 @@ void HunkFormat::Hunk::AppendBlock(std::shared_ptr<Block> block)
 			RelocationBlock * relocation_block = dynamic_cast<RelocationBlock *>(block.get());
 			for(auto& data : relocation_block->relocations)
 			{
-				if(relocations.find(data.hunk) == relocations.end())
-					relocations[data.hunk] = std::set<Relocation>();
 				for(auto offset : data.offsets)
 				{
 					// TODO: more information needs to be stored
-					relocations[data.hunk].insert(Relocation(relocation_block->GetRelocationSize(), relocation_block->GetRelocationType(), offset));
+					relocations.push_back({ data.hunk, Relocation(relocation_block->GetRelocationSize(), relocation_block->GetRelocationType(), offset) });
 				}
 			}
 		}
@@ -1973,7 +1980,7 @@ void HunkFormat::ProcessModule(Linker::Module& module)
 				Linker::Debug << rel << std::endl;
 				Linker::Debug << resolution << std::endl;
 			}
-			modules[0].hunks[source].relocations[target].insert(Relocation(rel.size, type, position.address));
+			modules[0].hunks[source].relocations.push_back({ target, Relocation(rel.size, type, position.address) });
 		}
 	}
 
@@ -46,6 +46,7 @@ namespace Amiga
 				: size(size), type(type), offset(offset)
 			{
 			}
+			bool operator ==(const Relocation& other) const;
 			bool operator <(const Relocation& other) const;
 		};
 
@@ -592,8 +593,8 @@ namespace Amiga
 			{
 			}
 
-			/** @brief Internal relocations, grouped according to addressed hunk number */
-			std::map<uint32_t, std::set<Relocation>> relocations;
+			/** @brief Internal relocations, each paired with the addressed hunk number, sorted and made unique when producing the blocks */
+			std::vector<std::pair<uint32_t, Relocation>> relocations;
 
 			/** @brief External relocations, grouped according to name of symbol (only for object files) */
 			std::map<std::string, std::set<Relocation>> externals;
@@ -1,8 +1,11 @@
 
+#include <fstream>
 #include <sstream>
 #include "leexe.h"
 #include "mzexe.h"
 #include "neexe.h"
+#include "../linker/checksum.h"
+#include "../linker/memory_usage.h"
 #include "../linker/position.h"
 #include "../linker/resolution.h"
 
@@ -1576,7 +1579,20 @@ offset_t LEFormat::ImageSize() const
 offset_t LEFormat::WriteFile(Linker::Writer& wr) const
 {
 	wr.endiantype = endiantype;
-	stub.WriteStubImage(wr);
+
+	Linker::PageChecksum page_checksums(4);
+	if(per_page_checksum_offset != 0 && option_checksum)
+	{
+		for(PhysicalPageNumber physical_page_index = PhysicalPageNumber{1}; physical_page_index <= page_count; physical_page_index++)
+		{
+			if(offset_t page_offset = GetPageOffset(physical_page_index))
+				page_checksums.AddPage(page_offset, GetPageSize(physical_page_index));
+		}
+		wr.checksums.push_back(&page_checksums);
+	}
+
+	if(!embedded)
+		stub.WriteStubImage(wr);
 
 	/* new header */
 	wr.Seek(file_offset);
@@ -1816,6 +1832,8 @@ offset_t LEFormat::WriteFile(Linker::Writer& wr) const
 	}
 
 	/*** Page Data ***/
+	/* LX pages might not be stored in the order of their page numbers */
+	offset_t page_data_end = wr.Tell();
 	for(PhysicalPageNumber physical_page_index = PhysicalPageNumber{1}; physical_page_index <= page_count; physical_page_index++)
 	{
 		const Page& page = pages[physical_page_index];
@@ -1824,10 +1842,12 @@ offset_t LEFormat::WriteFile(Linker::Writer& wr) const
 		case Page::Preload:
 			wr.Seek(GetPageOffset(physical_page_index));
 			page.image->WriteFile(wr);
+			page_data_end = std::max(page_data_end, wr.Tell());
 			break;
 		case Page::Iterated:
 			wr.Seek(GetPageOffset(physical_page_index));
 			page.image->WriteFile(wr);
+			page_data_end = std::max(page_data_end, wr.Tell());
 			break;
 		case Page::Invalid:
 			break;
@@ -1845,6 +1865,7 @@ offset_t LEFormat::WriteFile(Linker::Writer& wr) const
 
 	/*** Non-Resident ***/
 	/* Non-Resident Name Table */
+	wr.Seek(page_data_end);
 	for(const Name& name : nonresident_names)
 	{
 		wr.WriteWord(1, name.name.size());
@@ -1854,6 +1875,23 @@ offset_t LEFormat::WriteFile(Linker::Writer& wr) const
 	wr.WriteWord(1, 0);
 	/* Non-Resident Directives */
 
+	if(per_page_checksum_offset != 0 && option_checksum)
+	{
+		std::erase(wr.checksums, &page_checksums);
+		if(page_checksums.valid)
+		{
+			for(PhysicalPageNumber physical_page_index = PhysicalPageNumber{1}; physical_page_index <= page_count; physical_page_index++)
+			{
+				wr.Seek(per_page_checksum_offset + 4 * (physical_page_index - 1));
+				wr.WriteWord(4, uint32_t(page_checksums.GetPageSum(GetPageOffset(physical_page_index))));
+			}
+		}
+		else
+		{
+			Linker::Warning << "Warning: unable to calculate the per-page checksums" << std::endl;
+		}
+	}
+
 	return offset_t(-1);
 }
 
@@ -2559,6 +2597,11 @@ void LEFormat::SetOptions(std::map<std::string, std::string>& options)
 
 	heap_size = collector.heap();
 
+	option_checksum = collector.checksum();
+	option_preload = collector.preload();
+	option_preload_segments = collector.preload_segments();
+	option_page_profile = collector.page_profile();
+
 	/* TODO */
 }
 
@@ -2581,6 +2624,8 @@ void LEFormat::OnNewSegment(std::shared_ptr<Linker::Segment> segment)
 	{
 		std::shared_ptr<Linker::Section> section = segment->sections[0];
 		unsigned flags = GetDefaultObjectFlags() | Object::BigSegment;
+		if(std::find(option_preload_segments.begin(), option_preload_segments.end(), segment->name) != option_preload_segments.end())
+			flags |= Object::PreloadPages;
 		if(section->IsReadable())
 			flags |= Object::Readable;
 		if(section->IsWritable())
@@ -2953,6 +2998,11 @@ void LEFormat::CalculateValues()
 
 	/* TODO */
 
+	if(option_preload || option_page_profile != "")
+	{
+		OrderPages();
+	}
+
 	if(IsExtendedFormat())
 	{
 		page_offset_shift = 0;
@@ -2968,7 +3018,8 @@ void LEFormat::CalculateValues()
 #endif
 	}
 
-	file_offset = stub.GetStubImageSize();
+	if(!embedded)
+		file_offset = stub.GetStubImageSize();
 
 	object_table_offset = file_offset + 0xC4;
 
@@ -2996,6 +3047,15 @@ void LEFormat::CalculateValues()
 	}
 
 	fixup_page_table_offset = entry_table_offset + entry_table_length;
+
+	per_page_checksum_offset = 0;
+	if(option_checksum && IsExtendedFormat())
+	{
+		/* LX places the table in the loader section, after the module directives */
+		per_page_checksum_offset = fixup_page_table_offset;
+		fixup_page_table_offset += 4 * (pages.size() - 2);
+	}
+
 	fixup_record_table_offset = fixup_page_table_offset + 4 * (pages.size() - 1); /* including terminator entry (first entry fake because pages are 1 based) */
 
 	offset_t fixup_offset = 0;
@@ -3008,7 +3068,7 @@ void LEFormat::CalculateValues()
 		if(&page == &pages.back())
 			continue;
 //Linker::Debug << "Debug: Expect page " << page.relocations.size() << std::endl;
-		for(auto it : page.relocations)
+		for(auto& it : page.relocations)
 		{
 			it.second.CalculateSizes(compatibility);
 			fixup_offset += it.second.GetSize();
@@ -3037,6 +3097,13 @@ void LEFormat::CalculateValues()
 	loader_section_size = fixup_page_table_offset - object_table_offset;
 	fixup_section_size = imported_procedure_table_end - fixup_page_table_offset;
 
+	if(option_checksum && !IsExtendedFormat())
+	{
+		/* LE places the table after the fixup section */
+		per_page_checksum_offset = imported_procedure_table_end;
+		imported_procedure_table_end += 4 * (pages.size() - 2);
+	}
+
 	data_pages_offset = imported_procedure_table_end;
 	if(compatibility == CompatibleWatcom && (page_offset_shift < 2 || !IsExtendedFormat()))
 	{
@@ -3076,6 +3143,131 @@ void LEFormat::CalculateValues()
 	file_size = pages_offset + nonresident_name_table_size;
 }
 
+void LEFormat::OrderPages()
+{
+	/* pages mentioned in the access profile, mapped to the position of their first access */
+	std::map<uint32_t, size_t> first_access;
+	if(option_page_profile != "")
+	{
+		std::ifstream profile_file;
+		if(!IsExtendedFormat())
+		{
+			Linker::Warning << "Warning: LE pages are stored in the order of their page numbers, ignoring page profile" << std::endl;
+		}
+		else
+		{
+			profile_file.open(Linker::ResolvePath(option_page_profile), std::ios_base::in);
+			if(!profile_file.is_open())
+			{
+				Linker::Error << "Error: unable to open page profile " << option_page_profile << ", ignoring" << std::endl;
+			}
+		}
+
+		std::string line;
+		while(profile_file.is_open() && std::getline(profile_file, line))
+		{
+			if(line.size() == 0 || line[0] == '#')
+				continue;
+			std::istringstream line_stream(line);
+			offset_t address;
+			if(!(line_stream >> std::hex >> address))
+			{
+				Linker::Warning << "Warning: invalid line in page profile: " << line << std::endl;
+				continue;
+			}
+			for(Object& object : objects)
+			{
+				if(object.address <= address && address < object.address + object.size)
+				{
+					uint32_t object_page = (address - object.address) / page_size;
+					if(object_page < object.page_entry_count)
+						first_access.insert({ObjectPageToPhysicalPage(object.page_table_index + object_page), first_access.size()});
+					break;
+				}
+			}
+		}
+	}
+
+	enum
+	{
+		GroupPreload,
+		GroupInstancePreload,
+		GroupDemand,
+	};
+	struct page_order
+	{
+		PhysicalPageNumber physical_page;
+		int group;
+		bool instance;
+		size_t access;
+	};
+	std::vector<page_order> order;
+	for(Object& object : objects)
+	{
+		bool preload = option_preload && (object.flags & Object::PreloadPages) != 0;
+		bool instance = (object.flags & Object::Writable) != 0 && (object.flags & Object::Shared) == 0;
+		for(uint32_t object_page = 0; object_page < object.page_entry_count; object_page++)
+		{
+			PhysicalPageNumber physical_page = ObjectPageToPhysicalPage(object.page_table_index + object_page);
+			if(pages[physical_page].GetPageType(*this) != Page::Preload)
+				continue; /* no page data */
+			auto it = first_access.find(physical_page);
+			order.push_back(page_order {
+				physical_page,
+				!preload ? GroupDemand : instance ? GroupInstancePreload : GroupPreload,
+				instance,
+				it != first_access.end() ? it->second : SIZE_MAX });
+		}
+	}
+
+	if(IsExtendedFormat())
+	{
+		std::stable_sort(order.begin(), order.end(), [](const page_order& a, const page_order& b)
+		{
+			return a.group != b.group ? a.group < b.group : a.access < b.access;
+		});
+		offset_t page_offset = 0;
+		for(auto& entry : order)
+		{
+			pages[entry.physical_page].offset = page_offset;
+			page_offset += pages[entry.physical_page].size;
+		}
+	}
+	else
+	{
+		/* only the initial run of preload pages can be loaded together */
+		std::stable_sort(order.begin(), order.end(), [](const page_order& a, const page_order& b)
+		{
+			return a.physical_page < b.physical_page;
+		});
+		bool preload_run = true;
+		for(auto& entry : order)
+		{
+			if(entry.group == GroupDemand)
+				preload_run = false;
+			else if(!preload_run)
+				entry.group = GroupDemand;
+		}
+	}
+
+	preload_page_count = 0;
+	instance_preload_page_count = 0;
+	instance_demand_page_count = 0;
+	for(auto& entry : order)
+	{
+		if(entry.group != GroupDemand)
+			preload_page_count++;
+		if(entry.instance)
+		{
+			if(entry.group != GroupDemand)
+				instance_preload_page_count++;
+			else
+				instance_demand_page_count++;
+		}
+	}
+	Linker::Debug << "Debug: " << preload_page_count << " preload pages, " << instance_preload_page_count << " instance preload pages, " << instance_demand_page_count << " instance demand pages" << std::endl;
+}
+
 void LEFormat::GenerateFile(std::string filename, Linker::Module& module)
 {
 	program_name = filename;
@@ -3092,6 +3284,39 @@ void LEFormat::GenerateFile(std::string filename, Linker::Module& module)
 	Linker::OutputFormat::GenerateFile(filename, module);
 }
 
+void LEFormat::AccountMemory(Linker::MemoryUsage& usage) const
+{
+	Linker::SegmentManager::AccountMemory(usage);
+
+	usage.AddVector("format tables", objects);
+	for(auto& object : objects)
+	{
+		usage.AddContents("section data", object.image);
+	}
+	usage.Add("format tables", pages.size() * sizeof(Page));
+	for(auto& page : pages)
+	{
+		usage.AddMap("relocations", page.relocations);
+		for(auto& it : page.relocations)
+		{
+			usage.AddVector("relocations", it.second.sources);
+			for(auto& source : it.second.sources)
+			{
+				usage.AddVector("relocations", source.chains);
+			}
+		}
+	}
+	usage.AddVector("format tables", page_map_table);
+	usage.AddMap("format tables", resources);
+	usage.AddVector("format tables", resident_names);
+	usage.AddVector("format tables", nonresident_names);
+	usage.AddVector("format tables", entries);
+	usage.AddVector("format tables", imported_modules);
+	usage.AddVector("format tables", imported_procedures);
+	usage.AddMap("format tables", object_index);
+	usage.AddMap("format tables", imported_procedure_name_offsets);
+}
+
 std::string LEFormat::GetDefaultExtension(Linker::Module& module, std::string filename) const
 {
 	switch(output)
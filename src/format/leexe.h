@@ -347,6 +347,7 @@ namespace Microsoft
 				void WriteFile(Linker::Writer& wr) const;
 			};
 			std::map<uint16_t, Relocation> relocations;
+			/** @brief Checksum of the page, stored in the per-page checksum table, calculated while writing if option_checksum is set */
 			uint32_t checksum = 0;
 			std::shared_ptr<Linker::Contents> image;
 
@@ -779,10 +780,14 @@ namespace Microsoft
 			Linker::Option<offset_t> heap{"heap", "Specify the heap size"};
 			Linker::Option<bool> le{"le", "Original linear executable (LE)"};
 			Linker::Option<bool> lx{"lx", "Extended linear executable (LX)"};
+			Linker::Option<bool> checksum{"checksum", "Generate a per-page checksum table"};
+			Linker::Option<bool> preload{"preload", "Place the preload pages at the start of the page data and record the preload page counts"};
+			Linker::Option<std::vector<std::string>> preload_segments{"preload_segments", "Segments whose pages should also be preloaded"};
+			Linker::Option<std::string> page_profile{"page_profile", "File listing accessed addresses in order, used to order the remaining pages (LX only)"};
 
 			LEOptionCollector()
 			{
-				InitializeFields(stub, system, type, compat, stack, heap, le, lx);
+				InitializeFields(stub, system, type, compat, stack, heap, le, lx, checksum, preload, preload_segments, page_profile);
 			}
 		};
 
@@ -797,9 +802,20 @@ namespace Microsoft
 		std::shared_ptr<LEFormat> SimulateLinker(compatibility_type compatibility);
 
 		mutable MZStubWriter stub;
+		/** @brief Set when the executable is stored inside a container (such as a W3 file), file_offset is then provided by the container and no stub is written */
+		bool embedded = false;
 
 		compatibility_type compatibility = CompatibleNone;
 
+		/** @brief Generate a per-page checksum table, each entry is the sum of the 32-bit words of the page, calculated while the pages are written */
+		bool option_checksum = false;
+		/** @brief Group the preload pages, followed by the instance preload pages, at the start of the page data, and fill in the preload page counts */
+		bool option_preload = false;
+		/** @brief Names of the segments whose objects get the preload flag, in addition to the default ones */
+		std::vector<std::string> option_preload_segments;
+		/** @brief A text file of hexadecimal addresses, one per line, in the order they were first accessed, used to order the demand loaded pages */
+		std::string option_page_profile;
+
 		/*std::string stub_file;*/
 		std::string program_name, module_name;
 
@@ -838,7 +854,15 @@ namespace Microsoft
 		void Link(Linker::Module& module);
 		void ProcessModule(Linker::Module& module) override;
 		void CalculateValues() override;
+		/**
+		 * @brief Determines the order of the pages within the page data, and counts the preload and instance pages
+		 *
+		 * For LX, the page offsets are reassigned so that preload pages come first, then instance preload pages, then the demand loaded pages in the order of the access profile, if any.
+		 * For LE, pages must follow their physical page numbers, so only the preload pages at the start of the page data are counted.
+		 */
+		void OrderPages();
 		void GenerateFile(std::string filename, Linker::Module& module) override;
+		void AccountMemory(Linker::MemoryUsage& usage) const override;
 		using Linker::OutputFormat::GetDefaultExtension;
 		std::string GetDefaultExtension(Linker::Module& module, std::string filename) const override;
 
@@ -1,6 +1,7 @@
 
 #include <cstring>
 #include "macos.h"
+#include "../linker/duplicate_finder.h"
 #include "../linker/options.h"
 #include "../linker/position.h"
 #include "../linker/reader.h"
@@ -909,11 +910,12 @@ void AppleSingleDouble::GenerateFile(std::string filename, Linker::Module& modul
 	CalculateValues();
 
 	std::ofstream out;
+	std::string path_name = Linker::ResolvePath(filename);
 	Linker::Writer wr(::BigEndian);
 	switch(type)
 	{
 	case SINGLE:
-		out.open(filename, std::ios_base::out | std::ios_base::binary);
+		out.open(path_name, std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		WriteFile(wr);
 		out.close();
@@ -921,12 +923,12 @@ void AppleSingleDouble::GenerateFile(std::string filename, Linker::Module& modul
 	case DOUBLE:
 		{
 			std::ofstream empty;
-			empty.open(filename, std::ios_base::out | std::ios_base::binary);
+			empty.open(path_name, std::ios_base::out | std::ios_base::binary);
 			empty.close();
 		}
 
 		// TODO: check host operating system
-		out.open(GetUNIXDoubleFilename(filename), std::ios_base::out | std::ios_base::binary);
+		out.open(GetUNIXDoubleFilename(path_name), std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		WriteFile(wr);
 		out.close();
@@ -977,9 +979,17 @@ void DataFork::CalculateValues()
 
 // ResourceFork
 
+std::shared_ptr<Linker::OptionCollector> ResourceFork::GetOptions()
+{
+	return std::make_shared<ResourceForkOptionCollector>();
+}
+
 void ResourceFork::SetOptions(std::map<std::string, std::string>& options)
 {
-	/* TODO */
+	ResourceForkOptionCollector collector;
+	collector.ConsiderOptions(options);
+
+	option_merge_resources = collector.merge_resources();
 }
 
 std::vector<Linker::OptionDescription<void>> ResourceFork::MemoryModelNames =
@@ -1624,6 +1634,9 @@ void ResourceFork::CalculateValues()
 	uint16_t reference_list_offset = 2 + resources.size() * 8;
 	resource_types.clear();
 	resource_names.clear();
+	/* a resource identical to one already stored shares its data */
+	Linker::DuplicateFinder duplicate_resources;
+	std::vector<uint32_t> stored_resource_offsets;
 	for(auto it : resources)
 	{
 		if(it.second.size() == 0)
@@ -1642,7 +1655,27 @@ void ResourceFork::CalculateValues()
 			reference.data = resource;
 			reference.data_offset = data_length;
 			resource->CalculateValues();
-			data_length += 4 + resource->ImageSize();
+			if(option_merge_resources && resource->ImageSize() != 0)
+			{
+				std::ostringstream contents;
+				Linker::Writer wr(::BigEndian, &contents);
+				resource->WriteFile(wr);
+				std::string data = contents.str();
+				size_t index = duplicate_resources.Add(std::vector<uint8_t>(data.begin(), data.end()), 4 + data.size());
+				if(index == Linker::DuplicateFinder::None)
+				{
+					stored_resource_offsets.push_back(reference.data_offset);
+				}
+				else
+				{
+					reference.data_offset = stored_resource_offsets[index];
+					reference.merged = true;
+				}
+			}
+			if(!reference.merged)
+			{
+				data_length += 4 + resource->ImageSize();
+			}
 			if(resource->name)
 			{
 				resource_names.push_back(*resource->name);
@@ -1660,6 +1693,11 @@ void ResourceFork::CalculateValues()
 		resource_types.push_back(type);
 	}
 
+	if(option_merge_resources)
+	{
+		duplicate_resources.ReportDuplicates("resource");
+	}
+
 	resource_type_list_offset = 28;
 	name_list_offset = resource_type_list_offset + reference_list_offset;
 	if(data_offset < 16)
@@ -1761,6 +1799,8 @@ offset_t ResourceFork::WriteFile(Linker::Writer& wr) const
 	{
 		for(auto& reference : type.references)
 		{
+			if(reference.merged)
+				continue;
 			std::shared_ptr<Resource> resource = reference.data;
 			wr.Seek(write_offset + data_offset + reference.data_offset);
 			wr.WriteWord(4, resource->ImageSize());
@@ -2642,6 +2682,12 @@ std::shared_ptr<MacBinary> MacDriver::GetMacBinary()
 	return std::const_pointer_cast<MacBinary>(const_cast<const MacDriver *>(this)->GetMacBinary());
 }
 
+std::shared_ptr<Linker::OptionCollector> MacDriver::GetOptions()
+{
+	ResourceFork tmp;
+	return tmp.GetOptions();
+}
+
 void MacDriver::SetOptions(std::map<std::string, std::string>& options)
 {
 	this->options = options;
@@ -2683,13 +2729,14 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 	container->CalculateValues();
 
 	std::ofstream out;
+	std::string path_name = Linker::ResolvePath(filename);
 	Linker::Writer wr(::BigEndian);
 	switch(target)
 	{
 	case TARGET_NONE:
 		break;
 	case TARGET_DATA_FORK:
-		out.open(filename, std::ios_base::out | std::ios_base::binary);
+		out.open(path_name, std::ios_base::out | std::ios_base::binary);
 		if(auto entry = container->FindEntry(AppleSingleDouble::ID_DataFork))
 		{
 			wr.out = &out;
@@ -2698,7 +2745,7 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 		out.close();
 		break;
 	case TARGET_RESOURCE_FORK:
-		out.open(filename, std::ios_base::out | std::ios_base::binary);
+		out.open(path_name, std::ios_base::out | std::ios_base::binary);
 		if(auto entry = container->FindEntry(AppleSingleDouble::ID_ResourceFork))
 		{
 			wr.out = &out;
@@ -2707,14 +2754,14 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 		out.close();
 		break;
 	case TARGET_APPLE_SINGLE:
-		out.open(filename, std::ios_base::out | std::ios_base::binary);
+		out.open(path_name, std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		WriteFile(wr);
 		out.close();
 		break;
 	case TARGET_MAC_BINARY:
 		// TODO: untested
-		out.open(filename, std::ios_base::out | std::ios_base::binary);
+		out.open(path_name, std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		{
 			MacBinary macbinary(*container, macbinary_version, macbinary_minimum_version);
@@ -2729,7 +2776,7 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 	{
 		Linker::Debug << "Debug: Generating resource fork under .rsrc" << std::endl;
 		std::error_code err;
-		std::filesystem::path path = std::filesystem::path(filename);
+		std::filesystem::path path = std::filesystem::path(path_name);
 		path = path.parent_path() / ".rsrc" / path.filename();
 		if(!std::filesystem::create_directory(path.parent_path(), err) && err != std::errc(0))
 		{
@@ -2751,7 +2798,7 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 	{
 		Linker::Debug << "Debug: Generating Finder Info file under .finf" << std::endl;
 		std::error_code err;
-		std::filesystem::path path = std::filesystem::path(filename);
+		std::filesystem::path path = std::filesystem::path(path_name);
 		path = path.parent_path() / ".finf" / path.filename();
 		if(!std::filesystem::create_directory(path.parent_path(), err) && err != std::errc(0))
 		{
@@ -2773,7 +2820,7 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 	{
 		Linker::Debug << "Debug: Generating AppleDouble" << std::endl;
 		std::ofstream out;
-		out.open(container->GetUNIXDoubleFilename(filename), std::ios_base::out | std::ios_base::binary);
+		out.open(container->GetUNIXDoubleFilename(path_name), std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		if(target != TARGET_APPLE_SINGLE)
 		{
@@ -2792,7 +2839,7 @@ void MacDriver::GenerateFile(std::string filename, Linker::Module& module)
 		Linker::Debug << "Debug: Generating MacBinary" << std::endl;
 		std::ofstream out;
 		out.open(
-			target == TARGET_NONE ? filename : filename + ".mbin",
+			target == TARGET_NONE ? path_name : path_name + ".mbin",
 			std::ios_base::out | std::ios_base::binary);
 		wr.out = &out;
 		MacBinary macbinary(*container, macbinary_version, macbinary_minimum_version);
@@ -7,6 +7,7 @@
 #include <vector>
 #include "../dumper/dumper.h"
 #include "../linker/module.h"
+#include "../linker/options.h"
 #include "../linker/segment.h"
 #include "../linker/segment_manager.h"
 #include "../linker/writer.h"
@@ -306,6 +307,22 @@ namespace Apple
 		};
 		memory_model_t memory_model = MODEL_DEFAULT;
 
+		class ResourceForkOptionCollector : public Linker::OptionCollector
+		{
+		public:
+			Linker::Option<bool> merge_resources{"merge_resources", "Store resources with identical contents only once"};
+
+			ResourceForkOptionCollector()
+			{
+				InitializeFields(merge_resources);
+			}
+		};
+
+		/** @brief Let resources with identical contents share the same data in the resource fork */
+		bool option_merge_resources = false;
+
+		std::shared_ptr<Linker::OptionCollector> GetOptions() override;
+
 		void SetOptions(std::map<std::string, std::string>& options) override;
 
 		static std::vector<Linker::OptionDescription<void>> MemoryModelNames;
@@ -481,6 +498,8 @@ namespace Apple
 			uint8_t attributes = 0;
 			uint32_t data_offset = 0;
 			std::shared_ptr<Resource> data;
+			/** @brief Set if the reference shares the data of an identical resource stored earlier, only used for generating images */
+			bool merged = false;
 		};
 
 		struct ResourceType
@@ -1068,6 +1087,8 @@ namespace Apple
 		std::map<std::string, std::string> script_options;
 
 	public:
+		std::shared_ptr<Linker::OptionCollector> GetOptions() override;
+
 		void SetOptions(std::map<std::string, std::string>& options) override;
 
 		std::vector<Linker::OptionDescription<void>> GetMemoryModelNames() override;
@@ -1,5 +1,7 @@
 
+#include <cstring>
 #include "mzexe.h"
+#include "../linker/checksum.h"
 #include "../linker/position.h"
 #include "../linker/resolution.h"
 
@@ -243,6 +245,12 @@ void MZFormat::ReadFile(Linker::Reader& rd)
 offset_t MZFormat::WriteFile(Linker::Writer& wr) const
 {
 	wr.endiantype = ::LittleEndian;
+	Linker::Checksum file_checksum(2);
+	if(option_checksum)
+	{
+		wr.checksums.push_back(&file_checksum);
+	}
+
 	wr.WriteData(2, signature);
 	wr.WriteWord(2, last_block_size);
 	wr.WriteWord(2, file_size_blocks);
@@ -252,7 +260,7 @@ offset_t MZFormat::WriteFile(Linker::Writer& wr) const
 	wr.WriteWord(2, max_extra_paras);
 	wr.WriteWord(2, ss);
 	wr.WriteWord(2, sp);
-	wr.WriteWord(2, 0); /* TODO: checksum */
+	wr.WriteWord(2, 0); /* checksum, filled in at the end */
 	wr.WriteWord(2, ip);
 	wr.WriteWord(2, cs);
 	wr.WriteWord(2, relocation_offset);
@@ -274,6 +282,21 @@ offset_t MZFormat::WriteFile(Linker::Writer& wr) const
 
 	wr.FillTo(ImageSize());
 
+	if(option_checksum)
+	{
+		std::erase(wr.checksums, &file_checksum);
+		if(file_checksum.valid)
+		{
+			wr.Seek(0x12);
+			wr.WriteWord(2, uint16_t(~file_checksum.sum));
+			wr.Seek(ImageSize());
+		}
+		else
+		{
+			Linker::Warning << "Warning: unable to calculate the checksum" << std::endl;
+		}
+	}
+
 	return ImageSize();
 }
 
@@ -304,6 +327,21 @@ void MZFormat::Dump(Dumper::Dumper& dump) const
 	header_region.AddOptionalField("Checksum", Dumper::HexDisplay::Make(4), offset_t(checksum));
 	header_region.Display(dump);
 
+	if(IsCompressed())
+	{
+		std::vector<uint8_t> header_data(EXEPackHeader::SIZE);
+		image->AsImage()->ReadData(ip, offset_t(cs) << 4, header_data.data());
+		EXEPackHeader header;
+		header.Load(header_data, 0, ip == EXEPackHeader::SIZE);
+
+		Dumper::Region exepack_region("EXEPACK header", file_offset + GetHeaderSize() + (offset_t(cs) << 4), header.exepack_size, 6);
+		exepack_region.AddField("SS:SP", Dumper::SegmentedDisplay::Make(), offset_t(header.real_ss), offset_t(header.real_sp));
+		exepack_region.AddField("CS:IP", Dumper::SegmentedDisplay::Make(), offset_t(header.real_cs), offset_t(header.real_ip));
+		exepack_region.AddField("Expanded size", Dumper::HexDisplay::Make(), offset_t(uint32_t(header.dest_len) << 4));
+		exepack_region.AddOptionalField("Skip paragraphs", Dumper::DecDisplay::Make(), offset_t(header.skip_len - 1));
+		exepack_region.Display(dump);
+	}
+
 	Dumper::Region relocations_region("Relocations", file_offset + relocation_offset, relocation_count * 4, 8);
 	relocations_region.AddField("Count", Dumper::DecDisplay::Make(), offset_t(relocation_count));
 	relocations_region.Display(dump);
@@ -378,6 +416,464 @@ void MZFormat::CalculateValues()
 	max_extra_paras = min_extra_paras + extra_paras; /* TODO */
 }
 
+/* * * EXEPACK compression * * */
+
+void MZFormat::EXEPackHeader::Load(const std::vector<uint8_t>& data, size_t offset, bool has_skip_len)
+{
+	real_ip = ::ReadUnsigned(2, 2, data.data() + offset, ::LittleEndian);
+	real_cs = ::ReadUnsigned(2, 2, data.data() + offset + 2, ::LittleEndian);
+	mem_start = ::ReadUnsigned(2, 2, data.data() + offset + 4, ::LittleEndian);
+	exepack_size = ::ReadUnsigned(2, 2, data.data() + offset + 6, ::LittleEndian);
+	real_sp = ::ReadUnsigned(2, 2, data.data() + offset + 8, ::LittleEndian);
+	real_ss = ::ReadUnsigned(2, 2, data.data() + offset + 10, ::LittleEndian);
+	dest_len = ::ReadUnsigned(2, 2, data.data() + offset + 12, ::LittleEndian);
+	skip_len = has_skip_len ? ::ReadUnsigned(2, 2, data.data() + offset + 14, ::LittleEndian) : 1;
+}
+
+void MZFormat::EXEPackHeader::Store(std::vector<uint8_t>& data, size_t offset) const
+{
+	::WriteWord(2, 2, data.data() + offset, real_ip, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 2, real_cs, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 4, mem_start, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 6, exepack_size, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 8, real_sp, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 10, real_ss, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 12, dest_len, ::LittleEndian);
+	::WriteWord(2, 2, data.data() + offset + 14, skip_len, ::LittleEndian);
+	data[offset + 16] = 'R';
+	data[offset + 17] = 'B';
+}
+
+/**
+ * @brief Decompressor placed after the EXEPACK header
+ *
+ * On entry, CS points to the header, DS and ES to the PSP, and SS:SP to a small stack placed above the final location of the decompressor.
+ * The offsets of the header fields, the relocated entry, the message and the relocation table are hardcoded.
+ */
+static const uint8_t EXEPackDecompressor[] =
+{
+	/* start: */
+	/* CS = packed segment, DS = ES = PSP, SS = load segment + dest_len */
+	0x50,	/* push ax */
+	0x8C, 0xC0,	/* mov ax, es */
+	0x83, 0xC0, 0x10,	/* add ax, 0x10 */
+	0x0E,	/* push cs */
+	0x1F,	/* pop ds */
+	0xA3, 0x04, 0x00,	/* mov [4], ax */
+	0x8C, 0xCD,	/* mov bp, cs */
+	0x8C, 0xD3,	/* mov bx, ss */
+	0x8E, 0xC3,	/* mov es, bx */
+	0x8B, 0x0E, 0x06, 0x00,	/* mov cx, [6] */
+	0x89, 0xCE,	/* mov si, cx */
+	0x4E,	/* dec si */
+	0x89, 0xF7,	/* mov di, si */
+	0xFD,	/* std */
+	0xF3, 0xA4,	/* rep movsb */
+	0x53,	/* push bx */
+	0xB8, 0x35, 0x00,	/* mov ax, offset relocated */
+	0x50,	/* push ax */
+	0xCB,	/* retf */
+	/* relocated: */
+	/* CS = ES = SS, BP = packed segment */
+	0x89, 0xEA,	/* mov dx, bp */
+	0x4A,	/* dec dx */
+	0xB8, 0x0F, 0x00,	/* mov ax, 0x000F */
+	0xE8, 0x96, 0x00,	/* call normalize */
+	0x8E, 0xDA,	/* mov ds, dx */
+	0x89, 0xC6,	/* mov si, ax */
+	0x8C, 0xCA,	/* mov dx, cs */
+	0x4A,	/* dec dx */
+	0xB8, 0x0F, 0x00,	/* mov ax, 0x000F */
+	0xE8, 0x89, 0x00,	/* call normalize */
+	0x8E, 0xC2,	/* mov es, dx */
+	0x89, 0xC7,	/* mov di, ax */
+	/* skip_padding: */
+	0xAC,	/* lodsb */
+	0x3C, 0xFF,	/* cmp al, 0xFF */
+	0x74, 0xFB,	/* je skip_padding */
+	0x46,	/* inc si */
+	/* next_command: */
+	0x8C, 0xDA,	/* mov dx, ds */
+	0x89, 0xF0,	/* mov ax, si */
+	0xE8, 0x78, 0x00,	/* call normalize */
+	0x8E, 0xDA,	/* mov ds, dx */
+	0x89, 0xC6,	/* mov si, ax */
+	0x8C, 0xC2,	/* mov dx, es */
+	0x89, 0xF8,	/* mov ax, di */
+	0xE8, 0x6D, 0x00,	/* call normalize */
+	0x8E, 0xC2,	/* mov es, dx */
+	0x89, 0xC7,	/* mov di, ax */
+	0xAC,	/* lodsb */
+	0x88, 0xC3,	/* mov bl, al */
+	0x4E,	/* dec si */
+	0xAD,	/* lodsw */
+	0x89, 0xC1,	/* mov cx, ax */
+	0x46,	/* inc si */
+	0x88, 0xD8,	/* mov al, bl */
+	0x24, 0xFE,	/* and al, 0xFE */
+	0x3C, 0xB0,	/* cmp al, 0xB0 */
+	0x74, 0x08,	/* je fill */
+	0x3C, 0xB2,	/* cmp al, 0xB2 */
+	0x75, 0x75,	/* jne corrupt */
+	0xF3, 0xA4,	/* rep movsb */
+	0xEB, 0x03,	/* jmp command_done */
+	/* fill: */
+	0xAC,	/* lodsb */
+	0xF3, 0xAA,	/* rep stosb */
+	/* command_done: */
+	0xF6, 0xC3, 0x01,	/* test bl, 1 */
+	0x74, 0xCA,	/* jz next_command */
+	/* apply relocations */
+	0x0E,	/* push cs */
+	0x1F,	/* pop ds */
+	0xFC,	/* cld */
+	0x8B, 0x2E, 0x04, 0x00,	/* mov bp, [4] */
+	0xBE, 0x1E, 0x01,	/* mov si, offset relocations */
+	0x89, 0xEA,	/* mov dx, bp */
+	0xBB, 0x10, 0x00,	/* mov bx, 16 */
+	/* relocate_frame: */
+	0xAD,	/* lodsw */
+	0x89, 0xC1,	/* mov cx, ax */
+	0xE3, 0x0A,	/* jcxz frame_done */
+	0x8E, 0xC2,	/* mov es, dx */
+	/* relocate_entry: */
+	0xAD,	/* lodsw */
+	0x89, 0xC7,	/* mov di, ax */
+	0x26, 0x01, 0x2D,	/* add es:[di], bp */
+	0xE2, 0xF8,	/* loop relocate_entry */
+	/* frame_done: */
+	0x81, 0xC2, 0x00, 0x10,	/* add dx, 0x1000 */
+	0x4B,	/* dec bx */
+	0x75, 0xEA,	/* jnz relocate_frame */
+	/* start program */
+	0xA1, 0x0A, 0x00,	/* mov ax, [10] */
+	0x01, 0xE8,	/* add ax, bp */
+	0x8B, 0x1E, 0x08, 0x00,	/* mov bx, [8] */
+	0x01, 0x2E, 0x02, 0x00,	/* add [2], bp */
+	0x5E,	/* pop si */
+	0xFA,	/* cli */
+	0x8E, 0xD0,	/* mov ss, ax */
+	0x89, 0xDC,	/* mov sp, bx */
+	0xFB,	/* sti */
+	0x89, 0xE8,	/* mov ax, bp */
+	0x83, 0xE8, 0x10,	/* sub ax, 0x10 */
+	0x8E, 0xD8,	/* mov ds, ax */
+	0x8E, 0xC0,	/* mov es, ax */
+	0x89, 0xF0,	/* mov ax, si */
+	0x2E, 0xFF, 0x2E, 0x00, 0x00,	/* jmp dword ptr cs:[0] */
+	/* normalize: */
+	/* DX:AX -> DX:AX, with AX maximized, but never past the bottom of memory */
+	0x89, 0xC3,	/* mov bx, ax */
+	0x83, 0xE0, 0x0F,	/* and ax, 0x000F */
+	0xB1, 0x04,	/* mov cl, 4 */
+	0xD3, 0xEB,	/* shr bx, cl */
+	0x01, 0xDA,	/* add dx, bx */
+	0x81, 0xFA, 0xFF, 0x0F,	/* cmp dx, 0x0FFF */
+	0x72, 0x08,	/* jb normalize_low */
+	0x81, 0xEA, 0xFF, 0x0F,	/* sub dx, 0x0FFF */
+	0x83, 0xC0, 0xF0,	/* add ax, 0xFFF0 */
+	0xC3,	/* ret */
+	/* normalize_low: */
+	0xD3, 0xE2,	/* shl dx, cl */
+	0x01, 0xD0,	/* add ax, dx */
+	0x31, 0xD2,	/* xor dx, dx */
+	0xC3,	/* ret */
+	/* corrupt: */
+	0x0E,	/* push cs */
+	0x1F,	/* pop ds */
+	0xB4, 0x40,	/* mov ah, 0x40 */
+	0xBB, 0x02, 0x00,	/* mov bx, 2 */
+	0xB9, 0x16, 0x00,	/* mov cx, relocations - message */
+	0xBA, 0x08, 0x01,	/* mov dx, offset message */
+	0xCD, 0x21,	/* int 0x21 */
+	0xB8, 0xFF, 0x4C,	/* mov ax, 0x4CFF */
+	0xCD, 0x21,	/* int 0x21 */
+	/* message: followed by the relocation table */
+};
+
+bool MZFormat::PackData(const std::vector<uint8_t>& data, std::vector<uint8_t>& packed)
+{
+	struct Command
+	{
+		bool fill;
+		size_t offset;
+		size_t length;
+	};
+	std::vector<Command> commands;
+
+	/* running difference between the expanded and compressed sizes of the commands so far */
+	ptrdiff_t balance = 0;
+	ptrdiff_t minimum_balance = 0;
+	/* expansion starts at the last command where the balance is minimal, the previous data is stored as is */
+	size_t first_command = 0;
+
+	auto add_command = [&](bool fill, size_t offset, size_t length)
+	{
+		while(length > 0)
+		{
+			size_t count = std::min(length, size_t(EXEPackHeader::MaximumLength));
+			commands.push_back(Command{fill, offset, count});
+			balance += fill ? ptrdiff_t(count) - 4 : -3;
+			if(balance <= minimum_balance)
+			{
+				minimum_balance = balance;
+				first_command = commands.size();
+			}
+			offset += count;
+			length -= count;
+		}
+	};
+
+	size_t literal_start = 0;
+	for(size_t offset = 0; offset < data.size();)
+	{
+		size_t run_end = offset + 1;
+		while(run_end < data.size() && data[run_end] == data[offset])
+			run_end++;
+		size_t run_length = run_end - offset;
+		/* a fill between two copies also costs the header of the second copy */
+		if(run_length >= (offset == literal_start ? 5 : 8))
+		{
+			add_command(false, literal_start, offset - literal_start);
+			add_command(true, offset, run_length);
+			literal_start = run_end;
+		}
+		offset = run_end;
+	}
+	add_command(false, literal_start, data.size() - literal_start);
+
+	if(first_command >= commands.size())
+		return false;
+
+	packed.clear();
+	packed.reserve(data.size() - (balance - minimum_balance));
+	packed.insert(packed.end(), data.begin(), data.begin() + commands[first_command].offset);
+	for(size_t index = first_command; index < commands.size(); index++)
+	{
+		const Command& command = commands[index];
+		if(command.fill)
+		{
+			packed.push_back(data[command.offset]);
+		}
+		else
+		{
+			packed.insert(packed.end(), data.begin() + command.offset, data.begin() + command.offset + command.length);
+		}
+		packed.push_back(command.length);
+		packed.push_back(command.length >> 8);
+		packed.push_back((command.fill ? EXEPackHeader::CommandFill : EXEPackHeader::CommandCopy) | (index == first_command ? EXEPackHeader::CommandLast : 0));
+	}
+	return true;
+}
+
+bool MZFormat::UnpackData(const std::vector<uint8_t>& packed, std::vector<uint8_t>& data)
+{
+	size_t source = packed.size();
+	size_t destination = data.size();
+	while(source > 0 && packed[source - 1] == 0xFF)
+		source--;
+
+	uint8_t command;
+	do
+	{
+		if(source < 3)
+			return false;
+		command = packed[source - 1];
+		size_t length = packed[source - 3] | (packed[source - 2] << 8);
+		source -= 3;
+		if(destination < length)
+			return false;
+		switch(command & ~EXEPackHeader::CommandLast)
+		{
+		case EXEPackHeader::CommandFill:
+			if(source < 1)
+				return false;
+			source -= 1;
+			std::fill_n(data.begin() + destination - length, length, packed[source]);
+			break;
+		case EXEPackHeader::CommandCopy:
+			if(source < length)
+				return false;
+			source -= length;
+			std::copy_n(packed.begin() + source, length, data.begin() + destination - length);
+			break;
+		default:
+			return false;
+		}
+		destination -= length;
+		/* in memory, the expanded data would overwrite the compressed stream */
+		if(destination < source)
+			return false;
+	} while(!(command & EXEPackHeader::CommandLast));
+
+	/* the remaining data is already in place */
+	std::copy_n(packed.begin(), std::min(destination, packed.size()), data.begin());
+	return true;
+}
+
+bool MZFormat::Compress()
+{
+	if(GetSignature() == MAGIC_DL)
+	{
+		Linker::Warning << "Warning: compression not supported for .exm files, generating uncompressed image" << std::endl;
+		return false;
+	}
+
+	std::vector<uint8_t> data(::AlignTo(GetDataSize(), 0x10), 0);
+	if(image)
+		image->AsImage()->ReadData(GetDataSize(), 0, data.data());
+	if((data.size() >> 4) > 0xFFFF)
+	{
+		Linker::Warning << "Warning: image too large for compression, generating uncompressed image" << std::endl;
+		return false;
+	}
+
+	std::vector<uint8_t> packed;
+	if(!PackData(data, packed))
+	{
+		Linker::Warning << "Warning: image cannot be compressed, generating uncompressed image" << std::endl;
+		return false;
+	}
+	packed.resize(::AlignTo(packed.size(), 0x10), 0xFF);
+	size_t header_offset = packed.size();
+
+	std::array<std::vector<uint16_t>, 16> frames;
+	for(auto& rel : relocations)
+	{
+		if((rel.GetOffset() >> 16) >= frames.size())
+		{
+			Linker::Warning << "Warning: relocation outside of addressable memory, generating uncompressed image" << std::endl;
+			return false;
+		}
+		frames[rel.GetOffset() >> 16].push_back(rel.GetOffset());
+	}
+
+	EXEPackHeader header;
+	header.real_ip = ip;
+	header.real_cs = cs;
+	header.real_sp = sp;
+	header.real_ss = ss;
+	header.dest_len = data.size() >> 4;
+	size_t exepack_size = EXEPackHeader::SIZE + sizeof EXEPackDecompressor + strlen(EXEPackHeader::CorruptMessage) + 2 * (frames.size() + relocations.size());
+	if(exepack_size + EXEPackHeader::STACK_SIZE > 0xFFFF)
+	{
+		Linker::Warning << "Warning: too many relocations for compression, generating uncompressed image" << std::endl;
+		return false;
+	}
+	header.exepack_size = exepack_size;
+
+	packed.resize(header_offset + EXEPackHeader::SIZE);
+	header.Store(packed, header_offset);
+	packed.insert(packed.end(), EXEPackDecompressor, EXEPackDecompressor + sizeof EXEPackDecompressor);
+	packed.insert(packed.end(), EXEPackHeader::CorruptMessage, EXEPackHeader::CorruptMessage + strlen(EXEPackHeader::CorruptMessage));
+	for(auto& frame : frames)
+	{
+		std::sort(frame.begin(), frame.end());
+		packed.push_back(frame.size());
+		packed.push_back(frame.size() >> 8);
+		for(uint16_t offset : frame)
+		{
+			packed.push_back(offset);
+			packed.push_back(offset >> 8);
+		}
+	}
+
+	offset_t original_size = ::AlignTo(relocation_offset < 0x1C ? 0x20 : relocation_offset + 4 * relocations.size(), 0x10) + GetDataSize();
+	if(0x20 + packed.size() >= original_size)
+	{
+		Linker::Warning << "Warning: compressed image is not smaller, generating uncompressed image" << std::endl;
+		return false;
+	}
+
+	/* the program needs the expanded image with its own extra memory, the decompressor needs to fit above the expanded image with its stack */
+	uint32_t required_memory = std::max(
+		uint32_t(data.size()) + (uint32_t(min_extra_paras) << 4),
+		uint32_t(data.size()) + header.exepack_size + EXEPackHeader::STACK_SIZE);
+	uint32_t required_extra_paras = ((required_memory + 0xF) >> 4) - ((packed.size() + 0xF) >> 4);
+	if(required_extra_paras > 0xFFFF)
+	{
+		Linker::Warning << "Warning: compressed image requires too much memory, generating uncompressed image" << std::endl;
+		return false;
+	}
+
+	Linker::Debug << "Debug: compressed image from " << data.size() << " to " << header_offset << " bytes, " << relocations.size() << " relocations packed" << std::endl;
+
+	image = std::make_shared<Linker::Buffer>(packed);
+	relocations.clear();
+	cs = header_offset >> 4;
+	ip = EXEPackHeader::SIZE;
+	/* the decompressor stack is placed right above where the decompressor moves itself */
+	ss = header.dest_len;
+	sp = header.exepack_size + EXEPackHeader::STACK_SIZE;
+	min_extra_paras = required_extra_paras;
+
+	return true;
+}
+
+bool MZFormat::IsCompressed() const
+{
+	if(image == nullptr || (ip != EXEPackHeader::SIZE && ip != EXEPackHeader::SIZE - 2))
+		return false;
+	offset_t signature_offset = (offset_t(cs) << 4) + ip - 2;
+	if(signature_offset + 2 > image->ImageSize())
+		return false;
+	return image->AsImage()->ReadUnsigned(2, signature_offset, ::LittleEndian) == ('R' | ('B' << 8));
+}
+
+bool MZFormat::Decompress()
+{
+	if(!IsCompressed())
+		return false;
+
+	std::vector<uint8_t> packed(image->ImageSize());
+	image->AsImage()->ReadData(packed.size(), 0, packed.data());
+
+	size_t header_offset = offset_t(cs) << 4;
+	EXEPackHeader header;
+	header.Load(packed, header_offset, ip == EXEPackHeader::SIZE);
+	if(header_offset + header.exepack_size > packed.size() || header.skip_len == 0 || size_t(header.skip_len - 1) << 4 > header_offset)
+		return false;
+
+	/* the relocation table follows the error message of the decompressor */
+	auto stub_end = packed.begin() + header_offset + header.exepack_size;
+	auto message = std::search(packed.begin() + header_offset + ip, stub_end,
+		EXEPackHeader::CorruptMessage, EXEPackHeader::CorruptMessage + strlen(EXEPackHeader::CorruptMessage));
+	if(message == stub_end)
+		return false;
+	size_t relocation_table = message - packed.begin() + strlen(EXEPackHeader::CorruptMessage);
+
+	std::vector<Relocation> new_relocations;
+	for(uint32_t frame = 0; frame < 16; frame++)
+	{
+		if(relocation_table + 2 > header_offset + header.exepack_size)
+			return false;
+		size_t count = ::ReadUnsigned(2, 2, packed.data() + relocation_table, ::LittleEndian);
+		relocation_table += 2;
+		if(relocation_table + 2 * count > header_offset + header.exepack_size)
+			return false;
+		for(size_t i = 0; i < count; i++)
+		{
+			new_relocations.push_back(Relocation(frame << 12, ::ReadUnsigned(2, 2, packed.data() + relocation_table, ::LittleEndian)));
+			relocation_table += 2;
+		}
+	}
+
+	std::vector<uint8_t> data(size_t(header.dest_len) << 4);
+	packed.resize(header_offset - ((header.skip_len - 1) << 4));
+	if(!UnpackData(packed, data))
+		return false;
+
+	image = std::make_shared<Linker::Buffer>(data);
+	relocations = new_relocations;
+	relocation_count = relocations.size();
+	cs = header.real_cs;
+	ip = header.real_ip;
+	ss = header.real_ss;
+	sp = header.real_sp;
+
+	return true;
+}
+
 /* * * Writer members * * */
 
 bool MZFormat::FormatSupportsSegmentation() const
@@ -473,6 +969,8 @@ void MZFormat::SetOptions(std::map<std::string, std::string>& options)
 		option_file_align = file_align.value();
 	}
 	stack_size = collector.stack();
+	option_compress = collector.compress();
+	option_checksum = collector.checksum();
 }
 
 void MZFormat::OnNewSegment(std::shared_ptr<Linker::Segment> segment)
@@ -713,6 +1211,11 @@ void MZFormat::ProcessModule(Linker::Module& module)
 	}
 
 	min_extra_paras = (zero_fill + 0xF) >> 4;
+
+	if(option_compress)
+	{
+		Compress();
+	}
 }
 
 uint32_t MZFormat::GetDataSize() const
@@ -743,7 +1246,7 @@ bool MZSimpleStubWriter::OpenAndCheckValidFile()
 	{
 		if(!stream.is_open())
 		{
-			stream.open(filename, std::ios_base::in | std::ios_base::binary);
+			stream.open(Linker::ResolvePath(filename), std::ios_base::in | std::ios_base::binary);
 		}
 		if(!stream.good())
 		{
@@ -828,7 +1331,7 @@ bool MZStubWriter::OpenAndCheckValidFile()
 	{
 		if(!stream.is_open())
 		{
-			stream.open(filename, std::ios_base::in | std::ios_base::binary);
+			stream.open(Linker::ResolvePath(filename), std::ios_base::in | std::ios_base::binary);
 		}
 		if(!stream.good())
 		{
@@ -71,8 +71,8 @@ namespace Microsoft
 		uint16_t ss = 0;
 		/** @brief Initial value for the stack (SP) */
 		uint16_t sp = 0;
-		/** @brief Checksum */
-		uint16_t checksum = 0; /* TODO: fill when writing */
+		/** @brief Checksum, the one's complement of the sum of all the words in the file, calculated while writing if option_checksum is set */
+		uint16_t checksum = 0;
 		/** @brief Entry point initial value for IP */
 		uint16_t ip = 0;
 		/** @brief Initial value for the code segment (CS) */
@@ -172,6 +172,101 @@ namespace Microsoft
 
 		void CalculateValues() override;
 
+		/* * * EXEPACK compression * * */
+
+		/**
+		 * @brief Header of an EXEPACK compatible self-extracting image, placed at the start of the entry point segment
+		 *
+		 * A packed image consists of the compressed program image, padded to a paragraph boundary with 0xFF bytes,
+		 * followed by this header, the decompressor and the packed relocation table.
+		 * The decompressor moves itself above the expanded image, expands the image in place from its end backwards,
+		 * applies the relocations, and then transfers control to the original entry point.
+		 *
+		 * The compressed stream is a sequence of commands, read backwards from its end.
+		 * Each command is the byte CommandFill or CommandCopy, ORed with CommandLast for the final command, preceded by a 16-bit length.
+		 * A fill command is further preceded by the byte to repeat, a copy command by the bytes to copy.
+		 * The bytes preceding the final command are left in place.
+		 *
+		 * The relocation table contains 16 lists of 16-bit offsets, one for each 64 KiB frame of the image, each prefixed by its entry count.
+		 */
+		struct EXEPackHeader
+		{
+			static constexpr uint8_t CommandFill = 0xB0;
+			static constexpr uint8_t CommandCopy = 0xB2;
+			static constexpr uint8_t CommandLast = 0x01;
+			/** @brief Longest command generated, short enough to never overflow a normalized pointer in the decompressor */
+			static constexpr uint16_t MaximumLength = 0xFF00;
+			/** @brief Size of the header, the original EXEPACK also had a variant without the skip_len field */
+			static constexpr size_t SIZE = 18;
+			/** @brief Size of the stack placed above the relocated decompressor */
+			static constexpr uint16_t STACK_SIZE = 0x80;
+			/** @brief Message displayed by the decompressor for invalid data, the relocation table follows it */
+			static constexpr const char * CorruptMessage = "Packed file is corrupt";
+
+			/** @brief Entry point of the original program */
+			uint16_t real_ip = 0;
+			/** @brief Entry point segment of the original program, relative to the load segment */
+			uint16_t real_cs = 0;
+			/** @brief Used by the decompressor to store the load segment, 0 in the file */
+			uint16_t mem_start = 0;
+			/** @brief Size of the header, decompressor and packed relocation table */
+			uint16_t exepack_size = 0;
+			/** @brief Initial stack pointer of the original program */
+			uint16_t real_sp = 0;
+			/** @brief Initial stack segment of the original program, relative to the load segment */
+			uint16_t real_ss = 0;
+			/** @brief Size of the expanded image, in paragraphs */
+			uint16_t dest_len = 0;
+			/** @brief Number of paragraphs between the end of the compressed data and the header, plus 1 */
+			uint16_t skip_len = 1;
+
+			/** @brief Parses the header from a memory image, the 16 byte variant lacks the skip_len field */
+			void Load(const std::vector<uint8_t>& data, size_t offset, bool has_skip_len = true);
+
+			/** @brief Stores the header into a memory image */
+			void Store(std::vector<uint8_t>& data, size_t offset) const;
+		};
+
+		/**
+		 * @brief Compresses an image into an EXEPACK compatible stream
+		 *
+		 * The data is encoded in a single pass, runs of repeated bytes become fill commands and the remaining bytes copy commands.
+		 * As many of the leading commands are dropped as needed so that the stream can be safely expanded in place, with the source never overtaking the destination.
+		 *
+		 * @param data The image to compress, its size must be a multiple of 16
+		 * @param packed The generated stream, without the trailing padding
+		 * @return false if the data cannot be made smaller
+		 */
+		static bool PackData(const std::vector<uint8_t>& data, std::vector<uint8_t>& packed);
+
+		/**
+		 * @brief Expands an EXEPACK compatible stream the way the decompressor does in memory
+		 *
+		 * @param packed The compressed stream, possibly followed by 0xFF padding bytes
+		 * @param data The expanded image, must already have its final size
+		 * @return false if the stream is corrupt
+		 */
+		static bool UnpackData(const std::vector<uint8_t>& packed, std::vector<uint8_t>& data);
+
+		/**
+		 * @brief Replaces the image, relocations, entry point and stack with an EXEPACK compatible self-extracting image
+		 *
+		 * @return false if the image was left unchanged
+		 */
+		bool Compress();
+
+		/** @brief Checks whether the entry point is the start of an EXEPACK decompressor */
+		bool IsCompressed() const;
+
+		/**
+		 * @brief Restores the image, relocations, entry point and stack of an EXEPACK compressed image
+		 *
+		 * The memory requirements are not modified.
+		 *
+		 * @return false if the image is not compressed or it is corrupt
+		 */
+		bool Decompress();
+
 		/* * * Writer members * * */
 
 		class MZOptionCollector : public Linker::OptionCollector
@@ -180,10 +275,12 @@ namespace Microsoft
 			Linker::Option<std::optional<offset_t>> header_align{"header_align", "Aligns the end of the header to a specific boundary, must be power of 2"};
 			Linker::Option<std::optional<offset_t>> file_align{"file_align", "Aligns the end of the file to a specific boundary, must be power of 2"};
 			Linker::Option<offset_t> stack{"stack", "Specify the stack size"};
+			Linker::Option<bool> compress{"compress", "Generate an EXEPACK compatible self-extracting compressed executable"};
+			Linker::Option<bool> checksum{"checksum", "Fill in the checksum field of the header"};
 
 			MZOptionCollector()
 			{
-				InitializeFields(header_align, file_align, stack);
+				InitializeFields(header_align, file_align, stack, compress, checksum);
 			}
 		};
 
@@ -220,6 +317,12 @@ namespace Microsoft
 		/** @brief User provided alignment value for file align */
 		uint32_t option_file_align = 1;
 
+		/** @brief User requested EXEPACK compression */
+		bool option_compress = false;
+
+		/** @brief Calculate the checksum field while writing the file */
+		bool option_checksum = false;
+
 		bool FormatSupportsSegmentation() const override;
 
 		bool FormatIs16bit() const override;
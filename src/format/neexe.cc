@@ -1,6 +1,9 @@
 
 #include "neexe.h"
 #include "mzexe.h"
+#include "../linker/checksum.h"
+#include "../linker/duplicate_finder.h"
+#include "../linker/memory_usage.h"
 #include "../linker/position.h"
 #include "../linker/resolution.h"
 
@@ -56,6 +59,133 @@ const std::map<offset_t, std::string> Windows::resource_type_id_descriptions =
 	{ Windows::RT_MANIFEST, "RT_MANIFEST" },
 };
 
+offset_t NEFormat::IteratedData::ImageSize() const
+{
+	offset_t size = 4 * records.size();
+	for(auto& record : records)
+	{
+		size += record.data.size();
+	}
+	return size;
+}
+
+offset_t NEFormat::IteratedData::ExpandedSize() const
+{
+	offset_t size = 0;
+	for(auto& record : records)
+	{
+		size += offset_t(record.count) * record.data.size();
+	}
+	return size;
+}
+
+std::shared_ptr<NEFormat::IteratedData> NEFormat::IteratedData::ReadFromFile(Linker::Reader& rd, offset_t size)
+{
+	std::shared_ptr<IteratedData> iterated = std::make_shared<IteratedData>();
+	offset_t end = rd.Tell() + size;
+	while(rd.Tell() + 4 <= end)
+	{
+		IterationRecord record;
+		record.count = rd.ReadUnsigned(2);
+		uint16_t length = rd.ReadUnsigned(2);
+		if(rd.Tell() + length > end)
+			break;
+		record.data.resize(length);
+		rd.ReadData(record.data);
+		iterated->records.emplace_back(record);
+	}
+	rd.Seek(end);
+	return iterated;
+}
+
+offset_t NEFormat::IteratedData::WriteFile(Linker::Writer& wr, offset_t count, offset_t offset) const
+{
+	std::vector<uint8_t> data;
+	data.reserve(ImageSize());
+	for(auto& record : records)
+	{
+		data.push_back(record.count);
+		data.push_back(record.count >> 8);
+		data.push_back(record.data.size());
+		data.push_back(record.data.size() >> 8);
+		data.insert(data.end(), record.data.begin(), record.data.end());
+	}
+	if(offset >= data.size())
+		return 0;
+	count = std::min(count, offset_t(data.size() - offset));
+	wr.WriteData(count, data.data() + offset);
+	return count;
+}
+
+std::shared_ptr<Linker::Buffer> NEFormat::IteratedData::Expand() const
+{
+	std::vector<uint8_t> data;
+	data.reserve(ExpandedSize());
+	for(auto& record : records)
+	{
+		for(uint16_t i = 0; i < record.count; i++)
+		{
+			data.insert(data.end(), record.data.begin(), record.data.end());
+		}
+	}
+	return std::make_shared<Linker::Buffer>(data);
+}
+
+std::shared_ptr<NEFormat::IteratedData> NEFormat::IteratedData::Compress(const Linker::Image& image)
+{
+	std::vector<uint8_t> data(image.ImageSize());
+	image.ReadData(data.size(), 0, data.data());
+
+	std::shared_ptr<IteratedData> iterated = std::make_shared<IteratedData>();
+	auto add_literal = [&](size_t start, size_t end)
+	{
+		while(start < end)
+		{
+			size_t length = std::min(end - start, size_t(0xFFFF));
+			iterated->records.push_back(IterationRecord{1, std::vector<uint8_t>(data.begin() + start, data.begin() + start + length)});
+			start += length;
+		}
+	};
+
+	size_t literal_start = 0;
+	for(size_t offset = 0; offset < data.size();)
+	{
+		/* look for the pattern that collapses the most bytes */
+		size_t best_period = 0, best_count = 0, best_saved = 0;
+		for(size_t period : { 1, 2, 4 })
+		{
+			size_t end = offset + period;
+			while(end < data.size() && data[end] == data[end - period])
+				end++;
+			size_t count = std::min((end - offset) / period, size_t(0xFFFF));
+			size_t saved = (count - 1) * period;
+			/* the record must save more than its own header and the header of the literal record following it */
+			if(count >= 2 && saved > 8 && saved > best_saved)
+			{
+				best_period = period;
+				best_count = count;
+				best_saved = saved;
+			}
+		}
+
+		if(best_period == 0)
+		{
+			offset++;
+			continue;
+		}
+
+		add_literal(literal_start, offset);
+		iterated->records.push_back(IterationRecord{uint16_t(best_count), std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + best_period)});
+		offset += best_count * best_period;
+		literal_start = offset;
+	}
+	add_literal(literal_start, data.size());
+
+	if(iterated->ImageSize() >= data.size())
+		return nullptr;
+	return iterated;
+}
+
 NEFormat::Segment::Relocation::source_type NEFormat::Segment::Relocation::GetType(Linker::Relocation& rel)
 {
 	if(rel.kind == Linker::Relocation::SelectorIndex)
@@ -97,6 +227,22 @@ size_t NEFormat::Segment::Relocation::GetSize() const
 	}
 }
 
+bool NEFormat::Segment::Relocation::IsChainable() const
+{
+	if((flags & Additive) != 0 || (flags & TargetTypeMask) == OSFixup)
+		return false;
+	/* the link to the following relocation occupies the first 16 bits of the field */
+	switch(type)
+	{
+	case Selector16:
+	case Pointer32:
+	case Offset16:
+		return true;
+	default:
+		return false;
+	}
+}
+
 void NEFormat::Segment::AddRelocation(const Relocation& rel)
 {
 	if(rel.offsets.size() == 0)
@@ -104,30 +250,120 @@ void NEFormat::Segment::AddRelocation(const Relocation& rel)
 	relocations_map[rel.offsets[0]] = rel;
 }
 
+size_t NEFormat::Segment::CollectRelocations(bool chain)
+{
+	relocations.clear();
+	/* index of the relocation record that the next relocation with the same properties can be chained to */
+	std::map<std::tuple<uint8_t, uint8_t, uint16_t, uint16_t>, size_t> chains;
+	size_t saved_records = 0;
+	for(auto& pair : relocations_map)
+	{
+		const Relocation& relocation = pair.second;
+		if(chain && relocation.IsChainable())
+		{
+			auto key = std::make_tuple(uint8_t(relocation.type), uint8_t(relocation.flags), relocation.module, relocation.target);
+			auto it = chains.find(key);
+			if(it != chains.end())
+			{
+				/* the chain is written into the image by WriteFile, the last member keeps the terminating 0xFFFF */
+				relocations[it->second].offsets.push_back(relocation.offsets[0]);
+				saved_records++;
+				continue;
+			}
+			chains[key] = relocations.size();
+		}
+		relocations.emplace_back(relocation);
+	}
+	return saved_records;
+}
+
+std::shared_ptr<Linker::Image> NEFormat::Segment::GetMemoryImage() const
+{
+	if(auto iterated = std::dynamic_pointer_cast<IteratedData>(image))
+	{
+		return iterated->Expand();
+	}
+	return image->AsImage();
+}
+
+bool NEFormat::Segment::MakeIterated()
+{
+	if((flags & Iterated) != 0 || image->ImageSize() == 0)
+		return false;
+
+	/* chained relocations are stored in the segment data, and would have to be written into the records */
+	for(auto& relocation : relocations)
+	{
+		if(relocation.offsets.size() > 1)
+			return false;
+	}
+
+	std::shared_ptr<IteratedData> iterated = IteratedData::Compress(*image->AsImage());
+	if(iterated == nullptr)
+		return false;
+
+	image = iterated;
+	flags = flag_type(flags | Iterated);
+	return true;
+}
+
 void NEFormat::Segment::Dump(Dumper::Dumper& dump, unsigned index, bool isos2) const
 {
-	Dumper::Block segment_block("Segment", data_offset, image->AsImage(), 0, 8);
-	segment_block.InsertField(0, "Number", Dumper::DecDisplay::Make(), offset_t(index + 1));
-	segment_block.AddField("Memory size", Dumper::HexDisplay::Make(4), offset_t(total_size));
-	segment_block.AddField("Flags",
-		Dumper::BitFieldDisplay::Make(4)
-			->AddBitField(0, 1, Dumper::ChoiceDisplay::Make("data", "code"), false)
-			->AddBitField(1, 1, Dumper::ChoiceDisplay::Make("allocated"), true)
-			->AddBitField(2, 1, Dumper::ChoiceDisplay::Make("loaded/real mode"), true)
-			->AddBitField(3, 1, Dumper::ChoiceDisplay::Make("iterated"), true)
-			->AddBitField(4, 1, Dumper::ChoiceDisplay::Make("movable", "fixed"), false)
-			->AddBitField(5, 1, Dumper::ChoiceDisplay::Make("pure", "impure"), false)
-			->AddBitField(6, 1, Dumper::ChoiceDisplay::Make("load on call", "preload"), false)
-			->AddBitField(7, 1, Dumper::ChoiceDisplay::Make((flags & Segment::Data) != 0 ? "read only" : "execute only"), true)
-			->AddBitField(8, 1, Dumper::ChoiceDisplay::Make("relocations present"), true)
-			->AddBitField(9, 1, Dumper::ChoiceDisplay::Make("debugging information present/conforming code segment"), true)
-			->AddBitField(10, 2, "descriptor privilege level", Dumper::HexDisplay::Make(1))
-			->AddBitField(12, 4, "discard priority", Dumper::HexDisplay::Make(1))
-			->AddBitField(12, 1, Dumper::ChoiceDisplay::Make("discardable"), true)
-			->AddBitField(13, 1, Dumper::ChoiceDisplay::Make("32-bit"), true)
-			->AddBitField(14, 1, Dumper::ChoiceDisplay::Make("huge segment"), true)
-			->AddBitField(15, 1, Dumper::ChoiceDisplay::Make("RESRC_HIGH"), true),
-		offset_t(flags));
+	std::shared_ptr<IteratedData> iterated = (flags & Iterated) != 0 ? std::dynamic_pointer_cast<IteratedData>(image) : nullptr;
+	std::shared_ptr<Linker::Image> contents = GetMemoryImage();
+
+	auto add_segment_fields = [&](Dumper::Container& container)
+	{
+		container.InsertField(0, "Number", Dumper::DecDisplay::Make(), offset_t(index + 1));
+		container.AddField("Memory size", Dumper::HexDisplay::Make(4), offset_t(total_size));
+		container.AddField("Flags",
+			Dumper::BitFieldDisplay::Make(4)
+				->AddBitField(0, 1, Dumper::ChoiceDisplay::Make("data", "code"), false)
+				->AddBitField(1, 1, Dumper::ChoiceDisplay::Make("allocated"), true)
+				->AddBitField(2, 1, Dumper::ChoiceDisplay::Make("loaded/real mode"), true)
+				->AddBitField(3, 1, Dumper::ChoiceDisplay::Make("iterated"), true)
+				->AddBitField(4, 1, Dumper::ChoiceDisplay::Make("movable", "fixed"), false)
+				->AddBitField(5, 1, Dumper::ChoiceDisplay::Make("pure", "impure"), false)
+				->AddBitField(6, 1, Dumper::ChoiceDisplay::Make("load on call", "preload"), false)
+				->AddBitField(7, 1, Dumper::ChoiceDisplay::Make((flags & Segment::Data) != 0 ? "read only" : "execute only"), true)
+				->AddBitField(8, 1, Dumper::ChoiceDisplay::Make("relocations present"), true)
+				->AddBitField(9, 1, Dumper::ChoiceDisplay::Make("debugging information present/conforming code segment"), true)
+				->AddBitField(10, 2, "descriptor privilege level", Dumper::HexDisplay::Make(1))
+				->AddBitField(12, 4, "discard priority", Dumper::HexDisplay::Make(1))
+				->AddBitField(12, 1, Dumper::ChoiceDisplay::Make("discardable"), true)
+				->AddBitField(13, 1, Dumper::ChoiceDisplay::Make("32-bit"), true)
+				->AddBitField(14, 1, Dumper::ChoiceDisplay::Make("huge segment"), true)
+				->AddBitField(15, 1, Dumper::ChoiceDisplay::Make("RESRC_HIGH"), true),
+			offset_t(flags));
+	};
+
+	if(iterated != nullptr)
+	{
+		Dumper::Region segment_region("Segment", data_offset, image->ImageSize(), 8);
+		add_segment_fields(segment_region);
+		segment_region.AddField("Expanded size", Dumper::HexDisplay::Make(4), offset_t(contents->ImageSize()));
+		segment_region.Display(dump);
+
+		offset_t current_offset = data_offset;
+		uint32_t record_index = 0;
+		for(auto& record : iterated->records)
+		{
+			std::shared_ptr<Linker::Buffer> buffer = std::make_shared<Linker::Buffer>(record.data);
+			Dumper::Block iter_entry("Iteration record", current_offset + 4, buffer, 0, 8);
+			iter_entry.InsertField(0, "Index", Dumper::DecDisplay::Make(), offset_t(record_index + 1));
+			iter_entry.AddField("Iteration count", Dumper::DecDisplay::Make(), offset_t(record.count));
+			iter_entry.Display(dump);
+
+			current_offset += 4 + record.data.size();
+			record_index ++;
+		}
+	}
+
+	Dumper::Block segment_block(iterated != nullptr ? "Segment contents" : "Segment", iterated != nullptr ? 0 : data_offset, contents, 0, 8);
+	if(iterated == nullptr)
+	{
+		add_segment_fields(segment_block);
+	}
 	for(auto& relocation : relocations)
 	{
 		for(uint16_t offset : relocation.offsets)
@@ -211,7 +447,7 @@ void NEFormat::Segment::Dump(Dumper::Dumper& dump, unsigned index, bool isos2) c
 				}
 				if((relocation.flags & Relocation::Additive) != 0)
 				{
-					rel_entry.AddOptionalField("Addend", Dumper::HexDisplay::Make(4), offset_t(image->AsImage()->ReadUnsigned(2, offset, ::LittleEndian)));
+					rel_entry.AddOptionalField("Addend", Dumper::HexDisplay::Make(4), offset_t(contents->ReadUnsigned(2, offset, ::LittleEndian)));
 				}
 				rel_entry.Display(dump);
 			}
@@ -711,7 +947,14 @@ void NEFormat::ReadFile(Linker::Reader& rd)
 		if(segment->data_offset != 0)
 		{
 			rd.Seek(segment->data_offset);
-			segment->image = Linker::Buffer::ReadFromFile(rd, segment->image_size);
+			if((segment->flags & Segment::Iterated) != 0)
+			{
+				segment->image = IteratedData::ReadFromFile(rd, segment->image_size);
+			}
+			else
+			{
+				segment->image = Linker::Buffer::ReadFromFile(rd, segment->image_size);
+			}
 		}
 		else
 		{
@@ -720,6 +963,7 @@ void NEFormat::ReadFile(Linker::Reader& rd)
 		if((segment->flags & Segment::Relocations) != 0)
 		{
 			segment->relocations.clear();
+			auto image = segment->GetMemoryImage();
 			uint16_t count = rd.ReadUnsigned(2);
 			for(i = 0; i < count; i++)
 			{
@@ -732,7 +976,6 @@ void NEFormat::ReadFile(Linker::Reader& rd)
 				if((relocation.flags & Segment::Relocation::Additive) == 0)
 				{
 					uint16_t offset = relocation.offsets[0];
-					auto image = segment->image->AsImage();
 					while(true)
 					{
 						uint16_t new_offset = image->GetByte(offset) | (image->GetByte(offset + 1) << 8);
@@ -840,6 +1083,12 @@ offset_t NEFormat::ImageSize() const
 offset_t NEFormat::WriteFile(Linker::Writer& wr) const
 {
 	wr.endiantype = ::LittleEndian;
+	Linker::Checksum file_checksum(4);
+	if(option_checksum)
+	{
+		wr.checksums.push_back(&file_checksum);
+	}
+
 	stub.WriteStubImage(wr);
 	/* new header */
 	wr.Seek(file_offset);
@@ -999,7 +1248,10 @@ offset_t NEFormat::WriteFile(Linker::Writer& wr) const
 				wr.WriteWord(2, it.offsets[0]);
 				wr.WriteWord(2, it.module);
 				wr.WriteWord(2, it.target);
-				// TODO: check that this works
+			}
+			/* chains are threaded through the segment data, once all the records are written */
+			for(auto& it : segment->relocations)
+			{
 				for(unsigned i = 1; i < it.offsets.size(); i++)
 				{
 					wr.Seek(segment->data_offset + it.offsets[i - 1]);
@@ -1009,16 +1261,23 @@ offset_t NEFormat::WriteFile(Linker::Writer& wr) const
 		}
 	}
 
-	/* Resource data */
+	/* Resource data, merged resources share their data and only get written once */
+	std::set<offset_t> written_resource_offsets;
+	auto write_resource = [&](std::shared_ptr<Resource> resource)
+	{
+		if(resource->image == nullptr)
+			return;
+		if(resource->image->ImageSize() != 0 && !written_resource_offsets.insert(resource->data_offset).second)
+			return;
+		wr.Seek(resource->data_offset);
+		resource->image->WriteFile(wr);
+	};
+
 	if(IsOS2())
 	{
 		for(auto resource : resources)
 		{
-			if(resource->image != nullptr)
-			{
-				wr.Seek(resource->data_offset);
-				resource->image->WriteFile(wr);
-			}
+			write_resource(resource);
 		}
 	}
 	else
@@ -1027,15 +1286,25 @@ offset_t NEFormat::WriteFile(Linker::Writer& wr) const
 		{
 			for(auto resource : rtype->resources)
 			{
-				if(resource->image != nullptr)
-				{
-					wr.Seek(resource->data_offset);
-					resource->image->WriteFile(wr);
-				}
+				write_resource(resource);
 			}
 		}
 	}
 
+	if(option_checksum)
+	{
+		std::erase(wr.checksums, &file_checksum);
+		if(file_checksum.valid)
+		{
+			wr.Seek(file_offset + 8);
+			wr.WriteWord(4, file_checksum.sum);
+		}
+		else
+		{
+			Linker::Warning << "Warning: unable to calculate the file load checksum" << std::endl;
+		}
+	}
+
 	return offset_t(-1);
 }
 
@@ -1666,6 +1935,12 @@ void NEFormat::SetOptions(std::map<std::string, std::string>& options)
 		compatibility = collector.compat();
 	}
 
+	option_iterate = collector.iterate();
+	option_gangload = collector.gangload();
+	option_chain_relocations = collector.chain();
+	option_checksum = collector.checksum();
+	option_merge_resources = collector.merge_resources();
+
 	if(collector.stack())
 	{
 		if(IsLibrary())
@@ -2058,12 +2333,13 @@ void NEFormat::ProcessModule(Linker::Module& module)
 		}
 	}
 
-	for(auto segment : segments)
+	for(size_t segment_number = 0; segment_number < segments.size(); segment_number++)
 	{
-		segment->relocations.clear();
-		for(auto& pair : segment->relocations_map)
+		size_t saved_records = segments[segment_number]->CollectRelocations(option_chain_relocations);
+		if(saved_records != 0)
 		{
-			segment->relocations.emplace_back(pair.second);
+			Linker::Debug << "Debug: segment " << segment_number + 1 << ": " << segments[segment_number]->relocations_map.size() << " relocations stored in "
+				<< segments[segment_number]->relocations.size() << " records, chaining saved " << saved_records << " records (" << 8 * saved_records << " bytes)" << std::endl;
 		}
 	}
 
@@ -2294,28 +2570,76 @@ void NEFormat::CalculateValues()
 
 	current_offset = nonresident_name_table_offset + nonresident_name_table_length;
 
+	offset_t iterated_savings = 0;
 	for(auto segment : segments)
 	{
-		segment->data_offset = ::AlignTo(current_offset, 1 << sector_shift);
-		current_offset = segment->data_offset + segment->image->ImageSize();
 		if(Linker::Segment * segmentp = dynamic_cast<Linker::Segment *>(segment->image.get()))
 		{
 			segment->total_size = segmentp->TotalSize();
 		}
-		else
+		else if((segment->flags & Segment::Iterated) == 0)
 		{
 			segment->total_size = segment->image->ImageSize();
 		}
 
+		if(option_iterate)
+		{
+			offset_t original_size = segment->image->ImageSize();
+			if(segment->MakeIterated())
+			{
+				Linker::Debug << "Debug: segment stored as iterated data, " << segment->image->ImageSize() << " bytes instead of " << original_size << std::endl;
+				iterated_savings += original_size - segment->image->ImageSize();
+			}
+		}
+
 		if(segment->relocations.size() != 0)
 		{
 			segment->flags = Segment::flag_type(segment->flags | Segment::Relocations);
-			current_offset += 2 + 8 * segment->relocations.size();
 		}
 	}
 
-	for(auto resource : resources)
+	if(option_iterate)
+	{
+		Linker::Debug << "Debug: iterated segments saved " << iterated_savings << " bytes" << std::endl;
+	}
+
+	/* the segment and resource tables keep their order, only the data is placed differently in the file */
+	auto place_segment = [&](std::shared_ptr<Segment> segment)
+	{
+		segment->data_offset = ::AlignTo(current_offset, 1 << sector_shift);
+		current_offset = segment->data_offset + segment->image->ImageSize();
+		if(segment->relocations.size() != 0)
+		{
+			current_offset += 2 + 8 * segment->relocations.size();
+		}
+	};
+
+	/* a resource identical to one already placed shares its data */
+	Linker::DuplicateFinder duplicate_resources;
+	std::vector<std::shared_ptr<Resource>> placed_resources;
+	auto merge_resource = [&](std::shared_ptr<Resource> resource) -> bool
+	{
+		offset_t size = resource->image->ImageSize();
+		if(size == 0)
+			return false;
+		std::vector<uint8_t> data(size);
+		resource->image->AsImage()->ReadData(size, 0, data.data());
+		size_t index = duplicate_resources.Add(std::move(data), size);
+		if(index == Linker::DuplicateFinder::None)
+		{
+			placed_resources.push_back(resource);
+			return false;
+		}
+		resource->data_offset = placed_resources[index]->data_offset;
+		resource->total_size = placed_resources[index]->total_size;
+		return true;
+	};
+
+	auto place_resource = [&](std::shared_ptr<Resource> resource)
 	{
+		if(option_merge_resources && merge_resource(resource))
+			return;
+
 		if(IsOS2())
 		{
 			resource->data_offset = ::AlignTo(current_offset, 1 << sector_shift);
@@ -2327,13 +2651,72 @@ void NEFormat::CalculateValues()
 			resource->data_offset = ::AlignTo(current_offset, 1 << resource_shift);
 			current_offset = resource->data_offset + resource->image->ImageSize();
 		}
+	};
+
+	/* on OS/2, these fields hold thunk offsets instead */
+	bool gangload = option_gangload && !IsOS2();
+	fast_load_area_offset = 0;
+	fast_load_area_length = 0;
+	additional_flags = additional_flag_type(additional_flags & ~FAST_LOAD_AREA);
+
+	if(gangload)
+	{
+		offset_t fast_load_start = ::AlignTo(current_offset, 1 << sector_shift);
+		size_t preload_segment_count = 0, preload_resource_count = 0;
+		for(auto segment : segments)
+		{
+			if((segment->flags & Segment::Preload) != 0)
+			{
+				place_segment(segment);
+				preload_segment_count++;
+			}
+		}
+		for(auto resource : resources)
+		{
+			if((resource->flags & Segment::Preload) != 0)
+			{
+				place_resource(resource);
+				preload_resource_count++;
+			}
+		}
+
+		offset_t fast_load_length = ::AlignTo(current_offset - fast_load_start, 1 << sector_shift);
+		if(preload_segment_count + preload_resource_count == 0)
+		{
+			Linker::Debug << "Debug: no preload segments or resources, no fast-load area generated" << std::endl;
+		}
+		else if(((fast_load_start + fast_load_length) >> sector_shift) > 0xFFFF)
+		{
+			Linker::Warning << "Warning: fast-load area does not fit the header fields, omitting it" << std::endl;
+		}
+		else
+		{
+			fast_load_area_offset = fast_load_start >> sector_shift;
+			fast_load_area_length = fast_load_length >> sector_shift;
+			additional_flags = additional_flag_type(additional_flags | FAST_LOAD_AREA);
+			Linker::Debug << "Debug: fast-load area covers " << fast_load_length << " bytes at offset " << fast_load_start
+				<< ", " << preload_segment_count << " segment(s) and " << preload_resource_count << " resource(s)" << std::endl;
+		}
 	}
 
-	file_size = current_offset;
+	for(auto segment : segments)
+	{
+		if(!gangload || (segment->flags & Segment::Preload) == 0)
+			place_segment(segment);
+	}
+
+	for(auto resource : resources)
+	{
+		if(!gangload || (resource->flags & Segment::Preload) == 0)
+			place_resource(resource);
+	}
+
+	if(option_merge_resources)
+	{
+		duplicate_resources.ReportDuplicates("resource");
+	}
 
-	/* TODO: these are not going to be implemented */
-	fast_load_area_offset = 0 >> sector_shift;
-	fast_load_area_length = 0 >> sector_shift;
+	file_size = current_offset;
 }
 
 void NEFormat::SetModel(std::string model)
@@ -2369,6 +2752,36 @@ void NEFormat::GenerateFile(std::string filename, Linker::Module& module)
 	Linker::OutputFormat::GenerateFile(filename, module);
 }
 
+void NEFormat::AccountMemory(Linker::MemoryUsage& usage) const
+{
+	Linker::SegmentManager::AccountMemory(usage);
+
+	usage.AddVector("format tables", segments);
+	for(auto& segment : segments)
+	{
+		usage.Add("format tables", sizeof(Segment));
+		usage.AddContents("section data", segment->image);
+		usage.AddVector("relocations", segment->relocations);
+		for(auto& relocation : segment->relocations)
+		{
+			usage.AddVector("relocations", relocation.offsets);
+		}
+		usage.AddMap("relocations", segment->relocations_map);
+	}
+	usage.AddVector("format tables", resources);
+	usage.AddVector("format tables", resource_types);
+	usage.AddVector("format tables", resource_strings);
+	usage.AddVector("format tables", resident_names);
+	usage.AddVector("format tables", module_references);
+	usage.AddVector("format tables", imported_names);
+	usage.AddVector("format tables", nonresident_names);
+	usage.AddVector("format tables", entries);
+	usage.AddMap("format tables", segment_index);
+	usage.AddMap("format tables", module_reference_offsets);
+	usage.AddMap("format tables", imported_name_offsets);
+	usage.AddMap("format tables", resource_name_offsets);
+}
+
 std::string NEFormat::GetDefaultExtension(Linker::Module& module, std::string filename) const
 {
 	ResourceFile resfil;
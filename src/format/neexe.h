@@ -103,6 +103,40 @@ namespace Microsoft
 			uint16_t ordinal = 0;
 		};
 
+		/**
+		 * @brief Segment data stored as a sequence of iteration records, each one a byte pattern and its repetition count
+		 *
+		 * Segments with the Iterated flag set store their data in this form, the loader expands it before applying the relocations.
+		 */
+		class IteratedData : public Linker::Contents
+		{
+		public:
+			struct IterationRecord
+			{
+				uint16_t count = 0;
+				std::vector<uint8_t> data;
+			};
+			std::vector<IterationRecord> records;
+
+			/** @brief Size of the records as stored in the file */
+			offset_t ImageSize() const override;
+			/** @brief Size of the data after expanding the records */
+			offset_t ExpandedSize() const;
+			using Linker::Contents::WriteFile;
+			static std::shared_ptr<IteratedData> ReadFromFile(Linker::Reader& rd, offset_t size);
+			offset_t WriteFile(Linker::Writer& wr, offset_t count, offset_t offset = 0) const override;
+
+			/** @brief Expands the records into the bytes they represent */
+			std::shared_ptr<Linker::Buffer> Expand() const;
+
+			/**
+			 * @brief Encodes data as iteration records, collapsing runs of short repeated patterns
+			 *
+			 * @return The encoded data, or nullptr if it would not be smaller than the original
+			 */
+			static std::shared_ptr<IteratedData> Compress(const Linker::Image& image);
+		};
+
 		/** @brief Represents an NE segment as stored in the segment table and segment data */
 		class Segment
 		{
@@ -116,7 +150,7 @@ namespace Microsoft
 				Data = 1, Code = 0,
 				Allocated = 2,
 				Loaded = 4, /* RealMode = 4 */ /* TODO */
-				Iterated = 8, /* TODO */
+				Iterated = 8,
 				Movable = 0x10, Fixed = 0,
 				Shareable = 0x20,
 				Preload = 0x40, LoadOnCall = 0,
@@ -228,12 +262,32 @@ namespace Microsoft
 
 				static source_type GetType(Linker::Relocation& rel);
 				size_t GetSize() const;
+				/** @brief Whether further relocations with the same properties can be threaded through the image after this one */
+				bool IsChainable() const;
 			};
 			std::vector<Relocation> relocations;
 			/** @brief Used internally during output generation */
 			std::map<uint16_t, Relocation> relocations_map;
 
 			void AddRelocation(const Relocation& rel);
+
+			/**
+			 * @brief Fills the relocations from relocations_map, chaining together the ones that share all properties if requested
+			 *
+			 * @return Number of relocation records saved by chaining
+			 */
+			size_t CollectRelocations(bool chain);
+
+			/** @brief Retrieves the segment data as it appears in memory, expanding iterated data */
+			std::shared_ptr<Linker::Image> GetMemoryImage() const;
+
+			/**
+			 * @brief Replaces the segment data with iteration records, if it makes the segment smaller
+			 *
+			 * @return true if the segment has been converted
+			 */
+			bool MakeIterated();
+
 			void Dump(Dumper::Dumper& dump, unsigned index, bool isos2) const;
 		};
 
@@ -451,6 +505,7 @@ namespace Microsoft
 		/** @brief Version of the linker */
 		version linker_version{1, 0};
 
+		/** @brief File load checksum, the sum of all 32-bit words in the file with this field taken as 0, calculated while writing if option_checksum is set */
 		uint32_t crc32 = 0;
 
 		enum program_flag_type : uint8_t
@@ -769,11 +824,16 @@ namespace Microsoft
 			Linker::Option<Linker::ItemOf<OutputTypeEnumeration>> type{"type", "Type of binary"};
 			Linker::Option<Linker::ItemOf<CompatibilityEnumeration>> compat{"compat", "Mimics the behavior of another linker"};
 			Linker::Option<std::optional<offset_t>> stack{"stack", "Specify the stack size"};
+			Linker::Option<bool> iterate{"iterate", "Store segments containing repeated data as iterated segments"};
+			Linker::Option<bool> gangload{"gangload", "Place preload segments and resources at the start of the file as a fast-load area (Windows only)"};
+			Linker::Option<bool> chain{"chain", "Thread relocations with the same target through the segment data, storing a single record for each"};
+			Linker::Option<bool> checksum{"checksum", "Fill in the file load checksum of the header"};
+			Linker::Option<bool> merge_resources{"merge_resources", "Store resources with identical contents only once"};
 			// TODO: make heap, target windows version, font/memory support parameters
 
 			NEOptionCollector()
 			{
-				InitializeFields(stub, system, type, compat, stack);
+				InitializeFields(stub, system, type, compat, stack, iterate, gangload, chain, checksum, merge_resources);
 			}
 		};
 
@@ -791,6 +851,16 @@ namespace Microsoft
 		std::string program_name;
 
 		bool option_capitalize_names = false; /* TODO: parametrize */
+		/** @brief Compress segments into iterated records where it makes them smaller */
+		bool option_iterate = false;
+		/** @brief Place the preload segments, their relocations and the preload resources in a contiguous fast-load area, so that Windows can read them in a single pass */
+		bool option_gangload = false;
+		/** @brief Store relocations sharing all their properties as a single relocation chain */
+		bool option_chain_relocations = false;
+		/** @brief Calculate the file load checksum while writing the file */
+		bool option_checksum = false;
+		/** @brief Let resources with identical contents share the same data in the file */
+		bool option_merge_resources = false;
 		enum memory_model_t
 		{
 			MODEL_SMALL,
@@ -843,6 +913,7 @@ namespace Microsoft
 		void ProcessModule(Linker::Module& module) override;
 		void CalculateValues() override;
 		void GenerateFile(std::string filename, Linker::Module& module) override;
+		void AccountMemory(Linker::MemoryUsage& usage) const override;
 		using Linker::OutputFormat::GetDefaultExtension;
 		std::string GetDefaultExtension(Linker::Module& module, std::string filename) const override;
 	};
@@ -1,6 +1,9 @@
 
 #include <algorithm>
+#include <sstream>
 #include "omf.h"
+#include "../linker/module_collector.h"
+#include "../linker/section.h"
 
 /* TODO: incomplete */
 
@@ -549,7 +552,8 @@ OMF86Format::ExternalName OMF86Format::ExternalName::ReadCommonName(OMF86Format
 		if(1 <= data_type && data_type <= 0x5F)
 		{
 			extname.common_type = SegmentIndexCommon;
-			extname.value.segment_index = data_type;
+			extname.segment_index = data_type;
+			extname.value.near.length = ReadValue(omf, rd);
 		}
 		break;
 		// TODO: otherwise, error
@@ -584,7 +588,7 @@ uint16_t OMF86Format::ExternalName::GetExternalNameSize(OMF86Format * omf) const
 	case External:
 		break;
 	case SegmentIndexCommon:
-		bytes += 1;
+		bytes += 1 + ValueSize(omf, value.near.length);
 		break;
 	case FarCommon:
 		bytes += 1 + ValueSize(omf, value.far.number) + ValueSize(omf, value.far.element_size);
@@ -612,7 +616,8 @@ void OMF86Format::ExternalName::WriteExternalName(OMF86Format * omf, ChecksumWri
 	case External:
 		break;
 	case SegmentIndexCommon:
-		wr.WriteWord(1, value.segment_index);
+		wr.WriteWord(1, segment_index);
+		WriteValue(omf, wr, value.near.length);
 		break;
 	case FarCommon:
 		wr.WriteWord(1, common_type);
@@ -809,7 +814,7 @@ uint16_t OMF86Format::DataBlock::GetIteratedDataBlockSize(OMF86Format * omf, boo
 	uint16_t bytes = 2 + (is32bit ? 4 : 2); // TODO: Phar Lap always stores 2 bytes
 	if(auto data = std::get_if<Data>(&content))
 	{
-		bytes += data->size();
+		bytes += 1 + data->size();
 	}
 	else if(auto blocks = std::get_if<Blocks>(&content))
 	{
@@ -832,6 +837,7 @@ void OMF86Format::DataBlock::WriteIteratedDataBlock(OMF86Format * omf, ChecksumW
 	if(auto data = std::get_if<Data>(&content))
 	{
 		wr.WriteWord(2, 0);
+		wr.WriteWord(1, data->size());
 		wr.WriteData(*data);
 	}
 	else if(auto blocks = std::get_if<Blocks>(&content))
@@ -844,6 +850,46 @@ void OMF86Format::DataBlock::WriteIteratedDataBlock(OMF86Format * omf, ChecksumW
 	}
 }
 
+offset_t OMF86Format::DataBlock::GetExpandedSize() const
+{
+	offset_t size = 0;
+	if(auto data = std::get_if<Data>(&content))
+	{
+		size = data->size();
+	}
+	else if(auto blocks = std::get_if<Blocks>(&content))
+	{
+		for(auto& block : *blocks)
+		{
+			size += block->GetExpandedSize();
+		}
+	}
+	return size * repeat_count;
+}
+
+void OMF86Format::DataBlock::Expand(std::vector<uint8_t>& buffer) const
+{
+	size_t start = buffer.size();
+	if(auto data = std::get_if<Data>(&content))
+	{
+		buffer.insert(buffer.end(), data->begin(), data->end());
+	}
+	else if(auto blocks = std::get_if<Blocks>(&content))
+	{
+		for(auto& block : *blocks)
+		{
+			block->Expand(buffer);
+		}
+	}
+
+	size_t block_size = buffer.size() - start;
+	buffer.resize(start + block_size * repeat_count);
+	for(uint32_t i = 1; i < repeat_count; i++)
+	{
+		std::copy_n(buffer.begin() + start, block_size, buffer.begin() + start + i * block_size);
+	}
+}
+
 //// OMF86Format::Reference
 
 void OMF86Format::Reference::Read(OMF86Format * omf, Linker::Reader& rd, size_t displacement_size)
@@ -868,7 +914,7 @@ void OMF86Format::Reference::Read(OMF86Format * omf, Linker::Reader& rd, size_t
 			frame = ExternalIndex(ReadIndex(rd));
 			break;
 		case MethodFrame:
-			frame = FrameNumber(ReadIndex(rd));
+			frame = FrameNumber(rd.ReadUnsigned(2));
 			break;
 		case MethodSource:
 			frame = UsesSource{};
@@ -900,7 +946,7 @@ void OMF86Format::Reference::Read(OMF86Format * omf, Linker::Reader& rd, size_t
 			target = ExternalIndex(ReadIndex(rd));
 			break;
 		case MethodFrame:
-			target = FrameNumber(ReadIndex(rd));
+			target = FrameNumber(rd.ReadUnsigned(2));
 			break;
 		}
 	}
@@ -927,9 +973,9 @@ uint16_t OMF86Format::Reference::Size(OMF86Format * omf, bool is32bit) const
 	{
 		bytes += IndexSize(external->index);
 	}
-	else if(auto frame_number = std::get_if<FrameNumber>(&frame))
+	else if(std::get_if<FrameNumber>(&frame))
 	{
-		bytes += IndexSize(*frame_number);
+		bytes += 2;
 	}
 
 	if(auto segment = std::get_if<SegmentIndex>(&target))
@@ -944,9 +990,9 @@ uint16_t OMF86Format::Reference::Size(OMF86Format * omf, bool is32bit) const
 	{
 		bytes += IndexSize(external->index);
 	}
-	else if(auto frame_number = std::get_if<FrameNumber>(&target))
+	else if(std::get_if<FrameNumber>(&target))
 	{
-		bytes += IndexSize(*frame_number);
+		bytes += 2;
 	}
 
 	if(displacement != 0)
@@ -1052,7 +1098,7 @@ void OMF86Format::Reference::Write(OMF86Format * omf, ChecksumWriter& wr, bool i
 	}
 	else if(auto frame_number = std::get_if<FrameNumber>(&frame))
 	{
-		WriteIndex(wr, *frame_number);
+		wr.WriteWord(2, *frame_number);
 	}
 
 	if(auto segment = std::get_if<SegmentIndex>(&target))
@@ -1069,7 +1115,7 @@ void OMF86Format::Reference::Write(OMF86Format * omf, ChecksumWriter& wr, bool i
 	}
 	else if(auto frame_number = std::get_if<FrameNumber>(&target))
 	{
-		WriteIndex(wr, *frame_number);
+		wr.WriteWord(2, *frame_number);
 	}
 
 	if(displacement != 0)
@@ -2020,6 +2066,8 @@ void OMF86Format::ExternalNamesDefinitionRecord::ReadRecordContents(OMF86Format
 	{
 		if(common)
 			omf->modules.back().extdefs.push_back(ExternalName::ReadCommonName(omf, rd, local));
+		else if(record_type == CEXTDEF)
+			omf->modules.back().extdefs.push_back(ExternalName::ReadComdatExternalName(omf, rd));
 		else
 			omf->modules.back().extdefs.push_back(ExternalName::ReadExternalName(omf, rd, local));
 		extdef_count++;
@@ -2358,23 +2406,38 @@ void OMF86Format::LogicalDataRecord::ReadRecordContents(OMF86Format * omf, Modul
 {
 	segment.index = ReadIndex(rd);
 	offset = rd.ReadUnsigned(GetOffsetSize(omf));
-	if(record_type == LIDATA16)
-		data = DataBlock::ReadIteratedDataBlock(omf, rd, false);
-	else if(record_type == LIDATA32)
-		data = DataBlock::ReadIteratedDataBlock(omf, rd, true);
+	if(record_type == LIDATA16 || record_type == LIDATA32)
+	{
+		/* a record may contain several iterated blocks */
+		data = std::make_shared<DataBlock>();
+		data->repeat_count = 1;
+		data->content = DataBlock::Blocks();
+		auto& blocks = std::get<DataBlock::Blocks>(data->content);
+		while(rd.Tell() < RecordEnd())
+		{
+			blocks.push_back(DataBlock::ReadIteratedDataBlock(omf, rd, Is32Bit(omf)));
+		}
+	}
 	else
+	{
 		data = DataBlock::ReadEnumeratedDataBlock(omf, rd, RecordEnd() - rd.Tell());
+	}
 }
 
 uint16_t OMF86Format::LogicalDataRecord::GetRecordSize(OMF86Format * omf, Module * mod) const
 {
 	uint16_t bytes = 1 + IndexSize(segment.index) + GetOffsetSize(omf);
-	if(record_type == LIDATA16)
-		bytes += data->GetIteratedDataBlockSize(omf, false);
-	else if(record_type == LIDATA32)
-		bytes += data->GetIteratedDataBlockSize(omf, true);
+	if(record_type == LIDATA16 || record_type == LIDATA32)
+	{
+		for(auto& block : std::get<DataBlock::Blocks>(data->content))
+		{
+			bytes += block->GetIteratedDataBlockSize(omf, Is32Bit(omf));
+		}
+	}
 	else
+	{
 		bytes += data->GetEnumeratedDataBlockSize(omf);
+	}
 	return bytes;
 }
 
@@ -2382,12 +2445,17 @@ void OMF86Format::LogicalDataRecord::WriteRecordContents(OMF86Format * omf, Modu
 {
 	WriteIndex(wr, segment.index);
 	wr.WriteWord(GetOffsetSize(omf), offset);
-	if(record_type == LIDATA16)
-		data->WriteIteratedDataBlock(omf, wr, false);
-	else if(record_type == LIDATA32)
-		data->WriteIteratedDataBlock(omf, wr, true);
+	if(record_type == LIDATA16 || record_type == LIDATA32)
+	{
+		for(auto& block : std::get<DataBlock::Blocks>(data->content))
+		{
+			block->WriteIteratedDataBlock(omf, wr, Is32Bit(omf));
+		}
+	}
 	else
+	{
 		data->WriteEnumeratedDataBlock(omf, wr);
+	}
 }
 
 void OMF86Format::LogicalDataRecord::CalculateValues(OMF86Format * omf, Module * mod)
@@ -2420,7 +2488,7 @@ OMF86Format::FixupRecord::Thread OMF86Format::FixupRecord::Thread::Read(OMF86For
 		thread.reference = ExternalIndex(ReadIndex(rd));
 		break;
 	case MethodFrame:
-		thread.reference = FrameNumber(ReadIndex(rd));
+		thread.reference = FrameNumber(rd.ReadUnsigned(2));
 		break;
 	case MethodSource:
 		thread.reference = UsesSource{};
@@ -2451,9 +2519,9 @@ uint16_t OMF86Format::FixupRecord::Thread::Size(OMF86Format * omf, Module * mod)
 	{
 		bytes += IndexSize(externalp->index);
 	}
-	else if(auto frame_numberp = std::get_if<FrameNumber>(&reference))
+	else if(std::get_if<FrameNumber>(&reference))
 	{
-		bytes += IndexSize(*frame_numberp);
+		bytes += 2;
 	}
 
 	return bytes;
@@ -2482,7 +2550,7 @@ void OMF86Format::FixupRecord::Thread::Write(OMF86Format * omf, Module * mod, Ch
 	else if(auto frame_numberp = std::get_if<FrameNumber>(&reference))
 	{
 		wr.WriteWord(1, data_byte | (MethodFrame << 2));
-		WriteIndex(wr, *frame_numberp);
+		wr.WriteWord(2, *frame_numberp);
 	}
 	else if(std::get_if<UsesSource>(&reference))
 	{
@@ -2959,7 +3027,7 @@ void OMF86Format::RegisterInitializationRecord::ResolveReferences(OMF86Format *
 
 void OMF86Format::ModuleEndRecord::ReadRecordContents(OMF86Format * omf, Module * mod, Linker::Reader& rd)
 {
-	uint8_t module_type = rd.ReadUnsigned(1);
+	uint8_t module_type = rd.Tell() < RecordEnd() ? rd.ReadUnsigned(1) : 0;
 	main_module = (module_type & 0x80) != 0;
 	if((module_type & 0x40))
 	{
@@ -3544,6 +3612,7 @@ std::shared_ptr<OMF86Format::CommentRecord> OMF86Format::CommentRecord::ReadComm
 	case User:
 	case DependencyFile:
 	case CommandLine:
+	default:
 		record = std::make_shared<GenericCommentRecord>(comment_class_t(comment_class));
 		break;
 	}
@@ -3959,6 +4028,7 @@ void OMF86Format::LinkerDirectivesRecord::WriteComment(OMF86Format * omf, Module
 void OMF86Format::TISLibraryHeaderRecord::ReadRecordContents(OMF86Format * omf, Module * mod, Linker::Reader& rd)
 {
 	omf->page_size = record_length + 3;
+	omf->library_offset = record_offset;
 	dictionary_offset = rd.ReadUnsigned(4);
 	dictionary_size = rd.ReadUnsigned(2);
 	uint8_t flags = rd.ReadUnsigned(1);
@@ -4122,7 +4192,10 @@ Linker::Debug << "Debug: record 0x" << std::hex << int(record_type) << " at offs
 		record = std::make_shared<PhysicalDataRecord>(record_type_t(record_type));
 		break;
 	case COMENT:
-		return CommentRecord::ReadCommentRecord(this, mod, rd, record_length);
+		record = CommentRecord::ReadCommentRecord(this, mod, rd, record_length);
+		record->record_offset = record_offset;
+		record->record_length = record_length;
+		return record;
 	case MODEND16:
 	case MODEND32:
 		record = std::make_shared<ModuleEndRecord>(record_type_t(record_type));
@@ -4144,7 +4217,8 @@ Linker::Debug << "Debug: record 0x" << std::hex << int(record_type) << " at offs
 	case LNAMES:
 		record = std::make_shared<ListOfNamesRecord>(record_type_t(record_type));
 		break;
-	case SEGDEF:
+	case SEGDEF16:
+	case SEGDEF32:
 		record = std::make_shared<SegmentDefinitionRecord>(record_type_t(record_type));
 		break;
 	case GRPDEF:
@@ -4233,9 +4307,38 @@ Linker::Debug << "Debug: record 0x" << std::hex << int(record_type) << " at offs
 	record->record_offset = record_offset;
 	record->record_length = record_length;
 	record->ReadRecordContents(this, mod, rd);
+	if(rd.Tell() != record->RecordEnd())
+	{
+		Linker::Error << "Error: record at offset 0x" << std::hex << record_offset << " does not match its length, skipping remaining contents" << std::endl;
+		rd.Seek(record->RecordEnd());
+	}
 	rd.ReadUnsigned(1); // checksum
-	records.push_back(record);
-	assert(rd.Tell() == record->record_offset + record->record_length + 3);
+	return record;
+}
+
+std::shared_ptr<OMF86Format::Record> OMF86Format::ReadNextRecord(Linker::Reader& rd, offset_t end)
+{
+	if(rd.Tell() >= end)
+		return nullptr;
+
+	std::shared_ptr<Record> record = ReadRecord(rd);
+	switch(record->record_type)
+	{
+	case MODEND16:
+	case MODEND32:
+		if(page_size != 0)
+		{
+			/* modules inside a library are padded to the page size */
+			rd.Seek(library_offset + ::AlignTo(rd.Tell() - library_offset, page_size));
+		}
+		break;
+	case LibraryEnd:
+		/* followed by the dictionary */
+		rd.Seek(end);
+		break;
+	default:
+		break;
+	}
 	return record;
 }
 
@@ -4255,12 +4358,10 @@ void OMF86Format::ReadFile(Linker::Reader& rd)
 {
 	rd.endiantype = LittleEndian;
 	offset_t end = rd.GetImageEnd();
-
-	while(rd.Tell() < end)
+	while(std::shared_ptr<Record> record = ReadNextRecord(rd, end))
 	{
-		ReadRecord(rd);
+		records.push_back(record);
 	}
-
 	file_size = rd.Tell();
 }
 
@@ -4297,9 +4398,618 @@ void OMF86Format::Dump(Dumper::Dumper& dump) const
 	}
 }
 
+//// OMF86Format::ModuleConverter
+
+void OMF86Format::ModuleConverter::ProcessRecord(std::shared_ptr<Record> record, const Module * mod)
+{
+	switch(record->record_type)
+	{
+	case THEADR:
+	case LHEADR:
+		if(in_module)
+		{
+			Linker::Warning << "Warning: module header at offset 0x" << std::hex << record->record_offset << " without preceding module end record" << std::endl;
+			FinishModule();
+		}
+		StartModule();
+		return;
+	case LibraryHeader:
+		is_library = true;
+		return;
+	case LibraryEnd:
+		return;
+	default:
+		break;
+	}
+
+	if(!in_module || mod == nullptr)
+	{
+		Linker::Error << "Error: expected module header at offset 0x" << std::hex << record->record_offset << ", skipping record" << std::endl;
+		return;
+	}
+
+	switch(record->record_type)
+	{
+	case SEGDEF16:
+	case SEGDEF32:
+		ConvertSegmentDefinition(*mod, dynamic_cast<const SegmentDefinitionRecord&>(*record));
+		break;
+	case PUBDEF16:
+	case PUBDEF32:
+	case LPUBDEF16:
+	case LPUBDEF32:
+		ConvertSymbols(*mod, dynamic_cast<const SymbolsDefinitionRecord&>(*record));
+		break;
+	case EXTDEF:
+	case LEXTDEF16:
+	case LEXTDEF32:
+	case COMDEF:
+	case LCOMDEF:
+	case CEXTDEF:
+		ConvertExternalNames(*mod, dynamic_cast<const ExternalNamesDefinitionRecord&>(*record));
+		break;
+	case LEDATA16:
+	case LEDATA32:
+	case LIDATA16:
+	case LIDATA32:
+		ConvertData(std::dynamic_pointer_cast<LogicalDataRecord>(record));
+		break;
+	case FIXUPP16:
+	case FIXUPP32:
+		ConvertFixups(*mod, dynamic_cast<const FixupRecord&>(*record));
+		break;
+	case MODEND16:
+	case MODEND32:
+		ConvertModuleEnd(*mod, dynamic_cast<const ModuleEndRecord&>(*record));
+		FinishModule();
+		break;
+	case COMDAT16:
+	case COMDAT32:
+	case BAKPAT16:
+	case BAKPAT32:
+	case NBKPAT16:
+	case NBKPAT32:
+	case ALIAS:
+		Linker::Warning << "Warning: unsupported record type 0x" << std::hex << int(record->record_type) << " at offset 0x" << std::hex << record->record_offset << ", ignoring" << std::endl;
+		break;
+	default:
+		/* names are collected by the parser, the rest is comments and debug information */
+		break;
+	}
+}
+
+void OMF86Format::ModuleConverter::Finish()
+{
+	if(in_module)
+	{
+		Linker::Warning << "Warning: missing module end record" << std::endl;
+		FinishModule();
+	}
+}
+
+offset_t OMF86Format::ModuleConverter::GetIteratedOffsets(const DataBlock::Blocks& blocks, bool is32bit, offset_t position, std::vector<offset_t>& offsets)
+{
+	offset_t encoded_offset = 0;
+	offset_t expanded_offset = 0;
+	for(auto& block : blocks)
+	{
+		offset_t block_start = encoded_offset;
+		offset_t header_size = (is32bit ? 4 : 2) + 2;
+		bool inside = position != offset_t(-1) && position >= block_start + header_size;
+		/* offsets within a single iteration of the block */
+		std::vector<offset_t> block_offsets;
+		offset_t iteration_size = 0;
+
+		if(auto data = std::get_if<DataBlock::Data>(&block->content))
+		{
+			header_size += 1; // byte count
+			inside = inside && position >= block_start + header_size;
+			encoded_offset += header_size + data->size();
+			iteration_size = data->size();
+			if(inside && position < encoded_offset)
+			{
+				block_offsets.push_back(position - block_start - header_size);
+			}
+		}
+		else if(auto subblocks = std::get_if<DataBlock::Blocks>(&block->content))
+		{
+			encoded_offset += header_size + GetIteratedOffsets(*subblocks, is32bit, inside ? position - block_start - header_size : offset_t(-1), block_offsets);
+			for(auto& subblock : *subblocks)
+			{
+				iteration_size += subblock->GetExpandedSize();
+			}
+		}
+
+		for(uint32_t i = 0; i < block->repeat_count; i++)
+		{
+			for(offset_t block_offset : block_offsets)
+			{
+				offsets.push_back(expanded_offset + i * iteration_size + block_offset);
+			}
+		}
+		expanded_offset += iteration_size * block->repeat_count;
+	}
+	return encoded_offset;
+}
+
+void OMF86Format::ModuleConverter::StartModule()
+{
+	if(linker != nullptr)
+	{
+		current_module = linker->CreateModule(omf.shared_from_this(), file_name);
+		module = current_module.get();
+	}
+
+	module->cpu = omf.option_16bit ? Linker::Module::I86 : Linker::Module::I386;
+	module->endiantype = ::LittleEndian;
+
+	segments.clear();
+	for(ReferenceMethod& thread : target_threads)
+		thread = SegmentIndex();
+	for(ReferenceMethod& thread : frame_threads)
+		thread = SegmentIndex();
+	data_record = nullptr;
+	in_module = true;
+}
+
+void OMF86Format::ModuleConverter::FinishModule()
+{
+	in_module = false;
+	data_record = nullptr;
+
+	if(linker != nullptr)
+	{
+		if(is_library)
+			linker->AddLibraryModule(current_module);
+		else
+			linker->AddModule(current_module);
+		current_module = nullptr;
+		module = nullptr;
+	}
+}
+
+const std::string& OMF86Format::ModuleConverter::GetName(const Module& mod, index_t index) const
+{
+	static const std::string empty;
+	if(index == 0 || index > mod.lnames.size())
+	{
+		if(index != 0)
+			Linker::Error << "Error: invalid name index " << std::dec << index << std::endl;
+		return empty;
+	}
+	return mod.lnames[index - 1];
+}
+
+Linker::Location OMF86Format::ModuleConverter::GetSegmentLocation(index_t index, offset_t displacement) const
+{
+	if(index == 0 || index > segments.size())
+	{
+		Linker::Error << "Error: invalid segment index " << std::dec << index << std::endl;
+		return Linker::Location(displacement);
+	}
+	const SegmentEntry& segment = segments[index - 1];
+	if(segment.section == nullptr)
+		return Linker::Location(segment.base + displacement);
+	else
+		return Linker::Location(segment.section, displacement);
+}
+
+Linker::Target OMF86Format::ModuleConverter::GetReference(const Module& mod, const ReferenceMethod& method, offset_t displacement) const
+{
+	if(auto segment = std::get_if<SegmentIndex>(&method))
+	{
+		return Linker::Target(GetSegmentLocation(segment->index, displacement));
+	}
+	else if(auto group = std::get_if<GroupIndex>(&method))
+	{
+		index_t first_segment = 0;
+		if(group->index != 0 && group->index <= mod.grpdefs.size())
+		{
+			for(auto& component : mod.grpdefs[group->index - 1]->components)
+			{
+				if(auto segment = std::get_if<SegmentIndex>(&component.component))
+				{
+					first_segment = segment->index;
+					break;
+				}
+			}
+		}
+		if(first_segment == 0)
+		{
+			Linker::Error << "Error: invalid or empty group index " << std::dec << group->index << std::endl;
+			return Linker::Target(Linker::Location(displacement));
+		}
+		return Linker::Target(GetSegmentLocation(first_segment, displacement));
+	}
+	else if(auto external = std::get_if<ExternalIndex>(&method))
+	{
+		if(external->index == 0 || external->index > mod.extdefs.size())
+		{
+			Linker::Error << "Error: invalid external index " << std::dec << external->index << std::endl;
+			return Linker::Target(Linker::Location(displacement));
+		}
+		const ExternalName& extname = mod.extdefs[external->index - 1];
+		return Linker::Target(Linker::SymbolName(extname.name_is_index ? GetName(mod, extname.name.index) : extname.name.text));
+	}
+	else if(auto frame_number = std::get_if<FrameNumber>(&method))
+	{
+		return Linker::Target(Linker::Location((offset_t(*frame_number) << 4) + displacement));
+	}
+	else
+	{
+		Linker::Error << "Error: invalid reference method " << std::dec << method.index() << std::endl;
+		return Linker::Target(Linker::Location(displacement));
+	}
+}
+
+OMF86Format::ModuleConverter::ReferenceMethod OMF86Format::ModuleConverter::GetTarget(const Reference& ref) const
+{
+	if(auto thread = std::get_if<Reference::ThreadNumber>(&ref.target))
+		return target_threads[*thread & 3];
+	else if(auto segment = std::get_if<SegmentIndex>(&ref.target))
+		return *segment;
+	else if(auto group = std::get_if<GroupIndex>(&ref.target))
+		return *group;
+	else if(auto external = std::get_if<ExternalIndex>(&ref.target))
+		return *external;
+	else
+		return std::get<FrameNumber>(ref.target);
+}
+
+OMF86Format::ModuleConverter::ReferenceMethod OMF86Format::ModuleConverter::GetFrame(const Reference& ref) const
+{
+	if(auto thread = std::get_if<Reference::ThreadNumber>(&ref.frame))
+		return frame_threads[*thread & 3];
+	else if(auto segment = std::get_if<SegmentIndex>(&ref.frame))
+		return *segment;
+	else if(auto group = std::get_if<GroupIndex>(&ref.frame))
+		return *group;
+	else if(auto external = std::get_if<ExternalIndex>(&ref.frame))
+		return *external;
+	else if(auto frame_number = std::get_if<FrameNumber>(&ref.frame))
+		return *frame_number;
+	else if(std::get_if<UsesSource>(&ref.frame))
+		return UsesSource();
+	else if(std::get_if<UsesTarget>(&ref.frame))
+		return UsesTarget();
+	else
+		return UsesAbsolute();
+}
+
+std::shared_ptr<Linker::Section> OMF86Format::ModuleConverter::GetDataSection(const LogicalDataRecord& record)
+{
+	index_t index = record.segment.index;
+	if(index == 0 || index > segments.size() || segments[index - 1].section == nullptr)
+	{
+		Linker::Error << "Error: data record refers to invalid or absolute segment " << std::dec << index << ", ignoring" << std::endl;
+		return nullptr;
+	}
+	std::shared_ptr<Linker::Section> section = segments[index - 1].section;
+	if(section->IsZeroFilled())
+		section->SetZeroFilled(false);
+	return section;
+}
+
+void OMF86Format::ModuleConverter::ConvertSegmentDefinition(const Module& mod, const SegmentDefinitionRecord& record)
+{
+	SegmentEntry segment;
+	offset_t align = 1;
+	bool is_absolute = false;
+	switch(record.alignment)
+	{
+	case SegmentDefinitionRecord::AlignAbsolute:
+	case SegmentDefinitionRecord::AlignUnnamed:
+		is_absolute = true;
+		segment.base = std::get<SegmentDefinitionRecord::Absolute>(record.location);
+		break;
+	case SegmentDefinitionRecord::Align2:
+		align = 2;
+		break;
+	case SegmentDefinitionRecord::Align16:
+	case SegmentDefinitionRecord::AlignLTL16:
+		align = 16;
+		break;
+	case SegmentDefinitionRecord::Align256:
+		align = 256;
+		break;
+	case SegmentDefinitionRecord::Align4096:
+		align = 4096;
+		break;
+	case SegmentDefinitionRecord::Align32:
+		align = 4;
+		break;
+	default:
+		break;
+	}
+
+	if(!is_absolute)
+	{
+		/* sections start out zero filled, data records convert them as needed */
+		const std::string& class_name = GetName(mod, record.class_name.index);
+		bool is_code = ends_with(class_name, "CODE");
+		bool is_stack = class_name == "STACK" || record.combination == SegmentDefinitionRecord::Combination_Stack;
+		segment.section = std::make_shared<Linker::Section>(GetName(mod, record.segment_name.index),
+			Linker::Section::Readable
+			| (is_code ? Linker::Section::Executable : Linker::Section::Writable)
+			| Linker::Section::ZeroFilled
+			| (is_stack ? Linker::Section::Stack : 0));
+		segment.section->SetAlign(align);
+		segment.section->Expand(record.segment_length);
+		module->AddSection(segment.section);
+	}
+
+	segments.push_back(segment);
+}
+
+void OMF86Format::ModuleConverter::ConvertSymbols(const Module& mod, const SymbolsDefinitionRecord& record)
+{
+	bool local = record.record_type == LPUBDEF16 || record.record_type == LPUBDEF32;
+	for(auto& symbol : record.symbols)
+	{
+		Linker::Location location;
+		if(auto frame_number = std::get_if<FrameNumber>(&record.base.location))
+		{
+			location = Linker::Location((offset_t(*frame_number) << 4) + symbol.offset);
+		}
+		else
+		{
+			auto& base = std::get<BaseSpecification::Location>(record.base.location);
+			if(base.segment.index != 0)
+				location = GetSegmentLocation(base.segment.index, symbol.offset);
+			else
+				location = std::get<Linker::Location>(GetReference(mod, base.group, symbol.offset).target);
+		}
+
+		if(local)
+			module->AddLocalSymbol(symbol.name, location);
+		else
+			module->AddGlobalSymbol(symbol.name, location);
+	}
+}
+
+void OMF86Format::ModuleConverter::ConvertExternalNames(const Module& mod, const ExternalNamesDefinitionRecord& record)
+{
+	bool common = record.record_type == COMDEF || record.record_type == LCOMDEF;
+	for(index_t index = record.first_extdef.index; index < record.first_extdef.index + record.extdef_count; index++)
+	{
+		const ExternalName& extname = mod.extdefs[index];
+		std::string name = extname.name_is_index ? GetName(mod, extname.name.index) : extname.name.text;
+		if(!common)
+		{
+			module->AddUndefinedSymbol(name);
+			continue;
+		}
+
+		/* near variables and Borland segment indexes only store a length */
+		offset_t size = extname.common_type == ExternalName::FarCommon
+			? offset_t(extname.value.far.number) * extname.value.far.element_size
+			: extname.value.near.length;
+
+		if(record.record_type == LCOMDEF)
+			module->AddLocalCommonSymbol(Linker::SymbolDefinition::CreateLocalCommon(name, "", size));
+		else
+			module->AddCommonSymbol(Linker::SymbolDefinition::CreateCommon(name, "", size));
+	}
+}
+
+void OMF86Format::ModuleConverter::ConvertData(std::shared_ptr<LogicalDataRecord> record)
+{
+	std::shared_ptr<Linker::Section> section = GetDataSection(*record);
+	if(section == nullptr)
+	{
+		data_record = nullptr;
+		return;
+	}
+
+	data_record = record;
+	if(auto data = std::get_if<DataBlock::Data>(&record->data->content))
+	{
+		section->WriteData(data->size(), record->offset, data->data());
+	}
+	else
+	{
+		std::vector<uint8_t> buffer;
+		record->data->Expand(buffer);
+		section->WriteData(buffer.size(), record->offset, buffer.data());
+	}
+}
+
+void OMF86Format::ModuleConverter::ConvertFixups(const Module& mod, const FixupRecord& record)
+{
+	for(auto& entry : record.fixup_data)
+	{
+		if(auto thread = std::get_if<FixupRecord::Thread>(&entry))
+		{
+			if(thread->frame)
+				frame_threads[thread->thread_number & 3] = thread->reference;
+			else
+				target_threads[thread->thread_number & 3] = thread->reference;
+		}
+		else if(auto fixup = std::get_if<FixupRecord::Fixup>(&entry))
+		{
+			ConvertFixup(mod, *fixup);
+		}
+	}
+}
+
+void OMF86Format::ModuleConverter::ConvertFixup(const Module& mod, const FixupRecord::Fixup& fixup)
+{
+	if(data_record == nullptr)
+	{
+		Linker::Error << "Error: fixup without preceding data record, ignoring" << std::endl;
+		return;
+	}
+
+	/* a fixup within iterated data applies to every repetition of the value */
+	std::vector<offset_t> positions;
+	if(auto blocks = std::get_if<DataBlock::Blocks>(&data_record->data->content))
+	{
+		GetIteratedOffsets(*blocks, data_record->record_type == LIDATA32, fixup.offset, positions);
+		if(positions.empty())
+		{
+			std::ostringstream message;
+			message << "Fatal error: fixup at offset 0x" << std::hex << fixup.offset << " does not refer to the contents of the iterated data record at offset 0x" << std::hex << data_record->record_offset;
+			Linker::FatalError(message.str());
+		}
+	}
+	else
+	{
+		positions.push_back(fixup.offset);
+	}
+
+	ReferenceMethod target = GetTarget(fixup.ref);
+	ReferenceMethod frame = GetFrame(fixup.ref);
+	Linker::Target target_reference = GetReference(mod, target);
+	uint64_t displacement = fixup.ref.displacement;
+
+	for(offset_t position : positions)
+	{
+		Linker::Location source = GetSegmentLocation(data_record->segment.index, data_record->offset + position);
+		Linker::Target frame_reference;
+		if(std::get_if<UsesSource>(&frame))
+			frame_reference = Linker::Target(source).GetSegment();
+		else if(std::get_if<UsesTarget>(&frame) || std::get_if<UsesAbsolute>(&frame))
+			frame_reference = target_reference.GetSegment();
+		else
+			frame_reference = GetReference(mod, frame).GetSegment();
+
+		auto add_offset = [&](size_t size)
+		{
+			Linker::Relocation relocation =
+				!fixup.segment_relative
+				? Linker::Relocation::Relative(size, source, target_reference, displacement - size, ::LittleEndian)
+				: omf.option_linear
+				? Linker::Relocation::Absolute(size, source, target_reference, displacement, ::LittleEndian)
+				: Linker::Relocation::OffsetFrom(size, source, target_reference, frame_reference, displacement, ::LittleEndian);
+			relocation.AddCurrentValue();
+			module->AddRelocation(relocation);
+		};
+
+		auto add_base = [&](offset_t offset)
+		{
+			Linker::Location base_source(source.section, source.offset + offset);
+			Linker::Relocation relocation =
+				omf.option_pmode
+				? Linker::Relocation::Selector(base_source, frame_reference)
+				: Linker::Relocation::Paragraph(base_source, frame_reference);
+			relocation.AddCurrentValue();
+			module->AddRelocation(relocation);
+		};
+
+		switch(fixup.type)
+		{
+		case FixupRecord::Fixup::RelocationLowByte:
+			add_offset(1);
+			break;
+		case FixupRecord::Fixup::RelocationOffset16:
+		case FixupRecord::Fixup::RelocationOffset16_LoaderResolved:
+			add_offset(2);
+			break;
+		case FixupRecord::Fixup::RelocationSegment:
+			add_base(0);
+			break;
+		case FixupRecord::Fixup::RelocationPointer32:
+			add_offset(2);
+			add_base(2);
+			break;
+		case FixupRecord::Fixup::RelocationOffset32_PharLap:
+		case FixupRecord::Fixup::RelocationOffset32:
+		case FixupRecord::Fixup::RelocationOffset32_LoaderResolved:
+			add_offset(4);
+			break;
+		case FixupRecord::Fixup::RelocationPointer48_PharLap:
+		case FixupRecord::Fixup::RelocationPointer48:
+			if(fixup.type == FixupRecord::Fixup::RelocationPointer48 || omf.omf_version == OMF_VERSION_PHARLAP)
+			{
+				add_offset(4);
+				add_base(4);
+				break;
+			}
+			[[fallthrough]];
+		default:
+			Linker::Error << "Error: unsupported fixup location type " << std::dec << int(fixup.type) << ", ignoring" << std::endl;
+			break;
+		}
+	}
+}
+
+void OMF86Format::ModuleConverter::ConvertModuleEnd(const Module& mod, const ModuleEndRecord& record)
+{
+	if(!record.start_address)
+		return;
+
+	if(auto physical = std::get_if<std::tuple<uint16_t, uint16_t>>(&record.start_address.value()))
+	{
+		/* physical start address */
+		module->AddGlobalSymbol(".entry", Linker::Location((offset_t(std::get<0>(*physical)) << 4) + std::get<1>(*physical)));
+		return;
+	}
+
+	const Reference& ref = std::get<Reference>(record.start_address.value());
+	Linker::Target target = GetReference(mod, GetTarget(ref), ref.displacement);
+	if(Linker::Location * location = std::get_if<Linker::Location>(&target.target))
+	{
+		module->AddGlobalSymbol(".entry", *location);
+	}
+	else
+	{
+		Linker::Warning << "Warning: start address relative to an external symbol is not supported, ignoring" << std::endl;
+	}
+}
+
+//// OMF86Format (module generation)
+
+void OMF86Format::ConvertRecords(ModuleConverter& converter) const
+{
+	size_t module_index = 0;
+	const Module * mod = nullptr;
+	for(size_t record_index = 0; record_index < records.size(); record_index++)
+	{
+		if(module_index < modules.size() && modules[module_index].first_record == record_index)
+		{
+			mod = &modules[module_index++];
+		}
+		converter.ProcessRecord(records[record_index], mod);
+	}
+	converter.Finish();
+}
+
+void OMF86Format::SetupOptions(std::shared_ptr<Linker::OutputFormat> format)
+{
+	option_16bit = format->FormatIs16bit();
+	option_linear = format->FormatIsLinear();
+	option_pmode = format->FormatIsProtectedMode();
+}
+
+void OMF86Format::ProduceModule(Linker::ModuleCollector& linker, Linker::Reader& rd, std::string file_name)
+{
+	/* records are converted as soon as they are read and released afterwards, only the index tables of the modules are kept */
+	rd.endiantype = LittleEndian;
+	offset_t end = rd.GetImageEnd();
+	ModuleConverter converter(*this, linker, file_name, false);
+	while(std::shared_ptr<Record> record = ReadNextRecord(rd, end))
+	{
+		converter.ProcessRecord(record, modules.empty() ? nullptr : &modules.back());
+	}
+	converter.Finish();
+	file_size = rd.Tell();
+}
+
+void OMF86Format::GenerateModule(Linker::ModuleCollector& linker, std::string file_name, bool is_library) const
+{
+	ModuleConverter converter(*this, linker, file_name, is_library);
+	ConvertRecords(converter);
+}
+
 void OMF86Format::GenerateModule(Linker::Module& module) const
 {
-	/* TODO */
+	ModuleConverter converter(*this, module);
+	ConvertRecords(converter);
+}
+
+bool OMF86Format::FormatProvidesSegmentation() const
+{
+	return true;
 }
 
 //// OMF80Format::ExternalNameIndex
@@ -6,6 +6,7 @@
 #include "../common.h"
 #include "../dumper/dumper.h"
 #include "../linker/format.h"
+#include "../linker/module.h"
 #include "../linker/reader.h"
 #include "../linker/writer.h"
 
@@ -591,10 +592,11 @@ namespace OMF
 			NameIndex name;
 			TypeIndex type;
 			common_type_t common_type = External;
+			/** @brief Borland segment index, for SegmentIndexCommon, the length is stored in value.near */
+			uint8_t segment_index = 0;
 
 			union
 			{
-				uint8_t segment_index;
 				struct
 				{
 					uint32_t length;
@@ -717,7 +719,7 @@ namespace OMF
 		{
 		public:
 			/** @brief Number of times the data should be appear. Should be 1 for enumerated data */
-			uint16_t repeat_count;
+			uint32_t repeat_count;
 
 			/** @brief If the contents are a sequence of blocks (iterated only) */
 			typedef std::vector<std::shared_ptr<DataBlock>> Blocks;
@@ -740,6 +742,11 @@ namespace OMF
 			uint16_t GetIteratedDataBlockSize(OMF86Format * omf, bool is32bit) const;
 			/** @brief Writes the contents of an iterated record into a file */
 			void WriteIteratedDataBlock(OMF86Format * omf, ChecksumWriter& wr, bool is32bit) const;
+
+			/** @brief Gets the size of the block once all iterations are expanded */
+			offset_t GetExpandedSize() const;
+			/** @brief Appends the contents of the block to a buffer, with all iterations expanded */
+			void Expand(std::vector<uint8_t>& buffer) const;
 		};
 
 		/** @brief Represents a reference for a relocation */
@@ -754,7 +761,7 @@ namespace OMF
 			/** @brief The frame for a reference, or a thread number */
 			std::variant<ThreadNumber, SegmentIndex, GroupIndex, ExternalIndex, FrameNumber, UsesSource, UsesTarget, UsesAbsolute> frame = ThreadNumber(0);
 			/** @brief Displacement to be added to the value */
-			uint32_t displacement;
+			uint32_t displacement = 0;
 
 			void Read(OMF86Format * omf, Linker::Reader& rd, size_t displacement_size);
 			uint16_t Size(OMF86Format * omf, bool is32bit) const;
@@ -792,7 +799,9 @@ namespace OMF
 			LOCSYM = 0x92, // Intel 4.0
 			LINNUM = 0x94, // Intel 4.0
 			LNAMES = 0x96,
+			SEGDEF16 = 0x98,
 			SEGDEF = 0x98, // Intel 4.0
+			SEGDEF32 = 0x99, // TIS 1.1
 			GRPDEF = 0x9A, // Intel 4.0
 			FIXUPP16 = 0x9C,
 			FIXUPP = 0x9C,
@@ -1423,7 +1432,7 @@ namespace OMF
 			SegmentIndex segment;
 			/** @brief Offset within segment where the data starts */
 			uint32_t offset;
-			/** @brief The data contents */
+			/** @brief The data contents, for LIDATA this is a block repeated once, containing the iterated blocks of the record */
 			std::shared_ptr<DataBlock> data;
 
 			LogicalDataRecord(record_type_t record_type = record_type_t(0))
@@ -2148,20 +2157,138 @@ namespace OMF
 		std::vector<Module> modules;
 
 		// TIS library fields
-		uint16_t page_size;
+		/** @brief Page size of a TIS library, modules start on a page boundary, 0 if not a library */
+		uint16_t page_size = 0;
+		/** @brief Offset of the library header record, pages are counted from here */
+		offset_t library_offset = 0;
 
 		/** @brief Parses an OMF86 file */
 		static std::shared_ptr<OMF86Format> ReadOMFFile(Linker::Reader& rd);
 
 		static void DumpAddFields(const Record * record, Dumper::Dumper& dump, Dumper::Region& region, const OMF86Format * omf, const Module * mod, size_t record_index);
 
+		/* * * Module generation * * */
+
+		bool option_16bit = true;
+		bool option_linear = false;
+		bool option_pmode = false;
+
+		/**
+		 * @brief Converts the records of an OMF86 file into Linker::Module objects, one record at a time
+		 *
+		 * The same record objects are used for dumping and for linking.
+		 * When linking, records are read one at a time and released once they have been converted, only the index tables of the module and the last data record are kept.
+		 * Iterated data is expanded directly into the section contents and fixups are turned into relocations as soon as they are read.
+		 */
+		class ModuleConverter
+		{
+		public:
+			/** @brief Generates a separate module for every module in the file */
+			ModuleConverter(const OMF86Format& omf, Linker::ModuleCollector& linker, std::string file_name, bool is_library)
+				: omf(omf), linker(&linker), file_name(file_name), is_library(is_library)
+			{
+			}
+
+			/** @brief Collects every module in the file into a single module */
+			ModuleConverter(const OMF86Format& omf, Linker::Module& module)
+				: omf(omf), module(&module)
+			{
+			}
+
+			/**
+			 * @brief Converts a single record
+			 *
+			 * @param record The record to convert, it may be released afterwards
+			 * @param mod The module the record belongs to, its index tables must contain all the definitions up to this record
+			 */
+			void ProcessRecord(std::shared_ptr<Record> record, const Module * mod);
+			/** @brief Finishes the last module, must be called after the last record */
+			void Finish();
+
+			/**
+			 * @brief Collects the offsets in the expanded data at which a byte of a sequence of iterated data blocks appears
+			 *
+			 * @param blocks The iterated blocks, as they appear in an LIDATA record
+			 * @param is32bit Whether the repeat counts are 32-bit
+			 * @param position The offset of the byte within the encoded blocks, or offset_t(-1) if only the size is needed
+			 * @param offsets The offsets within the expanded data are appended to this vector, one for each repetition
+			 * @return The number of bytes the blocks occupy in the record
+			 */
+			static offset_t GetIteratedOffsets(const DataBlock::Blocks& blocks, bool is32bit, offset_t position, std::vector<offset_t>& offsets);
+
+		private:
+			const OMF86Format& omf;
+			Linker::ModuleCollector * linker = nullptr;
+			std::string file_name;
+			/** @brief Set if all generated modules are library modules, also set once a library header has been encountered */
+			bool is_library = false;
+			/** @brief The module currently being generated, if the modules are passed to a ModuleCollector */
+			std::shared_ptr<Linker::Module> current_module;
+			/** @brief The module the contents are added to */
+			Linker::Module * module = nullptr;
+			/** @brief Set between a module header and its module end record */
+			bool in_module = false;
+
+			struct SegmentEntry
+			{
+				/** @brief The generated section, or null for absolute segments */
+				std::shared_ptr<Linker::Section> section;
+				/** @brief Address of an absolute segment */
+				offset_t base = 0;
+			};
+
+			/** @brief The target or frame of a fixup, after thread references are resolved */
+			typedef std::variant<SegmentIndex, GroupIndex, ExternalIndex, FrameNumber, UsesSource, UsesTarget, UsesAbsolute> ReferenceMethod;
+
+			std::vector<SegmentEntry> segments;
+			ReferenceMethod target_threads[4] = { SegmentIndex(), SegmentIndex(), SegmentIndex(), SegmentIndex() };
+			ReferenceMethod frame_threads[4] = { SegmentIndex(), SegmentIndex(), SegmentIndex(), SegmentIndex() };
+
+			/** @brief The last LEDATA/LIDATA record, fixups refer to its contents */
+			std::shared_ptr<LogicalDataRecord> data_record;
+
+			void StartModule();
+			void FinishModule();
+
+			const std::string& GetName(const Module& mod, index_t index) const;
+			Linker::Location GetSegmentLocation(index_t index, offset_t displacement = 0) const;
+			Linker::Target GetReference(const Module& mod, const ReferenceMethod& method, offset_t displacement = 0) const;
+			/** @brief Returns the target of a reference, looking up the target thread if needed */
+			ReferenceMethod GetTarget(const Reference& ref) const;
+			/** @brief Returns the frame of a reference, looking up the frame thread if needed */
+			ReferenceMethod GetFrame(const Reference& ref) const;
+			/** @brief Returns the section of a data record, converting it from a zero filled section if needed */
+			std::shared_ptr<Linker::Section> GetDataSection(const LogicalDataRecord& record);
+
+			void ConvertSegmentDefinition(const Module& mod, const SegmentDefinitionRecord& record);
+			void ConvertSymbols(const Module& mod, const SymbolsDefinitionRecord& record);
+			void ConvertExternalNames(const Module& mod, const ExternalNamesDefinitionRecord& record);
+			void ConvertData(std::shared_ptr<LogicalDataRecord> record);
+			void ConvertFixups(const Module& mod, const FixupRecord& record);
+			void ConvertFixup(const Module& mod, const FixupRecord::Fixup& fixup);
+			void ConvertModuleEnd(const Module& mod, const ModuleEndRecord& record);
+		};
+
+		/**
+		 * @brief Parses the next record, skipping the padding after the modules of a library
+		 *
+		 * @return The record, or null if the end of the file or the library dictionary is reached
+		 */
+		std::shared_ptr<Record> ReadNextRecord(Linker::Reader& rd, offset_t end);
+
 		void ReadFile(Linker::Reader& rd) override;
 		using Linker::Format::WriteFile;
 		offset_t WriteFile(Linker::Writer& wr) const override;
 		void Dump(Dumper::Dumper& dump) const override;
-		using Linker::InputFormat::GenerateModule;
+		void SetupOptions(std::shared_ptr<Linker::OutputFormat> format) override;
+		using Linker::InputFormat::ProduceModule;
+		void ProduceModule(Linker::ModuleCollector& linker, Linker::Reader& rd, std::string file_name) override;
+		void GenerateModule(Linker::ModuleCollector& linker, std::string file_name, bool is_library = false) const override;
 		void GenerateModule(Linker::Module& module) const override;
-		/* TODO */
+		bool FormatProvidesSegmentation() const override;
+	private:
+		/** @brief Passes the stored records to a converter, used after the file has been read with ReadFile */
+		void ConvertRecords(ModuleConverter& converter) const;
 	};
 
 	class OMF86Format::CommentRecord::GenericCommentRecord : public CommentRecord
@@ -1,6 +1,10 @@
 
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include "peexe.h"
+#include "../linker/checksum.h"
 #include "../linker/position.h"
 #include "../linker/resolution.h"
 
@@ -130,8 +134,8 @@ offset_t PEFormat::PEOptionalHeader::CalculateValues(COFFFormat& coff)
 	data_size = 0;
 	bss_size = 0;
 
-	total_headers_size = AlignTo(pe.stub.GetStubImageSize() + 24 + GetSize() + coff.sections.size() * 40, file_align);
-	total_image_size = AlignTo(24 + GetSize() + coff.sections.size() * 40, section_align);
+	total_headers_size = AlignTo(pe.stub.GetStubImageSize() + 24 + GetSize() + coff.sections.size() * 40 + pe.bound_imports_size, file_align);
+	total_image_size = AlignTo(24 + GetSize() + coff.sections.size() * 40 + pe.bound_imports_size, section_align);
 
 	for(auto& coff_section : coff.sections)
 	{
@@ -161,7 +165,7 @@ offset_t PEFormat::PEOptionalHeader::CalculateValues(COFFFormat& coff)
 	auto data = coff.GetDataSegment();
 	data_address = data ? AddressToRVA(data->base_address) : 0; // technically not needed for 64-bit binaries
 
-	// TODO: checksum must be calculated for critical DLLs
+	// the checksum is calculated while writing the file, if requested
 
 	return offset_t(-1);
 }
@@ -516,11 +520,15 @@ void PEFormat::Resource::DumpResource(const PEFormat& fmt, Dumper::Dumper& dump,
 
 uint32_t PEFormat::Resource::AssignAddress(PEFormat& fmt, uint32_t rva)
 {
-	data_rva = rva;
 	if(section != nullptr)
 	{
 		size = section->Size();
+		if(fmt.option_merge_resources && fmt.resources->MergeResource(*this))
+		{
+			return rva;
+		}
 	}
+	data_rva = rva;
 	return rva + size;
 }
 
@@ -534,7 +542,7 @@ void PEFormat::Resource::WriteDirectories(Linker::Writer& wr, const PEFormat& fm
 
 offset_t PEFormat::Resource::WriteResource(Linker::Writer& wr, const PEFormat& fmt, uint32_t rva_to_offset) const
 {
-	if(section != nullptr)
+	if(section != nullptr && !merged)
 	{
 		wr.Seek(data_rva - rva_to_offset);
 		section->WriteFile(wr);
@@ -789,6 +797,12 @@ uint32_t PEFormat::ResourceDirectory::CalculateDirectoryOffsets(PEFormat& fmt, u
 					entry.content_offset = offset;
 				offset = (*dir)->CalculateDirectoryOffsets(fmt, offset, level_deeper - 1);
 			}
+			else if(level_deeper == 1)
+			{
+				// resource data entry
+				entry.content_offset = offset;
+				offset += 16;
+			}
 		}
 
 		for(auto& entry : id_entries)
@@ -799,6 +813,12 @@ uint32_t PEFormat::ResourceDirectory::CalculateDirectoryOffsets(PEFormat& fmt, u
 					entry.content_offset = offset;
 				offset = (*dir)->CalculateDirectoryOffsets(fmt, offset, level_deeper - 1);
 			}
+			else if(level_deeper == 1)
+			{
+				// resource data entry
+				entry.content_offset = offset;
+				offset += 16;
+			}
 		}
 
 		return offset;
@@ -977,6 +997,24 @@ uint32_t PEFormat::ResourcesSection::FetchString(std::string s)
 	}
 }
 
+bool PEFormat::ResourcesSection::MergeResource(Resource& resource)
+{
+	if(resource.size == 0)
+		return false;
+
+	std::vector<uint8_t> data(resource.size);
+	resource.section->ReadData(data.size(), 0, data.data());
+	size_t index = duplicate_resources.Add(std::move(data), resource.size);
+	if(index == Linker::DuplicateFinder::None)
+	{
+		placed_resources.push_back(&resource);
+		return false;
+	}
+	resource.data_rva = placed_resources[index]->data_rva;
+	resource.merged = true;
+	return true;
+}
+
 bool PEFormat::ResourcesSection::IsPresent() const
 {
 	return name_entries.size() > 0 || id_entries.size() > 0;
@@ -985,7 +1023,8 @@ bool PEFormat::ResourcesSection::IsPresent() const
 void PEFormat::ResourcesSection::Generate(PEFormat& fmt)
 {
 	uint32_t offset = 0;
-	for(size_t level = 0; level < max_depth; level++)
+	// the resource data entries follow the deepest level of directories
+	for(size_t level = 0; level <= max_depth; level++)
 	{
 		offset = CalculateDirectoryOffsets(fmt, offset, level);
 	}
@@ -1001,6 +1040,12 @@ void PEFormat::ResourcesSection::Generate(PEFormat& fmt)
 	{
 		rva = CollectResourceData(fmt, rva, level);
 	}
+	size = virtual_size() = rva - address;
+
+	if(fmt.option_merge_resources)
+	{
+		duplicate_resources.ReportDuplicates("resource");
+	}
 }
 
 void PEFormat::ResourcesSection::ReadSectionData(Linker::Reader& rd, const PEFormat& fmt)
@@ -1021,7 +1066,7 @@ void PEFormat::ResourcesSection::WriteSectionData(Linker::Writer& wr, const PEFo
 			wr.WriteWord(1, 0);
 	}
 
-	offset_t last_written_offset = WriteResources(wr, fmt, section_pointer - address);
+	offset_t last_written_offset = WriteResources(wr, fmt, address - section_pointer);
 
 	if(last_written_offset != section_pointer + size)
 	{
@@ -1194,10 +1239,20 @@ void PEFormat::ImportsSection::WriteSectionData(Linker::Writer& wr, const PEForm
 		last_written_offset = std::max(last_written_offset, wr.Tell());
 	}
 
-	// then list the import address tables (identical formats)
+	// then list the import address tables (identical formats, unless bound)
 	for(auto& library : libraries)
 	{
 		wr.Seek(rva_to_offset + library.address_table_rva);
+		if(library.bound_addresses.size() != 0)
+		{
+			for(uint64_t bound_address : library.bound_addresses)
+			{
+				wr.WriteWord(fmt.Is64Bit() ? 8 : 4, bound_address);
+			}
+			wr.WriteWord(fmt.Is64Bit() ? 8 : 4, 0);
+			last_written_offset = std::max(last_written_offset, wr.Tell());
+			continue;
+		}
 		for(auto& import_entry : library.import_table)
 		{
 			if(auto import_name = std::get_if<ImportedLibrary::Name>(&import_entry))
@@ -1309,8 +1364,8 @@ void PEFormat::ImportsSection::ParseDirectoryData(const PEFormat& fmt, uint32_t
 		library.name = fmt.ReadASCII(library.name_rva, '\0');
 		library_indexes[library.name] = libraries.size() - 1;
 
-		// only read the import address table
-		uint32_t ilt_rva = library.address_table_rva;
+		// only read the import address table, unless it has been bound
+		uint32_t ilt_rva = library.timestamp != 0 && library.lookup_table_rva != 0 ? library.lookup_table_rva : library.address_table_rva;
 		while(true)
 		{
 			offset_t entry = fmt.ReadUnsigned(entry_size, ilt_rva, ::LittleEndian); ilt_rva += entry_size;
@@ -1387,6 +1442,153 @@ void PEFormat::ImportsSection::DumpDirectory(const PEFormat& fmt, Dumper::Dumper
 	}
 }
 
+void PEFormat::CalculateBoundImports()
+{
+	// descriptors and forwarder references take 8 bytes each, followed by an empty descriptor
+	uint32_t offset = 8;
+	for(auto& descriptor : bound_imports)
+	{
+		offset += 8 * (1 + descriptor.forwarder_references.size());
+	}
+
+	// library names are only stored once
+	std::map<std::string, uint16_t> name_offsets;
+	auto assign_name = [&](BoundImportDescriptor& descriptor)
+	{
+		auto it = name_offsets.find(descriptor.name);
+		if(it != name_offsets.end())
+		{
+			descriptor.name_offset = it->second;
+			return;
+		}
+		descriptor.name_offset = name_offsets[descriptor.name] = offset;
+		offset += descriptor.name.size() + 1;
+	};
+
+	for(auto& descriptor : bound_imports)
+	{
+		assign_name(descriptor);
+		for(auto& forwarder_reference : descriptor.forwarder_references)
+		{
+			assign_name(forwarder_reference);
+		}
+	}
+
+	bound_imports_size = AlignTo(offset, 4);
+}
+
+void PEFormat::ReadBoundImports(Linker::Reader& rd, uint32_t directory_rva, uint32_t directory_size)
+{
+	auto read_descriptor = [&](uint16_t& count) -> BoundImportDescriptor
+	{
+		BoundImportDescriptor descriptor;
+		descriptor.timestamp = rd.ReadUnsigned(4);
+		descriptor.name_offset = rd.ReadUnsigned(2);
+		count = rd.ReadUnsigned(2);
+		return descriptor;
+	};
+	auto read_name = [&](BoundImportDescriptor& descriptor)
+	{
+		rd.Seek(directory_rva + descriptor.name_offset);
+		descriptor.name = rd.ReadASCIIZ();
+	};
+
+	bound_imports_offset = directory_rva;
+	bound_imports_size = directory_size;
+
+	rd.Seek(directory_rva);
+	while(rd.Tell() + 8 <= directory_rva + directory_size)
+	{
+		uint16_t forwarder_count;
+		BoundImportDescriptor descriptor = read_descriptor(forwarder_count);
+		if(descriptor.timestamp == 0 && descriptor.name_offset == 0 && forwarder_count == 0)
+			break;
+		for(uint16_t i = 0; i < forwarder_count; i++)
+		{
+			uint16_t reserved;
+			descriptor.forwarder_references.push_back(read_descriptor(reserved));
+		}
+		bound_imports.push_back(descriptor);
+	}
+
+	for(auto& descriptor : bound_imports)
+	{
+		read_name(descriptor);
+		for(auto& forwarder_reference : descriptor.forwarder_references)
+		{
+			read_name(forwarder_reference);
+		}
+	}
+}
+
+void PEFormat::WriteBoundImports(Linker::Writer& wr) const
+{
+	wr.Seek(bound_imports_offset);
+	for(auto& descriptor : bound_imports)
+	{
+		wr.WriteWord(4, descriptor.timestamp);
+		wr.WriteWord(2, descriptor.name_offset);
+		wr.WriteWord(2, descriptor.forwarder_references.size());
+		for(auto& forwarder_reference : descriptor.forwarder_references)
+		{
+			wr.WriteWord(4, forwarder_reference.timestamp);
+			wr.WriteWord(2, forwarder_reference.name_offset);
+			wr.WriteWord(2, 0);
+		}
+	}
+	wr.WriteWord(4, 0);
+	wr.WriteWord(4, 0);
+
+	auto write_name = [&](const BoundImportDescriptor& descriptor)
+	{
+		wr.Seek(bound_imports_offset + descriptor.name_offset);
+		wr.WriteData(descriptor.name);
+		wr.WriteWord(1, 0);
+	};
+	for(auto& descriptor : bound_imports)
+	{
+		write_name(descriptor);
+		for(auto& forwarder_reference : descriptor.forwarder_references)
+		{
+			write_name(forwarder_reference);
+		}
+	}
+}
+
+void PEFormat::DumpBoundImports(Dumper::Dumper& dump, uint32_t directory_rva, uint32_t directory_size) const
+{
+	Dumper::Region bound_imports_region("Bound import table", directory_rva, directory_size, 8);
+	bound_imports_region.AddField("Address", Dumper::HexDisplay::Make(), offset_t(directory_rva));
+	bound_imports_region.Display(dump);
+
+	uint32_t offset = directory_rva;
+	size_t library_index = 0;
+	for(auto& descriptor : bound_imports)
+	{
+		Dumper::Region library_region("Bound library", offset, 8 * (1 + descriptor.forwarder_references.size()), 8);
+		library_region.InsertField(0, "Index", Dumper::DecDisplay::Make(), offset_t(library_index + 1));
+		library_region.AddField("Name", Dumper::StringDisplay::Make("\""), descriptor.name);
+		library_region.AddField("Name offset", Dumper::HexDisplay::Make(4), offset_t(descriptor.name_offset));
+		library_region.AddField("Time stamp", Dumper::HexDisplay::Make(), offset_t(descriptor.timestamp));
+		library_region.Display(dump);
+		offset += 8;
+
+		uint32_t forwarder_index = 0;
+		for(auto& forwarder_reference : descriptor.forwarder_references)
+		{
+			Dumper::Entry forwarder_entry("Forwarder reference", forwarder_index + 1, offset, 8);
+			forwarder_entry.AddField("Name", Dumper::StringDisplay::Make("\""), forwarder_reference.name);
+			forwarder_entry.AddField("Name offset", Dumper::HexDisplay::Make(4), offset_t(forwarder_reference.name_offset));
+			forwarder_entry.AddField("Time stamp", Dumper::HexDisplay::Make(), offset_t(forwarder_reference.timestamp));
+			forwarder_entry.Display(dump);
+			offset += 8;
+			forwarder_index ++;
+		}
+
+		library_index ++;
+	}
+}
+
 void PEFormat::ExportsSection::SetEntry(PEFormat& fmt, uint32_t ordinal, std::shared_ptr<ExportedEntry> entry)
 {
 	if(entries.find(ordinal) != entries.end())
@@ -1849,36 +2051,80 @@ size_t PEFormat::BaseRelocation::GetRelocationSize(const PEFormat * format) cons
 
 bool PEFormat::BaseRelocationsSection::IsPresent() const
 {
-	return blocks_map.size() > 0;
+	return blocks_map.size() > 0 || collected_relocations.size() > 0;
 }
 
-void PEFormat::BaseRelocationsSection::Generate(PEFormat& fmt)
+void PEFormat::BaseRelocationsSection::SortRelocations(std::vector<collected_relocation>& relocations)
 {
-	uint32_t full_size = 0;
-	blocks_list.clear();
-	for(auto pair : blocks_map)
+	/* least significant digit first radix sort, each pass is stable */
+	std::vector<collected_relocation> buffer(relocations.size());
+	for(unsigned shift = 0; shift < 32; shift += 8)
 	{
-		blocks_list.push_back(pair.second);
+		size_t counts[256] = { };
+		for(auto& entry : relocations)
+		{
+			counts[(entry.rva >> shift) & 0xFF]++;
+		}
+		if(counts[(relocations[0].rva >> shift) & 0xFF] == relocations.size())
+			continue; /* all relocations share this digit, typically the most significant ones */
+		size_t position = 0;
+		for(size_t& count : counts)
+		{
+			size_t next_position = position + count;
+			count = position;
+			position = next_position;
+		}
+		for(auto& entry : relocations)
+		{
+			buffer[counts[(entry.rva >> shift) & 0xFF]++] = entry;
+		}
+		relocations.swap(buffer);
 	}
+}
 
-	for(auto block : blocks_list)
+void PEFormat::BaseRelocationsSection::Generate(PEFormat& fmt)
+{
+	blocks_list.clear();
+	blocks_map.clear();
+	if(collected_relocations.size() > 0)
+		SortRelocations(collected_relocations);
+
+	std::shared_ptr<BaseRelocationBlock> block = nullptr;
+	for(size_t index = 0; index < collected_relocations.size(); index++)
 	{
-		block->block_size = 8;
-		for(auto pair : block->relocations_map)
+		auto& entry = collected_relocations[index];
+		if(index + 1 < collected_relocations.size() && collected_relocations[index + 1].rva == entry.rva)
 		{
-			Linker::Debug << "Debug: Relocation at " << std::hex << pair.second.offset << std::endl;
-			block->relocations_list.push_back(pair.second);
-			block->block_size += 2 * pair.second.GetEntryCount(&fmt);
+			/* the last relocation added for an address takes precedence */
+			Linker::Error << "Error: duplicate relocation for address " << std::hex << entry.rva << std::dec << std::endl;
+			continue;
 		}
-		if(block->block_size != AlignTo(block->block_size, 4))
+
+		uint32_t page_rva = entry.rva & ~(BaseRelocationBlock::PAGE_SIZE - 1);
+		if(block == nullptr || block->page_rva != page_rva)
 		{
-			block->relocations_list.push_back(BaseRelocation{BaseRelocation::RelAbsolute, 0, 0});
-			block->block_size += 2;
+			block = std::make_shared<BaseRelocationBlock>(page_rva);
+			block->block_size = 8;
+			blocks_list.push_back(block);
+			blocks_map[page_rva] = block;
 		}
-		Linker::Debug << "Debug: Block size " << std::hex << block->block_size << std::endl;
-		full_size = AlignTo(full_size, 4) + block->block_size;
+		block->relocations_list.push_back(entry.relocation);
+		block->block_size += 2 * entry.relocation.GetEntryCount(&fmt);
 	}
 
+	/* blocks must start on 32-bit boundaries */
+	uint32_t full_size = 0;
+	for(auto& current_block : blocks_list)
+	{
+		if(current_block->block_size != AlignTo(current_block->block_size, 4))
+		{
+			current_block->relocations_list.push_back(BaseRelocation{BaseRelocation::RelAbsolute, 0, 0});
+			current_block->block_size += 2;
+		}
+		full_size += current_block->block_size;
+	}
+	Linker::Debug << "Debug: " << collected_relocations.size() << " base relocations in " << blocks_list.size() << " blocks, 0x" << std::hex << full_size << std::dec << " bytes" << std::endl;
+
 	virtual_size() = full_size;
 	size = AlignTo(full_size, fmt.GetOptionalHeader().file_align);
 }
@@ -1890,30 +2136,29 @@ void PEFormat::BaseRelocationsSection::ReadSectionData(Linker::Reader& rd, const
 
 void PEFormat::BaseRelocationsSection::WriteSectionData(Linker::Writer& wr, const PEFormat& fmt) const
 {
-	offset_t offset = section_pointer;
-	for(auto block : blocks_list)
+	/* the entire section, including the padding, is assembled in memory and written at once */
+	std::vector<uint8_t> data(size);
+	offset_t offset = 0;
+	for(auto& block : blocks_list)
 	{
-		offset = AlignTo(offset, 4);
-		wr.Seek(offset);
-		wr.WriteWord(4, block->page_rva);
-		wr.WriteWord(4, block->block_size);
-
-		for(auto relocation : block->relocations_list)
+		::WriteWord(4, 4, &data[offset], block->page_rva, ::LittleEndian);
+		::WriteWord(4, 4, &data[offset + 4], block->block_size, ::LittleEndian);
+		offset_t entry_offset = offset + 8;
+		for(auto& relocation : block->relocations_list)
 		{
-			wr.WriteWord(2, (relocation.type << 12) | (relocation.offset));
+			::WriteWord(2, 2, &data[entry_offset], (relocation.type << 12) | relocation.offset, ::LittleEndian);
+			entry_offset += 2;
 			if(relocation.GetEntryCount(&fmt) >= 2)
 			{
-				wr.WriteWord(2, relocation.parameter);
+				::WriteWord(2, 2, &data[entry_offset], relocation.parameter, ::LittleEndian);
+				entry_offset += 2;
 			}
 		}
-
 		offset += block->block_size;
 	}
 
-	while(wr.Tell() < section_pointer + size)
-	{
-		wr.WriteWord(1, 0);
-	}
+	wr.Seek(section_pointer);
+	wr.WriteData(data);
 }
 
 uint32_t PEFormat::BaseRelocationsSection::ImageSize(const PEFormat& fmt) const
@@ -2187,23 +2432,13 @@ std::string PEFormat::ReadData(uint32_t rva, size_t count) const
 
 void PEFormat::AddBaseRelocation(uint32_t rva, BaseRelocation::relocation_type type, uint16_t low_ref)
 {
-	uint32_t page_rva = rva & ~(BaseRelocationBlock::PAGE_SIZE - 1);
-	if(base_relocations->blocks_map.find(page_rva) == base_relocations->blocks_map.end())
-	{
-		base_relocations->blocks_map[page_rva] = std::make_shared<BaseRelocationBlock>(page_rva);
-	}
-	uint16_t page_offset = rva & (BaseRelocationBlock::PAGE_SIZE - 1);
-	if(base_relocations->blocks_map.find(page_offset) != base_relocations->blocks_map.end())
-	{
-		Linker::Error << "Error: duplicate relocation for address " << std::hex << rva << std::endl;
-	}
-	BaseRelocation rel(type, page_offset);
+	BaseRelocation rel(type, rva & (BaseRelocationBlock::PAGE_SIZE - 1));
 	if(rel.GetEntryCount(this) >= 2)
 	{
 		// we will store low_ref in the following relocation entry
 		rel.parameter = low_ref;
 	}
-	base_relocations->blocks_map[page_rva]->relocations_map[page_offset] = rel;
+	base_relocations->collected_relocations.push_back(BaseRelocationsSection::collected_relocation{rva, rel});
 }
 
 void PEFormat::ReadFile(Linker::Reader& rd)
@@ -2251,7 +2486,12 @@ void PEFormat::ReadFile(Linker::Reader& rd)
 		//case PEOptionalHeader::DirGlobalPointer:
 		//case PEOptionalHeader::DirTLSTable:
 		//case PEOptionalHeader::DirLoadConfigTable:
-		//case PEOptionalHeader::DirBoundImport:
+		case PEOptionalHeader::DirBoundImport:
+			if(data_directory.size != 0)
+			{
+				ReadBoundImports(rd, data_directory.address, data_directory.size);
+			}
+			break;
 		//case PEOptionalHeader::DirIAT:
 		//case PEOptionalHeader::DirDelayImportDescriptor:
 		//case PEOptionalHeader::DirCLRRuntimeHeader:
@@ -2339,6 +2579,16 @@ void PEFormat::CalculateValues()
 	offset_t section_header_size = 40;
 	offset_t offset = file_offset + 24 + optional_header->GetSize() + sections.size() * section_header_size;
 
+	if(bound_imports.size() != 0)
+	{
+		// the headers are mapped at the start of the image, so the file offset is also the relative virtual address
+		CalculateBoundImports();
+		bound_imports_offset = offset;
+		offset += bound_imports_size;
+		GetOptionalHeader().data_directories[PEOptionalHeader::DirBoundImport] =
+			PEOptionalHeader::DataDirectory{bound_imports_offset, bound_imports_size};
+	}
+
 	for(auto section : Sections())
 	{
 		section->virtual_size() = section->MemorySize(*this);
@@ -2367,10 +2617,37 @@ void PEFormat::CalculateValues()
 offset_t PEFormat::WriteFile(Linker::Writer& wr) const
 {
 	wr.endiantype = ::LittleEndian;
+	Linker::Checksum image_checksum(2);
+	if(option_checksum)
+	{
+		wr.checksums.push_back(&image_checksum);
+	}
+
 	stub.WriteStubImage(wr);
 	wr.Seek(file_offset);
 	wr.WriteData(pe_signature);
 	WriteFileContents(wr);
+	if(bound_imports.size() != 0)
+	{
+		WriteBoundImports(wr);
+	}
+
+	if(option_checksum)
+	{
+		std::erase(wr.checksums, &image_checksum);
+		if(image_checksum.valid)
+		{
+			// the folded sum of all 16-bit words, with the checksum field taken as 0, added to the file size
+			wr.SeekEnd();
+			offset_t file_size = wr.Tell();
+			wr.Seek(file_offset + 24 + 64);
+			wr.WriteWord(4, image_checksum.FoldedSum16() + file_size);
+		}
+		else
+		{
+			Linker::Warning << "Warning: unable to calculate the image checksum" << std::endl;
+		}
+	}
 	return offset_t(-1);
 }
 
@@ -2523,7 +2800,12 @@ void PEFormat::Dump(Dumper::Dumper& dump) const
 			//case PEOptionalHeader::DirGlobalPointer:
 			//case PEOptionalHeader::DirTLSTable:
 			//case PEOptionalHeader::DirLoadConfigTable:
-			//case PEOptionalHeader::DirBoundImport:
+			case PEOptionalHeader::DirBoundImport:
+				if(data_directory.size != 0)
+				{
+					DumpBoundImports(dump, data_directory.address, data_directory.size);
+				}
+				break;
 			//case PEOptionalHeader::DirIAT:
 			//case PEOptionalHeader::DirDelayImportDescriptor:
 			//case PEOptionalHeader::DirCLRRuntimeHeader:
@@ -3010,6 +3292,10 @@ void PEFormat::SetOptions(std::map<std::string, std::string>& options)
 		option_import_thunks = true;
 	}
 
+	option_bind_directory = collector.bind();
+	option_checksum = collector.checksum();
+	option_merge_resources = collector.merge_resources();
+
 	/* TODO */
 }
 
@@ -3485,6 +3771,203 @@ offset_t PEFormat::GenerateBaseRelocationSection(Linker::Module& module, offset_
 	return image_end;
 }
 
+/** @brief Searches the bind directory for a library, ignoring the case of the file name */
+static std::filesystem::path FindBindingLibrary(std::string directory, std::string library_name)
+{
+	std::filesystem::path path = std::filesystem::path(directory) / library_name;
+	std::error_code error;
+	if(std::filesystem::is_regular_file(path, error))
+		return path;
+
+	std::string lowercase_name = library_name;
+	std::transform(lowercase_name.begin(), lowercase_name.end(), lowercase_name.begin(), ::tolower);
+	for(auto& directory_entry : std::filesystem::directory_iterator(directory, error))
+	{
+		std::string entry_name = directory_entry.path().filename().string();
+		std::transform(entry_name.begin(), entry_name.end(), entry_name.begin(), ::tolower);
+		if(entry_name == lowercase_name && directory_entry.is_regular_file(error))
+			return directory_entry.path();
+	}
+	return std::filesystem::path();
+}
+
+void PEFormat::BindImports()
+{
+	std::map<std::string, std::shared_ptr<PEFormat>> loaded_libraries;
+	auto load_library = [&](std::string library_name) -> std::shared_ptr<PEFormat>
+	{
+		std::transform(library_name.begin(), library_name.end(), library_name.begin(), ::toupper);
+		auto it = loaded_libraries.find(library_name);
+		if(it != loaded_libraries.end())
+			return it->second;
+
+		std::shared_ptr<PEFormat> library = nullptr;
+		std::filesystem::path path = FindBindingLibrary(Linker::ResolvePath(option_bind_directory), library_name);
+		if(!path.empty())
+		{
+			/* a library that cannot be read only means that its imports stay unbound */
+			std::ifstream library_file(path, std::ios_base::in | std::ios_base::binary);
+			if(!library_file.is_open())
+			{
+				Linker::Warning << "Warning: unable to open " << path.string() << std::endl;
+			}
+			else
+			{
+				try
+				{
+					Linker::Reader rd(::LittleEndian, &library_file);
+					rd.on_overflow = Linker::Reader::ReportOnOverflow;
+					std::array<char, 4> signature;
+					Microsoft::FindActualSignature(rd, signature, "PE\0\0");
+					if(memcmp(signature.data(), "PE\0\0", 4) != 0)
+					{
+						Linker::Warning << "Warning: " << path.string() << " is not a PE file" << std::endl;
+					}
+					else
+					{
+						rd.Seek(0);
+						library = std::make_shared<PEFormat>();
+						library->ReadFile(rd);
+						Linker::Debug << "Debug: loaded " << path.string() << " for binding, time stamp 0x" << std::hex << library->timestamp << std::dec << std::endl;
+					}
+				}
+				catch(Linker::ReadOverflow&)
+				{
+					Linker::Warning << "Warning: " << path.string() << " is truncated" << std::endl;
+					library = nullptr;
+				}
+				catch(Linker::Exception& exception)
+				{
+					Linker::Warning << "Warning: unable to read " << path.string() << ": " << exception.message << std::endl;
+					library = nullptr;
+				}
+				catch(std::exception& error)
+				{
+					Linker::Warning << "Warning: unable to read " << path.string() << ": " << error.what() << std::endl;
+					library = nullptr;
+				}
+			}
+		}
+		loaded_libraries[library_name] = library;
+		return library;
+	};
+
+	bound_imports.clear();
+	for(auto& library : imports->libraries)
+	{
+		library.bound_addresses.clear();
+
+		std::shared_ptr<PEFormat> library_image = load_library(library.name);
+		if(library_image == nullptr)
+		{
+			Linker::Warning << "Warning: unable to load " << library.name << " from " << option_bind_directory << ", imports will be resolved at load time" << std::endl;
+			continue;
+		}
+		if(library_image->Is64Bit() != Is64Bit())
+		{
+			Linker::Warning << "Warning: " << library.name << " in " << option_bind_directory << " has a different word size, imports will be resolved at load time" << std::endl;
+			continue;
+		}
+
+		BoundImportDescriptor descriptor(library.name, library_image->timestamp);
+		std::vector<uint64_t> bound_addresses;
+		for(auto& import_entry : library.import_table)
+		{
+			std::variant<std::string, uint32_t> reference;
+			if(auto import_name = std::get_if<ImportedLibrary::Name>(&import_entry))
+				reference = import_name->name;
+			else
+				reference = uint32_t(std::get<ImportedLibrary::Ordinal>(import_entry));
+
+			// follow forwarders into other libraries, with a limit in case they form a cycle
+			std::optional<uint64_t> bound_address;
+			std::shared_ptr<PEFormat> exporting_library = library_image;
+			for(int forwarder_count = 0; exporting_library != nullptr && forwarder_count < 16; forwarder_count++)
+			{
+				auto& library_exports = *exporting_library->exports;
+				std::shared_ptr<ExportedEntry> exported_entry = nullptr;
+				if(auto name = std::get_if<std::string>(&reference))
+				{
+					auto it = library_exports.named_exports.find(*name);
+					if(it != library_exports.named_exports.end())
+						exported_entry = library_exports.entries[it->second];
+				}
+				else
+				{
+					auto it = library_exports.entries.find(std::get<uint32_t>(reference));
+					if(it != library_exports.entries.end())
+						exported_entry = it->second;
+				}
+				if(exported_entry == nullptr)
+					break;
+
+				if(auto export_rva = std::get_if<uint32_t>(&exported_entry->value))
+				{
+					bound_address = exporting_library->GetOptionalHeader().image_base + *export_rva;
+					break;
+				}
+
+				auto& forwarder = std::get<ExportedEntry::Forwarder>(exported_entry->value);
+				exporting_library = load_library(forwarder.dll_name + ".DLL");
+				if(exporting_library == nullptr)
+					break;
+				reference = forwarder.reference;
+
+				std::string forwarded_name = exporting_library->exports->dll_name != "" ? exporting_library->exports->dll_name : forwarder.dll_name + ".DLL";
+				if(std::find_if(descriptor.forwarder_references.begin(), descriptor.forwarder_references.end(),
+						[&](const BoundImportDescriptor& forwarder_reference) { return forwarder_reference.name == forwarded_name; })
+					== descriptor.forwarder_references.end())
+				{
+					descriptor.forwarder_references.push_back(BoundImportDescriptor(forwarded_name, exporting_library->timestamp));
+				}
+			}
+
+			if(!bound_address)
+			{
+				if(auto import_name = std::get_if<ImportedLibrary::Name>(&import_entry))
+					Linker::Warning << "Warning: unable to resolve " << import_name->name;
+				else
+					Linker::Warning << "Warning: unable to resolve ordinal " << std::get<ImportedLibrary::Ordinal>(import_entry);
+				Linker::Warning << " in " << library.name << ", imports will be resolved at load time" << std::endl;
+				bound_addresses.clear();
+				break;
+			}
+			bound_addresses.push_back(bound_address.value());
+		}
+
+		if(bound_addresses.size() != library.import_table.size())
+			continue;
+
+		library.bound_addresses = bound_addresses;
+		// new style binding, the loader checks the bound import directory
+		library.timestamp = 0xFFFFFFFF;
+		bound_imports.push_back(descriptor);
+		Linker::Debug << "Debug: bound " << bound_addresses.size() << " imports from " << library.name << std::endl;
+	}
+
+	if(bound_imports.size() == 0)
+		return;
+
+	// the bound import directory follows the section table, it must not overlap the first section
+	CalculateBoundImports();
+	offset_t headers_end = stub.GetStubImageSize() + 24 + optional_header->GetSize() + sections.size() * 40 + bound_imports_size;
+	for(auto section : Sections())
+	{
+		if(section->address != 0 && section->address < AlignTo(headers_end, GetOptionalHeader().file_align))
+		{
+			Linker::Warning << "Warning: no room for the bound import directory in the headers, imports will be resolved at load time" << std::endl;
+			for(auto& library : imports->libraries)
+			{
+				library.bound_addresses.clear();
+				library.timestamp = 0;
+			}
+			bound_imports.clear();
+			bound_imports_size = 0;
+			return;
+		}
+	}
+}
+
 void PEFormat::ProcessRelocations(Linker::Module& module)
 {
 	for(Linker::Relocation& rel : module.GetRelocations())
@@ -3847,6 +4330,11 @@ void PEFormat::ProcessModule(Linker::Module& module)
 		image_end = GenerateBaseRelocationSection(module, image_end);
 	}
 
+	if(option_bind_directory != "" && imports->IsPresent())
+	{
+		BindImports();
+	}
+
 	Linker::Location entry;
 	if(module.FindGlobalSymbol(".entry", entry))
 	{
@@ -4,6 +4,7 @@
 #include <array>
 #include "../common.h"
 #include "../dumper/dumper.h"
+#include "../linker/duplicate_finder.h"
 #include "../linker/options.h"
 #include "../linker/segment_manager.h"
 #include "coff.h"
@@ -360,6 +361,8 @@ namespace Microsoft
 
 			/** @brief The section containing the resource, only used for generating images */
 			std::shared_ptr<Linker::Section> section = nullptr;
+			/** @brief Set if the resource shares the data of an identical resource placed earlier, only used for generating images */
+			bool merged = false;
 
 			Resource(const std::vector<Resource::Identifier>& full_identifier)
 				: full_identifier(full_identifier)
@@ -458,8 +461,15 @@ namespace Microsoft
 			std::map<std::string, uint32_t> string_table_map;
 			uint32_t string_table_offset = 0;
 			uint32_t string_table_end_offset = 0;
+			/** @brief Resources that got an address, numbered in the same order as duplicate_resources */
+			std::vector<Resource *> placed_resources;
 		public:
+			/** @brief Finds resources with identical contents */
+			Linker::DuplicateFinder duplicate_resources;
+
 			uint32_t FetchString(std::string s);
+			/** @brief If a resource with identical contents already has an address, lets the resource share its data and returns true */
+			bool MergeResource(Resource& resource);
 
 			using Section::ReadSectionData;
 			using Section::WriteSectionData;
@@ -524,6 +534,8 @@ namespace Microsoft
 			std::map<std::string, size_t> imports_by_name;
 			/** @brief A convenience field to quickly access the imported entry index via its ordinal (only for import by ordinal, not for hints), must be kept synchronized with import_table */
 			std::map<Ordinal, size_t> imports_by_ordinal;
+			/** @brief When the library is bound, the preferred addresses of the imported entries, stored in the import address table in place of the lookup entries */
+			std::vector<uint64_t> bound_addresses;
 
 			/** @brief Adds a new imported entry by name and hint, unless an entry by the same name already exists, in which case it does nothing */
 			void AddImportByName(std::string entry_name, uint16_t hint);
@@ -581,6 +593,41 @@ namespace Microsoft
 		/** @brief The collection of imports in the file */
 		std::shared_ptr<ImportsSection> imports = std::make_shared<ImportsSection>();
 
+		/** @brief An entry of the bound import directory, identifying the version of a library that the import address table was bound against */
+		class BoundImportDescriptor
+		{
+		public:
+			/** @brief The time stamp of the library, the binding is only used if it matches the library being loaded */
+			uint32_t timestamp = 0;
+			/** @brief Name of the library */
+			std::string name;
+			/** @brief Offset of the name, relative to the start of the bound import directory */
+			uint16_t name_offset = 0;
+			/** @brief Further libraries that forwarded entries were resolved through, they do not have forwarder references of their own */
+			std::vector<BoundImportDescriptor> forwarder_references;
+
+			BoundImportDescriptor(std::string name = "", uint32_t timestamp = 0)
+				: timestamp(timestamp), name(name)
+			{
+			}
+		};
+
+		/** @brief The contents of the bound import directory, stored in the headers after the section table */
+		std::vector<BoundImportDescriptor> bound_imports;
+		/** @brief File offset (and relative virtual address) of the bound import directory */
+		uint32_t bound_imports_offset = 0;
+		/** @brief Size of the bound import directory, including the library names */
+		uint32_t bound_imports_size = 0;
+
+		/** @brief Assigns the name offsets in the bound import directory and calculates its size */
+		void CalculateBoundImports();
+		/** @brief Parses the bound import directory, stored in the headers */
+		void ReadBoundImports(Linker::Reader& rd, uint32_t directory_rva, uint32_t directory_size);
+		/** @brief Writes the bound import directory into the headers */
+		void WriteBoundImports(Linker::Writer& wr) const;
+		/** @brief Displays the bound import directory */
+		void DumpBoundImports(Dumper::Dumper& dump, uint32_t directory_rva, uint32_t directory_size) const;
+
 		/** @brief Represents a single exported entry in the file */
 		class ExportedEntry
 		{
@@ -760,7 +807,7 @@ namespace Microsoft
 			uint32_t block_size;
 			/** @brief Sequence of relocations in this block, filled in by the linker once all the relocations have been collected */
 			std::vector<BaseRelocation> relocations_list;
-			/** @brief Collection of relocations, accessed via their page offset */
+			/** @brief Collection of relocations, accessed via their page offset, only filled in when reading an image */
 			std::map<uint16_t, BaseRelocation> relocations_map;
 
 			BaseRelocationBlock(uint32_t page_rva = 0)
@@ -777,6 +824,14 @@ namespace Microsoft
 			std::vector<std::shared_ptr<BaseRelocationBlock>> blocks_list;
 			/** @brief Collection of relocation blocks, accessed via the relative virtual address of the page */
 			std::map<uint32_t, std::shared_ptr<BaseRelocationBlock>> blocks_map;
+			/** @brief A relocation collected by the linker, along with its full relative virtual address */
+			struct collected_relocation
+			{
+				uint32_t rva;
+				BaseRelocation relocation;
+			};
+			/** @brief All relocations collected by the linker, in no particular order, split into blocks by Generate */
+			std::vector<collected_relocation> collected_relocations;
 
 			BaseRelocationsSection()
 				: Section(DATA | DISCARDABLE | READ)
@@ -789,12 +844,20 @@ namespace Microsoft
 			using Section::ImageSize;
 
 			bool IsPresent() const;
+			/**
+			 * @brief Sorts the collected relocations and splits them into blocks
+			 *
+			 * The relocations are radix sorted by their relative virtual address, after which every run belonging to the same page becomes a block.
+			 */
 			void Generate(PEFormat& fmt);
 			void ReadSectionData(Linker::Reader& rd, const PEFormat& fmt) override;
 			void WriteSectionData(Linker::Writer& wr, const PEFormat& fmt) const override;
 			uint32_t ImageSize(const PEFormat& fmt) const override;
 			uint32_t MemorySize(const PEFormat& fmt) const override;
 
+			/** @brief Sorts relocations by their relative virtual address, keeping relocations to the same address in their original order */
+			static void SortRelocations(std::vector<collected_relocation>& relocations);
+
 			/** @brief Parses the contents of the directory, after all the section data for the file is loaded */
 			void ParseDirectoryData(const PEFormat& fmt, uint32_t directory_rva, uint32_t directory_size);
 			/** @brief Displays the directory contents */
@@ -908,6 +971,15 @@ namespace Microsoft
 		/** @brief By default, imported labels address the import address table directly */
 		bool option_import_thunks = false;
 
+		/** @brief Directory to load the imported libraries from and bind the import address tables against, empty if imports are not bound */
+		std::string option_bind_directory;
+
+		/** @brief Calculate the image checksum while writing the file, it is required for drivers and critical libraries */
+		bool option_checksum = false;
+
+		/** @brief Let resources with identical contents share the same data in the resource section */
+		bool option_merge_resources = false;
+
 		/** @brief Holds the segment that contains the import thinks */
 		std::shared_ptr<Linker::Segment> import_thunk_segment = nullptr;
 
@@ -1041,11 +1113,14 @@ namespace Microsoft
 			Linker::Option<offset_t> image_base{"base", "Base address of image, used for calculating relative virtual addresses"};
 			Linker::Option<offset_t> section_align{"section_align", "Section alignment"};
 			Linker::Option<bool> import_thunks{"import_thunks", "Create thunk procedures for imported names"};
+			Linker::Option<std::string> bind{"bind", "Directory containing the imported libraries, binds the import address tables to their preferred addresses"};
+			Linker::Option<bool> checksum{"checksum", "Calculate the image checksum"};
+			Linker::Option<bool> merge_resources{"merge_resources", "Store resources with identical contents only once"};
 			// TODO: make stack size a parameter
 
 			PEOptionCollector()
 			{
-				InitializeFields(stub, target, subsystem, output, compat, image_base, section_align, import_thunks);
+				InitializeFields(stub, target, subsystem, output, compat, image_base, section_align, import_thunks, bind, checksum, merge_resources);
 			}
 		};
 
@@ -1153,6 +1228,13 @@ namespace Microsoft
 		 */
 		offset_t GenerateBaseRelocationSection(Linker::Module& module, offset_t image_end);
 
+		/**
+		 * @brief Resolves the imported entries against the libraries found in the bind directory and fills in the bound import directory
+		 *
+		 * Libraries that cannot be found, or that have entries that cannot be resolved, are left unbound and get resolved at load time as usual.
+		 */
+		void BindImports();
+
 		/**
 		 * @brief Processes relocations present in the module and stores them as base relocations and imports
 		 */
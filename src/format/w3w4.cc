@@ -1,5 +1,14 @@
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include "w3w4.h"
 #include "mzexe.h"
 
@@ -43,14 +52,18 @@ offset_t W3Format::WriteFile(Linker::Writer& wr) const
 	wr.WriteWord(1, system_version.minor);
 	wr.WriteWord(1, system_version.major);
 	wr.WriteWord(2, entries.size());
-	wr.Skip(8);
+	wr.Skip(10);
 	for(auto& entry : entries)
 	{
 		wr.WriteData(8, entry.filename, ' ');
 		wr.WriteWord(4, entry.file_offset);
 		wr.WriteWord(4, entry.header_size);
 	}
-	// TODO: write contents
+	for(auto& entry : entries)
+	{
+		/* the entries are placed at their own file offsets */
+		entry.contents->WriteFile(wr);
+	}
 
 	return offset_t(-1);
 }
@@ -150,143 +163,443 @@ protected:
 	}
 };
 
+/**
+ * @brief Messages issued on a worker thread, passed on to the streams of the calling thread once the worker finishes
+ *
+ * The message streams are thread local, so worker threads would otherwise ignore how the caller configured them.
+ */
+struct WorkerMessages
+{
+	std::ostringstream debug;
+	std::ostringstream warning;
+	std::ostringstream error;
+};
+
+/**
+ * @brief Calls a function for each chunk index, distributing the chunks over a pool of threads
+ *
+ * If any of the calls throws an exception, the remaining chunks are skipped and the exception is passed on to the caller.
+ */
+static void ForEachChunk(size_t chunk_count, unsigned thread_count, const std::function<void(size_t)>& function)
+{
+	std::atomic<size_t> next_chunk = 0;
+	std::exception_ptr exception = nullptr;
+	std::mutex exception_mutex;
+
+	auto worker = [&](WorkerMessages * messages)
+	{
+		if(messages != nullptr)
+		{
+			Linker::Debug.rdbuf(messages->debug.rdbuf());
+			Linker::Warning.rdbuf(messages->warning.rdbuf());
+			Linker::Error.rdbuf(messages->error.rdbuf());
+		}
+		size_t chunk_index;
+		while((chunk_index = next_chunk++) < chunk_count)
+		{
+			try
+			{
+				function(chunk_index);
+			}
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(exception_mutex);
+				if(exception == nullptr)
+					exception = std::current_exception();
+				next_chunk = chunk_count;
+			}
+		}
+	};
+
+	if(thread_count == 0)
+		thread_count = std::thread::hardware_concurrency();
+	thread_count = std::max(1u, unsigned(std::min(size_t(thread_count), chunk_count)));
+
+	std::vector<WorkerMessages> messages(thread_count - 1);
+	std::vector<std::thread> threads;
+	for(unsigned i = 1; i < thread_count; i++)
+	{
+		threads.emplace_back(worker, &messages[i - 1]);
+	}
+	worker(nullptr);
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for(auto& thread_messages : messages)
+	{
+		Linker::Debug << thread_messages.debug.str();
+		Linker::Warning << thread_messages.warning.str();
+		Linker::Error << thread_messages.error.str();
+	}
+
+	if(exception != nullptr)
+		std::rethrow_exception(exception);
+}
+
+/**
+ * @brief Reads the W4 bitstream, least significant bits first, through a 64-bit bit buffer
+ *
+ * Reading past the end of the input produces 0 bits.
+ */
 class BitStream
 {
 protected:
-	std::shared_ptr<Linker::Image> contents;
-	offset_t contents_offset = 0;
-	uint8_t byte = 0;
+	const uint8_t * contents;
+	size_t contents_size;
+	size_t contents_offset = 0;
+	uint64_t bits = 0;
 	unsigned bit_count = 0;
+	/** @brief Number of bits consumed so far */
+	size_t bits_read = 0;
 
-	void NextByte()
+	void Refill()
+	{
+		if(contents_offset + 8 <= contents_size)
+		{
+			uint64_t word = 0;
+			for(unsigned i = 0; i < 8; i++)
+				word |= uint64_t(contents[contents_offset + i]) << (8 * i);
+			/* the bits shifted out are loaded again on the next refill */
+			bits |= word << bit_count;
+			unsigned byte_count = (63 - bit_count) >> 3;
+			contents_offset += byte_count;
+			bit_count += byte_count << 3;
+		}
+		else
+		{
+			while(bit_count <= 56)
+			{
+				if(contents_offset < contents_size)
+					bits |= uint64_t(contents[contents_offset]) << bit_count;
+				contents_offset++;
+				bit_count += 8;
+			}
+		}
+	}
+
+public:
+	BitStream(const uint8_t * contents, size_t contents_size)
+		: contents(contents), contents_size(contents_size)
 	{
-		if(contents_offset >= contents->ImageSize())
-			return;
-		byte = contents->GetByte(contents_offset);
-		bit_count = 8;
-		contents_offset++;
 	}
 
-	unsigned ReadSomeBits(unsigned count, uint8_t& read_bits)
+	uint32_t ReadBits(unsigned count)
+	{
+		if(bit_count < count)
+			Refill();
+		uint32_t value = bits & ((uint64_t(1) << count) - 1);
+		bits >>= count;
+		bit_count -= count;
+		bits_read += count;
+		return value;
+	}
+
+	bool IsOver() const
+	{
+		return bits_read >= contents_size * 8;
+	}
+};
+
+void W4Format::DecompressChunk(const uint8_t * input, size_t input_size, uint8_t * output, size_t output_size)
+{
+	BitStream bitstream(input, input_size);
+	/* bytes decoded past the end of the chunk are discarded, but they are still counted */
+	size_t position = 0;
+	while(!bitstream.IsOver())
 	{
-		if(bit_count == 0)
+		size_t depth = 0;
+		switch(bitstream.ReadBits(2))
 		{
-			NextByte();
-			if(bit_count == 0)
-				return 0;
+		case 0b00:
+			depth = bitstream.ReadBits(6);
+			if(depth == 0)
+				return;
+			break;
+		case 0b01:
+			if(position < output_size)
+				output[position] = bitstream.ReadBits(7) | 0x80;
+			else
+				bitstream.ReadBits(7);
+			position++;
+			continue;
+		case 0b10:
+			if(position < output_size)
+				output[position] = bitstream.ReadBits(7);
+			else
+				bitstream.ReadBits(7);
+			position++;
+			continue;
+		case 0b11:
+			if(bitstream.ReadBits(1) == 0)
+			{
+				depth = 64 + bitstream.ReadBits(8);
+			}
+			else
+			{
+				depth = 320 + bitstream.ReadBits(12);
+				if(depth == 4415)
+					continue;
+			}
+			break;
 		}
-		if(count > bit_count)
-			count = bit_count;
 
-		read_bits = byte & ((1 << count) - 1);
-		byte >>= count;
-		bit_count -= count;
-		return count;
+		size_t count_bits = 0;
+		while(bitstream.ReadBits(1) == 0)
+		{
+			count_bits ++;
+			if(count_bits == 9)
+			{
+				Linker::FatalError("Fatal error: illegal encoding in W4 compression");
+			}
+		}
+		size_t count = bitstream.ReadBits(count_bits) + (1 << count_bits) + 1;
+
+		if(depth > position)
+		{
+			Linker::FatalError("Fatal error: illegal encoding in W4 compression");
+		}
+
+		if(position < output_size)
+		{
+			size_t copy_count = std::min(count, output_size - position);
+			if(depth >= copy_count)
+			{
+				memcpy(output + position, output + position - depth, copy_count);
+			}
+			else
+			{
+				/* overlapping copy, repeats the last depth bytes */
+				for(size_t i = 0; i < copy_count; i++)
+					output[position + i] = output[position + i - depth];
+			}
+		}
+		position += count;
 	}
+}
+
+std::shared_ptr<Linker::Buffer> W4Format::DecompressW4(unsigned thread_count) const
+{
+	std::vector<uint8_t> image(size_t(chunk_size) * chunks.size(), 0);
+
+	ForEachChunk(chunks.size(), thread_count, [&](size_t chunk_index)
+	{
+		const Chunk& chunk = chunks[chunk_index];
+		std::vector<uint8_t> input(chunk.contents->ImageSize());
+		chunk.contents->ReadData(input.size(), 0, input.data());
+		DecompressChunk(input.data(), input.size(), image.data() + size_t(chunk_size) * chunk_index, chunk_size);
+	});
+
+	return std::make_shared<Linker::Buffer>(std::move(image));
+}
+
+/**
+ * @brief Collects bits into bytes, least significant bits first
+ */
+class BitWriter
+{
+protected:
+	std::vector<uint8_t>& bytes;
+	uint64_t bits = 0;
+	unsigned bit_count = 0;
 
 public:
-	BitStream(std::shared_ptr<Linker::Image> contents)
-		: contents(contents)
+	BitWriter(std::vector<uint8_t>& bytes)
+		: bytes(bytes)
 	{
 	}
 
-	uint32_t ReadBits(unsigned count)
+	void WriteBits(unsigned count, uint32_t value)
 	{
-		uint32_t value = 0;
-		uint32_t shift = 0;
-		while(count > 0)
+		bits |= uint64_t(value) << bit_count;
+		bit_count += count;
+		while(bit_count >= 8)
 		{
-			uint8_t bit_sequence = 0;
- 			unsigned read_bit_count = ReadSomeBits(count, bit_sequence);
-			if(read_bit_count == 0)
-				return value;
-			value |= uint32_t(bit_sequence) << shift;
-			shift += read_bit_count;
-			count -= read_bit_count;
+			bytes.push_back(bits);
+			bits >>= 8;
+			bit_count -= 8;
 		}
-		return value;
 	}
 
-	bool IsOver() const
+	void Flush()
 	{
-		return contents_offset >= contents->ImageSize() && bit_count == 0;
+		if(bit_count > 0)
+		{
+			bytes.push_back(bits);
+			bits = 0;
+			bit_count = 0;
+		}
 	}
 };
 
-std::shared_ptr<Linker::Buffer> W4Format::DecompressW4()
+/**
+ * @brief Finds the longest earlier occurrence of the bytes at a position, positions are chained by their first two bytes
+ */
+class MatchFinder
 {
-	std::shared_ptr<Linker::Buffer> buffer = std::make_shared<Linker::Buffer>();
-	uint32_t chunk_index = 0;
-	for(auto& chunk : chunks)
+protected:
+	const uint8_t * input;
+	size_t input_size;
+	std::vector<int32_t> head;
+	std::vector<int32_t> previous;
+	/** @brief All positions before this one have been inserted */
+	size_t inserted = 0;
+
+	static uint16_t Key(const uint8_t * bytes)
+	{
+		return bytes[0] | (bytes[1] << 8);
+	}
+
+public:
+	MatchFinder(const uint8_t * input, size_t input_size)
+		: input(input), input_size(input_size), head(0x10000, -1), previous(input_size, -1)
+	{
+	}
+
+	/**
+	 * @brief Makes all positions up to (but not including) position available as match sources
+	 */
+	void InsertUntil(size_t position)
+	{
+		for(; inserted < position && inserted + 1 < input_size; inserted++)
+		{
+			uint16_t key = Key(input + inserted);
+			previous[inserted] = head[key];
+			head[key] = inserted;
+		}
+	}
+
+	/**
+	 * @brief Searches for the longest match, preferring the nearest one among matches of equal length
+	 *
+	 * @return The length of the match, or 0 if none of at least 2 bytes is found
+	 */
+	size_t FindMatch(size_t position, size_t& depth)
 	{
-		std::vector<uint8_t> bytes;
-		BitStream bitstream(chunk.contents);
-		bool chunk_over = false;
-		while(!chunk_over && !bitstream.IsOver())
+		if(position + 1 >= input_size)
+			return 0;
+		InsertUntil(position);
+		size_t maximum_length = std::min(input_size - position, W4Format::MaximumMatchLength);
+		size_t best_length = 0;
+		size_t chain_length = 0;
+		for(int32_t candidate = head[Key(input + position)];
+			candidate >= 0 && position - candidate <= W4Format::MaximumMatchDepth && chain_length < W4Format::MaximumChainLength;
+			candidate = previous[candidate], chain_length++)
 		{
-			size_t depth = 0;
-			size_t count = 0;
-			switch(bitstream.ReadBits(2))
+			if(best_length > 0 && input[candidate + best_length] != input[position + best_length])
+				continue;
+			size_t length = 2;
+			while(length < maximum_length && input[candidate + length] == input[position + length])
+				length++;
+			if(length > best_length)
 			{
-			case 0b00:
-				//Linker::Debug << "Debug: 0b00" << std::endl;
-				depth = bitstream.ReadBits(6);
-				if(depth == 0)
-				{
-					chunk_over = true;
-				}
-				break;
-			case 0b01:
-				//Linker::Debug << "Debug: 0b01" << std::endl;
-				bytes.push_back(bitstream.ReadBits(7) | 0x80);
-				//Linker::Debug << std::hex << int(bytes[bytes.size() - 1]) << std::endl;
-				break;
-			case 0b10:
-				//Linker::Debug << "Debug: 0b10" << std::endl;
-				bytes.push_back(bitstream.ReadBits(7));
-				//Linker::Debug << std::hex << int(bytes[bytes.size() - 1]) << std::endl;
-				break;
-			case 0b11:
-				//Linker::Debug << "Debug: 0b11" << std::endl;
-				switch(bitstream.ReadBits(1))
-				{
-				case 0b0:
-					depth = 64 + bitstream.ReadBits(8);
-					break;
-				case 0b1:
-					depth = 320 + bitstream.ReadBits(12);
-					if(depth == 4415)
-						continue;
+				best_length = length;
+				depth = position - candidate;
+				if(length == maximum_length)
 					break;
-				}
-				break;
-			}
-			if(depth != 0)
-			{
-				size_t count_bits = 0;
-				while(bitstream.ReadBits(1) == 0)
-				{
-					count_bits ++;
-					if(count_bits == 9)
-					{
-						Linker::FatalError("Fatal error: illegal encoding in W4 compression");
-					}
-				}
-				count = bitstream.ReadBits(count_bits) + (1 << count_bits) + 1;
-
-				//Linker::Debug << "Debug: repeat " << std::dec << depth << " bytes for " << count << " bytes" << std::endl;
-				for(size_t char_index = 0; char_index < count; char_index++)
-				{
-					bytes.push_back(bytes[bytes.size() - depth]);
-					//Linker::Debug << std::hex << int(bytes[bytes.size() - 1]) << std::endl;
-				}
 			}
 		}
-		buffer->Append(bytes);
-		buffer->Resize(chunk_size * (chunk_index + 1));
-		chunk_index ++;
+		return best_length;
+	}
+};
+
+static void WriteLiteral(BitWriter& writer, uint8_t byte)
+{
+	writer.WriteBits(2, byte & 0x80 ? 0b01 : 0b10);
+	writer.WriteBits(7, byte & 0x7F);
+}
+
+static void WriteMatch(BitWriter& writer, size_t depth, size_t length)
+{
+	if(depth < 64)
+	{
+		writer.WriteBits(2, 0b00);
+		writer.WriteBits(6, depth);
 	}
-	return buffer;
+	else if(depth < 320)
+	{
+		writer.WriteBits(2, 0b11);
+		writer.WriteBits(1, 0);
+		writer.WriteBits(8, depth - 64);
+	}
+	else
+	{
+		writer.WriteBits(2, 0b11);
+		writer.WriteBits(1, 1);
+		writer.WriteBits(12, depth - 320);
+	}
+
+	/* the count is stored as a unary bit count, followed by the bits below the highest set bit of length - 1 */
+	size_t value = length - 1;
+	unsigned count_bits = 0;
+	while((value >> (count_bits + 1)) != 0)
+		count_bits++;
+	writer.WriteBits(count_bits, 0);
+	writer.WriteBits(1, 1);
+	writer.WriteBits(count_bits, value - (size_t(1) << count_bits));
+}
+
+std::vector<uint8_t> W4Format::CompressChunk(const uint8_t * input, size_t input_size)
+{
+	std::vector<uint8_t> output;
+	BitWriter writer(output);
+	MatchFinder finder(input, input_size);
+
+	size_t position = 0;
+	size_t depth = 0;
+	size_t length = finder.FindMatch(position, depth);
+	while(position < input_size)
+	{
+		if(length < 2)
+		{
+			WriteLiteral(writer, input[position]);
+			position++;
+			length = finder.FindMatch(position, depth);
+			continue;
+		}
+
+		/* lazy evaluation: a literal followed by a longer match is usually cheaper */
+		size_t next_depth = 0;
+		size_t next_length = length < MaximumMatchLength ? finder.FindMatch(position + 1, next_depth) : 0;
+		if(next_length > length + 1)
+		{
+			WriteLiteral(writer, input[position]);
+			position++;
+			length = next_length;
+			depth = next_depth;
+			continue;
+		}
+
+		WriteMatch(writer, depth, length);
+		position += length;
+		length = finder.FindMatch(position, depth);
+	}
+
+	/* end of chunk */
+	writer.WriteBits(2, 0b00);
+	writer.WriteBits(6, 0);
+	writer.Flush();
+	return output;
+}
+
+void W4Format::CompressW4(const std::vector<uint8_t>& image, unsigned thread_count)
+{
+	size_t chunk_count = (image.size() + chunk_size - 1) / chunk_size;
+	if(chunk_count > 0xFFFF)
+	{
+		Linker::FatalError("Fatal error: image too large for W4 format");
+	}
+
+	chunks.clear();
+	chunks.resize(chunk_count);
+	ForEachChunk(chunk_count, thread_count, [&](size_t chunk_index)
+	{
+		size_t chunk_offset = size_t(chunk_size) * chunk_index;
+		std::vector<uint8_t> compressed = CompressChunk(image.data() + chunk_offset, std::min(size_t(chunk_size), image.size() - chunk_offset));
+		chunks[chunk_index].length = compressed.size();
+		chunks[chunk_index].contents = std::make_shared<Linker::Buffer>(std::move(compressed));
+	});
 }
 
 void W4Format::ReadFile(Linker::Reader& rd)
@@ -335,6 +648,8 @@ void W4Format::ReadFile(Linker::Reader& rd)
 offset_t W4Format::WriteFile(Linker::Writer& wr) const
 {
 	wr.endiantype = ::LittleEndian;
+	if(device_driver != nullptr)
+		stub.WriteStubImage(wr);
 	wr.Seek(file_offset);
 	wr.WriteData("W4");
 	wr.WriteWord(1, system_version.minor);
@@ -347,7 +662,11 @@ offset_t W4Format::WriteFile(Linker::Writer& wr) const
 	{
 		wr.WriteWord(4, chunk.file_offset);
 	}
-	// TODO: write contents
+	for(auto& chunk : chunks)
+	{
+		wr.Seek(chunk.file_offset);
+		chunk.contents->WriteFile(wr);
+	}
 
 	return offset_t(-1);
 }
@@ -376,3 +695,154 @@ void W4Format::Dump(Dumper::Dumper& dump) const
 	w3format.Dump(dump);
 }
 
+std::vector<Linker::OptionDescription<void>> W4Format::GetMemoryModelNames()
+{
+	return device_driver->GetMemoryModelNames();
+}
+
+std::vector<Linker::OptionDescription<void> *> W4Format::GetLinkerScriptParameterNames()
+{
+	return device_driver->GetLinkerScriptParameterNames();
+}
+
+std::shared_ptr<Linker::OptionCollector> W4Format::GetOptions()
+{
+	return device_driver->GetOptions();
+}
+
+void W4Format::SetOptions(std::map<std::string, std::string>& options)
+{
+	device_driver->SetOptions(options);
+	/* the stub belongs to the container */
+	stub.filename = device_driver->stub.filename;
+	device_driver->embedded = true;
+}
+
+void W4Format::SetModel(std::string model)
+{
+	device_driver->SetModel(model);
+}
+
+void W4Format::SetLinkScript(std::string script_file, std::map<std::string, std::string>& options)
+{
+	device_driver->SetLinkScript(script_file, options);
+}
+
+bool W4Format::FormatSupportsSegmentation() const
+{
+	return device_driver->FormatSupportsSegmentation();
+}
+
+bool W4Format::FormatIs16bit() const
+{
+	return device_driver->FormatIs16bit();
+}
+
+bool W4Format::FormatIsProtectedMode() const
+{
+	return device_driver->FormatIsProtectedMode();
+}
+
+bool W4Format::FormatIsLinear() const
+{
+	return device_driver->FormatIsLinear();
+}
+
+bool W4Format::FormatSupportsResources() const
+{
+	return device_driver->FormatSupportsResources();
+}
+
+bool W4Format::FormatSupportsLibraries() const
+{
+	return device_driver->FormatSupportsLibraries();
+}
+
+unsigned W4Format::FormatAdditionalSectionFlags(std::string section_name) const
+{
+	return device_driver->FormatAdditionalSectionFlags(section_name);
+}
+
+void W4Format::ProcessModule(Linker::Module& module)
+{
+	device_driver->ProcessModule(module);
+}
+
+void W4Format::CalculateValues()
+{
+	file_offset = stub.GetStubImageSize();
+
+	/* the W3 container occupies the decompressed image, which is placed at the same offset as the W4 header */
+	w3format.file_offset = file_offset;
+	w3format.system_version.major = system_version.major;
+	w3format.system_version.minor = system_version.minor;
+	w3format.entries.clear();
+
+	W3Format::Entry entry;
+	entry.filename = device_driver->module_name;
+	size_t separator = entry.filename.find_last_of("/\\:");
+	if(separator != std::string::npos)
+		entry.filename = entry.filename.substr(separator + 1);
+	if(entry.filename.size() > 8)
+		entry.filename = entry.filename.substr(0, 8);
+	for(auto& c : entry.filename)
+		c = std::toupper(c);
+	entry.file_offset = ::AlignTo(file_offset + 16 + 16, 16);
+	entry.contents = device_driver;
+	w3format.entries.push_back(entry);
+
+	device_driver->embedded = true;
+	device_driver->file_offset = entry.file_offset;
+	device_driver->CalculateValues();
+	/* the headers and the loader and fixup sections precede the pages */
+	w3format.entries[0].header_size = device_driver->data_pages_offset - device_driver->file_offset;
+	w3format.file_end = device_driver->file_size;
+
+	std::ostringstream w3_stream;
+	Linker::Writer w3_writer(::LittleEndian, &w3_stream);
+	w3format.WriteFile(w3_writer);
+	std::string w3_image = w3_stream.str();
+	std::vector<uint8_t> image(w3_image.begin() + std::min(size_t(file_offset), w3_image.size()), w3_image.end());
+
+	CompressW4(image);
+
+	/* lay out the compressed chunks after the header and chunk table */
+	offset_t offset = file_offset + 16 + 4 * chunks.size();
+	for(auto& chunk : chunks)
+	{
+		chunk.file_offset = offset;
+		offset += chunk.length;
+	}
+	file_end = offset;
+
+	/* verify that the decompressor reproduces the image */
+	std::shared_ptr<Linker::Buffer> decompressed = DecompressW4();
+	std::vector<uint8_t> decompressed_bytes(decompressed->ImageSize());
+	decompressed->ReadData(decompressed_bytes.size(), 0, decompressed_bytes.data());
+	image.resize(decompressed_bytes.size(), 0);
+	if(image != decompressed_bytes)
+	{
+		Linker::FatalError("Internal error: W4 compressed image does not decompress to the original");
+	}
+}
+
+void W4Format::GenerateFile(std::string filename, Linker::Module& module)
+{
+	device_driver->program_name = filename;
+	size_t ix = filename.rfind('.');
+	if(ix != std::string::npos)
+		device_driver->module_name = filename.substr(0, ix);
+	else
+		device_driver->module_name = filename;
+	if(module.cpu != Linker::Module::I386)
+	{
+		Linker::FatalError("Fatal error: Format only supports Intel 80386 binaries");
+	}
+
+	Linker::OutputFormat::GenerateFile(filename, module);
+}
+
+std::string W4Format::GetDefaultExtension(Linker::Module& module, std::string filename) const
+{
+	return filename + ".vxd";
+}
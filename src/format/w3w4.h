@@ -3,18 +3,19 @@
 
 #include <array>
 #include "leexe.h"
+#include "mzexe.h"
 #include "../common.h"
 #include "../dumper/dumper.h"
 #include "../linker/reader.h"
 #include "../linker/segment_manager.h"
 #include "../linker/writer.h"
 
-/* TODO: unimplemented */
-
 namespace Microsoft
 {
 	/**
-	 * @brief WIN386.EXE (TODO: not implemented)
+	 * @brief WIN386.EXE
+	 *
+	 * Only the reading and dumping of entire files and the writing of files prepared by W4Format are supported.
 	 */
 	class W3Format : public virtual Linker::OutputFormat
 	{
@@ -50,11 +51,23 @@ namespace Microsoft
 	};
 
 	/**
-	 * @brief WMM32.VXD (TODO: not implemented)
+	 * @brief WMM32.VXD
+	 *
+	 * As an output format, a single virtual device driver is generated into a W3 container, which is then compressed.
 	 */
 	class W4Format : public virtual Linker::OutputFormat
 	{
 	public:
+		W4Format() = default;
+
+		/**
+		 * @brief Creates a container for a single virtual device driver
+		 */
+		W4Format(std::shared_ptr<LEFormat> device_driver)
+			: device_driver(device_driver)
+		{
+		}
+
 		// as documented in https://github.com/JHRobotics/patcher9x/blob/main/doc/VXDLIB_UTF8.txt
 
 		class Chunk
@@ -70,24 +83,81 @@ namespace Microsoft
 		{
 			uint8_t major, minor;
 		};
-		version system_version;
-		uint16_t chunk_size;
+		version system_version = { 4, 0 };
+		uint16_t chunk_size = 0x2000;
 		std::vector<Chunk> chunks;
 		uint32_t file_end;
 		W3Format w3format;
 
-		std::shared_ptr<Linker::Buffer> DecompressW4();
+		/**
+		 * @brief Decompresses a single chunk
+		 *
+		 * @param input The compressed bitstream of the chunk
+		 * @param input_size Size of the compressed data
+		 * @param output The decompressed bytes, any data past output_size is discarded
+		 * @param output_size Size of a decompressed chunk, normally chunk_size
+		 */
+		static void DecompressChunk(const uint8_t * input, size_t input_size, uint8_t * output, size_t output_size);
+		/**
+		 * @brief Decompresses all the chunks into a single image, each chunk occupying chunk_size bytes
+		 *
+		 * @param thread_count Number of chunks decompressed in parallel, 0 for the number of processors
+		 */
+		std::shared_ptr<Linker::Buffer> DecompressW4(unsigned thread_count = 0) const;
+
+		/** @brief The longest back reference that can be encoded */
+		static constexpr size_t MaximumMatchDepth = 4414;
+		/** @brief The longest repeat count that can be encoded */
+		static constexpr size_t MaximumMatchLength = 512;
+		/** @brief Number of earlier positions with the same leading bytes examined when searching for a match */
+		static constexpr size_t MaximumChainLength = 256;
+
+		/**
+		 * @brief Compresses a single chunk, using a hash chain to find back references
+		 *
+		 * @param input The bytes of the chunk, at most chunk_size
+		 * @param input_size Number of bytes in the chunk
+		 * @return The compressed bitstream, terminated by an end of chunk marker
+		 */
+		static std::vector<uint8_t> CompressChunk(const uint8_t * input, size_t input_size);
+		/**
+		 * @brief Splits an image into chunks of chunk_size bytes and compresses them
+		 *
+		 * @param image The uncompressed image, starting with the W3 header
+		 * @param thread_count Number of chunks compressed in parallel, 0 for the number of processors
+		 */
+		void CompressW4(const std::vector<uint8_t>& image, unsigned thread_count = 0);
 
 //		void Clear() override;
-//		void CalculateValues() override;
 		void ReadFile(Linker::Reader& rd) override;
 		using Linker::Format::WriteFile;
 		offset_t WriteFile(Linker::Writer& wr) const override;
 		void Dump(Dumper::Dumper& dump) const override;
-		/* TODO */
 
-//		using Linker::OutputFormat::GetDefaultExtension;
-//		std::string GetDefaultExtension(Linker::Module& module, std::string filename) override;
+		/* * * Writer members * * */
+
+		/** @brief The device driver stored in the container, only used for writing */
+		std::shared_ptr<LEFormat> device_driver;
+		mutable MZStubWriter stub;
+
+		std::vector<Linker::OptionDescription<void>> GetMemoryModelNames() override;
+		std::vector<Linker::OptionDescription<void> *> GetLinkerScriptParameterNames() override;
+		std::shared_ptr<Linker::OptionCollector> GetOptions() override;
+		void SetOptions(std::map<std::string, std::string>& options) override;
+		void SetModel(std::string model) override;
+		void SetLinkScript(std::string script_file, std::map<std::string, std::string>& options) override;
+		bool FormatSupportsSegmentation() const override;
+		bool FormatIs16bit() const override;
+		bool FormatIsProtectedMode() const override;
+		bool FormatIsLinear() const override;
+		bool FormatSupportsResources() const override;
+		bool FormatSupportsLibraries() const override;
+		unsigned FormatAdditionalSectionFlags(std::string section_name) const override;
+		void ProcessModule(Linker::Module& module) override;
+		void CalculateValues() override;
+		void GenerateFile(std::string filename, Linker::Module& module) override;
+		using Linker::OutputFormat::GetDefaultExtension;
+		std::string GetDefaultExtension(Linker::Module& module, std::string filename) const override;
 	};
 }
 
@@ -1,4 +1,7 @@
 
+#include <algorithm>
+#include <array>
+#include <map>
 #include "formats.h"
 #include "format/8bitexe.h" /* 8-bit binary formats */ /* TODO: not yet finished or tested */
 #include "format/aif.h" /* AIF format */ /* TODO: not implemented */
@@ -204,10 +207,10 @@ format_specification formats[] =
 	{ "68k_noncont" },
 	{ "601b" },
 	{ "cdos68k",
-		[]() -> std::shared_ptr<Format> { return std::make_shared<CPM68KFormat>(CPM68KFormat::SYSTEM_HUMAN68K); },
+		[]() -> std::shared_ptr<Format> { return std::make_shared<CPM68KFormat>(CPM68KFormat::SYSTEM_CDOS68K, CPM68KFormat::MAGIC_CONTIGUOUS); },
 		"Concurrent DOS 68K contiguous executable (.68k) [untested]" },
 	{ "cdos68k_c",
-		[]() -> std::shared_ptr<Format> { return std::make_shared<CPM68KFormat>(CPM68KFormat::SYSTEM_CDOS68K, CPM68KFormat::MAGIC_CONTIGUOUS); },
+		[]() -> std::shared_ptr<Format> { return std::make_shared<CPM68KFormat>(CPM68KFormat::SYSTEM_CDOS68K, CPM68KFormat::MAGIC_CRUNCHED); },
 		"Concurrent DOS 68K contiguous executable with crunched relocations (.68k) [untested]" },
 	{ "cdos68k_crunched" },
 	{ "cdos68kc" },
@@ -409,6 +412,10 @@ format_specification formats[] =
 	{ "win_vxd" },
 	{ "vxd" },
 	{ "le" },
+	{ "vmm32",
+		[]() -> std::shared_ptr<Format> { return std::make_shared<W4Format>(LEFormat::CreateDeviceDriver(LEFormat::Windows386)->SimulateLinker(LEFormat::CompatibleWatcom)); },
+		"Windows 95 \"W4\" compressed container for a virtual device driver (VMM32.VXD)" },
+	{ "w4" },
 	{ "os2v2",
 		[]() -> std::shared_ptr<Format> { return LEFormat::CreateConsoleApplication(LEFormat::OS2)->SimulateLinker(LEFormat::CompatibleWatcom); },
 		"32-bit OS/2 \"LX\" console executable (.exe), Watcom compatible" },
@@ -1069,7 +1076,126 @@ static const struct format_magic library_format_magics[] =
 	{ std::string("\x01\x1F"),            2, FORMAT_AOUT,    "Big endian a.out, System V overlay, separate code/data" },
 };
 
-void DetermineFormatFor(const format_magic * format_magics, size_t format_magics_count, std::vector<format_description>& descriptions, Reader& rd, uint32_t offset)
+/**
+ * @brief Dispatch structure compiled from a table of magic signatures
+ *
+ * For every offset where a signature may appear, the entries are stored in a trie, with the first byte looked up in a 256 entry table.
+ * Matching a file only follows the bytes of the file, and the matching entries are returned in the same order as they appear in the table.
+ */
+class MagicIndex
+{
+public:
+	const format_magic * format_magics;
+
+	MagicIndex(const format_magic * format_magics, size_t format_magics_count)
+		: format_magics(format_magics)
+	{
+		for(size_t i = 0; i < format_magics_count; i++)
+		{
+			Insert(i);
+		}
+	}
+
+	/**
+	 * @brief Collects the indices of all entries that match the bytes read from the file, in table order
+	 */
+	void Match(const char * bytes, size_t bytes_read, std::vector<size_t>& matches) const
+	{
+		for(auto& root : roots)
+		{
+			if(bytes_read <= root.offset)
+				continue;
+			matches.insert(matches.end(), root.empty_magics.begin(), root.empty_magics.end());
+			size_t node_index = root.first_byte[uint8_t(bytes[root.offset])];
+			for(size_t position = root.offset + 1; node_index != NoNode; position++)
+			{
+				const Node& node = nodes[node_index];
+				matches.insert(matches.end(), node.entries.begin(), node.entries.end());
+				if(position >= bytes_read)
+					break;
+				auto it = node.children.find(uint8_t(bytes[position]));
+				node_index = it != node.children.end() ? it->second : NoNode;
+			}
+		}
+		/* shorter signatures and other offsets are collected first, restore table order */
+		std::sort(matches.begin(), matches.end());
+	}
+
+private:
+	static constexpr size_t NoNode = size_t(-1);
+
+	struct Node
+	{
+		/** @brief Entries whose signature ends at this node */
+		std::vector<size_t> entries;
+		std::map<uint8_t, size_t> children;
+	};
+
+	struct Root
+	{
+		unsigned offset;
+		/** @brief Entries without a signature, matching any file long enough */
+		std::vector<size_t> empty_magics;
+		std::array<size_t, 256> first_byte;
+	};
+
+	std::vector<Root> roots;
+	std::vector<Node> nodes;
+
+	void Insert(size_t entry)
+	{
+		const format_magic& format_magic = format_magics[entry];
+		Root * root = nullptr;
+		for(auto& current : roots)
+		{
+			if(current.offset == format_magic.offset)
+			{
+				root = &current;
+				break;
+			}
+		}
+		if(root == nullptr)
+		{
+			roots.emplace_back();
+			root = &roots.back();
+			root->offset = format_magic.offset;
+			root->first_byte.fill(NoNode);
+		}
+
+		if(format_magic.magic.size() == 0)
+		{
+			root->empty_magics.push_back(entry);
+			return;
+		}
+
+		size_t& first_node = root->first_byte[uint8_t(format_magic.magic[0])];
+		if(first_node == NoNode)
+		{
+			first_node = nodes.size();
+			nodes.emplace_back();
+		}
+		size_t node_index = first_node;
+		for(size_t position = 1; position < format_magic.magic.size(); position++)
+		{
+			uint8_t byte = format_magic.magic[position];
+			auto it = nodes[node_index].children.find(byte);
+			if(it == nodes[node_index].children.end())
+			{
+				size_t new_node = nodes.size();
+				nodes.emplace_back();
+				nodes[node_index].children[byte] = new_node;
+				node_index = new_node;
+			}
+			else
+			{
+				node_index = it->second;
+			}
+		}
+		nodes[node_index].entries.push_back(entry);
+	}
+};
+
+static void DetermineFormatFor(const MagicIndex& index, std::vector<format_description>& descriptions, Reader& rd, uint32_t offset)
 {
 	rd.Seek(offset);
 	char magic[8];
@@ -1080,32 +1206,16 @@ void DetermineFormatFor(const format_magic * format_magics, size_t format_magics
 	uint32_t bytes_read = position > offset ? position - offset : 0;
 	if(bytes_read == 0)
 		return;
-	for(size_t i = 0; i < format_magics_count; i++)
+	std::vector<size_t> matches;
+	index.Match(magic, bytes_read, matches);
+	for(size_t i : matches)
 	{
-		if(bytes_read < format_magics[i].offset + format_magics[i].magic.size())
-			continue;
-#if 0
-Linker::Debug << "\"";
-for(unsigned j = 0; j < format_magics[i].magic.size(); j++)
-{
-	int c = magic[format_magics[i].offset + j];
-	if(' ' <= c && c <= '~')
-		Linker::Debug << char(c);
-	else
-		Linker::Debug << "\\x" << std::hex << std::setfill('0') << std::setw(2) << int(c);
-}
-Linker::Debug << "\"" << std::endl;
-#endif
-		if(std::string(magic + format_magics[i].offset, format_magics[i].magic.size()) == format_magics[i].magic)
+		format_description description;
+		description.magic = index.format_magics[i];
+		description.offset = offset;
+		if(index.format_magics[i].special_parse == nullptr || index.format_magics[i].special_parse(rd, description))
 		{
-//Linker::Debug << format_magics[i].description << std::endl;
-			format_description description;
-			description.magic = format_magics[i];
-			description.offset = offset;
-			if(format_magics[i].special_parse == nullptr || format_magics[i].special_parse(rd, description))
-			{
-				descriptions.push_back(description);
-			}
+			descriptions.push_back(description);
 		}
 	}
 	if(offset == 0)
@@ -1166,7 +1276,8 @@ Linker::Debug << "\"" << std::endl;
 
 void DetermineFormat(std::vector<format_description>& descriptions, Reader& rd, uint32_t offset)
 {
-	DetermineFormatFor(format_magics, sizeof(format_magics) / sizeof(format_magics[0]), descriptions, rd, offset);
+	static const MagicIndex index(format_magics, sizeof(format_magics) / sizeof(format_magics[0]));
+	DetermineFormatFor(index, descriptions, rd, offset);
 }
 
 std::shared_ptr<Format> CreateFormat(Reader& rd, format_description& file_format, Archive::ArchiveFormat::file_reader_type * file_reader)
@@ -1303,7 +1414,8 @@ std::shared_ptr<Linker::Contents> ReadLibraryFile(Linker::Reader& rd, offset_t s
 {
 	std::vector<format_description> descriptions;
 	offset_t offset = rd.Tell();
-	DetermineFormatFor(library_format_magics, sizeof library_format_magics / sizeof library_format_magics[0], descriptions, rd, offset);
+	static const MagicIndex index(library_format_magics, sizeof library_format_magics / sizeof library_format_magics[0]);
+	DetermineFormatFor(index, descriptions, rd, offset);
 	rd.Seek(offset);
 	if(descriptions.size() == 0)
 	{
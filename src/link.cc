@@ -1,6 +1,8 @@
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -13,7 +15,11 @@
 #include "common.h"
 #include "formats.h"
 #include "linker/format.h"
+#include "linker/incremental_layout.h"
+#include "linker/link_server.h"
+#include "linker/memory_usage.h"
 #include "linker/module.h"
+#include "linker/module_cache.h"
 #include "linker/module_collector.h"
 #include "linker/options.h"
 #include "linker/reader.h"
@@ -65,6 +71,13 @@ void usage(char * argv0)
 	std::cerr << "\t-$=<char>, -$ <char>" << std::endl << "\t\tSet special character (default: '$')" << std::endl;
 	std::cerr << "\t--display-debug-messages" << std::endl << "\t\tPrint information only relevant for linker development" << std::endl;
 	std::cerr << "\t--suppress-warnings" << std::endl << "\t\tSuppress printing warnings" << std::endl;
+	std::cerr << "\t--module-cache=<directory>" << std::endl << "\t\tStore parsed input files in a directory, and load unchanged ones from there" << std::endl;
+	std::cerr << "\t--module-cache-size=<bytes>" << std::endl << "\t\tLimit for the total size of the module cache (default: 64 MiB)" << std::endl;
+	std::cerr << "\t--server=<socket>" << std::endl << "\t\tKeep running and accept link jobs on a Unix socket, the input files given are parsed in advance and kept in memory along with every other input" << std::endl;
+	std::cerr << "\t--connect=<socket>" << std::endl << "\t\tSend the link job to a server, or link locally if none is running" << std::endl;
+	std::cerr << "\t--memory-report" << std::endl << "\t\tPrint the memory held by the linker after each phase, per category" << std::endl;
+	std::cerr << "\t--memory-budget=<bytes>" << std::endl << "\t\tFail the link if the memory held by the linker exceeds a limit" << std::endl;
+	std::cerr << "\t--incremental" << std::endl << "\t\tOnly rewrite the parts of the previous output that changed, if every section kept its size (state stored in <output file>.layout)" << std::endl;
 
 	std::cerr << "List of supported output formats:" << std::endl;
 	format_specification * last = nullptr;
@@ -100,9 +113,79 @@ public:
 null_buffer null_buffer::the_null_buffer;
 
 /**
- * @brief The main entry to the linker
+ * @brief Parses an input file and adds its modules to the collector, or loads them from the module cache if possible
  */
-int main(int argc, char * argv[])
+static void read_input(ModuleCollector& linker, std::shared_ptr<OutputFormat> format, std::string input, ModuleCache * module_cache)
+{
+	if(module_cache != nullptr && module_cache->Load(linker, input))
+	{
+		return;
+	}
+
+	std::ifstream in;
+	in.open(Linker::ResolvePath(input), std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+	{
+		std::ostringstream message;
+		message << "Fatal error: Unable to open file " << input;
+		Linker::FatalError(message.str());
+	}
+	Reader rd (LittleEndian, &in);
+
+	std::vector<format_description> file_formats;
+	DetermineFormat(file_formats, rd);
+
+	std::shared_ptr<InputFormat> input_format = nullptr;
+
+	for(auto& file_format : file_formats)
+	{
+		input_format = std::dynamic_pointer_cast<InputFormat>(CreateFormat(rd, file_format, ReadLibraryFile));
+		if(input_format != nullptr)
+		{
+			input_format->file_offset = file_format.offset;
+			rd.Seek(file_format.offset);
+			break; /* already processed */
+		}
+	}
+	if(!input_format)
+	{
+		std::ostringstream message;
+		message << "Fatal error: Unable to process input file " << input << ", file format: ";
+		if(file_formats.size() == 0)
+		{
+			message << "unknown";
+		}
+		else
+		{
+			bool not_first = false;
+			for(auto& file_format : file_formats)
+			{
+				if(not_first)
+					message << ", ";
+				message << file_format.magic.description;
+				not_first = true;
+			}
+		}
+		Linker::FatalError(message.str());
+	}
+
+	input_format->SetupOptions(format);
+	size_t first_module = linker.modules.size();
+	input_format->ProduceModule(linker, rd, input);
+	in.close();
+
+	if(module_cache != nullptr)
+	{
+		module_cache->Store(linker, input, first_module);
+	}
+}
+
+/**
+ * @brief Runs a link job, as given on the command line
+ *
+ * @param resident_cache When running as a link server, the module cache shared by all jobs
+ */
+static int link(int argc, char * argv[], ModuleCache * resident_cache)
 {
 	Module module;
 	std::shared_ptr<OutputFormat> format = nullptr;
@@ -117,6 +200,13 @@ int main(int argc, char * argv[])
 	std::map<std::string, std::string> parameters;
 	std::map<std::string, Reference> defines;
 	char special_char = '$';
+	std::string format_name;
+	std::string module_cache_directory;
+	uint64_t module_cache_size = ModuleCache::DefaultMaximumSize;
+	bool incremental = false;
+	std::string server_socket;
+	bool memory_report = false;
+	offset_t memory_budget = 0;
 
 	for(int i = 1; i < argc; i++)
 	{
@@ -126,15 +216,16 @@ int main(int argc, char * argv[])
 			{
 				/* help */
 				usage(argv[0]);
-				exit(0);
+				return 0;
 			}
 			else if(argv[i][1] == 'F')
 			{
 				/* format type */
-				format = std::dynamic_pointer_cast<OutputFormat>(FetchFormat(argv[i][2] ? &argv[i][2] : argv[++i]));
+				format_name = argv[i][2] ? &argv[i][2] : argv[++i];
+				format = std::dynamic_pointer_cast<OutputFormat>(FetchFormat(format_name));
 				if(format == nullptr)
 				{
-					Linker::Error << "Error: Unknown output format " << (argv[i][2] ? &argv[i][2] : argv[++i]) << std::endl;
+					Linker::Error << "Error: Unknown output format " << format_name << std::endl;
 				}
 			}
 			else if(argv[i][1] == 'o')
@@ -237,6 +328,44 @@ int main(int argc, char * argv[])
 			{
 				suppress_warnings = true;
 			}
+			else if(strncmp(argv[i], "--server=", 9) == 0)
+			{
+				server_socket = &argv[i][9];
+			}
+			else if(strcmp(argv[i], "--incremental") == 0)
+			{
+				incremental = true;
+			}
+			else if(strncmp(argv[i], "--module-cache=", 15) == 0)
+			{
+				module_cache_directory = &argv[i][15];
+			}
+			else if(strncmp(argv[i], "--module-cache-size=", 20) == 0)
+			{
+				try
+				{
+					module_cache_size = std::stoull(&argv[i][20], nullptr, 0);
+				}
+				catch(std::logic_error& e)
+				{
+					Linker::Error << "Error: Unable to parse module cache size " << &argv[i][20] << ", ignoring" << std::endl;
+				}
+			}
+			else if(strcmp(argv[i], "--memory-report") == 0)
+			{
+				memory_report = true;
+			}
+			else if(strncmp(argv[i], "--memory-budget=", 16) == 0)
+			{
+				try
+				{
+					memory_budget = std::stoull(&argv[i][16], nullptr, 0);
+				}
+				catch(std::logic_error& e)
+				{
+					Linker::Error << "Error: Unable to parse memory budget " << &argv[i][16] << ", ignoring" << std::endl;
+				}
+			}
 			else
 			{
 				std::ostringstream message;
@@ -261,10 +390,16 @@ int main(int argc, char * argv[])
 		Linker::Warning.rdbuf(&null_buffer::the_null_buffer);
 	}
 
-	if(inputs.size() == 0)
+	if(resident_cache != nullptr && server_socket != "")
+	{
+		Linker::Error << "Error: Link server cannot start another server" << std::endl;
+		return 1;
+	}
+
+	if(inputs.size() == 0 && server_socket == "")
 	{
 		usage(argv[0]);
-		exit(0);
+		return 0;
 	}
 
 	if(format == nullptr)
@@ -277,62 +412,68 @@ int main(int argc, char * argv[])
 
 	linker.SetupOptions(special_char, format);
 
-	for(auto input : inputs)
+	MemoryAccounting memory_accounting;
+	memory_accounting.budget = memory_budget;
+	bool account_memory = memory_report || memory_budget != 0;
+	auto measure_memory = [&](std::string phase)
 	{
-		std::ifstream in;
-		in.open(input, std::ios_base::in | std::ios_base::binary);
-		if(!in.is_open())
-		{
-			std::ostringstream message;
-			message << "Fatal error: Unable to open file " << input;
-			Linker::FatalError(message.str());
-		}
-		Reader rd (LittleEndian, &in);
+		MemoryUsage usage;
+		linker.AccountMemory(usage);
+		module.AccountMemory(usage);
+		format->AccountMemory(usage);
+		memory_accounting.Record(phase, usage);
+	};
+
+	std::unique_ptr<ModuleCache> own_module_cache;
+	ModuleCache * module_cache = nullptr;
+	if(resident_cache != nullptr)
+	{
+		/* entries are keyed by the format and special character of the job */
+		resident_cache->format_name = format_name;
+		resident_cache->special_char = special_char;
+		module_cache = resident_cache;
+	}
+	else if(module_cache_directory != "" || server_socket != "")
+	{
+		own_module_cache = std::make_unique<ModuleCache>(module_cache_directory, format_name, special_char, module_cache_size, server_socket != "");
+		module_cache = own_module_cache.get();
+	}
 
-		std::vector<format_description> file_formats;
-		DetermineFormat(file_formats, rd);
+	for(auto input : inputs)
+	{
+		read_input(linker, format, input, module_cache);
+	}
 
-		std::shared_ptr<InputFormat> input_format = nullptr;
+	if(module_cache != nullptr)
+	{
+		module_cache->Flush();
+	}
 
-		for(auto& file_format : file_formats)
-		{
-			input_format = std::dynamic_pointer_cast<InputFormat>(CreateFormat(rd, file_format, ReadLibraryFile));
-			if(input_format != nullptr)
-			{
-				input_format->file_offset = file_format.offset;
-				rd.Seek(file_format.offset);
-				break; /* already processed */
-			}
-		}
-		if(!input_format)
+	if(server_socket != "")
+	{
+		/* the inputs only serve to preload the cache */
+		LinkServer server(server_socket);
+		server.Serve([module_cache](std::vector<std::string>& arguments) -> int
 		{
-			std::ostringstream message;
-			message << "Fatal error: Unable to process input file " << input << ", file format: ";
-			if(file_formats.size() == 0)
-			{
-				message << "unknown";
-			}
-			else
+			std::vector<char *> job_argv;
+			for(auto& argument : arguments)
 			{
-				bool not_first = false;
-				for(auto& file_format : file_formats)
-				{
-					if(not_first)
-						message << ", ";
-					message << file_format.magic.description;
-					not_first = true;
-				}
+				job_argv.push_back(argument.data());
 			}
-			Linker::FatalError(message.str());
-		}
-
-		input_format->SetupOptions(format);
-		input_format->ProduceModule(linker, rd, input);
-		in.close();
+			job_argv.push_back(nullptr);
+			return link(arguments.size(), job_argv.data(), module_cache);
+		});
+		return 0;
 	}
 
+	if(account_memory)
+		measure_memory("read");
+
 	linker.CombineModulesInto(module);
 
+	if(account_memory)
+		measure_memory("combine");
+
 #if DISPLAY_LOGS
 	for(auto section : module.Sections())
 	{
@@ -390,9 +531,49 @@ int main(int argc, char * argv[])
 	format->SetModel(model);
 	format->SetLinkScript(linker_script, parameters);
 
+	if(incremental)
+	{
+		format->incremental_layout = std::make_shared<IncrementalLayout>(output + ".layout");
+	}
+
+	if(account_memory)
+	{
+		format->stage_finished = measure_memory;
+	}
+
 	Linker::Debug << "Debug: Generating " << output << std::endl;
 	format->GenerateFile(output, module);
 
+	if(memory_report)
+	{
+		memory_accounting.Report(std::cerr);
+	}
+
 	return 0;
 }
 
+/**
+ * @brief The main entry to the linker
+ */
+int main(int argc, char * argv[])
+{
+	for(int i = 1; i < argc; i++)
+	{
+		if(strncmp(argv[i], "--connect=", 10) == 0)
+		{
+			std::string socket_path = &argv[i][10];
+			/* the remaining arguments are passed on unchanged */
+			std::copy(argv + i + 1, argv + argc, argv + i);
+			argc--;
+			argv[argc] = nullptr;
+
+			int status = LinkServer::Forward(socket_path, std::vector<std::string>(argv, argv + argc));
+			if(status >= 0)
+				return status;
+			Linker::Warning << "Warning: No link server at " << socket_path << ", linking locally" << std::endl;
+			break;
+		}
+	}
+
+	return link(argc, argv, nullptr);
+}
@@ -11,6 +11,11 @@ offset_t Buffer::ImageSize() const
 	return data.size();
 }
 
+offset_t Buffer::AllocatedSize() const
+{
+	return data.capacity();
+}
+
 void Buffer::Resize(offset_t new_size)
 {
 	data.resize(new_size);
@@ -36,7 +36,16 @@ namespace Linker
 		{
 		}
 
+		Buffer(std::vector<uint8_t>&& data)
+			: data(std::move(data))
+		{
+		}
+
 		offset_t ImageSize() const override;
+		/**
+		 * @brief Number of bytes allocated for the data, which may exceed its size
+		 */
+		offset_t AllocatedSize() const;
 		/**
 		 * @brief Resize buffer
 		 */
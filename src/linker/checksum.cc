@@ -0,0 +1,135 @@
+
+#include <algorithm>
+#include "checksum.h"
+#include "writer.h"
+
+using namespace Linker;
+
+void Checksum::Update(Writer& wr, offset_t offset, const uint8_t * data, size_t count)
+{
+	if(count == 0)
+		return;
+
+	offset_t end = offset + count;
+	offset_t merged_start = offset;
+	offset_t merged_end = end;
+
+	auto it = written.upper_bound(offset);
+	if(it != written.begin() && std::prev(it)->second >= offset)
+		--it;
+	while(it != written.end() && it->first <= end)
+	{
+		offset_t overlap_start = std::max(offset, it->first);
+		offset_t overlap_end = std::min(end, it->second);
+		if(overlap_start < overlap_end && valid)
+		{
+			std::vector<uint8_t> previous_data(overlap_end - overlap_start);
+			if(wr.ReadBack(overlap_start, previous_data.size(), previous_data.data()))
+			{
+				Add(overlap_start, previous_data.data(), previous_data.size(), true);
+			}
+			else
+			{
+				Linker::Debug << "Debug: unable to read back overwritten data at offset 0x" << std::hex << overlap_start << std::dec << ", checksum cannot be calculated" << std::endl;
+				valid = false;
+			}
+		}
+		merged_start = std::min(merged_start, it->first);
+		merged_end = std::max(merged_end, it->second);
+		it = written.erase(it);
+	}
+	written[merged_start] = merged_end;
+
+	Add(offset, data, count, false);
+}
+
+uint16_t Checksum::FoldedSum16() const
+{
+	uint64_t value = sum;
+	while((value >> 16) != 0)
+	{
+		value = (value & 0xFFFF) + (value >> 16);
+	}
+	return value;
+}
+
+uint64_t Checksum::SumWords(size_t word_size, offset_t position, const uint8_t * data, size_t count)
+{
+	/* since the word size divides 8, every eighth byte occupies the same place within its word, so bytes are summed in 8 lanes and only weighted at the end */
+	uint64_t lanes[8] = { };
+	size_t index = 0;
+	while(count - index >= 8)
+	{
+		/* 32-bit lanes cannot overflow within 16 MiB and let the compiler use wider vectors */
+		size_t block_end = index + (std::min(count - index, size_t(1) << 24) & ~size_t(7));
+		uint32_t block_lanes[8] = { };
+		for(; index < block_end; index += 8)
+		{
+			for(size_t lane = 0; lane < 8; lane++)
+			{
+				block_lanes[lane] += data[index + lane];
+			}
+		}
+		for(size_t lane = 0; lane < 8; lane++)
+		{
+			lanes[lane] += block_lanes[lane];
+		}
+	}
+	for(; index < count; index++)
+	{
+		lanes[index & 7] += data[index];
+	}
+
+	uint64_t sum = 0;
+	for(size_t lane = 0; lane < 8; lane++)
+	{
+		sum += lanes[lane] << (8 * ((position + lane) % word_size));
+	}
+	return sum;
+}
+
+void Checksum::Add(offset_t offset, const uint8_t * data, size_t count, bool remove)
+{
+	uint64_t value = SumWords(word_size, offset, data, count);
+	if(remove)
+		sum -= value;
+	else
+		sum += value;
+}
+
+void PageChecksum::AddPage(offset_t offset, offset_t size)
+{
+	auto it = std::upper_bound(pages.begin(), pages.end(), offset,
+		[](offset_t value, const page& current_page) { return value < current_page.offset; });
+	pages.insert(it, page { offset, size, 0 });
+}
+
+uint64_t PageChecksum::GetPageSum(offset_t offset) const
+{
+	auto it = std::lower_bound(pages.begin(), pages.end(), offset,
+		[](const page& current_page, offset_t value) { return current_page.offset < value; });
+	if(it == pages.end() || it->offset != offset)
+		return 0;
+	return it->sum;
+}
+
+void PageChecksum::Add(offset_t offset, const uint8_t * data, size_t count, bool remove)
+{
+	offset_t end = offset + count;
+	/* first page that ends after the start of the data */
+	auto it = std::upper_bound(pages.begin(), pages.end(), offset,
+		[](offset_t value, const page& current_page) { return value < current_page.offset + current_page.size; });
+	for(; it != pages.end() && it->offset < end; ++it)
+	{
+		offset_t piece_start = std::max(offset, it->offset);
+		offset_t piece_end = std::min(end, it->offset + it->size);
+		if(piece_start >= piece_end)
+			continue;
+		uint64_t value = SumWords(word_size, piece_start - it->offset, data + (piece_start - offset), piece_end - piece_start);
+		if(remove)
+			it->sum -= value;
+		else
+			it->sum += value;
+	}
+}
+
@@ -0,0 +1,93 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <map>
+#include <vector>
+#include "../common.h"
+
+namespace Linker
+{
+	class Writer;
+
+	/**
+	 * @brief Sums the little endian words of a file while it is being written
+	 *
+	 * A checksum is attached to a Writer, which passes it every byte it writes along with its file offset.
+	 * Words are counted from the beginning of the file, so the order in which the parts of the file are written does not matter.
+	 * When bytes that have already been summed are overwritten, their previous contents are read back and removed from the sum if the output stream supports reading, otherwise the checksum becomes invalid.
+	 * Once writing is finished, the checksum is detached and the format patches the header with the result.
+	 */
+	class Checksum
+	{
+	public:
+		/** @brief Size of the summed words, 2 or 4 */
+		size_t word_size;
+		/** @brief Sum of all words written so far, the checksum field itself must be 0 while the file is written */
+		uint64_t sum = 0;
+		/** @brief Cleared if summed bytes were overwritten and could not be read back */
+		bool valid = true;
+
+		Checksum(size_t word_size)
+			: word_size(word_size)
+		{
+		}
+
+		virtual ~Checksum() = default;
+
+		/** @brief Adds the bytes written at a file offset, removing the contribution of any bytes previously written at the same place */
+		void Update(Writer& wr, offset_t offset, const uint8_t * data, size_t count);
+
+		/** @brief The sum with carries folded back into the low 16 bits, as used for the PE image checksum */
+		uint16_t FoldedSum16() const;
+
+		/**
+		 * @brief Sums the bytes of a buffer as parts of little endian words
+		 *
+		 * @param word_size The size of the words, 2 or 4
+		 * @param position The position of the first byte within its word, counted from the start of the summed area
+		 */
+		static uint64_t SumWords(size_t word_size, offset_t position, const uint8_t * data, size_t count);
+
+	protected:
+		/** @brief Adds the contribution of some bytes, or removes it if the bytes are being replaced */
+		virtual void Add(offset_t offset, const uint8_t * data, size_t count, bool remove);
+
+	private:
+		/** @brief The areas that have already been summed, mapping each start offset to the end offset */
+		std::map<offset_t, offset_t> written;
+	};
+
+	/**
+	 * @brief Sums the little endian words of each page in a file separately
+	 *
+	 * Words are counted from the start of each page, bytes outside of all pages are ignored.
+	 */
+	class PageChecksum : public Checksum
+	{
+	public:
+		struct page
+		{
+			offset_t offset;
+			offset_t size;
+			uint64_t sum;
+		};
+		/** @brief The pages, sorted by file offset */
+		std::vector<page> pages;
+
+		PageChecksum(size_t word_size)
+			: Checksum(word_size)
+		{
+		}
+
+		/** @brief Registers a page, pages may not overlap and must be registered before any data is written */
+		void AddPage(offset_t offset, offset_t size);
+
+		/** @brief Retrieves the sum of the page starting at a file offset, 0 if there is no such page */
+		uint64_t GetPageSum(offset_t offset) const;
+
+	protected:
+		void Add(offset_t offset, const uint8_t * data, size_t count, bool remove) override;
+	};
+}
+
+#endif /* CHECKSUM_H */
@@ -0,0 +1,27 @@
+
+#include "duplicate_finder.h"
+
+using namespace Linker;
+
+size_t DuplicateFinder::Add(std::vector<uint8_t> data, offset_t stored_size)
+{
+	uint64_t hash = Hash(data.data(), data.size());
+	auto range = block_hashes.equal_range(hash);
+	for(auto it = range.first; it != range.second; ++it)
+	{
+		if(blocks[it->second] == data)
+		{
+			duplicate_count++;
+			duplicate_bytes += stored_size;
+			return it->second;
+		}
+	}
+	block_hashes.emplace(hash, blocks.size());
+	blocks.push_back(std::move(data));
+	return None;
+}
+
+void DuplicateFinder::ReportDuplicates(std::string kind) const
+{
+	Linker::Debug << "Debug: merged " << std::dec << duplicate_count << " identical " << kind << "(s), saving " << duplicate_bytes << " bytes" << std::endl;
+}
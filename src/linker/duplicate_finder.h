@@ -0,0 +1,47 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include <map>
+#include <vector>
+#include "../common.h"
+
+namespace Linker
+{
+	/**
+	 * @brief Finds blocks of data with identical contents, so that they only need to be stored once
+	 *
+	 * Blocks are looked up by the hash of their contents, and candidates are confirmed by a full comparison.
+	 * Each distinct block gets a number in the order it was added, which the caller uses to find where the earlier copy was placed.
+	 */
+	class DuplicateFinder
+	{
+	public:
+		/** @brief Returned by Add when there is no earlier block with the same contents */
+		static constexpr size_t None = size_t(-1);
+
+		/** @brief Number of blocks that were found to be duplicates */
+		size_t duplicate_count = 0;
+		/** @brief Total number of bytes that duplicates would have taken up */
+		offset_t duplicate_bytes = 0;
+
+		/**
+		 * @brief Looks for an earlier block with the same contents
+		 *
+		 * @param data The contents of the block
+		 * @param stored_size The number of bytes the block takes up in the output, counted as saved if it is a duplicate
+		 * @return The number of the earlier block with the same contents, or None if the block is new, in which case it becomes the next distinct block
+		 */
+		size_t Add(std::vector<uint8_t> data, offset_t stored_size);
+
+		/** @brief Displays the number of duplicates found and the bytes they saved as a debug message */
+		void ReportDuplicates(std::string kind) const;
+
+	private:
+		/** @brief The distinct blocks added so far, in order */
+		std::vector<std::vector<uint8_t>> blocks;
+		/** @brief Maps the hash of the contents to the numbers of the blocks */
+		std::multimap<uint64_t, size_t> block_hashes;
+	};
+}
+
+#endif /* DUPLICATE_FINDER_H */
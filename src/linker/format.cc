@@ -1,6 +1,8 @@
 
+#include <filesystem>
 #include <fstream>
 #include "format.h"
+#include "incremental_layout.h"
 #include "module.h"
 #include "module_collector.h"
 #include "options.h"
@@ -133,14 +135,56 @@ void OutputFormat::CalculateValues()
 
 void OutputFormat::GenerateFile(std::string filename, ::Linker::Module& module)
 {
+	if(incremental_layout)
+		incremental_layout->CompareSections(module);
 	ProcessModule(module);
+	if(incremental_layout)
+		incremental_layout->RecordLayout(*this, module);
+	if(stage_finished)
+		stage_finished("process");
 	CalculateValues();
+	if(stage_finished)
+		stage_finished("calculate");
 
-	std::ofstream out;
-	out.open(filename, std::ios_base::out | std::ios_base::binary);
-	Writer wr(::LittleEndian, &out);
-	WriteFile(wr);
-	out.close();
+	if(incremental_layout)
+	{
+		incremental_layout->WriteFile(*this, filename);
+	}
+	else
+	{
+		/* opened for reading as well, so that checksums can account for overwritten data */
+		std::fstream out;
+		out.open(Linker::ResolvePath(filename), std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if(!out.is_open())
+		{
+			Linker::FatalError("Fatal error: Unable to open output file " + filename);
+		}
+		Writer wr(::LittleEndian, &out);
+		WriteFile(wr);
+		out.close();
+		if(out.fail())
+		{
+			Linker::FatalError("Fatal error: Unable to write output file " + filename);
+		}
+	}
+	if(stage_finished)
+	{
+		try
+		{
+			stage_finished("write");
+		}
+		catch(Linker::Exception& exception)
+		{
+			/* a failed link, such as one that exceeded its memory budget, must not leave an output file behind */
+			std::error_code error;
+			std::filesystem::remove(Linker::ResolvePath(filename), error);
+			throw;
+		}
+	}
+}
+
+void OutputFormat::AccountMemory(MemoryUsage& usage) const
+{
 }
 
 std::string OutputFormat::GetDefaultExtension(::Linker::Module& module, std::string filename) const
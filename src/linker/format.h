@@ -1,7 +1,9 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <functional>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include "../common.h"
@@ -14,6 +16,8 @@ namespace Dumper
 
 namespace Linker
 {
+	class IncrementalLayout;
+	class MemoryUsage;
 	class Module;
 	class ModuleCollector;
 	class OptionCollector;
@@ -63,6 +67,16 @@ namespace Linker
 	class OutputFormat : public virtual Format
 	{
 	public:
+		/**
+		 * @brief Invoked by GenerateFile after processing the module, calculating the values and writing the file, used to time each stage
+		 *
+		 * If it raises an error after the file has been written, such as when a memory budget is exceeded, the file is removed.
+		 */
+		std::function<void(std::string stage)> stage_finished;
+		/**
+		 * @brief When set, GenerateFile keeps the layout of the previous output and only rewrites the parts of the file that changed
+		 */
+		std::shared_ptr<IncrementalLayout> incremental_layout;
 		/**
 		 * @brief If the output format actually drives multiple output formats (resource file, apple double, etc.), specify multiple types, return false if unknown
 		 */
@@ -124,6 +138,10 @@ namespace Linker
 		 * @brief The main function that handles processing, calculating and generating the final image
 		 */
 		virtual void GenerateFile(std::string filename, Module& module);
+		/**
+		 * @brief Adds the memory held by format specific tables to a measurement
+		 */
+		virtual void AccountMemory(MemoryUsage& usage) const;
 		/**
 		 * @brief Appends a default extension to the filename
 		 *
@@ -0,0 +1,225 @@
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "format.h"
+#include "incremental_layout.h"
+#include "module.h"
+#include "reader.h"
+#include "section.h"
+#include "segment.h"
+#include "segment_manager.h"
+#include "writer.h"
+
+using namespace Linker;
+
+IncrementalLayout::IncrementalLayout(std::string state_file_name)
+	: state_file_name(Linker::ResolvePath(state_file_name))
+{
+	ReadState();
+}
+
+void IncrementalLayout::CompareSections(const Module& module)
+{
+	const std::vector<std::shared_ptr<Section>>& sections = module.Sections();
+
+	/* the placement can only be kept if nothing moves, padding sections would make the output differ from a full link */
+	sections_unchanged = previous.valid && previous.input_sections.size() == sections.size();
+	for(size_t i = 0; sections_unchanged && i < sections.size(); i++)
+	{
+		const placement& old_section = previous.input_sections[i];
+		if(sections[i]->name != old_section.name || sections[i]->Size() != old_section.size)
+		{
+			Linker::Debug << "Debug: section " << sections[i]->name << " is new or changed size, layout will change" << std::endl;
+			sections_unchanged = false;
+		}
+	}
+
+	current.input_sections.clear();
+	for(auto& section : sections)
+	{
+		current.input_sections.push_back(placement { section->name, 0, section->Size() });
+	}
+}
+
+void IncrementalLayout::RecordLayout(OutputFormat& format, Module& module)
+{
+	current.segments.clear();
+	if(SegmentManager * segment_manager = dynamic_cast<SegmentManager *>(&format))
+	{
+		for(auto& segment : segment_manager->segment_vector)
+		{
+			current.segments.push_back(placement { segment->name, segment->base_address, segment->TotalSize() });
+		}
+	}
+
+	current.sections.clear();
+	for(auto& section : module.Sections())
+	{
+		current.sections.push_back(placement { section->name, section->IsFixed() ? section->GetStartAddress() : offset_t(-1), section->Size() });
+	}
+}
+
+void IncrementalLayout::WriteFile(const OutputFormat& format, std::string filename)
+{
+	std::stringstream image;
+	Writer wr(::LittleEndian, &image);
+	format.WriteFile(wr);
+	std::string data = image.str();
+	std::string path = Linker::ResolvePath(filename);
+
+	current.file_size = data.size();
+	current.block_hashes.clear();
+	for(offset_t offset = 0; offset < data.size(); offset += BlockSize)
+	{
+		current.block_hashes.push_back(Linker::Hash(data.data() + offset, std::min(BlockSize, data.size() - offset)));
+	}
+
+	bool in_place = false;
+	if(!previous.valid)
+	{
+		Linker::Debug << "Debug: no previous layout for " << filename << ", writing full file" << std::endl;
+	}
+	else if(!sections_unchanged || previous.segments != current.segments || previous.sections != current.sections || previous.file_size != current.file_size)
+	{
+		Linker::Debug << "Debug: layout of " << filename << " changed, writing full file" << std::endl;
+	}
+	else
+	{
+		std::error_code error;
+		offset_t file_size = std::filesystem::file_size(path, error);
+		int64_t modification_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+		if(error || file_size != previous.file_size || modification_time != previous.modification_time)
+		{
+			Linker::Debug << "Debug: " << filename << " was modified since the last link, writing full file" << std::endl;
+		}
+		else
+		{
+			in_place = true;
+		}
+	}
+
+	bool written;
+	if(in_place)
+	{
+		std::fstream out(path, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+		written = out.is_open();
+		size_t changed_blocks = 0;
+		for(size_t block = 0; written && block < current.block_hashes.size(); block++)
+		{
+			if(current.block_hashes[block] == previous.block_hashes[block])
+				continue;
+			offset_t offset = block * BlockSize;
+			out.seekp(offset);
+			out.write(data.data() + offset, std::min(BlockSize, data.size() - offset));
+			written = out.good();
+			changed_blocks++;
+		}
+		out.close();
+		written = written && !out.fail();
+		Linker::Debug << "Debug: layout of " << filename << " unchanged, rewrote " << changed_blocks << " of " << current.block_hashes.size() << " blocks" << std::endl;
+	}
+	else
+	{
+		std::ofstream out(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		written = out.is_open();
+		if(written)
+		{
+			out.write(data.data(), data.size());
+			out.close();
+			written = !out.fail();
+		}
+	}
+
+	if(!written)
+	{
+		/* the contents of the file are unknown, the next link has to write all of it */
+		current.valid = false;
+		WriteState();
+		Linker::FatalError("Fatal error: Unable to write output file " + filename);
+	}
+
+	std::error_code error;
+	current.modification_time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+	current.valid = !error;
+	WriteState();
+}
+
+void IncrementalLayout::ReadState()
+{
+	std::ifstream in(state_file_name, std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+		return;
+	try
+	{
+		Reader rd(::LittleEndian, &in);
+		if(rd.ReadData(4) != "RLIL" || rd.ReadUnsigned(4) != Version)
+			return;
+		previous.file_size = rd.ReadUnsigned(8);
+		previous.modification_time = rd.ReadUnsigned(8);
+		for(auto * placements : { &previous.input_sections, &previous.segments, &previous.sections })
+		{
+			uint32_t count = rd.ReadUnsigned(4);
+			for(uint32_t i = 0; i < count; i++)
+			{
+				placement entry;
+				entry.name = rd.ReadData(rd.ReadUnsigned(4));
+				entry.address = rd.ReadUnsigned(8);
+				entry.size = rd.ReadUnsigned(8);
+				placements->push_back(entry);
+			}
+		}
+		uint32_t block_count = rd.ReadUnsigned(4);
+		if(block_count != (previous.file_size + BlockSize - 1) / BlockSize)
+			return;
+		for(uint32_t i = 0; i < block_count; i++)
+		{
+			previous.block_hashes.push_back(rd.ReadUnsigned(8));
+		}
+		previous.valid = true;
+	}
+	catch(Linker::Exception& exception)
+	{
+		Linker::Warning << "Warning: ignoring damaged incremental link state " << state_file_name << ": " << exception.message << std::endl;
+		previous = state();
+	}
+}
+
+void IncrementalLayout::WriteState()
+{
+	if(!current.valid)
+	{
+		std::error_code error;
+		std::filesystem::remove(state_file_name, error);
+		return;
+	}
+
+	std::ofstream out(state_file_name, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if(!out.is_open())
+	{
+		Linker::Warning << "Warning: unable to write incremental link state " << state_file_name << std::endl;
+		return;
+	}
+	Writer wr(::LittleEndian, &out);
+	wr.WriteData("RLIL");
+	wr.WriteWord(4, Version);
+	wr.WriteWord(8, current.file_size);
+	wr.WriteWord(8, current.modification_time);
+	for(auto * placements : { &current.input_sections, &current.segments, &current.sections })
+	{
+		wr.WriteWord(4, placements->size());
+		for(auto& entry : *placements)
+		{
+			wr.WriteWord(4, entry.name.size());
+			wr.WriteData(entry.name);
+			wr.WriteWord(8, entry.address);
+			wr.WriteWord(8, entry.size);
+		}
+	}
+	wr.WriteWord(4, current.block_hashes.size());
+	for(uint64_t hash : current.block_hashes)
+	{
+		wr.WriteWord(8, hash);
+	}
+}
+
@@ -0,0 +1,93 @@
+#ifndef INCREMENTAL_LAYOUT_H
+#define INCREMENTAL_LAYOUT_H
+
+#include <string>
+#include <vector>
+#include "../common.h"
+
+namespace Linker
+{
+	class Module;
+	class OutputFormat;
+
+	/**
+	 * @brief Rewrites only the parts of an output file that changed since the previous link
+	 *
+	 * The sizes of the sections, the placement of segments and sections and a hash of each block of the output file are recorded in a state file next to the output.
+	 * On the next link, the complete image is generated as usual, so the result is always identical to a full link.
+	 * If every section has the same size as before, the placement did not change and the output file is the one that was written last time, only the blocks whose contents differ are written into it.
+	 * Otherwise the whole file is written, and the new layout is recorded.
+	 */
+	class IncrementalLayout
+	{
+	public:
+		/** @brief Version of the state file layout, files with any other version are ignored */
+		static constexpr uint32_t Version = 1;
+		/** @brief The unit in which the output file is compared and rewritten */
+		static constexpr offset_t BlockSize = 0x1000;
+
+		/** @brief Name of the file holding the state of the previous link */
+		std::string state_file_name;
+
+		IncrementalLayout(std::string state_file_name);
+
+		/**
+		 * @brief Checks whether the sections of the module have the same names and sizes as in the previous link
+		 *
+		 * Must be called before the module is processed by the output format.
+		 */
+		void CompareSections(const Module& module);
+
+		/**
+		 * @brief Records where the segments and sections were placed
+		 *
+		 * Must be called after the module is processed by the output format.
+		 */
+		void RecordLayout(OutputFormat& format, Module& module);
+
+		/**
+		 * @brief Writes the output file, in place if the layout did not change, and saves the new state
+		 *
+		 * If the output file cannot be written, the state file is removed, so that the next link writes the full file.
+		 */
+		void WriteFile(const OutputFormat& format, std::string filename);
+
+	private:
+		/** @brief The name, address and size of a segment or section */
+		struct placement
+		{
+			std::string name;
+			offset_t address;
+			offset_t size;
+
+			bool operator ==(const placement& other) const = default;
+		};
+
+		struct state
+		{
+			bool valid = false;
+			/** @brief Size of the output file */
+			offset_t file_size = 0;
+			/** @brief Modification time of the output file once written */
+			int64_t modification_time = 0;
+			/** @brief The sections of the module before processing */
+			std::vector<placement> input_sections;
+			/** @brief Segments created by the linker script */
+			std::vector<placement> segments;
+			/** @brief All sections after processing */
+			std::vector<placement> sections;
+			/** @brief Hash of each block of the output file */
+			std::vector<uint64_t> block_hashes;
+		};
+
+		state previous, current;
+
+		/** @brief Set if CompareSections found the same sections as in the previous link */
+		bool sections_unchanged = false;
+
+		void ReadState();
+		void WriteState();
+	};
+}
+
+#endif /* INCREMENTAL_LAYOUT_H */
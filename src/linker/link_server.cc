@@ -0,0 +1,252 @@
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "link_server.h"
+#include "reader.h"
+#include "writer.h"
+
+using namespace Linker;
+
+LinkServer::LinkServer(std::string socket_path)
+	: socket_path(socket_path)
+{
+}
+
+static sockaddr_un MakeAddress(std::string socket_path)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof address);
+	address.sun_family = AF_UNIX;
+	if(socket_path.size() >= sizeof address.sun_path)
+	{
+		Linker::FatalError("Fatal error: socket path too long: " + socket_path);
+	}
+	memcpy(address.sun_path, socket_path.data(), socket_path.size());
+	return address;
+}
+
+void LinkServer::Serve(job_function job, size_t job_limit)
+{
+	sockaddr_un address = MakeAddress(socket_path);
+
+	/* only a stale socket may be replaced, never a file that happens to be at the same path */
+	struct stat status;
+	if(lstat(socket_path.c_str(), &status) == 0)
+	{
+		if(!S_ISSOCK(status.st_mode))
+		{
+			Linker::FatalError("Fatal error: " + socket_path + " exists and is not a socket, refusing to start server");
+		}
+		unlink(socket_path.c_str());
+	}
+	else if(errno != ENOENT)
+	{
+		Linker::FatalError("Fatal error: unable to access " + socket_path + ": " + strerror(errno));
+	}
+
+	int server_handle = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(server_handle < 0)
+	{
+		Linker::FatalError("Fatal error: unable to create socket: " + std::string(strerror(errno)));
+	}
+	if(bind(server_handle, reinterpret_cast<sockaddr *>(&address), sizeof address) < 0 || listen(server_handle, 16) < 0)
+	{
+		close(server_handle);
+		Linker::FatalError("Fatal error: unable to listen on " + socket_path + ": " + strerror(errno));
+	}
+	Linker::Debug << "Debug: accepting jobs on " << socket_path << std::endl;
+
+	size_t job_count = 0;
+	while(job_limit == 0 || job_count < job_limit)
+	{
+		int client_handle = accept(server_handle, nullptr, nullptr);
+		if(client_handle < 0)
+		{
+			if(errno != EINTR)
+				Linker::Warning << "Warning: unable to accept job: " << strerror(errno) << std::endl;
+			continue;
+		}
+
+		std::string request;
+		std::vector<std::string> arguments;
+		try
+		{
+			if(!ReceiveMessage(client_handle, request))
+			{
+				Linker::Warning << "Warning: incomplete job request" << std::endl;
+				close(client_handle);
+				continue;
+			}
+			std::istringstream in(request);
+			Reader rd(::LittleEndian, &in);
+			if(rd.ReadData(4) != "RLLS" || rd.ReadUnsigned(4) != Version)
+			{
+				Linker::Warning << "Warning: job request of unknown version" << std::endl;
+				close(client_handle);
+				continue;
+			}
+			uint32_t count = rd.ReadUnsigned(4);
+			for(uint32_t i = 0; i < count; i++)
+			{
+				arguments.push_back(rd.ReadData(rd.ReadUnsigned(4)));
+			}
+		}
+		catch(Linker::Exception& exception)
+		{
+			Linker::Warning << "Warning: invalid job request: " << exception.message << std::endl;
+			close(client_handle);
+			continue;
+		}
+
+		/* first string is the working directory of the client */
+		std::pair<int, std::string> result(1, "Fatal error: job request without working directory\n");
+		if(arguments.size() > 0)
+		{
+			Linker::base_directory = arguments[0];
+			arguments.erase(arguments.begin());
+			result = RunJob(job, arguments);
+			Linker::base_directory = "";
+		}
+		job_count++;
+		Linker::Debug << "Debug: job finished with status " << result.first << std::endl;
+
+		std::ostringstream response;
+		Writer wr(::LittleEndian, &response);
+		wr.WriteWord(4, uint32_t(result.first));
+		wr.WriteData(result.second);
+		if(!SendMessage(client_handle, response.str()))
+		{
+			Linker::Warning << "Warning: client disconnected before receiving the job results" << std::endl;
+		}
+		close(client_handle);
+	}
+
+	close(server_handle);
+	unlink(socket_path.c_str());
+}
+
+std::pair<int, std::string> LinkServer::RunJob(job_function& job, std::vector<std::string>& arguments)
+{
+	std::ostringstream output;
+	std::streambuf * debug_buffer = Linker::Debug.rdbuf(output.rdbuf());
+	std::streambuf * warning_buffer = Linker::Warning.rdbuf(output.rdbuf());
+	std::streambuf * error_buffer = Linker::Error.rdbuf(output.rdbuf());
+	std::streambuf * cout_buffer = std::cout.rdbuf(output.rdbuf());
+	std::streambuf * cerr_buffer = std::cerr.rdbuf(output.rdbuf());
+
+	int status;
+	try
+	{
+		status = job(arguments);
+	}
+	catch(Linker::Exception& exception)
+	{
+		/* the message has already been printed by FatalError */
+		status = 1;
+	}
+	catch(std::exception& error)
+	{
+		output << "Fatal error: " << error.what() << std::endl;
+		status = 1;
+	}
+
+	Linker::Debug.rdbuf(debug_buffer);
+	Linker::Warning.rdbuf(warning_buffer);
+	Linker::Error.rdbuf(error_buffer);
+	std::cout.rdbuf(cout_buffer);
+	std::cerr.rdbuf(cerr_buffer);
+	return std::make_pair(status, output.str());
+}
+
+int LinkServer::Forward(std::string socket_path, const std::vector<std::string>& arguments)
+{
+	sockaddr_un address = MakeAddress(socket_path);
+	int client_handle = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(client_handle < 0)
+	{
+		return -1;
+	}
+	if(connect(client_handle, reinterpret_cast<sockaddr *>(&address), sizeof address) < 0)
+	{
+		close(client_handle);
+		return -1;
+	}
+
+	std::ostringstream request;
+	Writer wr(::LittleEndian, &request);
+	wr.WriteData("RLLS");
+	wr.WriteWord(4, Version);
+	wr.WriteWord(4, arguments.size() + 1);
+	std::string working_directory = std::filesystem::current_path().string();
+	wr.WriteWord(4, working_directory.size());
+	wr.WriteData(working_directory);
+	for(auto& argument : arguments)
+	{
+		wr.WriteWord(4, argument.size());
+		wr.WriteData(argument);
+	}
+
+	std::string response;
+	if(!SendMessage(client_handle, request.str()) || !ReceiveMessage(client_handle, response) || response.size() < 4)
+	{
+		close(client_handle);
+		Linker::FatalError("Fatal error: link server at " + socket_path + " did not complete the job");
+	}
+	close(client_handle);
+
+	std::istringstream in(response);
+	Reader rd(::LittleEndian, &in);
+	int status = int(rd.ReadUnsigned(4));
+	std::cerr << response.substr(4);
+	return status;
+}
+
+bool LinkServer::SendMessage(int socket_handle, const std::string& message)
+{
+	std::ostringstream header;
+	Writer wr(::LittleEndian, &header);
+	wr.WriteWord(4, message.size());
+	std::string data = header.str() + message;
+
+	for(size_t offset = 0; offset < data.size();)
+	{
+		ssize_t count = send(socket_handle, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+		if(count < 0 && errno == EINTR)
+			continue;
+		if(count <= 0)
+			return false;
+		offset += count;
+	}
+	return true;
+}
+
+bool LinkServer::ReceiveMessage(int socket_handle, std::string& message)
+{
+	auto receive = [socket_handle](char * buffer, size_t size) -> bool
+	{
+		for(size_t offset = 0; offset < size;)
+		{
+			ssize_t count = recv(socket_handle, buffer + offset, size - offset, 0);
+			if(count < 0 && errno == EINTR)
+				continue;
+			if(count <= 0)
+				return false;
+			offset += count;
+		}
+		return true;
+	};
+
+	uint8_t header[4];
+	if(!receive(reinterpret_cast<char *>(header), 4))
+		return false;
+	size_t size = header[0] | (header[1] << 8) | (header[2] << 16) | (uint32_t(header[3]) << 24);
+	message.resize(size);
+	return receive(message.data(), size);
+}
+
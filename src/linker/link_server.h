@@ -0,0 +1,62 @@
+#ifndef LINK_SERVER_H
+#define LINK_SERVER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "../common.h"
+
+namespace Linker
+{
+	/**
+	 * @brief A resident process that runs link jobs received over a local Unix socket
+	 *
+	 * A client sends its working directory and command line arguments, the server runs the job with relative file names resolved against that directory (see base_directory) and sends back everything the job printed, along with its exit status.
+	 * Jobs are run one at a time, since they share the state of the server.
+	 * The server is meant to keep state between jobs, such as a resident ModuleCache holding the modules of frequently used libraries.
+	 */
+	class LinkServer
+	{
+	public:
+		/** @brief Version of the protocol, requests with any other version are rejected */
+		static constexpr uint32_t Version = 1;
+
+		/** @brief Path to the socket */
+		std::string socket_path;
+
+		LinkServer(std::string socket_path);
+
+		/**
+		 * @brief The function invoked for each job, with the arguments received from the client (the first one is the program name), must return the exit status
+		 *
+		 * While it runs, base_directory is the working directory of the client, and Debug, Warning, Error as well as the standard output streams are collected to be sent back.
+		 * Uncaught Linker::Exception instances are reported as a failure of the job.
+		 */
+		typedef std::function<int(std::vector<std::string>& arguments)> job_function;
+
+		/**
+		 * @brief Creates the socket, replacing any stale one, and runs jobs
+		 *
+		 * Refuses to start if the socket path names something other than a socket.
+		 *
+		 * @param job_limit Number of jobs to run before closing the socket and returning, 0 to run jobs until the process is terminated
+		 */
+		void Serve(job_function job, size_t job_limit = 0);
+
+		/**
+		 * @brief Sends a job to a running server and prints its output to the standard error
+		 *
+		 * @return The exit status of the job, or -1 if no server is accepting jobs at the socket
+		 */
+		static int Forward(std::string socket_path, const std::vector<std::string>& arguments);
+
+	private:
+		/** @brief Runs a single job, returns its exit status and output */
+		std::pair<int, std::string> RunJob(job_function& job, std::vector<std::string>& arguments);
+
+		static bool SendMessage(int socket_handle, const std::string& message);
+		static bool ReceiveMessage(int socket_handle, std::string& message);
+	};
+}
+
+#endif /* LINK_SERVER_H */
@@ -0,0 +1,126 @@
+
+#include <fstream>
+#include <sstream>
+#include <sys/resource.h>
+#include "buffer.h"
+#include "memory_usage.h"
+#include "section.h"
+#include "segment.h"
+
+using namespace Linker;
+
+void MemoryUsage::Add(std::string category, offset_t bytes)
+{
+	categories[category] += bytes;
+}
+
+bool MemoryUsage::FirstVisit(const void * object)
+{
+	return visited.insert(object).second;
+}
+
+void MemoryUsage::AddContents(std::string category, std::shared_ptr<const Contents> contents)
+{
+	if(contents == nullptr || !FirstVisit(contents.get()))
+		return;
+
+	if(auto buffer = std::dynamic_pointer_cast<const Buffer>(contents))
+	{
+		Add(category, buffer->AllocatedSize());
+	}
+	else if(auto segment = std::dynamic_pointer_cast<const Segment>(contents))
+	{
+		AddVector(category, segment->sections);
+		for(auto& section : segment->sections)
+		{
+			AddContents(category, section);
+		}
+	}
+}
+
+offset_t MemoryUsage::Total() const
+{
+	offset_t total = 0;
+	for(auto& category : categories)
+	{
+		total += category.second;
+	}
+	return total;
+}
+
+void MemoryAccounting::Record(std::string name, const MemoryUsage& usage)
+{
+	phase measurement;
+	measurement.name = name;
+	measurement.categories = usage.categories;
+	measurement.total = usage.Total();
+	measurement.resident_size = GetResidentSize();
+	measurement.peak_resident_size = GetPeakResidentSize();
+	phases.push_back(measurement);
+
+	if(measurement.total > peak)
+		peak = measurement.total;
+
+	Linker::Debug << "Debug: memory held after " << name << ": " << measurement.total << " bytes" << std::endl;
+
+	if(budget != 0 && measurement.total > budget)
+	{
+		std::ostringstream message;
+		message << "Fatal error: Memory budget of " << budget << " bytes exceeded after " << name << ", " << measurement.total << " bytes held";
+		Linker::FatalError(message.str());
+	}
+}
+
+void MemoryAccounting::Report(std::ostream& out) const
+{
+	for(auto& measurement : phases)
+	{
+		out << "Memory after " << measurement.name << ": " << measurement.total << " bytes";
+		if(measurement.resident_size != 0)
+			out << ", resident " << measurement.resident_size << " bytes";
+		if(measurement.peak_resident_size != 0)
+			out << ", peak resident " << measurement.peak_resident_size << " bytes";
+		out << std::endl;
+		for(auto& category : measurement.categories)
+		{
+			if(category.second == 0)
+				continue;
+			out << "\t" << category.first << ": " << category.second << " bytes" << std::endl;
+		}
+	}
+	out << "Peak memory held: " << peak << " bytes" << std::endl;
+}
+
+/** @brief Reads a field of /proc/self/status, only available on Linux */
+static offset_t ReadProcessStatus(std::string field)
+{
+	std::ifstream in("/proc/self/status");
+	std::string line;
+	while(std::getline(in, line))
+	{
+		if(line.compare(0, field.size() + 1, field + ":") != 0)
+			continue;
+		std::istringstream value(line.substr(field.size() + 1));
+		offset_t kilobytes = 0;
+		value >> kilobytes;
+		return kilobytes * 1024;
+	}
+	return 0;
+}
+
+offset_t MemoryAccounting::GetResidentSize()
+{
+	return ReadProcessStatus("VmRSS");
+}
+
+offset_t MemoryAccounting::GetPeakResidentSize()
+{
+	if(offset_t peak_size = ReadProcessStatus("VmHWM"))
+		return peak_size;
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	/* kilobytes on Linux and most BSDs */
+	return offset_t(usage.ru_maxrss) * 1024;
+}
+
@@ -0,0 +1,99 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "../common.h"
+
+namespace Linker
+{
+	class Contents;
+
+	/**
+	 * @brief A measurement of the memory held by the data structures of the linker, in bytes per category
+	 *
+	 * The measurement is an estimate: container sizes are taken from their capacity, and each node of a map is assumed to carry a fixed overhead.
+	 * Objects shared by several owners, such as sections that are moved from an input module into the output module, are only counted once.
+	 */
+	class MemoryUsage
+	{
+	public:
+		/** @brief Estimated bookkeeping overhead of a single map node */
+		static constexpr offset_t MapNodeOverhead = 4 * sizeof(void *);
+
+		/** @brief Bytes held per category */
+		std::map<std::string, offset_t> categories;
+
+		/** @brief Adds bytes to a category */
+		void Add(std::string category, offset_t bytes);
+
+		/** @brief Returns true the first time it is called for an object, so that shared objects are counted once */
+		bool FirstVisit(const void * object);
+
+		/** @brief Adds the data held by a buffer, or by the sections of a segment, unless already counted */
+		void AddContents(std::string category, std::shared_ptr<const Contents> contents);
+
+		template <typename T>
+			void AddVector(std::string category, const std::vector<T>& vector)
+		{
+			Add(category, vector.capacity() * sizeof(T));
+		}
+
+		template <typename K, typename V>
+			void AddMap(std::string category, const std::map<K, V>& map)
+		{
+			Add(category, map.size() * (sizeof(typename std::map<K, V>::value_type) + MapNodeOverhead));
+		}
+
+		/** @brief Sum of all categories */
+		offset_t Total() const;
+
+	private:
+		std::set<const void *> visited;
+	};
+
+	/**
+	 * @brief Collects memory measurements taken at the end of each link phase, and enforces a memory budget
+	 */
+	class MemoryAccounting
+	{
+	public:
+		/** @brief Maximum number of bytes the measured data structures may hold, 0 if unlimited */
+		offset_t budget = 0;
+		/** @brief Highest total of all measurements */
+		offset_t peak = 0;
+
+		/** @brief A measurement taken after a phase */
+		struct phase
+		{
+			std::string name;
+			std::map<std::string, offset_t> categories;
+			offset_t total;
+			/** @brief Resident set size of the process, as reported by the operating system, 0 if unknown */
+			offset_t resident_size;
+			/** @brief Highest resident set size of the process so far, 0 if unknown */
+			offset_t peak_resident_size;
+		};
+		std::vector<phase> phases;
+
+		/**
+		 * @brief Records the measurement taken after a phase
+		 *
+		 * Raises a fatal error if the measured total exceeds the budget.
+		 */
+		void Record(std::string name, const MemoryUsage& usage);
+
+		/** @brief Prints the measurements of each phase, per category */
+		void Report(std::ostream& out) const;
+
+		/** @brief Current resident set size of the process, 0 if it cannot be determined */
+		static offset_t GetResidentSize();
+		/** @brief Highest resident set size of the process so far, 0 if it cannot be determined */
+		static offset_t GetPeakResidentSize();
+	};
+}
+
+#endif /* MEMORY_USAGE_H */
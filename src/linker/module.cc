@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <sstream>
 #include "format.h"
+#include "memory_usage.h"
 #include "module.h"
 #include "section.h"
 
@@ -1185,3 +1186,24 @@ void Module::AllocateStack(offset_t stack_size, std::string default_section_name
 	}
 }
 
+void Module::AccountMemory(MemoryUsage& usage) const
+{
+	if(!usage.FirstVisit(this))
+		return;
+
+	usage.AddVector("sections", sections);
+	usage.AddMap("sections", section_names);
+	for(auto& section : sections)
+	{
+		usage.AddContents("section data", section);
+	}
+
+	usage.AddVector("symbols", symbol_sequence);
+	usage.AddMap("symbols", global_symbols);
+	usage.AddMap("symbols", local_symbols);
+	usage.AddVector("symbols", imported_symbols);
+	usage.AddMap("symbols", exported_symbols);
+
+	usage.AddVector("relocations", relocations);
+	usage.AddMap("relocations", relocation_indexes);
+}
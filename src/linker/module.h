@@ -14,6 +14,8 @@
 namespace Linker
 {
 	class InputFormat;
+	class MemoryUsage;
+	class ModuleCache;
 	class OutputFormat;
 	class Section;
 
@@ -105,6 +107,7 @@ namespace Linker
 		std::map<ExportedSymbolName, Location> exported_symbols;
 
 		friend class ModuleCollector;
+		friend class ModuleCache;
 
 	private:
 		bool AddSymbol(const SymbolDefinition& symbol);
@@ -137,6 +140,9 @@ namespace Linker
 		/** @brief Set to true if module is included in the linking process, relevant for libraries */
 		bool is_included = false;
 
+		/** @brief Set to true if module was added as a library member, to be included only on demand */
+		bool is_library = false;
+
 		/**
 		 * @brief Initializes the reader for linking purposes
 		 * @param special_char Most input formats do not provide support for the special requirements of the output format (such as segmentation for ELF). We work around this by introducing special name prefixes $$SEGOF$ where $ is the value of special_char.
@@ -306,6 +312,11 @@ namespace Linker
 		 * @brief Unless .stack_top is defined or stack_size is zero, makes sure a .stack segment exists and is at least as large as stack_size
 		 */
 		void AllocateStack(offset_t stack_size, std::string default_section_name = ".stack");
+
+		/**
+		 * @brief Adds the memory held by the sections, symbols and relocations to a measurement
+		 */
+		void AccountMemory(MemoryUsage& usage) const;
 	};
 }
 
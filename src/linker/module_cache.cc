@@ -0,0 +1,777 @@
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+#include <typeinfo>
+#include "module_cache.h"
+#include "module_collector.h"
+
+using namespace Linker;
+
+ModuleCache::ModuleCache(std::filesystem::path directory, std::string format_name, char special_char, uint64_t maximum_size, bool resident)
+	: directory(Linker::ResolvePath(directory.string())), format_name(format_name), special_char(special_char), build_id(GetBuildId()), maximum_size(maximum_size), resident(resident)
+{
+	if(directory.empty())
+		return;
+	try
+	{
+		std::filesystem::create_directories(this->directory);
+	}
+	catch(std::filesystem::filesystem_error& error)
+	{
+		Linker::Warning << "Warning: unable to create module cache directory " << directory << ": " << error.what() << std::endl;
+	}
+	ReadIndex();
+}
+
+bool ModuleCache::Load(ModuleCollector& linker, std::string file_name)
+{
+	std::vector<std::shared_ptr<Module>> modules;
+	std::vector<bool> is_library;
+	std::filesystem::path entry_path;
+	try
+	{
+		file_status status = GetFileStatus(file_name);
+		entry_path = GetEntryPath(status);
+
+		std::string contents;
+		if(!ReadEntry(entry_path, contents))
+		{
+			Linker::Debug << "Debug: no module cache entry for " << file_name << std::endl;
+			return false;
+		}
+
+		/* header: magic, version, hash of the remaining data */
+		if(contents.size() < 16 || contents.compare(0, 4, "RLMC") != 0)
+		{
+			Linker::Warning << "Warning: ignoring invalid module cache entry " << entry_path << std::endl;
+			return false;
+		}
+		std::istringstream entry(contents);
+		Reader rd(::LittleEndian, &entry);
+		rd.Seek(4);
+		if(rd.ReadUnsigned(4) != Version)
+		{
+			Linker::Debug << "Debug: ignoring module cache entry of different version " << entry_path << std::endl;
+			return false;
+		}
+		if(rd.ReadUnsigned(8) != Hash(contents.data() + 16, contents.size() - 16))
+		{
+			Linker::Warning << "Warning: ignoring damaged module cache entry " << entry_path << std::endl;
+			return false;
+		}
+
+		/* the key is verified in full, in case two keys hash to the same entry */
+		if(rd.ReadUnsigned(8) != status.content_hash
+		|| rd.ReadUnsigned(8) != status.size
+		|| ReadString(rd) != format_name
+		|| rd.ReadUnsigned(1) != uint8_t(special_char)
+		|| ReadString(rd) != build_id)
+		{
+			Linker::Debug << "Debug: module cache entry " << entry_path << " belongs to a different input" << std::endl;
+			return false;
+		}
+
+		uint32_t module_count = rd.ReadUnsigned(4);
+		for(uint32_t i = 0; i < module_count; i++)
+		{
+			std::shared_ptr<Module> module = linker.CreateModule(nullptr, file_name);
+			is_library.push_back(ReadModule(rd, *module, file_name));
+			modules.push_back(module);
+		}
+
+		/* mark as recently used */
+		if(resident)
+			KeepResident(entry_path, std::move(contents));
+		if(!directory.empty())
+			std::filesystem::last_write_time(entry_path, std::filesystem::file_time_type::clock::now());
+	}
+	catch(Linker::Exception& exception)
+	{
+		Linker::Warning << "Warning: ignoring module cache entry " << entry_path << ": " << exception.message << std::endl;
+		return false;
+	}
+	catch(std::filesystem::filesystem_error& error)
+	{
+		Linker::Warning << "Warning: unable to access module cache for " << file_name << ": " << error.what() << std::endl;
+		return false;
+	}
+
+	Linker::Debug << "Debug: loaded " << modules.size() << " module(s) for " << file_name << " from module cache entry " << entry_path << std::endl;
+	/* the modules are only added once all of them have been read */
+	for(size_t i = 0; i < modules.size(); i++)
+	{
+		linker.AddModule(modules[i], is_library[i]);
+	}
+	return true;
+}
+
+void ModuleCache::Store(const ModuleCollector& linker, std::string file_name, size_t first_module)
+{
+	try
+	{
+		file_status status = GetFileStatus(file_name);
+
+		std::ostringstream payload;
+		Writer wr(::LittleEndian, &payload);
+		wr.WriteWord(8, status.content_hash);
+		wr.WriteWord(8, status.size);
+		WriteString(wr, format_name);
+		wr.WriteWord(1, uint8_t(special_char));
+		WriteString(wr, build_id);
+		wr.WriteWord(4, linker.modules.size() - first_module);
+		for(size_t i = first_module; i < linker.modules.size(); i++)
+		{
+			if(!WriteModule(wr, *linker.modules[i], file_name))
+			{
+				Linker::Debug << "Debug: module " << linker.modules[i]->file_name << " cannot be stored in module cache" << std::endl;
+				return;
+			}
+		}
+		std::string data = payload.str();
+
+		std::ostringstream entry;
+		Writer hwr(::LittleEndian, &entry);
+		hwr.WriteData("RLMC");
+		hwr.WriteWord(4, Version);
+		hwr.WriteWord(8, Hash(data.data(), data.size()));
+		hwr.WriteData(data);
+
+		std::filesystem::path entry_path = GetEntryPath(status);
+		if(resident)
+		{
+			KeepResident(entry_path, entry.str());
+		}
+		if(directory.empty())
+		{
+			Linker::Debug << "Debug: kept " << linker.modules.size() - first_module << " module(s) for " << file_name << " in memory" << std::endl;
+			return;
+		}
+
+		/* written under a temporary name first, so that readers never see a partial entry */
+		std::filesystem::path temporary_path = entry_path;
+		temporary_path += ".tmp";
+		std::ofstream out(temporary_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if(!out.is_open())
+		{
+			Linker::Warning << "Warning: unable to create module cache entry " << entry_path << std::endl;
+			return;
+		}
+		out << entry.str();
+		out.close();
+		if(!out)
+		{
+			Linker::Warning << "Warning: unable to write module cache entry " << entry_path << std::endl;
+			std::filesystem::remove(temporary_path);
+			return;
+		}
+		std::filesystem::rename(temporary_path, entry_path);
+		Linker::Debug << "Debug: stored " << linker.modules.size() - first_module << " module(s) for " << file_name << " in module cache entry " << entry_path << std::endl;
+	}
+	catch(std::filesystem::filesystem_error& error)
+	{
+		Linker::Warning << "Warning: unable to store " << file_name << " in module cache: " << error.what() << std::endl;
+	}
+}
+
+void ModuleCache::Flush()
+{
+	if(resident)
+	{
+		uint64_t resident_size = 0;
+		std::vector<std::pair<uint64_t, std::string>> entries;
+		for(auto& it : resident_entries)
+		{
+			entries.push_back(std::make_pair(it.second.last_use, it.first));
+			resident_size += it.second.contents.size();
+		}
+		std::sort(entries.begin(), entries.end());
+		for(auto& entry : entries)
+		{
+			if(resident_size <= maximum_size)
+				break;
+			Linker::Debug << "Debug: dropping least recently used module cache entry " << entry.second << " from memory" << std::endl;
+			resident_size -= resident_entries[entry.second].contents.size();
+			resident_entries.erase(entry.second);
+		}
+	}
+
+	if(directory.empty())
+		return;
+
+	try
+	{
+		if(index_changed)
+			WriteIndex();
+
+		std::vector<std::tuple<std::filesystem::file_time_type, uint64_t, std::filesystem::path>> entries;
+		uint64_t total_size = 0;
+		for(auto& entry : std::filesystem::directory_iterator(directory))
+		{
+			if(!entry.is_regular_file() || entry.path().extension() != ".module")
+				continue;
+			entries.push_back(std::make_tuple(entry.last_write_time(), entry.file_size(), entry.path()));
+			total_size += entry.file_size();
+		}
+
+		if(total_size <= maximum_size)
+			return;
+
+		std::sort(entries.begin(), entries.end());
+		for(auto& entry : entries)
+		{
+			if(total_size <= maximum_size)
+				break;
+			Linker::Debug << "Debug: removing least recently used module cache entry " << std::get<2>(entry) << std::endl;
+			std::filesystem::remove(std::get<2>(entry));
+			total_size -= std::get<1>(entry);
+		}
+	}
+	catch(std::filesystem::filesystem_error& error)
+	{
+		Linker::Warning << "Warning: unable to update module cache: " << error.what() << std::endl;
+	}
+}
+
+std::string ModuleCache::GetBuildId()
+{
+	std::error_code error;
+	/* only available on Linux */
+	std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+	if(!error)
+	{
+		offset_t size = std::filesystem::file_size(executable, error);
+		if(!error)
+		{
+			int64_t modification_time = std::filesystem::last_write_time(executable, error).time_since_epoch().count();
+			if(!error)
+			{
+				std::ostringstream id;
+				id << std::hex << size << ':' << modification_time;
+				return id.str();
+			}
+		}
+	}
+	return __DATE__ " " __TIME__;
+}
+
+uint64_t ModuleCache::HashFile(std::filesystem::path path)
+{
+	std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+	{
+		Linker::FatalError("Fatal error: Unable to open file " + path.string());
+	}
+	uint64_t hash = Hash(nullptr, 0);
+	std::vector<char> buffer(0x10000);
+	while(in)
+	{
+		in.read(buffer.data(), buffer.size());
+		hash = Hash(buffer.data(), in.gcount(), hash);
+	}
+	return hash;
+}
+
+ModuleCache::file_status ModuleCache::GetFileStatus(std::string file_name)
+{
+	std::filesystem::path path = std::filesystem::absolute(Linker::ResolvePath(file_name));
+	offset_t size = std::filesystem::file_size(path);
+	int64_t modification_time = std::filesystem::last_write_time(path).time_since_epoch().count();
+
+	auto it = index.find(path.string());
+	if(it != index.end() && it->second.size == size && it->second.modification_time == modification_time)
+	{
+		return it->second;
+	}
+
+	file_status status = { size, modification_time, HashFile(path) };
+	index[path.string()] = status;
+	index_changed = true;
+	return status;
+}
+
+std::filesystem::path ModuleCache::GetEntryPath(const file_status& status) const
+{
+	std::ostringstream key;
+	key << std::hex << status.content_hash << ':' << status.size << ':' << format_name << ':' << special_char << ':' << build_id;
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << Hash(key.str().data(), key.str().size()) << ".module";
+	return directory / name.str();
+}
+
+bool ModuleCache::ReadEntry(const std::filesystem::path& entry_path, std::string& contents)
+{
+	auto it = resident_entries.find(entry_path.string());
+	if(it != resident_entries.end())
+	{
+		contents = it->second.contents;
+		return true;
+	}
+
+	if(directory.empty())
+		return false;
+
+	std::ifstream in(entry_path, std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+		return false;
+	contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return true;
+}
+
+void ModuleCache::KeepResident(const std::filesystem::path& entry_path, std::string contents)
+{
+	resident_entry& entry = resident_entries[entry_path.string()];
+	entry.contents = std::move(contents);
+	entry.last_use = ++use_counter;
+}
+
+void ModuleCache::ReadIndex()
+{
+	std::ifstream in(directory / "index", std::ios_base::in | std::ios_base::binary);
+	if(!in.is_open())
+		return;
+	try
+	{
+		Reader rd(::LittleEndian, &in);
+		if(rd.ReadData(4) != "RLMI" || rd.ReadUnsigned(4) != Version)
+			return;
+		uint32_t count = rd.ReadUnsigned(4);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			std::string file_name = ReadString(rd);
+			file_status status;
+			status.size = rd.ReadUnsigned(8);
+			status.modification_time = rd.ReadUnsigned(8);
+			status.content_hash = rd.ReadUnsigned(8);
+			index[file_name] = status;
+		}
+	}
+	catch(Linker::Exception& exception)
+	{
+		Linker::Warning << "Warning: ignoring damaged module cache index: " << exception.message << std::endl;
+		index.clear();
+	}
+}
+
+void ModuleCache::WriteIndex()
+{
+	/* files that no longer exist are dropped, to keep the index from growing indefinitely */
+	for(auto it = index.begin(); it != index.end();)
+	{
+		if(std::filesystem::exists(it->first))
+			++it;
+		else
+			it = index.erase(it);
+	}
+
+	std::filesystem::path index_path = directory / "index";
+	std::filesystem::path temporary_path = index_path;
+	temporary_path += ".tmp";
+	std::ofstream out(temporary_path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if(!out.is_open())
+	{
+		Linker::Warning << "Warning: unable to write module cache index" << std::endl;
+		return;
+	}
+	Writer wr(::LittleEndian, &out);
+	wr.WriteData("RLMI");
+	wr.WriteWord(4, Version);
+	wr.WriteWord(4, index.size());
+	for(auto& it : index)
+	{
+		WriteString(wr, it.first);
+		wr.WriteWord(8, it.second.size);
+		wr.WriteWord(8, it.second.modification_time);
+		wr.WriteWord(8, it.second.content_hash);
+	}
+	out.close();
+	std::filesystem::rename(temporary_path, index_path);
+	index_changed = false;
+}
+
+bool ModuleCache::WriteModule(Writer& wr, const Module& module, std::string file_name)
+{
+	std::map<const Section *, uint32_t> section_indexes;
+	for(auto& section : module.sections)
+	{
+		/* format specific section types carry extra state that is not stored */
+		const Section& section_object = *section;
+		if(typeid(section_object) != typeid(Section))
+			return false;
+		uint32_t section_index = section_indexes.size();
+		section_indexes[section.get()] = section_index;
+	}
+
+	if(file_name != "" && module.file_name.rfind(file_name, 0) == 0)
+	{
+		/* archive members are named after the archive, which might be loaded under another name */
+		wr.WriteWord(1, 1);
+		WriteString(wr, module.file_name.substr(file_name.size()));
+	}
+	else
+	{
+		wr.WriteWord(1, 0);
+		WriteString(wr, module.file_name);
+	}
+	wr.WriteWord(1, module.is_library);
+	wr.WriteWord(1, module.cpu);
+	wr.WriteWord(1, module.endiantype);
+
+	wr.WriteWord(4, module.sections.size());
+	for(auto& section : module.sections)
+	{
+		WriteString(wr, section->name);
+		WriteString(wr, section->collection_name);
+		wr.WriteWord(4, section->flags);
+		if(section->IsZeroFilled())
+		{
+			wr.WriteWord(8, section->size);
+		}
+		else
+		{
+			wr.WriteWord(8, section->data.size());
+			wr.WriteData(section->data);
+		}
+		wr.WriteWord(8, section->IsFixed() ? section->address : section->align);
+		wr.WriteWord(8, section->bias);
+		WriteResourceIdentifier(wr, section->resource_type);
+		WriteResourceIdentifier(wr, section->resource_id);
+		WriteResourceIdentifier(wr, section->resource_language);
+	}
+
+	wr.WriteWord(4, module.symbol_sequence.size());
+	for(auto& symbol : module.symbol_sequence)
+	{
+		if(!WriteSymbolDefinition(wr, symbol, section_indexes))
+			return false;
+	}
+
+	for(auto * symbols : { &module.global_symbols, &module.local_symbols })
+	{
+		wr.WriteWord(4, symbols->size());
+		for(auto& symbol : *symbols)
+		{
+			WriteString(wr, symbol.first);
+			if(!WriteSymbolDefinition(wr, symbol.second, section_indexes))
+				return false;
+		}
+	}
+
+	wr.WriteWord(4, module.imported_symbols.size());
+	for(auto& symbol : module.imported_symbols)
+	{
+		if(!WriteSymbolName(wr, symbol))
+			return false;
+	}
+
+	wr.WriteWord(4, module.exported_symbols.size());
+	for(auto& symbol : module.exported_symbols)
+	{
+		std::string name;
+		uint16_t ordinal = 0;
+		symbol.first.LoadName(name);
+		if(symbol.first.IsExportedByOrdinal())
+		{
+			wr.WriteWord(1, 2);
+			symbol.first.LoadOrdinalOrHint(ordinal);
+		}
+		else if(symbol.first.LoadOrdinalOrHint(ordinal))
+		{
+			wr.WriteWord(1, 1);
+		}
+		else
+		{
+			wr.WriteWord(1, 0);
+		}
+		WriteString(wr, name);
+		wr.WriteWord(2, ordinal);
+		if(!WriteLocation(wr, symbol.second, section_indexes))
+			return false;
+	}
+
+	wr.WriteWord(4, module.relocations.size());
+	for(auto& relocation : module.relocations)
+	{
+		wr.WriteWord(1, relocation.kind);
+		wr.WriteWord(1, relocation.size);
+		if(!WriteLocation(wr, relocation.source, section_indexes)
+		|| !WriteTarget(wr, relocation.target, section_indexes)
+		|| !WriteTarget(wr, relocation.reference, section_indexes))
+			return false;
+		wr.WriteWord(8, relocation.addend);
+		wr.WriteWord(1, relocation.endiantype);
+		wr.WriteWord(1, relocation.shift);
+		wr.WriteWord(1, relocation.adjusted_shift);
+		wr.WriteWord(8, relocation.mask);
+		wr.WriteWord(1, relocation.subtract);
+	}
+
+	return true;
+}
+
+bool ModuleCache::ReadModule(Reader& rd, Module& module, std::string file_name)
+{
+	bool is_relative_name = rd.ReadUnsigned(1);
+	module.file_name = is_relative_name ? file_name + ReadString(rd) : ReadString(rd);
+	bool is_library = rd.ReadUnsigned(1);
+	module.cpu = Module::cpu_type(rd.ReadUnsigned(1));
+	module.endiantype = ::EndianType(rd.ReadUnsigned(1));
+
+	uint32_t section_count = rd.ReadUnsigned(4);
+	for(uint32_t i = 0; i < section_count; i++)
+	{
+		std::shared_ptr<Section> section = std::make_shared<Section>(ReadString(rd));
+		section->collection_name = ReadString(rd);
+		section->flags = Section::section_flags(rd.ReadUnsigned(4));
+		if(section->IsZeroFilled())
+		{
+			section->size = rd.ReadUnsigned(8);
+		}
+		else
+		{
+			section->data.resize(rd.ReadUnsigned(8));
+			rd.ReadData(section->data);
+		}
+		if(section->IsFixed())
+			section->address = rd.ReadUnsigned(8);
+		else
+			section->align = rd.ReadUnsigned(8);
+		section->bias = rd.ReadUnsigned(8);
+		section->resource_type = ReadResourceIdentifier(rd);
+		section->resource_id = ReadResourceIdentifier(rd);
+		section->resource_language = ReadResourceIdentifier(rd);
+
+		module.sections.push_back(section);
+		if(section->name != "" && module.section_names.find(section->name) == module.section_names.end())
+			module.section_names[section->name] = section;
+	}
+
+	uint32_t symbol_count = rd.ReadUnsigned(4);
+	for(uint32_t i = 0; i < symbol_count; i++)
+	{
+		module.symbol_sequence.push_back(ReadSymbolDefinition(rd, module.sections));
+	}
+
+	for(auto * symbols : { &module.global_symbols, &module.local_symbols })
+	{
+		uint32_t count = rd.ReadUnsigned(4);
+		for(uint32_t i = 0; i < count; i++)
+		{
+			std::string name = ReadString(rd);
+			(*symbols)[name] = ReadSymbolDefinition(rd, module.sections);
+		}
+	}
+
+	uint32_t import_count = rd.ReadUnsigned(4);
+	for(uint32_t i = 0; i < import_count; i++)
+	{
+		module.imported_symbols.push_back(ReadSymbolName(rd));
+	}
+
+	uint32_t export_count = rd.ReadUnsigned(4);
+	for(uint32_t i = 0; i < export_count; i++)
+	{
+		int kind = rd.ReadUnsigned(1);
+		std::string name = ReadString(rd);
+		uint16_t ordinal = rd.ReadUnsigned(2);
+		Location location = ReadLocation(rd, module.sections);
+		switch(kind)
+		{
+		case 0:
+			module.exported_symbols.emplace(ExportedSymbolName(name), location);
+			break;
+		case 1:
+			module.exported_symbols.emplace(ExportedSymbolName(name, ordinal), location);
+			break;
+		case 2:
+			module.exported_symbols.emplace(ExportedSymbolName(ordinal, name), location);
+			break;
+		default:
+			Linker::FatalError("Fatal error: invalid exported symbol in module cache entry");
+		}
+	}
+
+	uint32_t relocation_count = rd.ReadUnsigned(4);
+	for(uint32_t i = 0; i < relocation_count; i++)
+	{
+		Relocation relocation = Relocation::Empty();
+		relocation.kind = Relocation::reference_kind(rd.ReadUnsigned(1));
+		relocation.size = rd.ReadUnsigned(1);
+		relocation.source = ReadLocation(rd, module.sections);
+		relocation.target = ReadTarget(rd, module.sections);
+		relocation.reference = ReadTarget(rd, module.sections);
+		relocation.addend = rd.ReadUnsigned(8);
+		relocation.endiantype = ::EndianType(rd.ReadUnsigned(1));
+		relocation.shift = int8_t(rd.ReadUnsigned(1));
+		relocation.adjusted_shift = rd.ReadUnsigned(1);
+		relocation.mask = rd.ReadUnsigned(8);
+		relocation.subtract = rd.ReadUnsigned(1);
+		module.relocation_indexes[relocation.source] = module.relocations.size();
+		module.relocations.push_back(relocation);
+	}
+
+	return is_library;
+}
+
+void ModuleCache::WriteString(Writer& wr, const std::string& text)
+{
+	wr.WriteWord(4, text.size());
+	wr.WriteData(text);
+}
+
+std::string ModuleCache::ReadString(Reader& rd)
+{
+	return rd.ReadData(rd.ReadUnsigned(4));
+}
+
+void ModuleCache::WriteResourceIdentifier(Writer& wr, const ResourceIdentifier& identifier)
+{
+	if(auto * name = std::get_if<ResourceIdentifier_String>(&identifier))
+	{
+		wr.WriteWord(1, 0);
+		WriteString(wr, *name);
+	}
+	else
+	{
+		wr.WriteWord(1, 1);
+		wr.WriteWord(4, std::get<ResourceIdentifier_Integer>(identifier));
+	}
+}
+
+ResourceIdentifier ModuleCache::ReadResourceIdentifier(Reader& rd)
+{
+	if(rd.ReadUnsigned(1) == 0)
+		return ReadString(rd);
+	else
+		return ResourceIdentifier_Integer(rd.ReadUnsigned(4));
+}
+
+bool ModuleCache::WriteLocation(Writer& wr, const Location& location, const std::map<const Section *, uint32_t>& section_indexes)
+{
+	if(location.section == nullptr)
+	{
+		wr.WriteWord(4, uint32_t(-1));
+	}
+	else
+	{
+		auto it = section_indexes.find(location.section.get());
+		if(it == section_indexes.end())
+			return false; /* section of another module */
+		wr.WriteWord(4, it->second);
+	}
+	wr.WriteWord(8, location.offset);
+	return true;
+}
+
+Location ModuleCache::ReadLocation(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections)
+{
+	uint32_t section_index = rd.ReadUnsigned(4);
+	offset_t offset = rd.ReadUnsigned(8);
+	if(section_index == uint32_t(-1))
+		return Location(offset);
+	if(section_index >= sections.size())
+		Linker::FatalError("Fatal error: invalid section index in module cache entry");
+	return Location(sections[section_index], offset);
+}
+
+bool ModuleCache::WriteSymbolName(Writer& wr, const SymbolName& name)
+{
+	std::string library, symbol;
+	uint16_t hint = 0;
+	bool has_library = name.LoadLibraryName(library);
+	bool has_name = name.LoadName(symbol);
+	bool has_hint = name.LoadOrdinalOrHint(hint);
+	if(!has_library && (!has_name || has_hint))
+		return false; /* no constructor creates such a symbol */
+	wr.WriteWord(1, (has_library ? 1 : 0) | (has_name ? 2 : 0) | (has_hint ? 4 : 0));
+	WriteString(wr, library);
+	WriteString(wr, symbol);
+	wr.WriteWord(2, hint);
+	wr.WriteWord(8, name.addend);
+	return true;
+}
+
+SymbolName ModuleCache::ReadSymbolName(Reader& rd)
+{
+	int parts = rd.ReadUnsigned(1);
+	std::string library = ReadString(rd);
+	std::string symbol = ReadString(rd);
+	uint16_t hint = rd.ReadUnsigned(2);
+	offset_t addend = rd.ReadUnsigned(8);
+
+	SymbolName name(symbol);
+	switch(parts)
+	{
+	case 2:
+		break;
+	case 1:
+		name = SymbolName(library, SymbolName::IsLibrary);
+		break;
+	case 1 | 2:
+		name = SymbolName(library, symbol);
+		break;
+	case 1 | 4:
+		name = SymbolName(library, hint);
+		break;
+	case 1 | 2 | 4:
+		name = SymbolName(library, symbol, hint);
+		break;
+	default:
+		Linker::FatalError("Fatal error: invalid symbol name in module cache entry");
+	}
+	name.addend = addend;
+	return name;
+}
+
+bool ModuleCache::WriteTarget(Writer& wr, const Target& target, const std::map<const Section *, uint32_t>& section_indexes)
+{
+	wr.WriteWord(1, target.segment_of);
+	if(auto * location = std::get_if<Location>(&target.target))
+	{
+		wr.WriteWord(1, 0);
+		return WriteLocation(wr, *location, section_indexes);
+	}
+	else
+	{
+		wr.WriteWord(1, 1);
+		return WriteSymbolName(wr, std::get<SymbolName>(target.target));
+	}
+}
+
+Target ModuleCache::ReadTarget(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections)
+{
+	bool segment_of = rd.ReadUnsigned(1);
+	if(rd.ReadUnsigned(1) == 0)
+		return Target(ReadLocation(rd, sections), segment_of);
+	else
+		return Target(ReadSymbolName(rd), segment_of);
+}
+
+bool ModuleCache::WriteSymbolDefinition(Writer& wr, const SymbolDefinition& symbol, const std::map<const Section *, uint32_t>& section_indexes)
+{
+	WriteString(wr, symbol.name);
+	wr.WriteWord(1, symbol.binding);
+	if(!WriteLocation(wr, symbol.location, section_indexes))
+		return false;
+	wr.WriteWord(8, symbol.size);
+	wr.WriteWord(8, symbol.align);
+	WriteString(wr, symbol.section_name);
+	WriteString(wr, symbol.alternative_section_name);
+	return true;
+}
+
+SymbolDefinition ModuleCache::ReadSymbolDefinition(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections)
+{
+	SymbolDefinition symbol;
+	symbol.name = ReadString(rd);
+	symbol.binding = SymbolDefinition::binding_type(rd.ReadUnsigned(1));
+	symbol.location = ReadLocation(rd, sections);
+	symbol.size = rd.ReadUnsigned(8);
+	symbol.align = rd.ReadUnsigned(8);
+	symbol.section_name = ReadString(rd);
+	symbol.alternative_section_name = ReadString(rd);
+	return symbol;
+}
+
@@ -0,0 +1,160 @@
+#ifndef MODULE_CACHE_H
+#define MODULE_CACHE_H
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../common.h"
+#include "module.h"
+#include "reader.h"
+#include "section.h"
+#include "writer.h"
+
+namespace Linker
+{
+	class ModuleCollector;
+
+	/**
+	 * @brief An on-disk cache of the modules generated from input files, so that unchanged inputs do not have to be parsed again
+	 *
+	 * Each entry holds all the modules generated from a single input file (several for archives), along with their sections, symbols, relocations, imports and exports.
+	 * Entries are keyed by a hash of the file contents, the name of the output format and the special character, since the latter two influence how modules are generated.
+	 * The key also includes an identifier of the linker build, since a different build might parse the same input differently.
+	 * An index maps file names to their size, modification time and content hash, so that files whose size and modification time did not change are not read at all.
+	 * The total size of the entries is kept below a limit by removing the least recently used ones.
+	 *
+	 * A damaged or stale entry is never an error: it is treated as missing and the input file is parsed as usual.
+	 *
+	 * A resident cache also keeps the entries it loaded or stored in memory, so that a long running process (see LinkServer) can reuse them without accessing the disk.
+	 * Every Load decodes a fresh copy of the modules, since they are modified while combined into the output module.
+	 * If the directory is empty, the cache only exists in memory.
+	 */
+	class ModuleCache
+	{
+	public:
+		/** @brief Default limit for the total size of the entries, in bytes */
+		static constexpr uint64_t DefaultMaximumSize = uint64_t(64) << 20;
+		/** @brief Version of the entry and index layout, files with any other version are ignored */
+		static constexpr uint32_t Version = 2;
+
+		/** @brief Directory holding the entries and the index */
+		std::filesystem::path directory;
+		/** @brief Name of the output format, as given on the command line */
+		std::string format_name;
+		/** @brief The special character used to parse extended symbol names */
+		char special_char;
+		/** @brief Identifies the linker build that generated the modules, entries of other builds are ignored */
+		std::string build_id;
+		/** @brief Limit for the total size of the entries, in bytes, applied separately to the directory and to the entries kept in memory */
+		uint64_t maximum_size;
+		/** @brief Set if entries are kept in memory between calls to Load */
+		bool resident;
+
+		ModuleCache(std::filesystem::path directory, std::string format_name, char special_char, uint64_t maximum_size = DefaultMaximumSize, bool resident = false);
+
+		/**
+		 * @brief Adds the modules of an input file to the collector, if a valid entry exists for the current contents of the file
+		 *
+		 * @return False if the file has to be parsed, in which case Store should be called afterwards
+		 */
+		bool Load(ModuleCollector& linker, std::string file_name);
+
+		/**
+		 * @brief Creates an entry from the modules that the collector received from an input file
+		 *
+		 * @param first_module Index of the first module in the collector that was generated from the file
+		 */
+		void Store(const ModuleCollector& linker, std::string file_name, size_t first_module);
+
+		/**
+		 * @brief Writes the index and removes the least recently used entries until the cache fits its size limit
+		 *
+		 * For a resident cache, this also applies to the entries kept in memory.
+		 */
+		void Flush();
+
+		/**
+		 * @brief Identifies the running linker build
+		 *
+		 * The size and modification time of the executable are used when it can be located, otherwise the time the cache was compiled.
+		 */
+		static std::string GetBuildId();
+
+		/**
+		 * @brief Calculates the hash of a file's contents
+		 */
+		static uint64_t HashFile(std::filesystem::path path);
+
+		/**
+		 * @brief Encodes a module that has been generated from an input file
+		 *
+		 * @param file_name The input file, module names starting with it are stored relative to it
+		 * @return False if the module contains something that the cache cannot represent, such as format specific section types
+		 */
+		static bool WriteModule(Writer& wr, const Module& module, std::string file_name);
+
+		/**
+		 * @brief Decodes a module written by WriteModule into an empty module
+		 *
+		 * @param file_name The input file the module is now being loaded for
+		 * @return Whether the module was added to the collector as a library member
+		 */
+		static bool ReadModule(Reader& rd, Module& module, std::string file_name);
+
+	private:
+		/** @brief What is known about an input file */
+		struct file_status
+		{
+			offset_t size;
+			int64_t modification_time;
+			uint64_t content_hash;
+		};
+
+		/** @brief Maps absolute file names to the status they had when last hashed */
+		std::map<std::string, file_status> index;
+		bool index_changed = false;
+
+		/** @brief An entry kept in memory by a resident cache */
+		struct resident_entry
+		{
+			std::string contents;
+			/** @brief Value of use_counter when the entry was last loaded or stored */
+			uint64_t last_use;
+		};
+
+		/** @brief Maps entry paths to their contents, for a resident cache */
+		std::map<std::string, resident_entry> resident_entries;
+		uint64_t use_counter = 0;
+
+		/** @brief Fetches the contents of an entry, from memory or from the directory, returns false if the entry does not exist */
+		bool ReadEntry(const std::filesystem::path& entry_path, std::string& contents);
+		/** @brief Records an entry in memory, for a resident cache */
+		void KeepResident(const std::filesystem::path& entry_path, std::string contents);
+
+		/** @brief Looks up the status of a file, hashing its contents only if its size or modification time changed */
+		file_status GetFileStatus(std::string file_name);
+
+		/** @brief Path of the entry for a file with the given status */
+		std::filesystem::path GetEntryPath(const file_status& status) const;
+
+		void ReadIndex();
+		void WriteIndex();
+
+		static void WriteString(Writer& wr, const std::string& text);
+		static std::string ReadString(Reader& rd);
+		static void WriteResourceIdentifier(Writer& wr, const ResourceIdentifier& identifier);
+		static ResourceIdentifier ReadResourceIdentifier(Reader& rd);
+		static bool WriteLocation(Writer& wr, const Location& location, const std::map<const Section *, uint32_t>& section_indexes);
+		static Location ReadLocation(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections);
+		static bool WriteSymbolName(Writer& wr, const SymbolName& name);
+		static SymbolName ReadSymbolName(Reader& rd);
+		static bool WriteTarget(Writer& wr, const Target& target, const std::map<const Section *, uint32_t>& section_indexes);
+		static Target ReadTarget(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections);
+		static bool WriteSymbolDefinition(Writer& wr, const SymbolDefinition& symbol, const std::map<const Section *, uint32_t>& section_indexes);
+		static SymbolDefinition ReadSymbolDefinition(Reader& rd, const std::vector<std::shared_ptr<Section>>& sections);
+	};
+}
+
+#endif /* MODULE_CACHE_H */
@@ -1,4 +1,5 @@
 
+#include "memory_usage.h"
 #include "module.h"
 #include "module_collector.h"
 #include "symbol_name.h"
@@ -24,6 +25,7 @@ void ModuleCollector::AddModule(std::shared_ptr<Module> module, bool is_library)
 	/* attempts to resolve as many relocations as possible */
 	/* this is needed because local symbols can get lost or duplicated, but segment references are still stored as references to symbol names */
 	module->ResolveLocalRelocations();
+	module->is_library = is_library;
 	modules.push_back(module);
 	for(auto& symbol_definition : module->global_symbols)
 	{
@@ -122,6 +124,17 @@ void ModuleCollector::CombineModulesInto(Module& output_module)
 	}
 }
 
+void ModuleCollector::AccountMemory(MemoryUsage& usage) const
+{
+	usage.AddVector("modules", modules);
+	for(auto& module : modules)
+	{
+		module->AccountMemory(usage);
+	}
+	usage.AddMap("symbol index", symbol_definitions);
+	usage.Add("symbol index", required_symbols.size() * (sizeof(std::string) + MemoryUsage::MapNodeOverhead));
+}
+
 void ModuleCollector::IncludeModule(std::shared_ptr<Module> module)
 {
 	if(module->is_included)
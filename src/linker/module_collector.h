@@ -12,6 +12,7 @@
 
 namespace Linker
 {
+	class MemoryUsage;
 	class Module;
 	class InputFormat;
 	class OutputFormat;
@@ -78,6 +79,11 @@ namespace Linker
 		 */
 		void CombineModulesInto(Module& output_module);
 
+		/**
+		 * @brief Adds the memory held by the collected modules and the symbol index to a measurement
+		 */
+		void AccountMemory(MemoryUsage& usage) const;
+
 	private:
 		/**
 		 * @brief Makes a module included in the linking process. The module must have already been added to the modules vector
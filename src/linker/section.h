@@ -11,6 +11,7 @@
 
 namespace Linker
 {
+	class ModuleCache;
 	class Position;
 	class Reader;
 	class Segment;
@@ -157,6 +158,8 @@ namespace Linker
 		{
 		}
 
+		friend class ModuleCache;
+
 		static std::shared_ptr<Section> ReadFromFile(Reader& rd, std::string name, int flags = Readable);
 		static std::shared_ptr<Section> ReadFromFile(Reader& rd, offset_t count, std::string name, int flags = Readable);
 
@@ -111,24 +111,39 @@ offset_t Segment::WriteFile(std::ostream& out, offset_t size, offset_t offset) c
 }
 
 offset_t Segment::WriteFile(std::ostream& out) const
+{
+	return WriteFile(out, ImageSize());
+}
+
+offset_t Segment::WriteFile(Writer& wr, offset_t size, offset_t offset) const
 {
 	offset_t count = 0;
 	for(auto& section : sections)
 	{
 		if(!section->IsZeroFilled())
-			count += section->WriteFile(out);
+		{
+			if(offset > section->ImageSize())
+			{
+				offset -= section->ImageSize();
+			}
+			else
+			{
+				offset_t written = section->WriteFile(wr, size, offset);
+				offset = 0;
+				count += written;
+				if(size < written)
+					return count;
+				else
+					size -= written;
+			}
+		}
 	}
 	return count;
 }
 
-offset_t Segment::WriteFile(Writer& wr, offset_t count, offset_t offset) const
-{
-	return WriteFile(*wr.out, count, offset);
-}
-
 offset_t Segment::WriteFile(Writer& wr) const
 {
-	return WriteFile(*wr.out);
+	return WriteFile(wr, ImageSize());
 }
 
 void Segment::WriteData(size_t bytes, offset_t offset, const void * buffer)
@@ -1,6 +1,7 @@
 
 #include <set>
 #include <sstream>
+#include "memory_usage.h"
 #include "module.h"
 #include "position.h"
 #include "relocation.h"
@@ -22,6 +23,16 @@ void SegmentManager::ClearSegmentManager()
 	linker_parameters.clear();
 }
 
+void SegmentManager::AccountMemory(MemoryUsage& usage) const
+{
+	usage.AddVector("segments", segment_vector);
+	usage.AddMap("segments", segment_map);
+	for(auto& segment : segment_vector)
+	{
+		usage.AddContents("section data", segment);
+	}
+}
+
 void SegmentManager::SetLinkScript(std::string script_file, std::map<std::string, std::string>& options)
 {
 	if(script_file != "")
@@ -49,7 +60,7 @@ void SegmentManager::SetLinkScript(std::string script_file, std::map<std::string
 std::unique_ptr<Script::List> SegmentManager::GetScript(Linker::Module& module)
 {
 	bool file_error = false;
-	std::unique_ptr<Script::List> list = Script::parse_file(linker_script.c_str(), file_error);
+	std::unique_ptr<Script::List> list = Script::parse_file(Linker::ResolvePath(linker_script).c_str(), file_error);
 	if(file_error)
 	{
 		std::ostringstream message;
@@ -94,6 +94,11 @@ namespace Linker
 		 */
 		void SetLinkScript(std::string script_file, std::map<std::string, std::string>& options) override;
 
+		/**
+		 * @brief Adds the memory held by the segments to a measurement
+		 */
+		void AccountMemory(MemoryUsage& usage) const override;
+
 		/**
 		 * @brief Compiles the linker script into an internal format
 		 */
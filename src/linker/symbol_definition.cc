@@ -38,6 +38,21 @@ SymbolDefinition SymbolDefinition::CreateCommon(std::string name, std::string se
 	return SymbolDefinition(name, Common, Location(), 0, 1, section, alternative_section);
 }
 
+SymbolDefinition SymbolDefinition::CreateLocalCommon(std::string name, std::string section, offset_t size, offset_t align)
+{
+	return SymbolDefinition(name, LocalCommon, Location(), size, align, section);
+}
+
+SymbolDefinition SymbolDefinition::CreateLocalCommon(std::string name, std::string section, offset_t size, offset_t align, std::string alternative_section)
+{
+	return SymbolDefinition(name, LocalCommon, Location(), size, align, section, alternative_section);
+}
+
+SymbolDefinition SymbolDefinition::CreateLocalCommon(std::string name, std::string section, std::string alternative_section)
+{
+	return SymbolDefinition(name, LocalCommon, Location(), 0, 1, section, alternative_section);
+}
+
 bool SymbolDefinition::IsLocal() const
 {
 	return binding == Local || binding == LocalCommon;
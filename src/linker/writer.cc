@@ -1,11 +1,20 @@
 
 #include <cstring>
+#include "checksum.h"
 #include "writer.h"
 
 using namespace Linker;
 
 void Writer::WriteData(size_t count, const void * data)
 {
+	if(checksums.size() != 0)
+	{
+		offset_t offset = Tell();
+		for(Checksum * checksum : checksums)
+		{
+			checksum->Update(*this, offset, reinterpret_cast<const uint8_t *>(data), count);
+		}
+	}
 	out->write(reinterpret_cast<const char *>(data), count);
 }
 
@@ -39,7 +48,7 @@ void Writer::WriteData(size_t count, std::string text, char padding)
 	{
 		memcpy(data.data(), text.c_str(), count);
 	}
-	out->write(data.data(), count);
+	WriteData(count, data.data());
 }
 
 void Writer::WriteData(std::string text)
@@ -59,7 +68,7 @@ void Writer::WriteData(size_t count, std::istream& in)
 			byte_count = count;
 //Linker::Debug << "Write " << byte_count << " for total " << count << std::endl;
 		in.read(buffer.data(), byte_count);
-		out->write(buffer.data(), byte_count);
+		WriteData(byte_count, buffer.data());
 		count -= byte_count;
 	}
 }
@@ -149,3 +158,17 @@ void Writer::AlignTo(offset_t align)
 	FillTo(::AlignTo(Tell(), align));
 }
 
+bool Writer::ReadBack(offset_t offset, size_t count, uint8_t * data)
+{
+	std::istream * in = dynamic_cast<std::istream *>(out);
+	if(in == nullptr)
+		return false;
+	offset_t position = Tell();
+	in->seekg(offset);
+	in->read(reinterpret_cast<char *>(data), count);
+	bool success = size_t(in->gcount()) == count;
+	in->clear();
+	out->seekp(position);
+	return success;
+}
+
@@ -8,6 +8,8 @@
 
 namespace Linker
 {
+	class Checksum;
+
 	/**
 	 * @brief A helper class, encapsulating functionality needed to export binary data
 	 */
@@ -22,6 +24,10 @@ namespace Linker
 		 * @brief The output stream
 		 */
 		std::ostream * out;
+		/**
+		 * @brief Checksums that get updated with every byte written, see Checksum
+		 */
+		std::vector<Checksum *> checksums;
 
 		Writer(EndianType endiantype, std::ostream * out = nullptr)
 			: endiantype(endiantype), out(out)
@@ -112,6 +118,13 @@ namespace Linker
 		 * @brief Align the current pointer
 		 */
 		void AlignTo(offset_t align);
+
+		/**
+		 * @brief Reads back data that has already been written, if the output stream is also an input stream
+		 *
+		 * @return False if the data could not be read
+		 */
+		bool ReadBack(offset_t offset, size_t count, uint8_t * data);
 	};
 }
 
@@ -0,0 +1,142 @@
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/dumper/dumper.h"
+#include "../../src/linker/section.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestDumperBlock : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestDumperBlock);
+	CPPUNIT_TEST(testPlainRows);
+	CPPUNIT_TEST(testAnsiRows);
+	CPPUNIT_TEST(testAlignedRows);
+	CPPUNIT_TEST(testTextColumn);
+	CPPUNIT_TEST(testAnsiTextColumn);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies the plain text rows of an unaligned block with file offsets and segment positions, signals marked with brackets */
+	void testPlainRows();
+	/** @brief Verifies the same rows when signals are underlined with ANSI escape sequences */
+	void testAnsiRows();
+	/** @brief Verifies the rows of an aligned block at address 0, with neither file offsets nor segment positions */
+	void testAlignedRows();
+	/** @brief Verifies the text column using the default encoding, including unprintable characters */
+	void testTextColumn();
+	/** @brief Verifies the text column using code page 437, with signals underlined in both columns */
+	void testAnsiTextColumn();
+
+	std::string render(bool use_ansi, offset_t offset, offset_t address, Dumper::SingleByteEncoding * encoding = nullptr);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestDumperBlock::testPlainRows()
+{
+	std::string expected =
+		"== Block\n"
+		"\tOffset:\t0x0200\n"
+		"\tLength:\t0x0025\n"
+		"\tAddress:\t0x1003\n"
+		"[FILE    ]\t(SEGMENT )\tMEMORY  \tDATA\n"
+		"[00000200]\t(00000000)\t00001003\t          1c 23 2a 31 38  [3f 46 4d 54]5b 62 69[70\t    \n"
+		"[0000020d]\t(0000000d)\t00001010\t 77 7e 85 8c 93]9a a1 a8   af b6 bd c4 cb d2 d9 e0\t \n"
+		"[0000021d]\t(0000001d)\t00001020\t e7 ee f5[fc 03]0a 11 18                          \t         \n";
+	CPPUNIT_ASSERT_EQUAL(expected, render(false, 0x0200, 0x1003));
+}
+
+void TestDumperBlock::testAnsiRows()
+{
+	std::string expected =
+		"== Block\n"
+		"\tOffset:\t0x0200\n"
+		"\tLength:\t0x0025\n"
+		"\tAddress:\t0x1003\n"
+		"[FILE    ]\t(SEGMENT )\tMEMORY  \tDATA\n"
+		"[00000200]\t(00000000)\t00001003\t         1c 23 2a 31 38   \x1B[4m3f 46 4d 54\x1B[m 5b 62 69 \x1B[4m70\x1B[m\t    \x1B[4m\x1B[m\x1B[4m\x1B[m\n"
+		"[0000020d]\t(0000000d)\t00001010\t\x1B[4m77 7e 85 8c 93\x1B[m 9a a1 a8   af b6 bd c4 cb d2 d9 e0\t\x1B[4m\x1B[m \n"
+		"[0000021d]\t(0000001d)\t00001020\te7 ee f5 \x1B[4mfc 03\x1B[m 0a 11 18                          \t\x1B[4m\x1B[m         \n";
+	CPPUNIT_ASSERT_EQUAL(expected, render(true, 0x0200, 0x1003));
+}
+
+void TestDumperBlock::testAlignedRows()
+{
+	std::string expected =
+		"== Block\n"
+		"\tOffset:\t0x0000\n"
+		"\tLength:\t0x0025\n"
+		"\tAddress:\t0x0000\n"
+		"MEMORY  \tDATA\n"
+		"00000000\t 1c 23 2a 31 38[3f 46 4d   54]5b 62 69[70 77 7e 85\t \n"
+		"00000010\t 8c 93]9a a1 a8 af b6 bd   c4 cb d2 d9 e0 e7 ee f5\t \n"
+		"00000020\t[fc 03]0a 11 18                                   \t            \n";
+	CPPUNIT_ASSERT_EQUAL(expected, render(false, 0, 0));
+}
+
+void TestDumperBlock::testTextColumn()
+{
+	std::string expected =
+		"== Block\n"
+		"\tOffset:\t0x0000\n"
+		"\tLength:\t0x0025\n"
+		"\tAddress:\t0x0100\n"
+		"(SEGMENT )\tMEMORY  \tDATA\n"
+		"(00000000)\t00000100\t 1c 23 2a 31 38[3f 46 4d   54]5b 62 69[70 77 7e 85\t\xE2\x90\x9C#*18?FM T[bipw~\xEF\xBF\xBD\n"
+		"(00000010)\t00000110\t 8c 93]9a a1 a8 af b6 bd   c4 cb d2 d9 e0 e7 ee f5\t\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD \xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\n"
+		"(00000020)\t00000120\t[fc 03]0a 11 18                                   \t\xEF\xBF\xBD\xE2\x90\x83\xE2\x90\x8A\xE2\x90\x91\xE2\x90\x98            \n";
+	CPPUNIT_ASSERT_EQUAL(expected, render(false, 0, 0x0100, &Dumper::Block::encoding_default));
+}
+
+void TestDumperBlock::testAnsiTextColumn()
+{
+	std::string expected =
+		"== Block\n"
+		"\tOffset:\t0x0000\n"
+		"\tLength:\t0x0025\n"
+		"\tAddress:\t0x0100\n"
+		"(SEGMENT )\tMEMORY  \tDATA\n"
+		"(00000000)\t00000100\t1c 23 2a 31 38 \x1B[4m3f 46 4d   54\x1B[m 5b 62 69 \x1B[4m70 77 7e 85\x1B[m\t\xE2\x88\x9F#*18\x1B[4m?FM T\x1B[m[bi\x1B[4mpw~\xC3\xA0\x1B[m\n"
+		"(00000010)\t00000110\t\x1B[4m8c 93\x1B[m 9a a1 a8 af b6 bd   c4 cb d2 d9 e0 e7 ee f5\t\x1B[4m\xC3\xAE\xC3\xB4\x1B[m\xC3\x9C\xC3\xAD\xC2\xBF\xC2\xBB\xE2\x95\xA2\xE2\x95\x9C \xE2\x94\x80\xE2\x95\xA6\xE2\x95\xA5\xE2\x94\x98\xCE\xB1\xCF\x84\xCE\xB5\xE2\x8C\xA1\n"
+		"(00000020)\t00000120\t\x1B[4mfc 03\x1B[m 0a 11 18                                   \t\x1B[4m\xE2\x81\xBF\xE2\x99\xA5\x1B[m\xE2\x97\x99\xE2\x97\x84\xE2\x86\x91            \n";
+	CPPUNIT_ASSERT_EQUAL(expected, render(true, 0, 0x0100, &Dumper::Block::encoding_cp437));
+}
+
+std::string TestDumperBlock::render(bool use_ansi, offset_t offset, offset_t address, Dumper::SingleByteEncoding * encoding)
+{
+	std::shared_ptr<Section> section = std::make_shared<Section>(".data");
+	std::string data;
+	for(int i = 0; i < 0x25; i++)
+	{
+		data += char(i * 7 + 0x1C);
+	}
+	section->Append(data.c_str(), data.size());
+
+	std::ostringstream out;
+	Dumper::Dumper dump(out);
+	dump.use_ansi = use_ansi;
+	if(encoding != nullptr)
+		dump.SetEncoding(*encoding);
+
+	Dumper::Block block("Block", offset, section, address, 4);
+	block.AddSignal(0x05, 4);
+	block.AddSignal(0x0C, 6);
+	block.AddSignal(0x20, 2);
+	block.Display(dump);
+	return out.str();
+}
+
+void TestDumperBlock::setUp()
+{
+}
+
+void TestDumperBlock::tearDown()
+{
+}
+
+}
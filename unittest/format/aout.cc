@@ -0,0 +1,112 @@
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/aout.h"
+
+using namespace Linker;
+using namespace AOut;
+
+namespace UnitTests
+{
+
+class TestAOutFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestAOutFormat);
+	CPPUNIT_TEST(test32BitObject);
+	CPPUNIT_TEST(testPDP11Object);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that a 32-bit object that is also a plausible PDP-11 image is read as 32-bit, independently of the byte order of the reader, with 12 byte symbol entries */
+	void test32BitObject();
+	/** @brief Verifies that a PDP-11 object is still read as 16-bit, with 8 byte symbol entries */
+	void testPDP11Object();
+
+	void load(AOutFormat& aout, std::string data, ::EndianType endiantype);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+static std::string word16(uint16_t value)
+{
+	return std::string({ char(value), char(value >> 8) });
+}
+
+static std::string word32(uint32_t value)
+{
+	return word16(value) + word16(value >> 16);
+}
+
+void TestAOutFormat::test32BitObject()
+{
+	std::string symbols =
+		word32(4) + word32(0x05) + word32(0x0000) /* _start, external text symbol */
+		+ word32(11) + word32(0x07) + word32(0x0008); /* _data, external data symbol */
+	std::string strings = std::string("_start\0_data\0", 13);
+	std::string data =
+		word32(0x00640107) /* OMAGIC, MID_PC386 */
+		+ word32(8) + word32(4) + word32(0) + word32(symbols.size()) + word32(0) + word32(0) + word32(0)
+		+ std::string("\x55\x89\xE5\x90\x90\x90\x5D\xC3", 8)
+		+ std::string("\x01\x02\x03\x04", 4)
+		+ symbols
+		+ word32(4 + strings.size()) + strings;
+	/* large enough for the header to also describe a PDP-11 image with 0x64 bytes of code */
+	data.resize(0x100, '\0');
+
+	for(::EndianType endiantype : { ::LittleEndian, ::BigEndian })
+	{
+		AOutFormat aout;
+		load(aout, data, endiantype);
+		CPPUNIT_ASSERT_EQUAL(AOutFormat::WordSize32, aout.word_size);
+		CPPUNIT_ASSERT_EQUAL(::LittleEndian, aout.endiantype);
+		CPPUNIT_ASSERT_EQUAL(AOutFormat::I386, aout.cpu);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(8), aout.code_size);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(4), aout.data_size);
+		CPPUNIT_ASSERT_EQUAL(size_t(2), aout.symbols.size());
+		CPPUNIT_ASSERT_EQUAL(std::string("_start"), aout.symbols[0].name);
+		CPPUNIT_ASSERT_EQUAL(std::string("_data"), aout.symbols[1].name);
+		CPPUNIT_ASSERT_EQUAL(offset_t(8), aout.symbols[1].value);
+	}
+}
+
+void TestAOutFormat::testPDP11Object()
+{
+	std::string symbols =
+		word16(0) + word16(0) + word16(0x22) + word16(0x0000) /* _start, external text symbol */
+		+ word16(0) + word16(7) + word16(0x23) + word16(0x0004); /* _data, external data symbol */
+	std::string data =
+		word16(0x0107) + word16(4) + word16(2) + word16(0) + word16(symbols.size()) + word16(0) + word16(0) + word16(1) /* no relocations */
+		+ std::string("\xC0\x15\x87\x00", 4)
+		+ std::string("\x01\x02", 2)
+		+ symbols
+		+ std::string("_start\0_data\0", 13);
+
+	AOutFormat aout;
+	load(aout, data, ::LittleEndian);
+	CPPUNIT_ASSERT_EQUAL(AOutFormat::WordSize16, aout.word_size);
+	CPPUNIT_ASSERT_EQUAL(::PDP11Endian, aout.endiantype);
+	CPPUNIT_ASSERT_EQUAL(uint32_t(4), aout.code_size);
+	CPPUNIT_ASSERT_EQUAL(uint32_t(2), aout.data_size);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), aout.symbols.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("_start"), aout.symbols[0].name);
+	CPPUNIT_ASSERT_EQUAL(std::string("_data"), aout.symbols[1].name);
+	CPPUNIT_ASSERT_EQUAL(offset_t(4), aout.symbols[1].value);
+}
+
+void TestAOutFormat::load(AOutFormat& aout, std::string data, ::EndianType endiantype)
+{
+	std::istringstream in(data);
+	Reader rd(endiantype, &in);
+	CPPUNIT_ASSERT_NO_THROW(aout.ReadFile(rd));
+}
+
+void TestAOutFormat::setUp()
+{
+}
+
+void TestAOutFormat::tearDown()
+{
+}
+
+}
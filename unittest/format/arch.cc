@@ -0,0 +1,119 @@
+
+#include <iomanip>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/arch.h"
+#include "../../src/format/binary.h"
+#include "../../src/linker/module_collector.h"
+
+using namespace Linker;
+using namespace Archive;
+
+namespace UnitTests
+{
+
+class TestArchiveFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestArchiveFormat);
+	CPPUNIT_TEST(testMemberOptions);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that the output format passed to the archive reaches every member before its module is generated */
+	void testMemberOptions();
+
+	std::string member(std::string name, std::string data);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+/**
+ * @brief Archive member that records the options it receives
+ */
+class RecordingFormat : public virtual InputFormat
+{
+public:
+	std::shared_ptr<OutputFormat> output_format;
+	mutable std::vector<std::string> generated_modules;
+
+	void ReadFile(Reader& rd) override
+	{
+	}
+
+	using InputFormat::WriteFile;
+	offset_t WriteFile(Writer& wr) const override
+	{
+		return 0;
+	}
+
+	void SetupOptions(std::shared_ptr<OutputFormat> format) override
+	{
+		output_format = format;
+	}
+
+	using InputFormat::GenerateModule;
+	void GenerateModule(ModuleCollector& linker, std::string file_name, bool is_library = false) const override
+	{
+		/* the options must be set up before the module is generated */
+		CPPUNIT_ASSERT(output_format != nullptr);
+		CPPUNIT_ASSERT(is_library);
+		generated_modules.push_back(file_name);
+	}
+};
+
+class RecordingReader : public ArchiveFormat::FileReader
+{
+public:
+	std::vector<std::shared_ptr<RecordingFormat>> members;
+
+	std::shared_ptr<Contents> ReadFile(Reader& rd, offset_t size) override
+	{
+		members.push_back(std::make_shared<RecordingFormat>());
+		return members.back();
+	}
+};
+
+void TestArchiveFormat::testMemberOptions()
+{
+	std::string data = "!<arch>\n" + member("first.o/", "\x01\x02\x03") + member("second.o/", "\x04\x05");
+	std::shared_ptr<RecordingReader> reader = std::make_shared<RecordingReader>();
+	std::shared_ptr<ArchiveFormat> archive = std::make_shared<ArchiveFormat>(reader);
+
+	std::istringstream in(data);
+	Reader rd(::LittleEndian, &in);
+	archive->ReadFile(rd);
+	CPPUNIT_ASSERT_EQUAL(size_t(2), reader->members.size());
+
+	std::shared_ptr<OutputFormat> format = std::make_shared<Binary::BinaryFormat>(0, "");
+	archive->SetupOptions(format);
+	ModuleCollector linker;
+	archive->GenerateModule(linker, "lib.a");
+
+	for(auto& member : reader->members)
+	{
+		CPPUNIT_ASSERT(member->output_format == format);
+	}
+	CPPUNIT_ASSERT(reader->members[0]->generated_modules == std::vector<std::string>({ "lib.a:first.o" }));
+	CPPUNIT_ASSERT(reader->members[1]->generated_modules == std::vector<std::string>({ "lib.a:second.o" }));
+}
+
+std::string TestArchiveFormat::member(std::string name, std::string data)
+{
+	std::ostringstream out;
+	out.setf(std::ios_base::left, std::ios_base::adjustfield);
+	out << std::setw(16) << name << std::setw(12) << 0 << std::setw(6) << 0 << std::setw(6) << 0 << std::setw(8) << 644 << std::setw(10) << data.size() << "`\n" << data;
+	if((data.size() & 1) != 0)
+		out << '\n';
+	return out.str();
+}
+
+void TestArchiveFormat::setUp()
+{
+}
+
+void TestArchiveFormat::tearDown()
+{
+}
+
+}
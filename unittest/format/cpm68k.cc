@@ -0,0 +1,139 @@
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/cpm68k.h"
+
+using namespace Linker;
+using namespace DigitalResearch;
+
+namespace UnitTests
+{
+
+class TestCPM68KFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestCPM68KFormat);
+	CPPUNIT_TEST(testCrunchedEncoding);
+	CPPUNIT_TEST(testCrunchedRoundTrip);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies every distance encoding of crunched relocations */
+	void testCrunchedEncoding();
+	/** @brief Verifies that crunched relocations written by the generator are decoded by the reader into the same relocations */
+	void testCrunchedRoundTrip();
+
+	std::string store(const CPM68KFormat& exe);
+	void load(CPM68KFormat& exe, std::string data);
+
+	std::shared_ptr<Section> make_section(std::string name, size_t size);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestCPM68KFormat::testCrunchedEncoding()
+{
+	std::map<uint32_t, size_t> relocations;
+	relocations[0x1000] = 4;   // first relocation at the start, escaped byte distance
+	relocations[0x1004] = 2;   // short distance, word relocation
+	relocations[0x1080] = 4;   // longest short distance
+	relocations[0x1100] = 4;   // byte distance
+	relocations[0x1500] = 2;   // word distance
+	relocations[0x21500] = 4;  // longword distance
+
+	std::vector<uint8_t> stream = CPM68KFormat::CDOS68K_CrunchRelocations(relocations, 0x1000);
+	std::vector<uint8_t> expected =
+	{
+		0x7D, 0x00,
+		0x84,
+		0x7C,
+		0x7D, 0x80,
+		0xFE, 0x04, 0x00,
+		0x7F, 0x00, 0x02, 0x00, 0x00,
+		0x00,
+	};
+	CPPUNIT_ASSERT(stream == expected);
+}
+
+void TestCPM68KFormat::testCrunchedRoundTrip()
+{
+	CPM68KFormat exe(CPM68KFormat::SYSTEM_CDOS68K, CPM68KFormat::MAGIC_CRUNCHED);
+	std::shared_ptr<Section> code = make_section(".text", 0x20200);
+	std::shared_ptr<Section> data = make_section(".data", 0x100);
+	exe.code = code;
+	exe.data = data;
+	exe.code_size = code->Size();
+	exe.data_size = data->Size();
+	exe.bss_size = 0x40;
+	exe.stack_size = 0x400;
+	exe.code_address = 0;
+
+	/* every target is in the text segment */
+	std::vector<std::pair<uint32_t, size_t>> sources =
+	{
+		{ 0x0000, 4 }, { 0x0004, 2 }, { 0x0006, 4 }, { 0x0100, 4 }, { 0x0202, 2 },
+		{ 0x3000, 4 }, { 0x20000, 4 }, { 0x201FC, 2 }, { 0x20200 + 0x10, 4 },
+	};
+	for(auto& source : sources)
+	{
+		exe.relocations[source.first] = CPM68KFormat::Relocation{source.second, 2};
+		if(source.first < code->Size())
+			code->WriteWord(source.second, source.first, 0x0010, ::BigEndian);
+		else
+			data->WriteWord(source.second, source.first - code->Size(), 0x0010, ::BigEndian);
+	}
+	exe.relocations_suppressed = 0;
+
+	exe.CalculateValues();
+	std::string image = store(exe);
+	CPPUNIT_ASSERT_EQUAL(size_t(exe.ImageSize()), image.size());
+	CPPUNIT_ASSERT_EQUAL(char(0x1C), image[1]);
+	/* the relocations are much smaller than the word per word form */
+	CPPUNIT_ASSERT(exe.crunched_relocations.size() < 4 * sources.size());
+
+	CPM68KFormat loaded;
+	load(loaded, image);
+	CPPUNIT_ASSERT_EQUAL(CPM68KFormat::SYSTEM_CDOS68K, loaded.system);
+	CPPUNIT_ASSERT_EQUAL(CPM68KFormat::MAGIC_CRUNCHED, loaded.GetSignature());
+	CPPUNIT_ASSERT_EQUAL(sources.size(), loaded.relocations.size());
+	for(auto& source : sources)
+	{
+		auto it = loaded.relocations.find(source.first);
+		CPPUNIT_ASSERT(it != loaded.relocations.end());
+		CPPUNIT_ASSERT_EQUAL(source.second, it->second.size);
+		CPPUNIT_ASSERT_EQUAL(2u, it->second.segment);
+	}
+}
+
+std::string TestCPM68KFormat::store(const CPM68KFormat& exe)
+{
+	std::ostringstream out;
+	Writer wr(::BigEndian, &out);
+	exe.WriteFile(wr);
+	return out.str();
+}
+
+void TestCPM68KFormat::load(CPM68KFormat& exe, std::string data)
+{
+	std::istringstream in(data);
+	Reader rd(::BigEndian, &in);
+	CPPUNIT_ASSERT_NO_THROW(exe.ReadFile(rd));
+}
+
+std::shared_ptr<Section> TestCPM68KFormat::make_section(std::string name, size_t size)
+{
+	std::shared_ptr<Section> section = std::make_shared<Section>(name);
+	std::string data(size, '\0');
+	section->Append(data.c_str(), data.size());
+	return section;
+}
+
+void TestCPM68KFormat::setUp()
+{
+}
+
+void TestCPM68KFormat::tearDown()
+{
+}
+
+}
@@ -0,0 +1,202 @@
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/gsos.h"
+
+using namespace Linker;
+using namespace Apple;
+
+namespace UnitTests
+{
+
+class TestGSOSFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestGSOSFormat);
+	CPPUNIT_TEST(testSuperRecord);
+	CPPUNIT_TEST(testRelocationCompaction);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	OMFFormat::Segment segment;
+
+	/** @brief Verifies that SUPER records survive a write and read cycle, including long page skips */
+	void testSuperRecord();
+	/** @brief Verifies that compaction shrinks the relocation dictionary without changing the relocations it describes */
+	void testRelocationCompaction();
+
+	std::string store(const OMFFormat::Segment::Record& record);
+	std::unique_ptr<OMFFormat::Segment::Record> load(std::string data);
+
+	offset_t relocation_dictionary_size();
+	std::vector<OMFFormat::Segment::IntersegmentRelocationRecord> relocations();
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestGSOSFormat::testSuperRecord()
+{
+	OMFFormat::Segment::SuperCompactRecord super_record(OMFFormat::Segment::Record::OPC_SUPER, OMFFormat::Segment::SuperCompactRecord::SUPER_RELOC2);
+	super_record.offsets = { 0x0002, 0x0010, 0x0110, 0x0300, 0x9004, 0x9105, 0xFFFE };
+
+	std::string data = store(super_record);
+	CPPUNIT_ASSERT_EQUAL(size_t(super_record.GetLength(segment)), data.size());
+	/* header, pages 0 and 1, skip to page 3, skip to page 0x90 in two steps, page 0x91, skip to page 0xFF */
+	CPPUNIT_ASSERT_EQUAL(size_t(6 + 3 + 2 + (1 + 2) + (2 + 2) + 2 + (1 + 2)), data.size());
+
+	std::unique_ptr<OMFFormat::Segment::Record> record = load(data);
+	CPPUNIT_ASSERT(record != nullptr);
+	CPPUNIT_ASSERT_EQUAL(OMFFormat::Segment::Record::OPC_SUPER, record->type);
+	OMFFormat::Segment::SuperCompactRecord& loaded_record = dynamic_cast<OMFFormat::Segment::SuperCompactRecord&>(*record);
+	CPPUNIT_ASSERT_EQUAL(OMFFormat::Segment::SuperCompactRecord::SUPER_RELOC2, loaded_record.super_type);
+	CPPUNIT_ASSERT(loaded_record.offsets == super_record.offsets);
+}
+
+void TestGSOSFormat::testRelocationCompaction()
+{
+	std::vector<uint8_t> data(0x300, 0);
+	/* intrasegment, target stored in image */
+	data[0x10] = 0x34; data[0x11] = 0x12;
+	data[0x210] = 0x00; data[0x211] = 0x01;
+	data[0x30] = 0x78; data[0x31] = 0x56; data[0x32] = 0x00;
+	/* intersegment, target and segment stored in image */
+	data[0x40] = 0x10; data[0x41] = 0x00; data[0x42] = 0x03;
+	data[0x50] = 0x20; data[0x51] = 0x00;
+
+	segment.records.push_back(segment.makeLCONST(std::make_shared<Buffer>(data)));
+	segment.records.push_back(segment.makeRELOC(2, 0, 0x0010, 0x1234));
+	segment.records.push_back(segment.makeRELOC(2, 0, 0x0210, 0x0100));
+	segment.records.push_back(segment.makeRELOC(2, 0, 0x0020, 0x0055)); // image does not contain target
+	segment.records.push_back(segment.makeRELOC(3, 0, 0x0030, 0x5678));
+	segment.records.push_back(segment.makeINTERSEG(3, 0, 0x0040, 1, 3, 0x0010));
+	segment.records.push_back(segment.makeINTERSEG(2, -16, 0x0050, 1, 2, 0x0020));
+	segment.records.push_back(segment.makeINTERSEG(2, 0, 0x0060, 2, 1, 0x0000)); // image does not contain target, different file
+	segment.records.push_back(segment.makeRELOC(4, 0, 0x0070, 0x12345)); // target too large
+	segment.records.push_back(segment.makeEND());
+
+	std::vector<OMFFormat::Segment::IntersegmentRelocationRecord> old_relocations = relocations();
+	offset_t old_size = relocation_dictionary_size();
+
+	segment.CompactRelocations();
+
+	std::vector<OMFFormat::Segment::IntersegmentRelocationRecord> new_relocations = relocations();
+	offset_t new_size = relocation_dictionary_size();
+
+	CPPUNIT_ASSERT(new_size < old_size);
+	CPPUNIT_ASSERT_EQUAL(old_relocations.size(), new_relocations.size());
+	for(auto& old_relocation : old_relocations)
+	{
+		bool found = false;
+		for(auto& new_relocation : new_relocations)
+		{
+			if(old_relocation.size == new_relocation.size
+			&& old_relocation.shift == new_relocation.shift
+			&& old_relocation.source == new_relocation.source
+			&& old_relocation.target == new_relocation.target
+			&& old_relocation.file_number == new_relocation.file_number
+			&& old_relocation.segment_number == new_relocation.segment_number)
+			{
+				found = true;
+				break;
+			}
+		}
+		CPPUNIT_ASSERT(found);
+	}
+
+	size_t super_count = 0;
+	for(auto& record : segment.records)
+	{
+		CPPUNIT_ASSERT(record->type != OMFFormat::Segment::Record::OPC_C_RELOC || dynamic_cast<OMFFormat::Segment::RelocationRecord&>(*record).source == 0x0020);
+		if(record->type == OMFFormat::Segment::Record::OPC_SUPER)
+			super_count++;
+	}
+	/* RELOC2, RELOC3, INTERSEG1, INTERSEG26 */
+	CPPUNIT_ASSERT_EQUAL(size_t(4), super_count);
+	CPPUNIT_ASSERT_EQUAL(OMFFormat::Segment::Record::OPC_LCONST, segment.records.front()->type);
+	CPPUNIT_ASSERT_EQUAL(OMFFormat::Segment::Record::OPC_END, segment.records.back()->type);
+}
+
+std::string TestGSOSFormat::store(const OMFFormat::Segment::Record& record)
+{
+	std::ostringstream out;
+	Writer wr(::LittleEndian, &out);
+	record.WriteFile(segment, wr);
+	return out.str();
+}
+
+std::unique_ptr<OMFFormat::Segment::Record> TestGSOSFormat::load(std::string data)
+{
+	std::istringstream in(data);
+	Reader rd(::LittleEndian, &in);
+	return segment.ReadRecord(rd);
+}
+
+offset_t TestGSOSFormat::relocation_dictionary_size()
+{
+	offset_t size = 0;
+	for(auto& record : segment.records)
+	{
+		switch(record->type)
+		{
+		case OMFFormat::Segment::Record::OPC_RELOC:
+		case OMFFormat::Segment::Record::OPC_INTERSEG:
+		case OMFFormat::Segment::Record::OPC_C_RELOC:
+		case OMFFormat::Segment::Record::OPC_C_INTERSEG:
+		case OMFFormat::Segment::Record::OPC_SUPER:
+			size += record->GetLength(segment);
+			break;
+		default:
+			break;
+		}
+	}
+	return size;
+}
+
+std::vector<OMFFormat::Segment::IntersegmentRelocationRecord> TestGSOSFormat::relocations()
+{
+	std::vector<OMFFormat::Segment::IntersegmentRelocationRecord> result;
+	for(auto& record : segment.records)
+	{
+		switch(record->type)
+		{
+		case OMFFormat::Segment::Record::OPC_RELOC:
+		case OMFFormat::Segment::Record::OPC_C_RELOC:
+			{
+				OMFFormat::Segment::RelocationRecord& relocation = dynamic_cast<OMFFormat::Segment::RelocationRecord&>(*record);
+				result.emplace_back(OMFFormat::Segment::Record::OPC_INTERSEG, relocation.size, relocation.shift, relocation.source, 1, 0, relocation.target);
+			}
+			break;
+		case OMFFormat::Segment::Record::OPC_INTERSEG:
+		case OMFFormat::Segment::Record::OPC_C_INTERSEG:
+			result.push_back(dynamic_cast<OMFFormat::Segment::IntersegmentRelocationRecord&>(*record));
+			break;
+		case OMFFormat::Segment::Record::OPC_SUPER:
+			{
+				OMFFormat::Segment::SuperCompactRecord& super_record = dynamic_cast<OMFFormat::Segment::SuperCompactRecord&>(*record);
+				OMFFormat::Segment::IntersegmentRelocationRecord relocation;
+				for(unsigned i = 0; super_record.GetRelocation(relocation, i, segment); i++)
+				{
+					result.push_back(relocation);
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return result;
+}
+
+void TestGSOSFormat::setUp()
+{
+	segment.version = OMFFormat::Segment::OMF_VERSION_2;
+	segment.number_length = 4;
+	segment.endiantype = 0;
+}
+
+void TestGSOSFormat::tearDown()
+{
+	segment.records.clear();
+}
+
+}
@@ -0,0 +1,91 @@
+
+#include <filesystem>
+#include <fstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/leexe.h"
+
+using namespace Linker;
+using namespace Microsoft;
+
+namespace UnitTests
+{
+
+class TestLEFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestLEFormat);
+	CPPUNIT_TEST(testFixupSizes);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that fixups which need 32-bit target offsets are written with the sizes used to lay out the fixup record table */
+	void testFixupSizes();
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestLEFormat::testFixupSizes()
+{
+	std::shared_ptr<LEFormat> format = LEFormat::CreateConsoleApplication(LEFormat::DOS4G)->SimulateLinker(LEFormat::CompatibleWatcom);
+
+	Module input("fixups.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append(std::string(0x10, '\x90').c_str(), 0x10);
+	input.AddSection(text);
+	std::shared_ptr<Section> bss = std::make_shared<Section>(".bss", Section::Readable | Section::Writable | Section::ZeroFilled);
+	bss->Expand(0x20000);
+	input.AddSection(bss);
+	input.AddGlobalSymbol("_start", Location(text, 0));
+	/* the first target offset does not fit 16 bits, the second record is only found if the first one was written with the expected size */
+	input.AddRelocation(Relocation::Absolute(4, Location(text, 0), Target(Location(bss, 0x12345)), 0, ::LittleEndian));
+	input.AddRelocation(Relocation::Absolute(4, Location(text, 8), Target(Location(bss, 0x10)), 0, ::LittleEndian));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", options);
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "unittest_fixups.exe";
+	format->GenerateFile(path.string(), module);
+
+	std::shared_ptr<LEFormat> loaded = std::make_shared<LEFormat>();
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		CPPUNIT_ASSERT(in.is_open());
+		Reader rd(::LittleEndian, &in);
+		loaded->ReadFile(rd);
+	}
+	std::filesystem::remove(path);
+
+	CPPUNIT_ASSERT(loaded->objects.size() >= 2);
+	auto& relocations = loaded->pages[LEFormat::PhysicalPageNumber(1)].relocations;
+	CPPUNIT_ASSERT_EQUAL(size_t(2), relocations.size());
+
+	LEFormat::Page::Relocation& far_relocation = relocations[0];
+	CPPUNIT_ASSERT(far_relocation.flags & LEFormat::Page::Relocation::Target32);
+	CPPUNIT_ASSERT_EQUAL(uint32_t(0x12345), far_relocation.target);
+
+	LEFormat::Page::Relocation& near_relocation = relocations[8];
+	CPPUNIT_ASSERT(!(near_relocation.flags & LEFormat::Page::Relocation::Target32));
+	CPPUNIT_ASSERT_EQUAL(far_relocation.module, near_relocation.module);
+}
+
+void TestLEFormat::setUp()
+{
+}
+
+void TestLEFormat::tearDown()
+{
+}
+
+}
@@ -18,6 +18,7 @@ class TestMZFormat : public CppUnit::TestFixture
 	CPPUNIT_TEST(testEXEHeaderValues);
 	CPPUNIT_TEST(testEXERelocations);
 	CPPUNIT_TEST(testEXEHeaderSize);
+	CPPUNIT_TEST(testEXECompression);
 	CPPUNIT_TEST_SUITE_END();
 private:
 	MZFormat exe;
@@ -29,6 +30,7 @@ private:
 	void testEXEHeaderValues();
 	void testEXERelocations();
 	void testEXEHeaderSize();
+	void testEXECompression();
 
 	std::string store();
 	void load(std::string data);
@@ -290,6 +292,85 @@ void TestMZFormat::testEXEHeaderSize()
 	test_image(data);
 }
 
+void TestMZFormat::testEXECompression()
+{
+	std::vector<MZFormat::Relocation> relocations;
+	std::string data;
+
+	static const uint16_t cs = 0x0010;
+	static const uint16_t ip = 0x0004;
+	static const uint16_t ss = 0x01C0;
+	static const uint16_t sp = 0x0100;
+
+	/* mix of literal data, runs and relocations */
+
+	data = generate_image(0x300) + std::string(0x1000, '\0') + generate_image(0x200) + std::string(0x800, '\x90');
+	relocations.push_back(MZFormat::Relocation(0x0000, 0x0010));
+	relocations.push_back(MZFormat::Relocation(0x0020, 0x0004));
+	relocations.push_back(MZFormat::Relocation(0x0130, 0x0002));
+
+	exe.Clear();
+	set_image(data);
+	exe.relocations = relocations;
+	exe.cs = cs;
+	exe.ip = ip;
+	exe.ss = ss;
+	exe.sp = sp;
+	exe.CalculateValues();
+	size_t uncompressed_size = store().size();
+
+	exe.Clear();
+	set_image(data);
+	exe.relocations = relocations;
+	exe.cs = cs;
+	exe.ip = ip;
+	exe.ss = ss;
+	exe.sp = sp;
+	CPPUNIT_ASSERT(exe.Compress());
+	exe.CalculateValues();
+	std::string compressed = store();
+	CPPUNIT_ASSERT(compressed.size() < uncompressed_size);
+
+	load(compressed);
+	CPPUNIT_ASSERT_EQUAL(MZFormat::MAGIC_MZ, exe.GetSignature());
+	CPPUNIT_ASSERT(exe.IsCompressed());
+	CPPUNIT_ASSERT_EQUAL(size_t(0), exe.relocations.size());
+	CPPUNIT_ASSERT(exe.min_extra_paras >= (data.size() >> 4) - ((exe.ImageSize() - exe.GetHeaderSize()) >> 4));
+
+	CPPUNIT_ASSERT(exe.Decompress());
+	CPPUNIT_ASSERT_EQUAL(cs, exe.cs);
+	CPPUNIT_ASSERT_EQUAL(ip, exe.ip);
+	CPPUNIT_ASSERT_EQUAL(ss, exe.ss);
+	CPPUNIT_ASSERT_EQUAL(sp, exe.sp);
+	CPPUNIT_ASSERT_EQUAL(relocations.size(), exe.relocations.size());
+	for(size_t i = 0; i < relocations.size(); i++)
+	{
+		CPPUNIT_ASSERT_EQUAL(relocations[i].GetOffset(), exe.relocations[i].GetOffset());
+	}
+	std::shared_ptr<Linker::Buffer> buffer = std::dynamic_pointer_cast<Linker::Buffer>(exe.image);
+	assert(buffer != nullptr); /* internal check */
+	CPPUNIT_ASSERT_EQUAL(offset_t(data.size()), buffer->ImageSize());
+	for(uint32_t i = 0; i < data.size(); i++)
+	{
+		CPPUNIT_ASSERT_EQUAL(data[i] & 0xFF, buffer->GetByte(i) & 0xFF);
+	}
+
+	/* incompressible data is left alone */
+
+	data = generate_image(0x100);
+	exe.Clear();
+	set_image(data);
+	exe.cs = cs;
+	exe.ip = ip;
+	CPPUNIT_ASSERT(!exe.Compress());
+	exe.CalculateValues();
+	load(store());
+	CPPUNIT_ASSERT(!exe.IsCompressed());
+	CPPUNIT_ASSERT_EQUAL(cs, exe.cs);
+	CPPUNIT_ASSERT_EQUAL(ip, exe.ip);
+	test_image(data);
+}
+
 void TestMZFormat::setUp()
 {
 	exe.Clear();
@@ -0,0 +1,240 @@
+#include <filesystem>
+#include <fstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/neexe.h"
+
+using namespace Linker;
+using namespace Microsoft;
+
+namespace UnitTests
+{
+
+class TestNEFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestNEFormat);
+	CPPUNIT_TEST(testFastLoadArea);
+	CPPUNIT_TEST(testChainableRelocations);
+	CPPUNIT_TEST(testChainedRelocations);
+	CPPUNIT_TEST(testChainedIterated);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that the fast-load area covers every preload segment along with its relocations, and nothing that is loaded on demand */
+	void testFastLoadArea();
+	/** @brief Verifies that only relocations with identical, chainable properties are collected into a single record */
+	void testChainableRelocations();
+	/** @brief Verifies that chained relocations are threaded through the segment data and read back as the same relocations */
+	void testChainedRelocations();
+	/** @brief Verifies that segments with chained relocations are not stored as iterated data */
+	void testChainedIterated();
+
+	/** @brief Contents of the file generated by the last call to link */
+	std::string file_contents;
+
+	/** @brief Links a Windows application with a code segment, a data segment and a resource, then reads it back */
+	std::shared_ptr<NEFormat> link(std::map<std::string, std::string> options);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestNEFormat::testFastLoadArea()
+{
+	std::shared_ptr<NEFormat> plain = link({ });
+	CPPUNIT_ASSERT(!(plain->additional_flags & NEFormat::FAST_LOAD_AREA));
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0), plain->fast_load_area_offset);
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0), plain->fast_load_area_length);
+
+	std::shared_ptr<NEFormat> loaded = link({ { "gangload", "" } });
+	CPPUNIT_ASSERT(loaded->additional_flags & NEFormat::FAST_LOAD_AREA);
+	offset_t area_start = offset_t(loaded->fast_load_area_offset) << loaded->sector_shift;
+	offset_t area_end = area_start + (offset_t(loaded->fast_load_area_length) << loaded->sector_shift);
+	CPPUNIT_ASSERT(loaded->fast_load_area_length != 0);
+	CPPUNIT_ASSERT(area_end <= loaded->file_size);
+
+	size_t preload_count = 0;
+	for(auto& segment : loaded->segments)
+	{
+		CPPUNIT_ASSERT(segment->flags & NEFormat::Segment::Preload);
+		preload_count++;
+		/* the segment data is followed by the relocation count and records */
+		offset_t segment_end = segment->data_offset + segment->image_size;
+		if(segment->flags & NEFormat::Segment::Relocations)
+			segment_end += 2 + 8 * segment->relocations.size();
+		CPPUNIT_ASSERT(segment->data_offset >= area_start);
+		CPPUNIT_ASSERT(segment_end <= area_end);
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(2), preload_count);
+	CPPUNIT_ASSERT(loaded->segments[0]->relocations.size() != 0);
+
+	/* resources are loaded on demand under Windows */
+	size_t resource_count = 0;
+	for(auto& resource_type : loaded->resource_types)
+	{
+		for(auto& resource : resource_type->resources)
+		{
+			CPPUNIT_ASSERT(!(resource->flags & NEFormat::Segment::Preload));
+			CPPUNIT_ASSERT(resource->data_offset >= area_end);
+			resource_count++;
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(1), resource_count);
+
+	/* the segment and resource contents do not depend on their placement */
+	CPPUNIT_ASSERT_EQUAL(plain->segments.size(), loaded->segments.size());
+	for(size_t i = 0; i < loaded->segments.size(); i++)
+	{
+		CPPUNIT_ASSERT_EQUAL(plain->segments[i]->image_size, loaded->segments[i]->image_size);
+		CPPUNIT_ASSERT_EQUAL(plain->segments[i]->relocations.size(), loaded->segments[i]->relocations.size());
+	}
+}
+
+void TestNEFormat::testChainableRelocations()
+{
+	typedef NEFormat::Segment::Relocation Relocation;
+	CPPUNIT_ASSERT(Relocation(Relocation::Selector16, Relocation::Internal, 0, 2, 0).IsChainable());
+	CPPUNIT_ASSERT(Relocation(Relocation::Offset16, Relocation::ImportOrdinal, 0, 1, 5).IsChainable());
+	CPPUNIT_ASSERT(Relocation(Relocation::Pointer32, Relocation::ImportName, 0, 1, 8).IsChainable());
+	CPPUNIT_ASSERT(!Relocation(Relocation::Offset8, Relocation::Internal, 0, 2, 0).IsChainable());
+	CPPUNIT_ASSERT(!Relocation(Relocation::Offset32, Relocation::Internal, 0, 2, 0).IsChainable());
+	CPPUNIT_ASSERT(!Relocation(Relocation::Selector16, Relocation::Internal | Relocation::Additive, 0, 2, 0).IsChainable());
+	CPPUNIT_ASSERT(!Relocation(Relocation::Offset16, Relocation::OSFixup, 0, Relocation::FIARQQ, 0).IsChainable());
+
+	NEFormat::Segment segment;
+	segment.AddRelocation(Relocation(Relocation::Selector16, Relocation::Internal, 0x10, 2, 0));
+	segment.AddRelocation(Relocation(Relocation::Selector16, Relocation::Internal, 0x04, 2, 0));
+	segment.AddRelocation(Relocation(Relocation::Selector16, Relocation::Internal, 0x08, 3, 0));
+	segment.AddRelocation(Relocation(Relocation::Selector16, Relocation::Internal | Relocation::Additive, 0x0C, 2, 0));
+	segment.AddRelocation(Relocation(Relocation::Selector16, Relocation::Internal, 0x20, 2, 0));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(0), segment.CollectRelocations(false));
+	CPPUNIT_ASSERT_EQUAL(size_t(5), segment.relocations.size());
+
+	/* chains are ordered by offset, starting at the lowest one */
+	CPPUNIT_ASSERT_EQUAL(size_t(2), segment.CollectRelocations(true));
+	CPPUNIT_ASSERT_EQUAL(size_t(3), segment.relocations.size());
+	CPPUNIT_ASSERT(segment.relocations[0].offsets == std::vector<uint16_t>({ 0x04, 0x10, 0x20 }));
+	CPPUNIT_ASSERT(segment.relocations[1].offsets == std::vector<uint16_t>({ 0x08 }));
+	CPPUNIT_ASSERT_EQUAL(uint16_t(3), segment.relocations[1].module);
+	CPPUNIT_ASSERT(segment.relocations[2].offsets == std::vector<uint16_t>({ 0x0C }));
+	CPPUNIT_ASSERT(segment.relocations[2].flags & Relocation::Additive);
+}
+
+void TestNEFormat::testChainedRelocations()
+{
+	std::shared_ptr<NEFormat> plain = link({ });
+	std::shared_ptr<NEFormat> chained = link({ { "chain", "" } });
+	std::shared_ptr<NEFormat::Segment> code = chained->segments[0];
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), plain->segments[0]->relocations.size());
+	CPPUNIT_ASSERT_EQUAL(size_t(1), code->relocations.size());
+	CPPUNIT_ASSERT_EQUAL(plain->file_size - 2 * 8, chained->file_size);
+
+	/* the reader follows the chain through the segment data */
+	NEFormat::Segment::Relocation& relocation = code->relocations[0];
+	CPPUNIT_ASSERT(relocation.offsets == std::vector<uint16_t>({ 0x01, 0x05, 0x09 }));
+	for(auto& plain_relocation : plain->segments[0]->relocations)
+	{
+		CPPUNIT_ASSERT_EQUAL(relocation.type, plain_relocation.type);
+		CPPUNIT_ASSERT_EQUAL(relocation.flags, plain_relocation.flags);
+		CPPUNIT_ASSERT_EQUAL(relocation.module, plain_relocation.module);
+		CPPUNIT_ASSERT_EQUAL(relocation.target, plain_relocation.target);
+	}
+
+	/* the links are written into the segment data after the record table */
+	CPPUNIT_ASSERT_EQUAL(std::string("\x05\x00", 2), file_contents.substr(code->data_offset + 0x01, 2));
+	CPPUNIT_ASSERT_EQUAL(std::string("\x09\x00", 2), file_contents.substr(code->data_offset + 0x05, 2));
+	CPPUNIT_ASSERT_EQUAL(std::string("\xFF\xFF", 2), file_contents.substr(code->data_offset + 0x09, 2));
+	CPPUNIT_ASSERT_EQUAL(std::string("\x01\x00", 2), file_contents.substr(code->data_offset + code->image_size, 2));
+}
+
+void TestNEFormat::testChainedIterated()
+{
+	std::shared_ptr<NEFormat> iterated = link({ { "iterate", "" } });
+	CPPUNIT_ASSERT(iterated->segments[0]->flags & NEFormat::Segment::Iterated);
+	CPPUNIT_ASSERT(iterated->segments[1]->flags & NEFormat::Segment::Iterated);
+
+	std::shared_ptr<NEFormat> chained = link({ { "iterate", "" }, { "chain", "" } });
+	CPPUNIT_ASSERT(!(chained->segments[0]->flags & NEFormat::Segment::Iterated));
+	CPPUNIT_ASSERT(chained->segments[1]->flags & NEFormat::Segment::Iterated);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), chained->segments[0]->relocations.size());
+	CPPUNIT_ASSERT(chained->segments[0]->relocations[0].offsets == std::vector<uint16_t>({ 0x01, 0x05, 0x09 }));
+	CPPUNIT_ASSERT_EQUAL(size_t(3), iterated->segments[0]->relocations.size());
+
+	NEFormat::Segment segment(nullptr, 0);
+	segment.image = std::make_shared<Buffer>(std::vector<uint8_t>(0x40, 0x90));
+	segment.AddRelocation(NEFormat::Segment::Relocation(NEFormat::Segment::Relocation::Selector16, NEFormat::Segment::Relocation::Internal, 0x04, 2, 0));
+	segment.AddRelocation(NEFormat::Segment::Relocation(NEFormat::Segment::Relocation::Selector16, NEFormat::Segment::Relocation::Internal, 0x10, 2, 0));
+	segment.CollectRelocations(true);
+	CPPUNIT_ASSERT(!segment.MakeIterated());
+	CPPUNIT_ASSERT(!(segment.flags & NEFormat::Segment::Iterated));
+	segment.CollectRelocations(false);
+	CPPUNIT_ASSERT(segment.MakeIterated());
+	CPPUNIT_ASSERT(segment.flags & NEFormat::Segment::Iterated);
+}
+
+std::shared_ptr<NEFormat> TestNEFormat::link(std::map<std::string, std::string> options)
+{
+	std::shared_ptr<NEFormat> format = NEFormat::CreateGUIApplication(NEFormat::Windows);
+
+	Module input("program.o");
+	input.cpu = Module::I86;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> code = std::make_shared<Section>(".code", Section::Readable | Section::Executable);
+	code->Append(std::string(0x30, '\x90').c_str(), 0x30);
+	input.AddSection(code);
+	std::shared_ptr<Section> data = std::make_shared<Section>(".data", Section::Readable | Section::Writable);
+	data->Append(std::string(0x20, '\x01').c_str(), 0x20);
+	input.AddSection(data);
+	std::shared_ptr<Section> resource = std::make_shared<Section>(".rsrc", Section::Readable | Section::Resource);
+	resource->Append(std::string(0x40, '\x02').c_str(), 0x40);
+	resource->resource_type = uint32_t(2);
+	resource->resource_id = uint32_t(1);
+	input.AddSection(resource);
+	input.AddGlobalSymbol(".entry", Location(code, 0));
+	/* selectors to the data segment, so that the code segment has relocations that can be chained */
+	for(offset_t offset : { 1, 5, 9 })
+	{
+		input.AddRelocation(Relocation::Absolute(2, Location(code, offset), Target(Location(data, 0)).GetSegment(), 0, ::LittleEndian));
+	}
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I86;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> script_parameters;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", script_parameters);
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "unittest_program.exe";
+	format->GenerateFile(path.string(), module);
+
+	std::shared_ptr<NEFormat> loaded = std::make_shared<NEFormat>();
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		CPPUNIT_ASSERT(in.is_open());
+		Reader rd(::LittleEndian, &in);
+		loaded->ReadFile(rd);
+	}
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		file_contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	std::filesystem::remove(path);
+	return loaded;
+}
+
+void TestNEFormat::setUp()
+{
+}
+
+void TestNEFormat::tearDown()
+{
+}
+
+}
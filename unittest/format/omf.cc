@@ -0,0 +1,314 @@
+
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/omf.h"
+#include "../../src/linker/module_collector.h"
+
+using namespace Linker;
+using namespace OMF;
+
+namespace UnitTests
+{
+
+class TestOMF86Format : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestOMF86Format);
+	CPPUNIT_TEST(testEnumeratedData);
+	CPPUNIT_TEST(testIteratedData);
+	CPPUNIT_TEST(testIteratedOffsets);
+	CPPUNIT_TEST(testIteratedFixups);
+	CPPUNIT_TEST(testFixupThreads);
+	CPPUNIT_TEST(testLibrary);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that LEDATA records are written into zero filled segments, along with public symbols and the start address */
+	void testEnumeratedData();
+	/** @brief Verifies that nested LIDATA blocks are expanded, including several blocks in one record and 32-bit repeat counts */
+	void testIteratedData();
+	/** @brief Verifies that every repetition of a byte inside nested iterated blocks is found */
+	void testIteratedOffsets();
+	/** @brief Verifies that a fixup inside an LIDATA record generates a relocation for each repetition */
+	void testIteratedFixups();
+	/** @brief Verifies that target and frame threads, explicit frame numbers and the source and target frame methods are converted */
+	void testFixupThreads();
+	/** @brief Verifies that the modules of a TIS library are read up to the dictionary, both when streaming and when dumping */
+	void testLibrary();
+
+	static std::string record(uint8_t type, std::string body);
+	static std::string word(uint16_t value);
+	/** @brief A module header, names, a paragraph aligned _TEXT and a word aligned _DATA segment in DGROUP, and an external symbol */
+	static std::string header(uint16_t text_length, uint16_t data_length);
+	std::shared_ptr<OMF86Format> load(std::string data, Module& module);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestOMF86Format::testEnumeratedData()
+{
+	std::string file = header(8, 0x20);
+	file += record(OMF86Format::PUBDEF16, std::string("\x00\x01", 2) + std::string("\x05start", 6) + word(2) + std::string(1, '\0'));
+	file += record(OMF86Format::LEDATA16, std::string(1, '\x01') + word(2) + "\x90\x90\xEB\xFE");
+	/* main module, start address relative to segment 1 with frame segment 1 */
+	file += record(OMF86Format::MODEND16, std::string("\xC1\x00\x01\x01", 4) + word(2));
+
+	Module module;
+	load(file, module);
+
+	std::shared_ptr<Section> text = module.FindSection("_TEXT");
+	std::shared_ptr<Section> data = module.FindSection("_DATA");
+	CPPUNIT_ASSERT(text != nullptr && data != nullptr);
+	CPPUNIT_ASSERT(!text->IsZeroFilled());
+	CPPUNIT_ASSERT(text->IsExecutable());
+	CPPUNIT_ASSERT_EQUAL(offset_t(16), text->GetAlign());
+	CPPUNIT_ASSERT_EQUAL(offset_t(8), text->Size());
+	CPPUNIT_ASSERT_EQUAL(0x00, text->GetByte(1));
+	CPPUNIT_ASSERT_EQUAL(0x90, text->GetByte(2));
+	CPPUNIT_ASSERT_EQUAL(0xFE, text->GetByte(5));
+	CPPUNIT_ASSERT(data->IsZeroFilled());
+	CPPUNIT_ASSERT_EQUAL(offset_t(0x20), data->Size());
+
+	Location location;
+	CPPUNIT_ASSERT(module.FindGlobalSymbol("start", location));
+	CPPUNIT_ASSERT(location == Location(text, 2));
+	CPPUNIT_ASSERT(module.FindGlobalSymbol(".entry", location));
+	CPPUNIT_ASSERT(location == Location(text, 2));
+}
+
+void TestOMF86Format::testIteratedData()
+{
+	std::string file = header(2, 0x20);
+	/* 3 * { 2 * "ab", 1 * "c" }, followed by 2 * "z" */
+	file += record(OMF86Format::LIDATA16, std::string(1, '\x02') + word(4)
+		+ word(3) + word(2)
+			+ word(2) + word(0) + std::string("\x02" "ab", 3)
+			+ word(1) + word(0) + std::string("\x01" "c", 2)
+		+ word(2) + word(0) + std::string("\x01" "z", 2));
+	/* 32-bit offset and repeat count */
+	file += record(OMF86Format::LIDATA32, std::string(1, '\x02') + word(0x18) + word(0)
+		+ word(4) + word(0) + word(0) + std::string("\x01\x01", 2));
+	file += record(OMF86Format::MODEND16, std::string(1, '\0'));
+
+	Module module;
+	load(file, module);
+
+	std::shared_ptr<Section> data = module.FindSection("_DATA");
+	CPPUNIT_ASSERT(data != nullptr);
+	CPPUNIT_ASSERT(!data->IsZeroFilled());
+	std::string expected = std::string(4, '\0') + "ababcababcababczz" + std::string(3, '\0') + std::string(4, '\x01') + std::string(4, '\0');
+	std::string contents(data->Size(), '\0');
+	data->ReadData(contents.size(), 0, contents.data());
+	CPPUNIT_ASSERT_EQUAL(expected, contents);
+}
+
+void TestOMF86Format::testIteratedOffsets()
+{
+	/* 2 * { 3 * "ab", 1 * "c" }, expanded to "abababcabababc" */
+	auto leaf = [](uint32_t repeat_count, std::string bytes)
+	{
+		std::shared_ptr<OMF86Format::DataBlock> block = std::make_shared<OMF86Format::DataBlock>();
+		block->repeat_count = repeat_count;
+		block->content = OMF86Format::DataBlock::Data(bytes.begin(), bytes.end());
+		return block;
+	};
+	std::shared_ptr<OMF86Format::DataBlock> outer = std::make_shared<OMF86Format::DataBlock>();
+	outer->repeat_count = 2;
+	outer->content = OMF86Format::DataBlock::Blocks { leaf(3, "ab"), leaf(1, "c") };
+	OMF86Format::DataBlock::Blocks blocks { outer };
+
+	/* the encoded block: outer header at 0, "ab" header at 4 and data at 9, "c" header at 11 and data at 16 */
+	std::vector<offset_t> offsets;
+	CPPUNIT_ASSERT_EQUAL(offset_t(17), OMF86Format::ModuleConverter::GetIteratedOffsets(blocks, false, 10, offsets));
+	CPPUNIT_ASSERT(offsets == std::vector<offset_t>({ 1, 3, 5, 8, 10, 12 }));
+
+	offsets.clear();
+	OMF86Format::ModuleConverter::GetIteratedOffsets(blocks, false, 16, offsets);
+	CPPUNIT_ASSERT(offsets == std::vector<offset_t>({ 6, 13 }));
+
+	offsets.clear();
+	OMF86Format::ModuleConverter::GetIteratedOffsets(blocks, false, 5, offsets);
+	CPPUNIT_ASSERT(offsets.empty());
+
+	/* 32-bit repeat counts make each header 2 bytes longer */
+	offsets.clear();
+	CPPUNIT_ASSERT_EQUAL(offset_t(23), OMF86Format::ModuleConverter::GetIteratedOffsets(blocks, true, 22, offsets));
+	CPPUNIT_ASSERT(offsets == std::vector<offset_t>({ 6, 13 }));
+}
+
+void TestOMF86Format::testIteratedFixups()
+{
+	std::string file = header(0x20, 0x10);
+	/* 3 * a 16-bit word, the word is at offset 5 of the encoded block */
+	file += record(OMF86Format::LIDATA16, std::string(1, '\x02') + word(0) + word(3) + word(0) + std::string("\x02\x00\x00", 3));
+	/* segment relative offset at 5, frame group 1, target segment 1 with displacement 0x10 */
+	file += record(OMF86Format::FIXUPP16, std::string("\xC4\x05\x10\x01\x01", 5) + word(0x10));
+	file += record(OMF86Format::MODEND16, std::string(1, '\0'));
+
+	Module module;
+	load(file, module);
+
+	std::shared_ptr<Section> text = module.FindSection("_TEXT");
+	std::shared_ptr<Section> data = module.FindSection("_DATA");
+	std::vector<Relocation>& relocations = module.GetRelocations();
+	CPPUNIT_ASSERT_EQUAL(size_t(3), relocations.size());
+	for(size_t i = 0; i < relocations.size(); i++)
+	{
+		CPPUNIT_ASSERT(relocations[i].source == Location(data, 2 * i));
+		CPPUNIT_ASSERT_EQUAL(size_t(2), relocations[i].size);
+		CPPUNIT_ASSERT(relocations[i].target == Target(Location(text, 0)));
+		CPPUNIT_ASSERT(relocations[i].reference == Target(Location(data, 0)).GetSegment());
+		CPPUNIT_ASSERT_EQUAL(uint64_t(0x10), relocations[i].addend);
+	}
+
+	/* a fixup pointing into the repeat count of the block */
+	file = header(0x20, 0x10);
+	file += record(OMF86Format::LIDATA16, std::string(1, '\x02') + word(0) + word(3) + word(0) + std::string("\x02\x00\x00", 3));
+	file += record(OMF86Format::FIXUPP16, std::string("\xC4\x00\x14\x01\x01", 5));
+	file += record(OMF86Format::MODEND16, std::string(1, '\0'));
+
+	Module invalid;
+	CPPUNIT_ASSERT_THROW(load(file, invalid), Linker::Exception);
+}
+
+void TestOMF86Format::testFixupThreads()
+{
+	std::string file = header(0x10, 0x10);
+	file += record(OMF86Format::LEDATA16, std::string(1, '\x01') + word(0) + std::string(0x10, '\0'));
+	file += record(OMF86Format::FIXUPP16,
+		/* target thread 1: external 1 */
+		std::string("\x09\x01", 2)
+		/* frame thread 2: group 1 */
+		+ std::string("\x46\x01", 2)
+		/* segment relative offset at 0, frame thread 2, target thread 1 */
+		+ std::string("\xC4\x00\xAD", 3)
+		/* segment base at 4, frame number 0x1234, target segment 1 */
+		+ std::string("\xC8\x04\x34\x34\x12\x01", 6)
+		/* self relative offset at 8, frame of the source, target external 1 */
+		+ std::string("\x84\x08\x42\x01", 4) + word(0)
+		/* segment relative offset at 12, frame of the target, target thread 1 */
+		+ std::string("\xC4\x0C\x5D", 3));
+	file += record(OMF86Format::MODEND16, std::string(1, '\0'));
+
+	Module module;
+	load(file, module);
+
+	std::shared_ptr<Section> text = module.FindSection("_TEXT");
+	std::shared_ptr<Section> data = module.FindSection("_DATA");
+	std::vector<Relocation>& relocations = module.GetRelocations();
+	CPPUNIT_ASSERT_EQUAL(size_t(4), relocations.size());
+
+	CPPUNIT_ASSERT(relocations[0].source == Location(text, 0));
+	CPPUNIT_ASSERT(relocations[0].target == Target(SymbolName("ext")));
+	CPPUNIT_ASSERT(relocations[0].reference == Target(Location(data, 0)).GetSegment());
+
+	CPPUNIT_ASSERT(relocations[1].source == Location(text, 4));
+	CPPUNIT_ASSERT(relocations[1].target == Target(Location(offset_t(0x12340))).GetSegment());
+
+	CPPUNIT_ASSERT(relocations[2].source == Location(text, 8));
+	CPPUNIT_ASSERT(relocations[2].IsRelative());
+	CPPUNIT_ASSERT(relocations[2].target == Target(SymbolName("ext")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(-2), relocations[2].addend);
+
+	CPPUNIT_ASSERT(relocations[3].source == Location(text, 12));
+	CPPUNIT_ASSERT(relocations[3].target == Target(SymbolName("ext")));
+	CPPUNIT_ASSERT(relocations[3].reference == Target(SymbolName("ext")).GetSegment());
+}
+
+void TestOMF86Format::testLibrary()
+{
+	/* 16 byte pages, the header fills the first page */
+	std::string file = std::string("\xF0\x0D\x00", 3) + std::string(13, '\0');
+	for(std::string name : { "first", "second" })
+	{
+		std::string module = record(OMF86Format::THEADR, char(name.size()) + name);
+		module += record(OMF86Format::LNAMES, std::string("\x05_TEXT\x04" "CODE", 11));
+		module += record(OMF86Format::SEGDEF16, std::string("\x68\x01\x00\x01\x02\x00", 6));
+		module += record(OMF86Format::PUBDEF16, std::string("\x00\x01", 2) + char(name.size()) + name + word(0) + std::string(1, '\0'));
+		module += record(OMF86Format::MODEND16, std::string(1, '\0'));
+		module.resize(::AlignTo(module.size(), 16), '\0');
+		file += module;
+	}
+	file += std::string("\xF1\x0D\x00", 3) + std::string(13, '\0');
+	/* the dictionary must not be parsed as records */
+	file += std::string(0x20, '\xFF');
+
+	std::shared_ptr<OMF86Format> omf = std::make_shared<OMF86Format>();
+	ModuleCollector linker;
+	{
+		std::istringstream in(file);
+		Reader rd(::LittleEndian, &in);
+		omf->ProduceModule(linker, rd, "test.lib");
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(2), linker.modules.size());
+	CPPUNIT_ASSERT(linker.modules[0]->is_library && linker.modules[1]->is_library);
+	Location location;
+	CPPUNIT_ASSERT(linker.modules[0]->FindGlobalSymbol("first", location));
+	CPPUNIT_ASSERT(linker.modules[1]->FindGlobalSymbol("second", location));
+	CPPUNIT_ASSERT(omf->records.empty());
+
+	std::shared_ptr<OMF86Format> dumped = std::make_shared<OMF86Format>();
+	{
+		std::istringstream in(file);
+		Reader rd(::LittleEndian, &in);
+		dumped->ReadFile(rd);
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(2), dumped->modules.size());
+	/* library header, 5 records for each module, library end */
+	CPPUNIT_ASSERT_EQUAL(size_t(12), dumped->records.size());
+	CPPUNIT_ASSERT_EQUAL(OMF86Format::LibraryEnd, dumped->records.back()->record_type);
+}
+
+std::string TestOMF86Format::record(uint8_t type, std::string body)
+{
+	std::string data;
+	data += char(type);
+	data += word(body.size() + 1);
+	data += body;
+	uint8_t checksum = 0;
+	for(char c : data)
+	{
+		checksum -= uint8_t(c);
+	}
+	data += char(checksum);
+	return data;
+}
+
+std::string TestOMF86Format::word(uint16_t value)
+{
+	return std::string { char(value & 0xFF), char(value >> 8) };
+}
+
+std::string TestOMF86Format::header(uint16_t text_length, uint16_t data_length)
+{
+	std::string data = record(OMF86Format::THEADR, "\x04test");
+	data += record(OMF86Format::LNAMES, std::string("\x05_TEXT\x04" "CODE\x05_DATA\x04" "DATA\x06" "DGROUP", 29));
+	/* paragraph aligned, public */
+	data += record(OMF86Format::SEGDEF16, std::string(1, '\x68') + word(text_length) + std::string("\x01\x02\x00", 3));
+	/* word aligned, public */
+	data += record(OMF86Format::SEGDEF16, std::string(1, '\x48') + word(data_length) + std::string("\x03\x04\x00", 3));
+	data += record(OMF86Format::GRPDEF, std::string("\x05\xFF\x02", 3));
+	data += record(OMF86Format::EXTDEF, std::string("\x03" "ext\x00", 5));
+	return data;
+}
+
+std::shared_ptr<OMF86Format> TestOMF86Format::load(std::string data, Module& module)
+{
+	std::shared_ptr<OMF86Format> omf = std::make_shared<OMF86Format>();
+	std::istringstream in(data);
+	Reader rd(::LittleEndian, &in);
+	omf->ReadFile(rd);
+	omf->GenerateModule(module);
+	return omf;
+}
+
+void TestOMF86Format::setUp()
+{
+}
+
+void TestOMF86Format::tearDown()
+{
+}
+
+}
@@ -0,0 +1,461 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/peexe.h"
+
+using namespace Linker;
+using namespace Microsoft;
+
+namespace UnitTests
+{
+
+class TestPEFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestPEFormat);
+	CPPUNIT_TEST(testBindLibrary);
+	CPPUNIT_TEST(testBindStaleLibrary);
+	CPPUNIT_TEST(testBindInvalidLibrary);
+	CPPUNIT_TEST(testBaseRelocationLayout);
+	CPPUNIT_TEST(testBaseRelocationRandomOrder);
+	CPPUNIT_TEST(testResources);
+	CPPUNIT_TEST(testMergeResources);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that an import is bound to the preferred address of the entry in the library, and the time stamp of the library is recorded */
+	void testBindLibrary();
+	/** @brief Verifies that a binding made against an older build of a library can be told apart, and that linking again binds against the new build */
+	void testBindStaleLibrary();
+	/** @brief Verifies that a missing, truncated or non-PE library only leaves its imports unbound */
+	void testBindInvalidLibrary();
+	/** @brief Verifies the exact contents of a small .reloc section, including the padding of blocks and HIGHADJ parameters */
+	void testBaseRelocationLayout();
+	/** @brief Verifies that relocations added in random order are written as one block per page, in increasing order */
+	void testBaseRelocationRandomOrder();
+	/** @brief Verifies that several resources can be read back from the .rsrc section with their identifiers and contents, and that the section can be dumped */
+	void testResources();
+	/** @brief Verifies that resources with identical contents share their data only when merging is requested */
+	void testMergeResources();
+
+	std::filesystem::path directory;
+
+	/** @brief Generates FIXTURE.DLL in the bind directory, exporting Function at the given offset of its code */
+	void make_library(uint32_t timestamp, offset_t function_offset);
+	/** @brief Returns the preferred address of Function in FIXTURE.DLL */
+	uint64_t get_function_address();
+	/** @brief Links a program importing Function from FIXTURE.DLL, binding it against the bind directory, and reads it back */
+	std::shared_ptr<PEFormat> link_program();
+	/** @brief Returns the first entry of the import address table of the program */
+	uint64_t get_bound_address(const PEFormat& program);
+	/** @brief Generates the .reloc section from the collected relocations and returns its contents */
+	std::string write_base_relocations(PEFormat& format);
+	/** @brief Links a program with the given resources and reads it back */
+	std::shared_ptr<PEFormat> link_resources(const std::vector<std::shared_ptr<Section>>& resources, std::map<std::string, std::string> options = { });
+	/** @brief Collects the resources of a directory read back from a file, along with all its subdirectories */
+	static void collect_resources(const PEFormat::ResourceDirectory& directory, std::vector<std::shared_ptr<PEFormat::Resource>>& resources);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestPEFormat::testBindLibrary()
+{
+	make_library(0x12345678, 4);
+	std::shared_ptr<PEFormat> program = link_program();
+
+	CPPUNIT_ASSERT_EQUAL(size_t(1), program->bound_imports.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("FIXTURE.DLL"), program->bound_imports[0].name);
+	CPPUNIT_ASSERT_EQUAL(uint32_t(0x12345678), program->bound_imports[0].timestamp);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), program->imports->libraries.size());
+	CPPUNIT_ASSERT_EQUAL(uint32_t(0xFFFFFFFF), program->imports->libraries[0].timestamp);
+	CPPUNIT_ASSERT_EQUAL(get_function_address(), get_bound_address(*program));
+}
+
+void TestPEFormat::testBindStaleLibrary()
+{
+	make_library(0x12345678, 4);
+	std::shared_ptr<PEFormat> program = link_program();
+	uint64_t old_address = get_bound_address(*program);
+
+	/* the library is rebuilt with the entry at another address */
+	make_library(0x23456789, 8);
+	uint64_t new_address = get_function_address();
+	CPPUNIT_ASSERT(old_address != new_address);
+	/* the loader compares the recorded time stamp against the library it loads */
+	CPPUNIT_ASSERT(program->bound_imports[0].timestamp != 0x23456789);
+
+	program = link_program();
+	CPPUNIT_ASSERT_EQUAL(size_t(1), program->bound_imports.size());
+	CPPUNIT_ASSERT_EQUAL(uint32_t(0x23456789), program->bound_imports[0].timestamp);
+	CPPUNIT_ASSERT_EQUAL(new_address, get_bound_address(*program));
+}
+
+void TestPEFormat::testBindInvalidLibrary()
+{
+	std::ostringstream messages;
+	std::streambuf * warning_buffer = Linker::Warning.rdbuf(messages.rdbuf());
+	std::streambuf * error_buffer = Linker::Error.rdbuf(messages.rdbuf());
+
+	std::vector<std::string> contents;
+	/* missing */
+	contents.push_back("");
+	/* not a PE file */
+	contents.push_back("MZ not a library");
+	/* truncated */
+	make_library(0x12345678, 4);
+	{
+		std::ifstream in(directory / "FIXTURE.DLL", std::ios_base::in | std::ios_base::binary);
+		std::string library((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		contents.push_back(library.substr(0, 0x100));
+		contents.push_back(library.substr(0, library.size() / 2));
+	}
+
+	for(auto& library : contents)
+	{
+		std::filesystem::remove(directory / "FIXTURE.DLL");
+		if(library != "")
+		{
+			std::ofstream out(directory / "FIXTURE.DLL", std::ios_base::out | std::ios_base::binary);
+			out << library;
+		}
+
+		std::shared_ptr<PEFormat> program;
+		CPPUNIT_ASSERT_NO_THROW(program = link_program());
+		CPPUNIT_ASSERT_EQUAL(size_t(0), program->bound_imports.size());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), program->imports->libraries[0].timestamp);
+	}
+
+	Linker::Warning.rdbuf(warning_buffer);
+	Linker::Error.rdbuf(error_buffer);
+	CPPUNIT_ASSERT(messages.str().find("imports will be resolved at load time") != std::string::npos);
+}
+
+void TestPEFormat::testBaseRelocationLayout()
+{
+	PEFormat format;
+	format.AddBaseRelocation(0x3008, PEFormat::BaseRelocation::RelHighLow);
+	format.AddBaseRelocation(0x1004, PEFormat::BaseRelocation::RelHighLow);
+	format.AddBaseRelocation(0x1000, PEFormat::BaseRelocation::RelHighLow);
+	format.AddBaseRelocation(0x3002, PEFormat::BaseRelocation::RelHighAdj, 0x1234);
+	format.AddBaseRelocation(0x1FF0, PEFormat::BaseRelocation::RelHighLow);
+
+	std::string data = write_base_relocations(format);
+	const std::string expected(
+		"\x00\x10\x00\x00" "\x10\x00\x00\x00" "\x00\x30" "\x04\x30" "\xF0\x3F" "\x00\x00"
+		"\x00\x30\x00\x00" "\x10\x00\x00\x00" "\x02\x40" "\x34\x12" "\x08\x30" "\x00\x00", 32);
+	CPPUNIT_ASSERT_EQUAL(uint32_t(32), format.base_relocations->virtual_size());
+	CPPUNIT_ASSERT_EQUAL(size_t(0x200), data.size());
+	CPPUNIT_ASSERT(data.substr(0, 32) == expected);
+	CPPUNIT_ASSERT(data.substr(32) == std::string(0x200 - 32, '\0'));
+}
+
+void TestPEFormat::testBaseRelocationRandomOrder()
+{
+	/* addresses spread over several pages and all four bytes of the address, so that every pass of the sort matters */
+	std::mt19937 random(0x5EED);
+	std::map<uint32_t, std::set<uint16_t>> pages;
+	std::vector<uint32_t> addresses;
+	while(addresses.size() < 2000)
+	{
+		uint32_t rva = (random() % 0x01000000) & ~3;
+		if(random() % 4 == 0)
+			rva = 0x00ABC000 | (rva & 0x0FFC); /* a few crowded pages */
+		if(!pages[rva & ~0xFFF].insert(rva & 0xFFF).second)
+			continue;
+		addresses.push_back(rva);
+	}
+	std::shuffle(addresses.begin(), addresses.end(), random);
+
+	PEFormat format;
+	for(uint32_t rva : addresses)
+	{
+		format.AddBaseRelocation(rva, PEFormat::BaseRelocation::RelHighLow);
+	}
+	std::string data = write_base_relocations(format);
+
+	std::ostringstream expected_stream;
+	Writer wr(::LittleEndian, &expected_stream);
+	for(auto& page : pages)
+	{
+		uint32_t block_size = AlignTo(8 + 2 * page.second.size(), 4);
+		wr.WriteWord(4, page.first);
+		wr.WriteWord(4, block_size);
+		for(uint16_t offset : page.second)
+		{
+			wr.WriteWord(2, (PEFormat::BaseRelocation::RelHighLow << 12) | offset);
+		}
+		if(page.second.size() % 2 != 0)
+			wr.WriteWord(2, 0);
+	}
+	std::string expected = expected_stream.str();
+
+	CPPUNIT_ASSERT_EQUAL(pages.size(), format.base_relocations->blocks_list.size());
+	CPPUNIT_ASSERT_EQUAL(uint32_t(expected.size()), format.base_relocations->virtual_size());
+	CPPUNIT_ASSERT_EQUAL(size_t(AlignTo(expected.size(), 0x200)), data.size());
+	CPPUNIT_ASSERT(data.substr(0, expected.size()) == expected);
+}
+
+void TestPEFormat::testResources()
+{
+	std::vector<std::shared_ptr<Section>> resources;
+	std::vector<std::string> contents = { std::string(0x40, '\x02'), std::string(0x30, '\x03'), std::string(0x20, '\x04'), std::string(0x11, '\x05') };
+	std::vector<std::pair<PEFormat::Resource::Identifier, PEFormat::Resource::Identifier>> identifiers =
+	{
+		{ uint32_t(2), uint32_t(1) },
+		{ uint32_t(2), uint32_t(2) },
+		{ uint32_t(3), uint32_t(1) },
+		{ std::string("DATA"), uint32_t(7) },
+	};
+	std::vector<std::string> names = { "$$RSRC$2$1", "$$RSRC$2$2", "$$RSRC$3$1", "$$RSRC$_DATA$7" };
+	for(size_t index = 0; index < contents.size(); index++)
+	{
+		/* sections with the same name would be merged into one resource */
+		std::shared_ptr<Section> resource = std::make_shared<Section>(names[index], Section::Readable | Section::Resource);
+		resource->Append(contents[index].c_str(), contents[index].size());
+		resource->resource_type = identifiers[index].first;
+		resource->resource_id = identifiers[index].second;
+		resources.push_back(resource);
+	}
+	std::shared_ptr<PEFormat> program = link_resources(resources);
+
+	const PEFormat::PEOptionalHeader::DataDirectory& resource_directory = program->GetOptionalHeader().data_directories[PEFormat::PEOptionalHeader::DirResourceTable];
+	CPPUNIT_ASSERT(resource_directory.address != 0);
+	std::vector<std::shared_ptr<PEFormat::Resource>> loaded;
+	collect_resources(*program->resources, loaded);
+	CPPUNIT_ASSERT_EQUAL(contents.size(), loaded.size());
+
+	for(size_t index = 0; index < contents.size(); index++)
+	{
+		auto it = std::find_if(loaded.begin(), loaded.end(), [&](std::shared_ptr<PEFormat::Resource>& resource)
+		{
+			return resource->full_identifier.size() == 3
+				&& resource->full_identifier[PEFormat::Resource::Level_Type] == identifiers[index].first
+				&& resource->full_identifier[PEFormat::Resource::Level_Name] == identifiers[index].second;
+		});
+		CPPUNIT_ASSERT(it != loaded.end());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(contents[index].size()), (*it)->size);
+		/* the data must be inside the resource directory, after the directory tables */
+		CPPUNIT_ASSERT((*it)->data_rva > resource_directory.address);
+		CPPUNIT_ASSERT((*it)->data_rva + (*it)->size <= resource_directory.address + resource_directory.size);
+		CPPUNIT_ASSERT(program->ReadData((*it)->data_rva, (*it)->size) == contents[index]);
+	}
+
+	std::ostringstream out;
+	Dumper::Dumper dump(out);
+	CPPUNIT_ASSERT_NO_THROW(program->Dump(dump));
+	CPPUNIT_ASSERT(out.str().find("Resource table") != std::string::npos);
+}
+
+void TestPEFormat::testMergeResources()
+{
+	for(bool merge : { false, true })
+	{
+		std::vector<std::shared_ptr<Section>> resources;
+		std::vector<std::string> names = { "$$RSRC$2$1", "$$RSRC$2$2", "$$RSRC$2$3" };
+		std::vector<std::string> contents = { std::string(0x40, '\x02'), std::string(0x40, '\x03'), std::string(0x40, '\x02') };
+		for(size_t index = 0; index < names.size(); index++)
+		{
+			std::shared_ptr<Section> resource = std::make_shared<Section>(names[index], Section::Readable | Section::Resource);
+			resource->Append(contents[index].c_str(), contents[index].size());
+			resource->resource_type = uint32_t(2);
+			resource->resource_id = uint32_t(index + 1);
+			resources.push_back(resource);
+		}
+		std::map<std::string, std::string> options;
+		if(merge)
+			options["merge_resources"] = "";
+		std::shared_ptr<PEFormat> program = link_resources(resources, options);
+
+		std::vector<std::shared_ptr<PEFormat::Resource>> loaded;
+		collect_resources(*program->resources, loaded);
+		CPPUNIT_ASSERT_EQUAL(size_t(3), loaded.size());
+		std::map<uint32_t, uint32_t> data_rvas;
+		for(auto& resource : loaded)
+		{
+			uint32_t id = std::get<uint32_t>(resource->full_identifier[PEFormat::Resource::Level_Name]);
+			data_rvas[id] = resource->data_rva;
+			CPPUNIT_ASSERT(program->ReadData(resource->data_rva, resource->size) == contents[id - 1]);
+		}
+		CPPUNIT_ASSERT(data_rvas[1] != data_rvas[2]);
+		CPPUNIT_ASSERT_EQUAL(merge, data_rvas[1] == data_rvas[3]);
+	}
+}
+
+void TestPEFormat::make_library(uint32_t timestamp, offset_t function_offset)
+{
+	std::shared_ptr<PEFormat> format = PEFormat::CreateLibraryModule(PEFormat::TargetWinNT);
+
+	Module input("fixture.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append(std::string(0x10, '\xC3').c_str(), 0x10);
+	input.AddSection(text);
+	input.AddGlobalSymbol(".entry", Location(text, 0));
+	input.AddExportedSymbol(ExportedSymbolName("Function"), Location(text, function_offset));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", options);
+
+	format->timestamp = timestamp;
+	format->GenerateFile((directory / "FIXTURE.DLL").string(), module);
+}
+
+uint64_t TestPEFormat::get_function_address()
+{
+	PEFormat library;
+	std::ifstream in(directory / "FIXTURE.DLL", std::ios_base::in | std::ios_base::binary);
+	CPPUNIT_ASSERT(in.is_open());
+	Reader rd(::LittleEndian, &in);
+	library.ReadFile(rd);
+
+	auto it = library.exports->named_exports.find("Function");
+	CPPUNIT_ASSERT(it != library.exports->named_exports.end());
+	uint32_t * rva = std::get_if<uint32_t>(&library.exports->entries[it->second]->value);
+	CPPUNIT_ASSERT(rva != nullptr);
+	return library.GetOptionalHeader().image_base + *rva;
+}
+
+std::shared_ptr<PEFormat> TestPEFormat::link_program()
+{
+	std::shared_ptr<PEFormat> format = PEFormat::CreateConsoleApplication(PEFormat::TargetWinNT);
+
+	Module input("program.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append(std::string(0x10, '\x90').c_str(), 0x10);
+	input.AddSection(text);
+	input.AddGlobalSymbol(".entry", Location(text, 0));
+	input.AddImportedSymbol(SymbolName("FIXTURE.DLL", "Function"));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options = { { "bind", directory.string() } };
+	std::map<std::string, std::string> script_parameters;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", script_parameters);
+
+	std::filesystem::path path = directory / "program.exe";
+	format->GenerateFile(path.string(), module);
+
+	std::shared_ptr<PEFormat> loaded = std::make_shared<PEFormat>();
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		CPPUNIT_ASSERT(in.is_open());
+		Reader rd(::LittleEndian, &in);
+		loaded->ReadFile(rd);
+	}
+	std::filesystem::remove(path);
+	return loaded;
+}
+
+uint64_t TestPEFormat::get_bound_address(const PEFormat& program)
+{
+	CPPUNIT_ASSERT_EQUAL(size_t(1), program.imports->libraries.size());
+	return program.ReadUnsigned(4, program.imports->libraries[0].address_table_rva, ::LittleEndian);
+}
+
+std::string TestPEFormat::write_base_relocations(PEFormat& format)
+{
+	format.GetOptionalHeader().file_align = 0x200;
+	format.base_relocations->Generate(format);
+	format.base_relocations->section_pointer = 0;
+
+	std::stringstream out;
+	Writer wr(::LittleEndian, &out);
+	format.base_relocations->WriteSectionData(wr, format);
+	return out.str();
+}
+
+std::shared_ptr<PEFormat> TestPEFormat::link_resources(const std::vector<std::shared_ptr<Section>>& resources, std::map<std::string, std::string> options)
+{
+	std::shared_ptr<PEFormat> format = PEFormat::CreateGUIApplication(PEFormat::TargetWinNT);
+
+	Module input("program.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append(std::string(0x10, '\xC3').c_str(), 0x10);
+	input.AddSection(text);
+	input.AddGlobalSymbol(".entry", Location(text, 0));
+	for(auto& resource : resources)
+	{
+		input.AddSection(resource);
+	}
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> script_parameters;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", script_parameters);
+
+	std::filesystem::path path = directory / "program.exe";
+	format->GenerateFile(path.string(), module);
+
+	std::shared_ptr<PEFormat> loaded = std::make_shared<PEFormat>();
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		CPPUNIT_ASSERT(in.is_open());
+		Reader rd(::LittleEndian, &in);
+		loaded->ReadFile(rd);
+	}
+	std::filesystem::remove(path);
+	return loaded;
+}
+
+void TestPEFormat::collect_resources(const PEFormat::ResourceDirectory& directory, std::vector<std::shared_ptr<PEFormat::Resource>>& resources)
+{
+	auto collect = [&](auto& entries)
+	{
+		for(auto& entry : entries)
+		{
+			if(auto * subdirectory = std::get_if<std::shared_ptr<PEFormat::ResourceDirectory>>(&entry.content))
+				collect_resources(**subdirectory, resources);
+			else
+				resources.push_back(std::get<std::shared_ptr<PEFormat::Resource>>(entry.content));
+		}
+	};
+	collect(directory.name_entries);
+	collect(directory.id_entries);
+}
+
+void TestPEFormat::setUp()
+{
+	directory = std::filesystem::temp_directory_path() / "unittest_bind";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+}
+
+void TestPEFormat::tearDown()
+{
+	std::filesystem::remove_all(directory);
+}
+
+}
@@ -0,0 +1,96 @@
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/8bitexe.h"
+
+using namespace Linker;
+using namespace Binary;
+
+namespace UnitTests
+{
+
+class TestPRLFormat : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestPRLFormat);
+	CPPUNIT_TEST(testRelocationBitmap);
+	CPPUNIT_TEST(testRoundTrip);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that relocations are stored with the lowest offset in the most significant bit */
+	void testRelocationBitmap();
+	/** @brief Verifies that the bitmap is padded to the image size when written and read back unchanged */
+	void testRoundTrip();
+
+	std::string store(const PRLFormat& exe);
+	void load(PRLFormat& exe, std::string data);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestPRLFormat::testRelocationBitmap()
+{
+	PRLFormat exe;
+	exe.AddRelocation(0x0001);
+	exe.AddRelocation(0x0007);
+	exe.AddRelocation(0x0010);
+
+	std::vector<uint8_t> expected = { 0x41, 0x00, 0x80 };
+	CPPUNIT_ASSERT(exe.relocation_bitmap == expected);
+	CPPUNIT_ASSERT(exe.HasRelocation(0x0007));
+	CPPUNIT_ASSERT(!exe.HasRelocation(0x0008));
+	CPPUNIT_ASSERT(!exe.HasRelocation(0x0100));
+	CPPUNIT_ASSERT(exe.GetRelocations() == std::vector<uint16_t>({ 0x0001, 0x0007, 0x0010 }));
+}
+
+void TestPRLFormat::testRoundTrip()
+{
+	PRLFormat exe;
+	std::shared_ptr<Section> code = std::make_shared<Section>(".code");
+	std::string data(0x2B, '\x01');
+	code->Append(data.c_str(), data.size());
+	exe.image = code;
+	exe.zero_fill = 0x20;
+	std::vector<uint16_t> relocations = { 0x0002, 0x0009, 0x0010, 0x0011 };
+	for(auto relocation : relocations)
+	{
+		exe.AddRelocation(relocation);
+	}
+
+	std::string image = store(exe);
+	CPPUNIT_ASSERT_EQUAL(size_t(0x0100 + 0x2B + 6), image.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("\x20\x40\xC0\x00\x00\x00", 6), image.substr(0x0100 + 0x2B));
+
+	PRLFormat loaded;
+	load(loaded, image);
+	CPPUNIT_ASSERT(!loaded.suppress_relocations);
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0x20), loaded.zero_fill);
+	CPPUNIT_ASSERT_EQUAL(offset_t(0x2B), loaded.image->ImageSize());
+	CPPUNIT_ASSERT(loaded.GetRelocations() == relocations);
+}
+
+std::string TestPRLFormat::store(const PRLFormat& exe)
+{
+	std::ostringstream out;
+	Writer wr(::LittleEndian, &out);
+	exe.WriteFile(wr);
+	return out.str();
+}
+
+void TestPRLFormat::load(PRLFormat& exe, std::string data)
+{
+	std::istringstream in(data);
+	Reader rd(::LittleEndian, &in);
+	CPPUNIT_ASSERT_NO_THROW(exe.ReadFile(rd));
+}
+
+void TestPRLFormat::setUp()
+{
+}
+
+void TestPRLFormat::tearDown()
+{
+}
+
+}
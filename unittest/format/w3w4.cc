@@ -0,0 +1,165 @@
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/w3w4.h"
+
+using namespace Linker;
+using namespace Microsoft;
+
+namespace UnitTests
+{
+
+class TestW4Format : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestW4Format);
+	CPPUNIT_TEST(testChunkRoundTrip);
+	CPPUNIT_TEST(testImageRoundTrip);
+	CPPUNIT_TEST(testLinkDeviceDriver);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that compressed chunks of various contents decompress to the original bytes */
+	void testChunkRoundTrip();
+	/** @brief Verifies that an image split into several chunks and compressed in parallel decompresses to the original image */
+	void testImageRoundTrip();
+	/** @brief Verifies that a device driver linked into a VMM32 container is read back with its name and contents */
+	void testLinkDeviceDriver();
+
+	void checkRoundTrip(const std::vector<uint8_t>& data);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestW4Format::testChunkRoundTrip()
+{
+	std::mt19937 random(1);
+
+	checkRoundTrip({ });
+	checkRoundTrip({ 0x12 });
+	checkRoundTrip({ 0x80, 0x80 });
+	checkRoundTrip(std::vector<uint8_t>(0x2000, 0x00));
+	checkRoundTrip(std::vector<uint8_t>(0x2000, 0xFF));
+
+	std::vector<uint8_t> data(0x2000);
+	for(auto& byte : data)
+		byte = random();
+	checkRoundTrip(data);
+
+	/* repeated patterns of various periods, including matches at the maximum depth and of maximum length */
+	for(size_t period : { 1, 3, 63, 64, 319, 320, 1000, 4414, 4415 })
+	{
+		std::vector<uint8_t> pattern(period);
+		for(auto& byte : pattern)
+			byte = random();
+		for(size_t i = 0; i < data.size(); i++)
+			data[i] = pattern[i % period];
+		checkRoundTrip(data);
+	}
+
+	/* sparse changes in a repeated pattern, similar to code */
+	for(size_t i = 0; i < data.size(); i++)
+		data[i] = i % 7 == 0 ? random() : "\x55\x8B\xEC\x83\xEC"[i % 5];
+	std::vector<uint8_t> compressed = W4Format::CompressChunk(data.data(), data.size());
+	CPPUNIT_ASSERT(compressed.size() < data.size() / 2);
+	checkRoundTrip(data);
+}
+
+void TestW4Format::testImageRoundTrip()
+{
+	std::mt19937 random(2);
+	std::vector<uint8_t> image(0x2000 * 5 + 0x123);
+	for(size_t i = 0; i < image.size(); i++)
+		image[i] = random() % 4 == 0 ? random() : i & 0x3F;
+
+	W4Format w4;
+	w4.chunk_size = 0x2000;
+	w4.CompressW4(image, 3);
+	CPPUNIT_ASSERT_EQUAL(size_t(6), w4.chunks.size());
+
+	std::shared_ptr<Buffer> decompressed = w4.DecompressW4(4);
+	/* the final chunk is padded with zeros */
+	CPPUNIT_ASSERT_EQUAL(offset_t(0x2000 * 6), decompressed->ImageSize());
+	std::vector<uint8_t> bytes(decompressed->ImageSize());
+	decompressed->ReadData(bytes.size(), 0, bytes.data());
+	image.resize(bytes.size(), 0);
+	CPPUNIT_ASSERT(bytes == image);
+}
+
+void TestW4Format::testLinkDeviceDriver()
+{
+	std::shared_ptr<W4Format> format = std::make_shared<W4Format>(LEFormat::CreateDeviceDriver(LEFormat::Windows386)->SimulateLinker(LEFormat::CompatibleWatcom));
+
+	Module input("driver.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	std::string code;
+	/* long enough to span several chunks, and compressible, the last page is partial */
+	for(size_t i = 0; i < 0x2345; i++)
+		code += "\x55\x8B\xEC\x90\xC3"[i % 5];
+	text->Append(code.c_str(), code.size());
+	input.AddSection(text);
+	input.AddGlobalSymbol("_start", Location(text, 0));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", options);
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / "unittest_driver.vxd";
+	format->GenerateFile(path.string(), module);
+
+	W4Format loaded;
+	{
+		std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+		CPPUNIT_ASSERT(in.is_open());
+		Reader rd(::LittleEndian, &in);
+		loaded.ReadFile(rd);
+	}
+	std::filesystem::remove(path);
+
+	CPPUNIT_ASSERT(loaded.chunks.size() > 1);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), loaded.w3format.entries.size());
+	W3Format::Entry& entry = loaded.w3format.entries[0];
+	CPPUNIT_ASSERT_EQUAL(std::string("UNITTEST"), entry.filename);
+	CPPUNIT_ASSERT(entry.contents != nullptr);
+	CPPUNIT_ASSERT(entry.contents->objects.size() >= 1);
+
+	std::shared_ptr<Linker::Contents> object = entry.contents->objects[0].image;
+	CPPUNIT_ASSERT(object->ImageSize() >= code.size());
+	std::string object_code(code.size(), '\0');
+	object->AsImage()->ReadData(code.size(), 0, object_code.data());
+	CPPUNIT_ASSERT(object_code == code);
+}
+
+void TestW4Format::checkRoundTrip(const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> compressed = W4Format::CompressChunk(data.data(), data.size());
+	/* an extra byte to check that nothing is written past the end */
+	std::vector<uint8_t> decompressed(data.size() + 1, 0xA5);
+	W4Format::DecompressChunk(compressed.data(), compressed.size(), decompressed.data(), data.size());
+	CPPUNIT_ASSERT_EQUAL(uint8_t(0xA5), decompressed.back());
+	decompressed.pop_back();
+	CPPUNIT_ASSERT(decompressed == data);
+}
+
+void TestW4Format::setUp()
+{
+}
+
+void TestW4Format::tearDown()
+{
+}
+
+}
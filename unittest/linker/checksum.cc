@@ -0,0 +1,168 @@
+
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/linker/checksum.h"
+#include "../../src/linker/writer.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestChecksum : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestChecksum);
+	CPPUNIT_TEST(testSumWords);
+	CPPUNIT_TEST(testSumWordsLong);
+	CPPUNIT_TEST(testFoldedSum16);
+	CPPUNIT_TEST(testOverwrite);
+	CPPUNIT_TEST(testOverwriteWithoutReadBack);
+	CPPUNIT_TEST(testPageChecksum);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies the sum of short buffers against precalculated values, including buffers that start in the middle of a word or end with a partial word */
+	void testSumWords();
+	/** @brief Verifies that buffers long enough to be summed in lanes give the same result as summing each word in turn */
+	void testSumWordsLong();
+	/** @brief Verifies that the carries are folded back into the low 16 bits until none remain */
+	void testFoldedSum16();
+	/** @brief Verifies that overwritten bytes are removed from the sum when the output can be read back */
+	void testOverwrite();
+	/** @brief Verifies that the checksum is marked invalid when overwritten bytes cannot be read back */
+	void testOverwriteWithoutReadBack();
+	/** @brief Verifies that each page is summed from its own start, and bytes outside of all pages are ignored */
+	void testPageChecksum();
+
+	/** @brief Sums the bytes one at a time, as the reference for the lane based implementation */
+	static uint64_t NaiveSum(size_t word_size, offset_t position, const std::vector<uint8_t>& data);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestChecksum::testSumWords()
+{
+	const uint8_t data[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x0604), Checksum::SumWords(2, 0, data, 4));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x0102), Checksum::SumWords(2, 1, data, 2));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x0609), Checksum::SumWords(2, 0, data, 5));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x04030206), Checksum::SumWords(4, 0, data, 5));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x03020104), Checksum::SumWords(4, 1, data, 4));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), Checksum::SumWords(4, 0, data, 0));
+}
+
+void TestChecksum::testSumWordsLong()
+{
+	std::vector<uint8_t> ones(0x20, 0xFF);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xFFFF0), Checksum::SumWords(2, 0, ones.data(), ones.size()));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x7FFFFFFF8), Checksum::SumWords(4, 0, ones.data(), ones.size()));
+
+	std::vector<uint8_t> data(0x1003);
+	for(size_t index = 0; index < data.size(); index++)
+	{
+		data[index] = uint8_t(index * 0x9D + (index >> 8));
+	}
+	for(size_t word_size : { 2, 4 })
+	{
+		for(offset_t position = 0; position < 8; position++)
+		{
+			CPPUNIT_ASSERT_EQUAL(NaiveSum(word_size, position, data), Checksum::SumWords(word_size, position, data.data(), data.size()));
+		}
+	}
+}
+
+void TestChecksum::testFoldedSum16()
+{
+	Checksum checksum(2);
+	checksum.sum = 0x1234;
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0x1234), checksum.FoldedSum16());
+	checksum.sum = 0x12345;
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0x2346), checksum.FoldedSum16());
+	/* the first fold carries again */
+	checksum.sum = 0x1FFFF;
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0x0001), checksum.FoldedSum16());
+	checksum.sum = 0xFFFFFFFF;
+	CPPUNIT_ASSERT_EQUAL(uint16_t(0xFFFF), checksum.FoldedSum16());
+}
+
+void TestChecksum::testOverwrite()
+{
+	std::stringstream out;
+	Writer wr(::LittleEndian, &out);
+	Checksum checksum(2);
+	wr.checksums.push_back(&checksum);
+
+	wr.WriteData(std::string("\x01\x02\x03\x04"));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x0604), checksum.sum);
+
+	/* a header field patched after the rest of the file is written */
+	wr.Seek(1);
+	wr.WriteData(std::string("\xAA\xBB"));
+	wr.Seek(4);
+	wr.WriteData(std::string("\x05\x06"));
+
+	CPPUNIT_ASSERT(checksum.valid);
+	CPPUNIT_ASSERT_EQUAL(std::string("\x01\xAA\xBB\x04\x05\x06", 6), out.str());
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xAA01 + 0x04BB + 0x0605), checksum.sum);
+}
+
+void TestChecksum::testOverwriteWithoutReadBack()
+{
+	std::ostringstream out;
+	Writer wr(::LittleEndian, &out);
+	Checksum checksum(2);
+	wr.checksums.push_back(&checksum);
+
+	wr.WriteData(std::string("\x01\x02\x03\x04"));
+	CPPUNIT_ASSERT(checksum.valid);
+	wr.Seek(0);
+	wr.WriteData(std::string("\xFF"));
+	CPPUNIT_ASSERT(!checksum.valid);
+}
+
+void TestChecksum::testPageChecksum()
+{
+	std::stringstream out;
+	Writer wr(::LittleEndian, &out);
+	PageChecksum checksum(4);
+	checksum.AddPage(4, 4);
+	checksum.AddPage(0, 4);
+	wr.checksums.push_back(&checksum);
+
+	/* the last two bytes are not part of any page */
+	wr.WriteData(std::string("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0A"));
+	CPPUNIT_ASSERT_EQUAL(size_t(2), checksum.pages.size());
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x04030201), checksum.GetPageSum(0));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x08070605), checksum.GetPageSum(4));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), checksum.GetPageSum(2));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0), checksum.GetPageSum(8));
+
+	/* an overwrite crossing the page boundary */
+	wr.Seek(3);
+	wr.WriteData(std::string("\xFF\xFF"));
+	CPPUNIT_ASSERT(checksum.valid);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xFF030201), checksum.GetPageSum(0));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x080706FF), checksum.GetPageSum(4));
+}
+
+uint64_t TestChecksum::NaiveSum(size_t word_size, offset_t position, const std::vector<uint8_t>& data)
+{
+	uint64_t sum = 0;
+	for(size_t index = 0; index < data.size(); index++)
+	{
+		sum += uint64_t(data[index]) << (8 * ((position + index) % word_size));
+	}
+	return sum;
+}
+
+void TestChecksum::setUp()
+{
+}
+
+void TestChecksum::tearDown()
+{
+}
+
+}
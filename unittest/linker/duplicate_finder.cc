@@ -0,0 +1,59 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/linker/duplicate_finder.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestDuplicateFinder : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestDuplicateFinder);
+	CPPUNIT_TEST(testDuplicates);
+	CPPUNIT_TEST(testHash);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that only blocks with identical contents are reported as duplicates, and that they refer to the first copy */
+	void testDuplicates();
+	/** @brief Verifies the hash against known FNV-1a values, and that it can be continued */
+	void testHash();
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestDuplicateFinder::testDuplicates()
+{
+	DuplicateFinder finder;
+	CPPUNIT_ASSERT_EQUAL(DuplicateFinder::None, finder.Add({ 1, 2, 3 }, 3));
+	CPPUNIT_ASSERT_EQUAL(DuplicateFinder::None, finder.Add({ 1, 2, 4 }, 3));
+	CPPUNIT_ASSERT_EQUAL(DuplicateFinder::None, finder.Add({ 1, 2 }, 2));
+	CPPUNIT_ASSERT_EQUAL(size_t(1), finder.Add({ 1, 2, 4 }, 7));
+	CPPUNIT_ASSERT_EQUAL(size_t(0), finder.Add({ 1, 2, 3 }, 3));
+	CPPUNIT_ASSERT_EQUAL(size_t(0), finder.Add({ 1, 2, 3 }, 3));
+	CPPUNIT_ASSERT_EQUAL(DuplicateFinder::None, finder.Add({ }, 0));
+	CPPUNIT_ASSERT_EQUAL(size_t(3), finder.Add({ }, 0));
+
+	CPPUNIT_ASSERT_EQUAL(size_t(4), finder.duplicate_count);
+	CPPUNIT_ASSERT_EQUAL(offset_t(13), finder.duplicate_bytes);
+}
+
+void TestDuplicateFinder::testHash()
+{
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xCBF29CE484222325), Hash("", 0));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0xAF63DC4C8601EC8C), Hash("a", 1));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(0x85944171F73967E8), Hash("foobar", 6));
+	CPPUNIT_ASSERT_EQUAL(Hash("foobar", 6), Hash("bar", 3, Hash("foo", 3)));
+}
+
+void TestDuplicateFinder::setUp()
+{
+}
+
+void TestDuplicateFinder::tearDown()
+{
+}
+
+}
@@ -0,0 +1,130 @@
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/binary.h"
+#include "../../src/linker/incremental_layout.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestIncrementalLayout : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestIncrementalLayout);
+	CPPUNIT_TEST(testUnchangedRelink);
+	CPPUNIT_TEST(testChangedSection);
+	CPPUNIT_TEST(testResizedSection);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that relinking unchanged inputs produces the same file as a full link */
+	void testUnchangedRelink();
+	/** @brief Verifies that relinking with one section changed in place produces the same file as a full link */
+	void testChangedSection();
+	/** @brief Verifies that relinking with a section that shrank or grew produces the same file as a full link */
+	void testResizedSection();
+
+	std::filesystem::path directory;
+
+	std::string link(std::string name, std::string code, std::string data, bool incremental);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestIncrementalLayout::testUnchangedRelink()
+{
+	std::string code(0x1800, '\x90');
+	std::string data(0x1800, '\x01');
+	std::string expected = link("full.bin", code, data, false);
+
+	CPPUNIT_ASSERT(link("output.bin", code, data, true) == expected);
+	CPPUNIT_ASSERT(std::filesystem::exists(directory / "output.bin.layout"));
+	CPPUNIT_ASSERT(link("output.bin", code, data, true) == expected);
+}
+
+void TestIncrementalLayout::testChangedSection()
+{
+	std::string code(0x1800, '\x90');
+	std::string data(0x1800, '\x01');
+	link("output.bin", code, data, true);
+
+	data[0x1234] = '\x02';
+	std::string expected = link("full.bin", code, data, false);
+	CPPUNIT_ASSERT(link("output.bin", code, data, true) == expected);
+}
+
+void TestIncrementalLayout::testResizedSection()
+{
+	std::string code(0x1800, '\x90');
+	std::string data(0x1800, '\x01');
+	link("output.bin", code, data, true);
+
+	/* a shrunk section must not be padded to its previous size */
+	code.resize(0x1000);
+	std::string expected = link("full.bin", code, data, false);
+	CPPUNIT_ASSERT(link("output.bin", code, data, true) == expected);
+
+	code.resize(0x2000, '\x90');
+	expected = link("full.bin", code, data, false);
+	CPPUNIT_ASSERT(link("output.bin", code, data, true) == expected);
+}
+
+std::string TestIncrementalLayout::link(std::string name, std::string code, std::string data, bool incremental)
+{
+	std::shared_ptr<Binary::BinaryFormat> format = std::make_shared<Binary::BinaryFormat>(0x100, "");
+
+	Module input("input.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append(code.c_str(), code.size());
+	input.AddSection(text);
+	std::shared_ptr<Section> data_section = std::make_shared<Section>(".data", Section::Readable | Section::Writable);
+	data_section->Append(data.c_str(), data.size());
+	input.AddSection(data_section);
+	input.AddGlobalSymbol("_start", Location(text, 0));
+	/* the code refers to the data, so that moving the data changes the code */
+	input.AddRelocation(Relocation::Absolute(4, Location(text, 0), Target(Location(data_section, 0x10)), 0, ::LittleEndian));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", options);
+
+	std::filesystem::path path = directory / name;
+	if(incremental)
+		format->incremental_layout = std::make_shared<IncrementalLayout>(path.string() + ".layout");
+	format->GenerateFile(path.string(), module);
+
+	std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+	CPPUNIT_ASSERT(in.is_open());
+	std::ostringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+void TestIncrementalLayout::setUp()
+{
+	directory = std::filesystem::temp_directory_path() / "unittest_incremental_layout";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+}
+
+void TestIncrementalLayout::tearDown()
+{
+	std::filesystem::remove_all(directory);
+}
+
+}
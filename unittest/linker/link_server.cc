@@ -0,0 +1,268 @@
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/linker/link_server.h"
+#include "../../src/linker/module_cache.h"
+#include "../../src/linker/module_collector.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestLinkServer : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestLinkServer);
+	CPPUNIT_TEST(testForward);
+	CPPUNIT_TEST(testClientDirectory);
+	CPPUNIT_TEST(testResidentCache);
+	CPPUNIT_TEST(testRefuseNonSocket);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that the arguments reach the job, and that its exit status and output are sent back to the client */
+	void testForward();
+	/** @brief Verifies that relative file names are resolved against the directory of the client, without changing the working directory of the server */
+	void testClientDirectory();
+	/** @brief Verifies that a resident module cache is shared between jobs, so that an input parsed by one job is loaded from memory by the next */
+	void testResidentCache();
+	/** @brief Verifies that the server does not replace a file at the socket path that is not a socket */
+	void testRefuseNonSocket();
+
+	std::filesystem::path directory;
+	std::string socket_path;
+
+	/** @brief Sends a job request on behalf of a client in the given directory, returns the exit status of the job, or -1 if no server accepted it */
+	int SendJob(std::string client_directory, std::vector<std::string> arguments);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestLinkServer::testForward()
+{
+	std::vector<std::string> received;
+	std::string received_directory;
+	std::string directory_after_job = "unset";
+	std::thread server_thread([&]()
+	{
+		/* keep the messages of the server apart from the output forwarded to the client */
+		std::ostringstream server_log;
+		Linker::Debug.rdbuf(server_log.rdbuf());
+		Linker::Warning.rdbuf(server_log.rdbuf());
+		Linker::Error.rdbuf(server_log.rdbuf());
+		LinkServer server(socket_path);
+		server.Serve([&](std::vector<std::string>& arguments) -> int
+		{
+			received = arguments;
+			received_directory = Linker::base_directory;
+			Linker::Warning << "Warning: job output" << std::endl;
+			return 3;
+		}, 1);
+		directory_after_job = Linker::base_directory;
+	});
+
+	std::vector<std::string> arguments = { "link", "-Fexe", "input.o" };
+	std::ostringstream output;
+	std::streambuf * cerr_buffer = std::cerr.rdbuf(output.rdbuf());
+	int status = -1;
+	for(int attempt = 0; attempt < 500 && status == -1; attempt++)
+	{
+		status = LinkServer::Forward(socket_path, arguments);
+		if(status == -1)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	std::cerr.rdbuf(cerr_buffer);
+	server_thread.join();
+
+	CPPUNIT_ASSERT_EQUAL(3, status);
+	CPPUNIT_ASSERT_EQUAL(std::string("Warning: job output\n"), output.str());
+	CPPUNIT_ASSERT(received == arguments);
+	CPPUNIT_ASSERT_EQUAL(std::filesystem::current_path().string(), received_directory);
+	CPPUNIT_ASSERT_EQUAL(std::string(""), directory_after_job);
+	CPPUNIT_ASSERT(!std::filesystem::exists(socket_path));
+}
+
+void TestLinkServer::testClientDirectory()
+{
+	std::filesystem::path client_directory = directory / "client";
+	std::filesystem::create_directories(client_directory);
+	{
+		std::ofstream out(client_directory / "input.o", std::ios_base::out | std::ios_base::binary);
+		out << "client input";
+	}
+
+	std::filesystem::path server_directory = std::filesystem::current_path();
+	std::string contents;
+	std::filesystem::path job_directory;
+	std::thread server_thread([&]()
+	{
+		LinkServer server(socket_path);
+		server.Serve([&](std::vector<std::string>& arguments) -> int
+		{
+			job_directory = std::filesystem::current_path();
+			std::ifstream in(Linker::ResolvePath(arguments.at(1)), std::ios_base::in | std::ios_base::binary);
+			if(!in.is_open())
+				return 1;
+			contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			return 0;
+		}, 1);
+	});
+
+	int status = SendJob(client_directory.string(), { "link", "input.o" });
+	server_thread.join();
+
+	CPPUNIT_ASSERT_EQUAL(0, status);
+	CPPUNIT_ASSERT_EQUAL(std::string("client input"), contents);
+	CPPUNIT_ASSERT(job_directory == server_directory);
+	CPPUNIT_ASSERT(std::filesystem::current_path() == server_directory);
+}
+
+void TestLinkServer::testResidentCache()
+{
+	std::filesystem::path client_directory = directory / "client";
+	std::filesystem::create_directories(client_directory);
+	{
+		std::ofstream out(client_directory / "input.o", std::ios_base::out | std::ios_base::binary);
+		out << "cached input";
+	}
+
+	/* kept in memory only, like the cache of a server started without a cache directory */
+	ModuleCache cache("", "exe", '$', ModuleCache::DefaultMaximumSize, true);
+	std::vector<size_t> section_counts;
+	std::thread server_thread([&]()
+	{
+		LinkServer server(socket_path);
+		server.Serve([&](std::vector<std::string>& arguments) -> int
+		{
+			std::string input = arguments.at(1);
+			ModuleCollector linker;
+			if(cache.Load(linker, input))
+			{
+				section_counts.push_back(linker.modules.size() == 1 ? linker.modules[0]->Sections().size() : 0);
+				return 2;
+			}
+			std::shared_ptr<Module> module = linker.CreateModule(nullptr, input);
+			std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+			text->Append("\xC3", 1);
+			module->AddSection(text);
+			linker.AddModule(module);
+			cache.Store(linker, input, 0);
+			return 1;
+		}, 2);
+	});
+
+	int first_status = SendJob(client_directory.string(), { "link", "input.o" });
+	int second_status = SendJob(client_directory.string(), { "link", "input.o" });
+	server_thread.join();
+
+	CPPUNIT_ASSERT_EQUAL(1, first_status);
+	CPPUNIT_ASSERT_EQUAL(2, second_status);
+	CPPUNIT_ASSERT(section_counts == std::vector<size_t>({ 1 }));
+}
+
+void TestLinkServer::testRefuseNonSocket()
+{
+	{
+		std::ofstream out(socket_path, std::ios_base::out | std::ios_base::binary);
+		out << "not a socket";
+	}
+
+	bool job_run = false;
+	LinkServer server(socket_path);
+	std::ostringstream output;
+	std::streambuf * error_buffer = Linker::Error.rdbuf(output.rdbuf());
+	CPPUNIT_ASSERT_THROW(server.Serve([&](std::vector<std::string>& arguments) -> int
+	{
+		job_run = true;
+		return 0;
+	}, 1), Linker::Exception);
+	Linker::Error.rdbuf(error_buffer);
+
+	CPPUNIT_ASSERT(!job_run);
+	CPPUNIT_ASSERT(std::filesystem::is_regular_file(socket_path));
+	std::ifstream in(socket_path, std::ios_base::in | std::ios_base::binary);
+	std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	CPPUNIT_ASSERT_EQUAL(std::string("not a socket"), contents);
+}
+
+int TestLinkServer::SendJob(std::string client_directory, std::vector<std::string> arguments)
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof address);
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, socket_path.data(), socket_path.size());
+
+	/* the server is started on another thread, wait for it to listen */
+	int client_handle = -1;
+	for(int attempt = 0; attempt < 500; attempt++)
+	{
+		client_handle = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(connect(client_handle, reinterpret_cast<sockaddr *>(&address), sizeof address) == 0)
+			break;
+		close(client_handle);
+		client_handle = -1;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	if(client_handle < 0)
+		return -1;
+
+	std::ostringstream request;
+	Writer wr(::LittleEndian, &request);
+	wr.WriteData("RLLS");
+	wr.WriteWord(4, LinkServer::Version);
+	wr.WriteWord(4, arguments.size() + 1);
+	wr.WriteWord(4, client_directory.size());
+	wr.WriteData(client_directory);
+	for(auto& argument : arguments)
+	{
+		wr.WriteWord(4, argument.size());
+		wr.WriteData(argument);
+	}
+
+	std::ostringstream message;
+	Writer mwr(::LittleEndian, &message);
+	mwr.WriteWord(4, request.str().size());
+	mwr.WriteData(request.str());
+	std::string data = message.str();
+	CPPUNIT_ASSERT_EQUAL(ssize_t(data.size()), send(client_handle, data.data(), data.size(), MSG_NOSIGNAL));
+
+	std::string response;
+	char buffer[256];
+	ssize_t count;
+	while((count = recv(client_handle, buffer, sizeof buffer, 0)) > 0)
+	{
+		response.append(buffer, count);
+	}
+	close(client_handle);
+
+	CPPUNIT_ASSERT(response.size() >= 8);
+	std::istringstream in(response);
+	Reader rd(::LittleEndian, &in);
+	CPPUNIT_ASSERT_EQUAL(uint64_t(response.size() - 4), rd.ReadUnsigned(4));
+	return int(rd.ReadUnsigned(4));
+}
+
+void TestLinkServer::setUp()
+{
+	directory = std::filesystem::temp_directory_path() / "unittest_link_server";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	socket_path = (directory / "server.sock").string();
+}
+
+void TestLinkServer::tearDown()
+{
+	std::filesystem::remove_all(directory);
+}
+
+}
@@ -0,0 +1,107 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/format/binary.h"
+#include "../../src/linker/memory_usage.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestMemoryUsage : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestMemoryUsage);
+	CPPUNIT_TEST(testWithinBudget);
+	CPPUNIT_TEST(testBudgetExceededAfterWrite);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that every stage is measured and the output is written when the budget is not exceeded */
+	void testWithinBudget();
+	/** @brief Verifies that no output file is left behind when the budget is exceeded after the file is written */
+	void testBudgetExceededAfterWrite();
+
+	std::filesystem::path directory;
+
+	/** @brief Links a small binary, recording the given number of bytes for each stage */
+	void link(std::string name, MemoryAccounting& accounting, offset_t write_usage);
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestMemoryUsage::testWithinBudget()
+{
+	MemoryAccounting accounting;
+	accounting.budget = 0x1000;
+	link("output.bin", accounting, 0x800);
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), accounting.phases.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("write"), accounting.phases[2].name);
+	CPPUNIT_ASSERT_EQUAL(offset_t(0x800), accounting.peak);
+	CPPUNIT_ASSERT(std::filesystem::exists(directory / "output.bin"));
+}
+
+void TestMemoryUsage::testBudgetExceededAfterWrite()
+{
+	MemoryAccounting accounting;
+	accounting.budget = 0x1000;
+	std::ostringstream output;
+	std::streambuf * error_buffer = Linker::Error.rdbuf(output.rdbuf());
+	CPPUNIT_ASSERT_THROW(link("output.bin", accounting, 0x2000), Linker::Exception);
+	Linker::Error.rdbuf(error_buffer);
+
+	CPPUNIT_ASSERT_EQUAL(size_t(3), accounting.phases.size());
+	CPPUNIT_ASSERT(!std::filesystem::exists(directory / "output.bin"));
+}
+
+void TestMemoryUsage::link(std::string name, MemoryAccounting& accounting, offset_t write_usage)
+{
+	std::shared_ptr<Binary::BinaryFormat> format = std::make_shared<Binary::BinaryFormat>(0x100, "");
+
+	Module input("input.o");
+	input.cpu = Module::I386;
+	input.endiantype = ::LittleEndian;
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append("\x90\x90\xC3", 3);
+	input.AddSection(text);
+	input.AddGlobalSymbol("_start", Location(text, 0));
+
+	Module module;
+	module.SetupOptions('$', format, nullptr);
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+	module.Append(input);
+
+	std::map<std::string, std::string> options;
+	format->AllocateSymbols(module);
+	format->SetOptions(options);
+	format->SetModel("");
+	format->SetLinkScript("", options);
+
+	/* only the write stage goes beyond a small fixed amount */
+	format->stage_finished = [&](std::string stage)
+	{
+		MemoryUsage usage;
+		usage.Add("test", stage == "write" ? write_usage : 0x10);
+		accounting.Record(stage, usage);
+	};
+	format->GenerateFile((directory / name).string(), module);
+}
+
+void TestMemoryUsage::setUp()
+{
+	directory = std::filesystem::temp_directory_path() / "unittest_memory_usage";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+}
+
+void TestMemoryUsage::tearDown()
+{
+	std::filesystem::remove_all(directory);
+}
+
+}
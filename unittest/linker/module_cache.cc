@@ -0,0 +1,167 @@
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include "../../src/linker/module_cache.h"
+#include "../../src/linker/module_collector.h"
+#include "../../src/linker/table_section.h"
+
+using namespace Linker;
+
+namespace UnitTests
+{
+
+class TestModuleCache : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE(TestModuleCache);
+	CPPUNIT_TEST(testModuleRoundTrip);
+	CPPUNIT_TEST(testUnsupportedSection);
+	CPPUNIT_TEST(testBuildId);
+	CPPUNIT_TEST_SUITE_END();
+private:
+	/** @brief Verifies that sections, symbols, imports, exports and relocations survive encoding and decoding */
+	void testModuleRoundTrip();
+	/** @brief Verifies that modules with format specific section types are not encoded */
+	void testUnsupportedSection();
+	/** @brief Verifies that entries stored by a different linker build are not loaded */
+	void testBuildId();
+public:
+	void setUp() override;
+	void tearDown() override;
+};
+
+void TestModuleCache::testModuleRoundTrip()
+{
+	Module module("lib.a:member.o");
+	module.cpu = Module::I386;
+	module.endiantype = ::LittleEndian;
+
+	std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+	text->Append("\x90\x90\xE8\x00\x00\x00\x00\xC3", 8);
+	text->SetAlign(16);
+	module.AddSection(text);
+	std::shared_ptr<Section> bss = std::make_shared<Section>(".bss", Section::Readable | Section::Writable | Section::ZeroFilled);
+	bss->Expand(0x100);
+	module.AddSection(bss);
+
+	module.AddGlobalSymbol("_start", Location(text, 0));
+	module.AddLocalSymbol("buffer", Location(bss, 0x10));
+	module.AddUndefinedSymbol("external");
+	module.AddImportedSymbol(SymbolName("KERNEL", 12));
+	module.AddExportedSymbol(ExportedSymbolName("Entry", 3), Location(text, 2));
+	module.AddRelocation(Relocation::Relative(4, Location(text, 3), SymbolName("external"), -4, ::LittleEndian));
+	module.AddRelocation(Relocation::Absolute(4, Location(bss, 0), Target(Location(text, 1)).GetSegment(), 0, ::LittleEndian).SetShift(4));
+
+	std::ostringstream out;
+	Writer wr(::LittleEndian, &out);
+	CPPUNIT_ASSERT(ModuleCache::WriteModule(wr, module, "lib.a"));
+
+	/* loaded under a different archive name */
+	std::istringstream in(out.str());
+	Reader rd(::LittleEndian, &in);
+	Module loaded;
+	CPPUNIT_ASSERT(!ModuleCache::ReadModule(rd, loaded, "other.a"));
+	CPPUNIT_ASSERT_EQUAL(std::string("other.a:member.o"), loaded.file_name);
+	CPPUNIT_ASSERT_EQUAL(Module::I386, loaded.cpu);
+
+	CPPUNIT_ASSERT_EQUAL(size_t(2), loaded.Sections().size());
+	std::shared_ptr<Section> loaded_text = loaded.FindSection(".text");
+	std::shared_ptr<Section> loaded_bss = loaded.FindSection(".bss");
+	CPPUNIT_ASSERT(loaded_text != nullptr && loaded_bss != nullptr);
+	CPPUNIT_ASSERT_EQUAL(text->GetFlags(), loaded_text->GetFlags());
+	CPPUNIT_ASSERT_EQUAL(offset_t(16), loaded_text->GetAlign());
+	CPPUNIT_ASSERT_EQUAL(offset_t(8), loaded_text->Size());
+	CPPUNIT_ASSERT_EQUAL(0xE8, loaded_text->GetByte(2));
+	CPPUNIT_ASSERT(loaded_bss->IsZeroFilled());
+	CPPUNIT_ASSERT_EQUAL(offset_t(0x100), loaded_bss->Size());
+
+	Location location;
+	CPPUNIT_ASSERT(loaded.FindGlobalSymbol("_start", location));
+	CPPUNIT_ASSERT(location == Location(loaded_text, 0));
+	CPPUNIT_ASSERT(loaded.FindLocalSymbol("buffer", location));
+	CPPUNIT_ASSERT(location == Location(loaded_bss, 0x10));
+	CPPUNIT_ASSERT_EQUAL(module.symbol_sequence.size(), loaded.symbol_sequence.size());
+
+	CPPUNIT_ASSERT_EQUAL(size_t(1), loaded.GetImportedSymbols().size());
+	CPPUNIT_ASSERT(loaded.GetImportedSymbols()[0] == SymbolName("KERNEL", 12));
+	auto exported = loaded.GetExportedSymbols().find(ExportedSymbolName("Entry", 3));
+	CPPUNIT_ASSERT(exported != loaded.GetExportedSymbols().end());
+	CPPUNIT_ASSERT(exported->second == Location(loaded_text, 2));
+
+	std::vector<Relocation>& relocations = loaded.GetRelocations();
+	CPPUNIT_ASSERT_EQUAL(size_t(2), relocations.size());
+	CPPUNIT_ASSERT(relocations[0].IsRelative());
+	CPPUNIT_ASSERT(relocations[0].source == Location(loaded_text, 3));
+	CPPUNIT_ASSERT(relocations[0].target == Target(SymbolName("external")));
+	CPPUNIT_ASSERT_EQUAL(uint64_t(-4), relocations[0].addend);
+	CPPUNIT_ASSERT(relocations[1].target == Target(Location(loaded_text, 1)).GetSegment());
+	CPPUNIT_ASSERT_EQUAL(4, relocations[1].shift);
+}
+
+void TestModuleCache::testUnsupportedSection()
+{
+	Module module("got.o");
+	module.AddSection(std::make_shared<GlobalOffsetTable>(::LittleEndian, ".got"));
+
+	std::ostringstream out;
+	Writer wr(::LittleEndian, &out);
+	CPPUNIT_ASSERT(!ModuleCache::WriteModule(wr, module, "got.o"));
+}
+
+void TestModuleCache::testBuildId()
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "unittest_module_cache";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	std::string input = (directory / "input.o").string();
+	{
+		std::ofstream out(input, std::ios_base::out | std::ios_base::binary);
+		out << "input";
+	}
+
+	CPPUNIT_ASSERT(!ModuleCache::GetBuildId().empty());
+
+	{
+		ModuleCache cache(directory / "cache", "exe", '$');
+		cache.build_id = "first";
+		ModuleCollector linker;
+		std::shared_ptr<Module> module = linker.CreateModule(nullptr, input);
+		std::shared_ptr<Section> text = std::make_shared<Section>(".text", Section::Readable | Section::Executable);
+		text->Append("\xC3", 1);
+		module->AddSection(text);
+		linker.AddModule(module);
+		cache.Store(linker, input, 0);
+		cache.Flush();
+	}
+
+	{
+		ModuleCache cache(directory / "cache", "exe", '$');
+		cache.build_id = "second";
+		ModuleCollector linker;
+		CPPUNIT_ASSERT(!cache.Load(linker, input));
+		CPPUNIT_ASSERT_EQUAL(size_t(0), linker.modules.size());
+	}
+
+	{
+		ModuleCache cache(directory / "cache", "exe", '$');
+		cache.build_id = "first";
+		ModuleCollector linker;
+		CPPUNIT_ASSERT(cache.Load(linker, input));
+		CPPUNIT_ASSERT_EQUAL(size_t(1), linker.modules.size());
+	}
+
+	std::filesystem::remove_all(directory);
+}
+
+void TestModuleCache::setUp()
+{
+}
+
+void TestModuleCache::tearDown()
+{
+}
+
+}
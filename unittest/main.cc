@@ -1,11 +1,28 @@
 
 #include "unicode.cc"
 #include "linker/buffer.cc"
+#include "linker/checksum.cc"
+#include "linker/duplicate_finder.cc"
+#include "linker/incremental_layout.cc"
+#include "linker/link_server.cc"
 #include "linker/location.cc"
+#include "linker/memory_usage.cc"
+#include "linker/module_cache.cc"
 #include "linker/reader.cc"
 #include "linker/section.cc"
 #include "linker/symbol_name.cc"
+#include "format/aout.cc"
+#include "format/arch.cc"
+#include "format/cpm68k.cc"
+#include "format/gsos.cc"
+#include "format/leexe.cc"
 #include "format/mzexe.cc"
+#include "format/neexe.cc"
+#include "format/omf.cc"
+#include "format/peexe.cc"
+#include "format/prl.cc"
+#include "format/w3w4.cc"
+#include "dumper/block.cc"
 
 #include <cppunit/extensions/HelperMacros.h>
 #include <cppunit/extensions/TestFactoryRegistry.h>
@@ -18,13 +35,31 @@
 
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestUnicode);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestBuffer);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestChecksum);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestDuplicateFinder);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestIncrementalLayout);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestLinkServer);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestLocation);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestMemoryUsage);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestModuleCache);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestReader);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestSection);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestSymbolName);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestExportedSymbol);
 
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestAOutFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestArchiveFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestCPM68KFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestGSOSFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestLEFormat);
 CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestMZFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestNEFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestOMF86Format);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestPEFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestPRLFormat);
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestW4Format);
+
+CPPUNIT_TEST_SUITE_REGISTRATION(UnitTests::TestDumperBlock);
 
 int main()
 {